@@ -17,19 +17,14 @@
  * the use of this software.
  */
 
-#include <errno.h>
-#include <pthread.h>
 #include <sys/stat.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <utime.h>
 #include <glib.h>
 
-#ifdef _WIN32
-#include <winbase.h>
-#endif
-
 #include <libfauxdcore/preferences.h>
 #include <libfauxdcore/drct.h>
 #include <libfauxdcore/i18n.h>
@@ -40,6 +35,8 @@
 #include <libfauxdgui/libfauxdgui.h>
 #include <libfauxdgui/libfauxdgui-gtk.h>
 
+#include "../ui-common/fetch-queue.h"
+
 /* JWT:"Duplicate Images" - When Fauxdacious plays most streaming radio stations, the default cover-
    art image displayed will usually be an icon image associated with the station and retrieved by the
    URL-helper script.  This image will always display by default in the Infobar, info-popup window, and
@@ -67,10 +64,9 @@
    same time.
 */
 
-static bool fromsongstartup = false;  // TRUE WHEN THREAD STARTED BY SONG CHANGE (album_init()).
-static bool skipArtReInit = false;    // JWT:TRUE:SKIP RESETTING ART (ALREADY RESET BY THREAD NOW SLEEPING).
-static bool resetthreads = false;     // JWT:TRUE STOP ANY THREADS RUNNING ON SONG CHANGE OR SHUTDOWN.
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool fromsongstartup = false;  // TRUE WHEN FETCH REQUESTED BY SONG CHANGE (album_init()).
+static bool skipArtReInit = false;    // JWT:TRUE:SKIP RESETTING ART (ALREADY RESET, DELAYED FETCH STILL WAITING).
+static GtkWidget * album_widget;      // WHERE ART FETCHED FROM THE WEB IS SHOWN.
 static bool hide_dup_art_icon;   /* JWT:TOGGLE TO TRUE TO HIDE (DUPLICATE) ART ICON IN INFOBAR IF A WEB IMAGE FETCHED. */
 
 class AlbumArtPlugin : public GeneralPlugin
@@ -99,6 +95,7 @@ const char * const AlbumArtPlugin::defaults[] = {
     "internet_coverartlookup", "FALSE",
     "scale_to_fill", "FALSE",
     "save_by_songfile", "FALSE",
+    "fetch_cache_mb", "64",
     nullptr
 };
 
@@ -109,165 +106,119 @@ bool AlbumArtPlugin::init ()
     return true;
 }
 
-/* CALLED BY g_idle_add() TO UPDATE ALBUMART WIDGET FROM THREAD: */
-static gboolean albumart_ready (gpointer widget)
+/* JWT:SHOW ART FOUND IN A CACHE OR ON THE WEB (THUS NOT A DUP.): */
+static bool show_cover (GtkWidget * widget, const char * path)
 {
-    AudguiPixbuf pixbuf;
-    String coverart_file;
-    Index<String> extlist = str_list_to_index ("jpg,png,gif,jpeg,webp", ",");
+    AudguiPixbuf pixbuf = audgui_pixbuf_request (filename_to_uri (path));
+    if (! pixbuf)
+        return false;
+
+    audgui_scaled_image_set (widget, pixbuf.get ());
+    /* INFOBAR ICON POSSIBLY HIDDEN BY HIDE DUP. OPTION, SO FORCE "SHOW" IN INFOBAR: */
+    aud_set_int ("albumart", "_infoarea_hide_art_gtk", 0);
+    hook_call ("gtkui toggle infoarea_art", nullptr);
 
+    return true;
+}
+
+/* JWT:FETCH BACKEND (RUNS ON THE FETCH THREAD) - CALL THE HELPER TO FIND AND FETCH THE ALBUM-ART,
+   WHICH IT LEAVES IN ~/.config/fauxdacious[_?]/_tmp_albumart.<ext>.  THIS MUST *NOT* CALL THE
+   ART FUNCTIONS THOUGH - CAUSES GUI ISSUES!
+*/
+static bool fetch_cover (FetchQueue & queue, const FetchRequest & request, String & file, int & status)
+{
+    String cover_helper = aud_get_str ("audacious", "cover_helper");
+    if (! cover_helper[0])  //JWT:NO PERL HELPER TO LOOK UP COVER ART.
+        return false;
+
+    String webfetch = (! strncmp (request.filename, "file://", 7)
+                    && aud_get_bool ("albumart", "save_by_songfile"))
+                    ? request.filename : aud_get_str (nullptr, "_cover_art_link");
+    const char * artist = (request.artist && request.artist[0]) ? (const char *) request.artist : "_";
+
+    Index<String> args;
+    args.append (String ("ALBUM"));
+    args.append (String (str_encode_percent (request.album)));
+    args.append (String (aud_get_path (AudPath::UserDir)));
+    args.append (String (str_encode_percent (artist)));
+    args.append (String (str_encode_percent (request.title)));
+    args.append (webfetch);
+
+    time_t started = time (nullptr);
+    status = fetch_run_helper (queue, cover_helper, args);
+    if (status < 0)
+        return false;
+
+    /* ONLY TAKE AN IMAGE THE HELPER JUST WROTE, NOT ONE LEFT FROM THE LAST SONG: */
+    Index<String> extlist = str_list_to_index ("jpg,png,gif,jpeg,webp", ",");
     for (auto & ext : extlist)
     {
-        coverart_file = String (str_concat ({aud_get_path (AudPath::UserDir), "/_tmp_albumart.", (const char *) ext}));
-        const char * filenamechar = coverart_file;
+        StringBuf coverart_file = str_concat ({aud_get_path (AudPath::UserDir), "/_tmp_albumart.", (const char *) ext});
         struct stat statbuf;
 
-        if (resetthreads)
-            break;
-
-        if (stat (filenamechar, &statbuf) >= 0)  // ART IMAGE FILE FROM WEB EXISTS (THUS NOT A DUP.):
+        if (stat (coverart_file, &statbuf) >= 0 && statbuf.st_mtime >= started)
         {
-            coverart_file = String (filename_to_uri (filenamechar));
-            pixbuf = audgui_pixbuf_request ((const char *) coverart_file);
-            if (pixbuf)
-            {
-                audgui_scaled_image_set ((GtkWidget *) widget, pixbuf.get ());
-                /* INFOBAR ICON POSSIBLY HIDDEN BY HIDE DUP. OPTION, SO FORCE "SHOW" IN INFOBAR: */
-                aud_set_int ("albumart", "_infoarea_hide_art_gtk", 0);
-                hook_call ("gtkui toggle infoarea_art", nullptr);
-                pixbuf = AudguiPixbuf ();
-            }
-            return false;
+            file = String (coverart_file);
+            return true;
         }
     }
+
     return false;
 }
 
-/* JWT:SEPARATE THREAD TO CALL THE HELPER SO THAT THE "LONG" TIME IT TAKES DOESN'T FREEZE THE GUI
-   DISPLAY WHILE ATTEMPTING TO FIND AND FETCH THE ALBUM-ART.  THIS THREAD MUST *NOT* CALL THE
-   ART FUNCTIONS THOUGH - CAUSES GUI ISSUES!  WHEN STARTING A NEW SONG/STREAM, WE WAIT FOR 2
-   SECONDS BEFORE FETCHING IMAGE TO ALLOW THE TUPLE TO CHANGE (IE. RESTARTING A STREAMING STATION
-   LATER USUALLY MEANS A DIFFERENT SONG TITLE), OTHERWISE, WE'D CALL THE THREAD TWICE, ONE FOR THE
-   PREV. SONG TITLE STILL DISPLAYED, THEN AGAIN WHEN THE TUPLE CHANGES (USUALLY, ALMOST IMMEDIATELY)!
+/* JWT:CALLED IN THE MAIN THREAD WHEN THE FETCH FOR THE CURRENT SONG IS DONE: */
+static void cover_fetched (const FetchRequest &, const char * path, int)
+{
+    skipArtReInit = false;
+    if (path && album_widget)
+        show_cover (album_widget, path);
+}
+
+/* SEARCHED WEB IMAGES ARE KEPT IN ~/.config/fauxdacious[_?]/fetch-cache/albumart/: */
+static FetchQueue fetch_queue ("albumart", "jpg,png,gif,jpeg,webp", 64, fetch_cover, cover_fetched);
+
+/* JWT:STRIP STREAM NAMES, ETC. OFF THE TAGS TO GET THE ARTIST/ALBUM/TITLE TO SEARCH FOR,
+   SETS skipweb IF THERE'S NOTHING WORTH SEARCHING THE WEB FOR.
 */
-static void * album_helper_thread_fn (void * data)
+static void get_search_fields (FetchRequest & request, bool & skipweb)
 {
-    bool abortthisthread = resetthreads;
-    if (abortthisthread)
+    bool split_titles = aud_get_bool (nullptr, "split_titles");
+    const char * album = (const char *) request.album;
+    if (album && album[0])  // ALBUM FIELD NOT BLANK AND NOT A FILE/URL:
     {
-        pthread_exit (nullptr);
-        return nullptr;
-    }
-    if (fromsongstartup)
-    {
-        String filename = aud_drct_get_filename ();
-        if (! strcmp_nocase (filename, "https://", 8) || ! strcmp_nocase (filename, "http://", 7))
+        const char * album_uri = strstr (album, "://");  // FOR URI, WE'LL ASSUME LONGEST IS "stdin" (5 chars)
+        if (album_uri && (album_uri-album) < 6)  // ALBUM FIELD IS A URI (PBLY A PODCAST/VIDEO FROM STREAMFINDER!):
         {
-            int sleep_msec = aud_get_int ("albumart", "sleep_msec");
-            if (sleep_msec < 1)  sleep_msec = 1500;
-            skipArtReInit = true;
-            g_usleep (sleep_msec * 1000);  // SLEEP 2" TO ALLOW FOR ANY TUPLE CHANGE TO OVERRIDE! */
-            if (! fromsongstartup || resetthreads)
-            {
-                /* ANOTHER THREAD HAS BEEN STARTED BY TUPLE-CHANGE, WHILE WE SLEPT, SO ABORT THIS
-                   THREAD AND LET THE LATTER (TUPLE-CHANGE) THREAD UPDATE THE LYRICS!
-                */
-                filename = String ();
-                pthread_exit (nullptr);
-                return nullptr;
-            }
+            request.album = String ("_");
+            String s = aud_get_str (nullptr, "_cover_art_link");
+            if (! s || ! s[0])
+                skipweb = true;
+        }
+        else if (split_titles)
+        {
+            /* ALBUM MAY ALSO CONTAIN THE STREAM NAME (IE. "<ALBUM> - <STREAM NAME>"): STRIP THAT OFF: */
+            const char * throwaway = strstr (album, " - ");
+            int albumlen = throwaway ? throwaway - album : -1;
+            request.album = String (str_copy (album, albumlen));
         }
     }
+    else
+        request.album = String ("_");
 
-    pthread_mutex_lock (& mutex);
-
-    String cover_helper = aud_get_str ("audacious", "cover_helper");
-
-    if (! resetthreads && cover_helper && cover_helper[0]) //JWT:WE HAVE A PERL HELPER TO LOOK UP COVER ART.
+    if (! split_titles)
     {
-        Tuple tuple = aud_drct_get_tuple ();
-        String Title = tuple.get_str (Tuple::Title);
-        String Artist = tuple.get_str (Tuple::Artist);
-        String Album = tuple.get_str (Tuple::Album);
-        String audio_fn = tuple.get_str (Tuple::AudioFile);
-        if (! audio_fn || ! audio_fn[0])
-            audio_fn = aud_drct_get_filename ();
-
-        const char * album = (const char *) Album;
-        if (Title && Title[0])
+        /* ARTIST MAY BE IN TITLE INSTEAD (IE. "<ARTIST> - <TITLE>"): IF SO, USE THAT FOR ARTIST: */
+        const char * title = (const char *) request.title;
+        if (title)
         {
-            if (album && album[0])  // ALBUM FIELD NOT BLANK AND NOT A FILE/URL:
+            const char * artistlen = strstr (title, " - ");
+            if (artistlen)
             {
-                const char * album_uri = strstr (album, "://");  // FOR URI, WE'LL ASSUME LONGEST IS "stdin" (5 chars)
-                if (album_uri && (album_uri-album) < 6)  // ALBUM FIELD IS A URI (PBLY A PODCAST/VIDEO FROM STREAMFINDER!):
-                    Album = String ("_");
-                else if (aud_get_bool (nullptr, "split_titles"))
-                {
-                    /* ALBUM MAY ALSO CONTAIN THE STREAM NAME (IE. "<ALBUM> - <STREAM NAME>"): STRIP THAT OFF: */
-                    const char * throwaway = strstr (album, " - ");
-                    int albumlen = throwaway ? throwaway - album : -1;
-                    Album = String (str_copy (album, albumlen));
-                }
-            }
-            else
-                Album = String ("_");
-
-            String webfetch = (! strncmp (audio_fn, "file://", 7)
-                            && aud_get_bool ("albumart", "save_by_songfile"))
-                            ? audio_fn : aud_get_str (nullptr, "_cover_art_link");
-
-            if (! aud_get_bool (nullptr, "split_titles"))
-            {
-                /* ARTIST MAY BE IN TITLE INSTEAD (IE. "<ARTIST> - <TITLE>"): IF SO, USE THAT FOR ARTIST: */
-                const char * title = (const char *) Title;
-                if (title)
-                {
-                    const char * artistlen = strstr (title, " - ");
-                    if (artistlen)
-                    {
-                        Artist = String (str_copy (title, artistlen - title));
-                        const char * titleoffset = artistlen+3;
-                        if (titleoffset)
-                            Title = String (str_copy (artistlen+3, -1));
-                    }
-                }
+                request.artist = String (str_copy (title, artistlen - title));
+                request.title = String (str_copy (artistlen+3, -1));
             }
-            if (!Artist || !Artist[0])
-                Artist = String ("_");
-
-            StringBuf album_buf = str_encode_percent (Album);
-            StringBuf artist_buf = str_encode_percent (Artist);
-            StringBuf title_buf = str_encode_percent (Title);
-
-#ifdef _WIN32
-            WinExec ((const char *) str_concat ({cover_helper, " ALBUM '",
-                    (const char *) album_buf, "' ", aud_get_path (AudPath::UserDir), " '",
-                    (const char *) artist_buf, "' '", (const char *) title_buf, "' '",
-                    (const char *) webfetch, "'"}), SW_HIDE);
-#else
-            system ((const char *) str_concat ({cover_helper, " ALBUM '",
-                    (const char *) album_buf, "' ", aud_get_path (AudPath::UserDir), " '",
-                    (const char *) artist_buf, "' '", (const char *) title_buf, "' '",
-                    (const char *) webfetch, "'"}));
-#endif
         }
     }
-    else
-        abortthisthread = true;
-
-    cover_helper = String ();
-
-    if (! abortthisthread && ! resetthreads)
-    {
-        skipArtReInit = false;
-        g_idle_add (albumart_ready, data);
-    }
-
-    pthread_mutex_unlock (& mutex);
-
-    pthread_exit (nullptr);
-
-    return nullptr;
 }
 
 /* JWT:UPDATE THE ALBUM-COVER IMAGE (CALL THREAD IF NEEDED & DYNAMIC ALBUM-ART OPTION IN EFFECT): */
@@ -372,78 +323,47 @@ static void album_update (void *, GtkWidget * widget)
         return;
     }
 
-    /* JWT:NOW CHECK THE ALBUM-ART CACHE (IF NOT SEARCHED ALREADY):
+    /* JWT:NOW CHECK THE ALBUM-ART CACHES (IF NOT SEARCHED ALREADY):
        (ANY ART FOUND BELOW HERE IS UNIQUE TO TITLE/ARTIST|ALBUM AND THUS NOT A DUP.)
     */
     Tuple tuple = aud_drct_get_tuple ();
-    String Title = tuple.get_str (Tuple::Title);
-    String Artist = tuple.get_str (Tuple::Artist);
-    String Album = tuple.get_str (Tuple::Album);
-    String audio_fn = tuple.get_str (Tuple::AudioFile);
-    if (! audio_fn || ! audio_fn[0])
-        audio_fn = aud_drct_get_filename ();
-
-    if (Title && Title[0] && ((Artist && Artist[0]) || (Album && Album[0])))
+    FetchRequest request;
+    request.title = tuple.get_str (Tuple::Title);
+    request.artist = tuple.get_str (Tuple::Artist);
+    request.album = tuple.get_str (Tuple::Album);
+    request.filename = tuple.get_str (Tuple::AudioFile);
+    if (! request.filename || ! request.filename[0])
+        request.filename = filename;
+
+    if (request.title && request.title[0] && ((request.artist && request.artist[0])
+            || (request.album && request.album[0])))
     {
         bool skipweb = false;
-        /* DON'T BOTHER SEARCHING CACHE IF FILE AND WE'VE ALREADY SEARCHED CACHE IN art-search.cc!: */
+        get_search_fields (request, skipweb);
+
+        /* FIRST THE CACHE OF ART WE'VE FETCHED FROM THE WEB BEFORE: */
+        String coverart_file = fetch_queue.lookup (request);
+        if (coverart_file && show_cover (widget, coverart_file))
+            return;
+
+        /* DON'T BOTHER SEARCHING THE HELPER'S CACHE IF FILE AND WE'VE ALREADY SEARCHED IT IN art-search.cc!: */
         if (! strncmp (filename, "http://", 7) || ! strncmp (filename, "https://", 8)
                 || ! aud_get_bool (nullptr, "search_albumart_cache"))
         {
             /* IF HERE, WE'RE EITHER A STREAM, OR A FILE W/NO ART & CACHE ALREADY SEARCHED: */
-            bool split_titles = aud_get_bool (nullptr, "split_titles");
-            const char * album = (const char *) Album;
-            if (album && album[0])  // ALBUM FIELD NOT BLANK AND NOT A FILE/URL:
-            {
-                const char * album_uri = strstr (album, "://");  // FOR URI, WE'LL ASSUME LONGEST IS "stdin" (5 chars)
-                if (album_uri && (album_uri-album) < 6)  // ALBUM FIELD IS A URI (PBLY A PODCAST/VIDEO FROM STREAMFINDER!):
-                {
-                    Album = String ("_");
-                    String s = aud_get_str (nullptr, "_cover_art_link");
-                    if (! s || ! s[0])
-                        skipweb = true;
-                }
-                else if (split_titles)
-                {
-                    /* ALBUM MAY ALSO CONTAIN THE STREAM NAME (IE. "<ALBUM> - <STREAM NAME>"): STRIP THAT OFF: */
-                    const char * throwaway = strstr (album, " - ");
-                    int albumlen = throwaway ? throwaway - album : -1;
-                    Album = String (str_copy (album, albumlen));
-                }
-            }
-            else
-                Album = String ("_");
-
-            if (! split_titles)
-            {
-                /* ARTIST MAY BE IN TITLE INSTEAD (IE. "<ARTIST> - <TITLE>"): IF SO, USE THAT FOR ARTIST: */
-                const char * title = (const char *) Title;
-                if (title)
-                {
-                    const char * artistlen = strstr (title, " - ");
-                    if (artistlen)
-                    {
-                        Artist = String (str_copy (title, artistlen - title));
-                        const char * titleoffset = artistlen+3;
-                        if (titleoffset)
-                            Title = String (str_copy (artistlen+3, -1));
-                    }
-                }
-            }
-
             StringBuf albart_FN;
-            StringBuf album_buf = str_copy (Album);
+            StringBuf album_buf = str_copy (request.album);
             str_replace_char (album_buf, ' ', '~');  // JWT:PROTECT SPACES!
-            if (Artist && Artist[0])
+            if (request.artist && request.artist[0])
             {
-                StringBuf artist_buf = str_copy (Artist);
+                StringBuf artist_buf = str_copy (request.artist);
                 str_replace_char (artist_buf, ' ', '~');
                 albart_FN = str_concat ({(const char *) str_encode_percent (album_buf), "__",
                         (const char *) str_encode_percent (artist_buf)});
             }
             else
             {
-                if (Album == String ("_"))
+                if (request.album == String ("_"))
                 {
                     if (! hookalreadycalled)
                     {
@@ -453,21 +373,17 @@ static void album_update (void *, GtkWidget * widget)
                     }
                     return;   /* JWT:NO ALBUM OR ARTIST, PUNT (MAY BE STREAM OR FILE)! */
                 }
-                else if (Title && Title[0])
+                else
                 {
-                    StringBuf title_buf = str_copy (Title);
+                    StringBuf title_buf = str_copy (request.title);
                     str_replace_char (title_buf, ' ', '~');
                     albart_FN = str_concat ({(const char *) str_encode_percent (album_buf), "__",
                             (const char *) str_encode_percent (title_buf)});
                 }
-                else
-                    albart_FN = str_encode_percent (album_buf);
             }
             str_replace_char (albart_FN, '~', ' ');  // JWT:UNPROTECT SPACES!
 
-            String coverart_file;
             Index<String> extlist = str_list_to_index ("jpg,png,gif,jpeg", ",");
-            AudguiPixbuf pixbuf;
             for (auto & ext : extlist)
             {
                 coverart_file = String (str_concat ({aud_get_path (AudPath::UserDir),
@@ -476,20 +392,12 @@ static void album_update (void *, GtkWidget * widget)
                 struct stat statbuf;
                 if (stat (filenamechar, &statbuf) >= 0)  // ART IMAGE FILE EXISTS:
                 {
-                    String coverart_uri = String (filename_to_uri (filenamechar));
-                    pixbuf = audgui_pixbuf_request ((const char *) coverart_uri);
-                    if (pixbuf)  /* FOUND ART IN CACHE (THUS NOT A DUP.), RETURN: */
+                    if (show_cover (widget, filenamechar))  /* FOUND ART IN CACHE (THUS NOT A DUP.), RETURN: */
                     {
-                        audgui_scaled_image_set ((GtkWidget *) widget, pixbuf.get ());
                         /* MAKE FILE NEWEST FOR EASIER USER-LOOKUP IN SONG-EDIT!: */
                         if (utime (filenamechar, nullptr) < 0)
                             AUDWARN ("i:Failed to update art-file time (for easier user-lookup)!\n");
 
-                        /* INFOBAR ICON POSSIBLY HIDDEN BY HIDE DUP. OPTION, SO FORCE "SHOW" IN INFOBAR: */
-                        aud_set_int ("albumart", "_infoarea_hide_art_gtk", 0);
-                        hook_call ("gtkui toggle infoarea_art", nullptr);
-                        pixbuf = AudguiPixbuf ();
-
                         return;
                     }
                     else
@@ -505,30 +413,25 @@ static void album_update (void *, GtkWidget * widget)
             hookalreadycalled = 1;
         }
 
-        /* JWT:NO CACHED ART, CALL HELPER TO SEARCH WEB: */
+        /* JWT:NO CACHED ART, HAVE THE HELPER SEARCH WEB (IN THE BACKGROUND, SO THAT THE "LONG" TIME IT
+           TAKES DOESN'T FREEZE THE GUI).  WHEN STARTING A NEW STREAM, WE WAIT FOR 2 SECONDS BEFORE
+           FETCHING THE IMAGE TO ALLOW THE TUPLE TO CHANGE (IE. RESTARTING A STREAMING STATION LATER
+           USUALLY MEANS A DIFFERENT SONG TITLE), OTHERWISE, WE'D FETCH TWICE, ONCE FOR THE PREV. SONG
+           TITLE STILL DISPLAYED, THEN AGAIN WHEN THE TUPLE CHANGES (USUALLY, ALMOST IMMEDIATELY)!
+           ANY NEWER REQUEST REPLACES A WAITING (OR STOPS A RUNNING) ONE.
+        */
         if (! skip_web_art_search && ! skipweb && aud_get_bool ("albumart", "internet_coverartlookup")
-                && aud_get_str ("audacious", "cover_helper"))
+                && aud_get_str ("audacious", "cover_helper")[0])
         {
-            pthread_attr_t thread_attrs;
-            if (! pthread_attr_init (& thread_attrs))
+            int delay_msec = 0;
+            if (fromsongstartup && (! strcmp_nocase (filename, "https://", 8)
+                    || ! strcmp_nocase (filename, "http://", 7)))
             {
-                if (! pthread_attr_setdetachstate (& thread_attrs, PTHREAD_CREATE_DETACHED)
-                        || ! pthread_attr_setscope (& thread_attrs, PTHREAD_SCOPE_PROCESS))
-                {
-                    pthread_t album_helper_thread;
-
-                    resetthreads = false;
-                    if (pthread_create (&album_helper_thread, nullptr, album_helper_thread_fn, widget))
-                        AUDERR ("s:Error creating helper thread: %s - Expect Delays!...\n", strerror (errno));
-                }
-                else
-                    AUDERR ("s:Error detatching helper thread: %s!\n", strerror (errno));
-
-                if (pthread_attr_destroy (& thread_attrs))
-                    AUDERR ("s:Error destroying helper thread attributes: %s!\n", strerror (errno));
+                delay_msec = aud_get_int ("albumart", "sleep_msec");
+                if (delay_msec < 1)  delay_msec = 1500;
+                skipArtReInit = true;
             }
-            else
-                AUDERR ("s:Error initializing helper thread attributes: %s!\n", strerror (errno));
+            fetch_queue.request (request, delay_msec);
         }
     }
     if (! hookalreadycalled)
@@ -543,7 +446,8 @@ static void album_update (void *, GtkWidget * widget)
 static void album_init (void *, GtkWidget * widget)
 {
     aud_set_str (nullptr, "_cover_art_link", "");  // JWT:MAKE SURE THIS IS CLEARED, AS THREAD DOESN'T ALWAYS SEEM TO DO SO?!:
-    resetthreads = true;
+    fetch_queue.cancel ();
+    skipArtReInit = false;
     fromsongstartup = true;
     album_update (nullptr, widget);  // JWT:CHECK FILES & DISKS (TUPLE DOESN'T CHANGE IN THESE) ONCE NOW ON PLAY START!
 }
@@ -559,7 +463,8 @@ static void album_tuplechg (void *, GtkWidget * widget)
 /* JWT:CALLED WHEN PLAY IS STOPPED (BUT NOT WHEN JUMPING BETWEEN ENTRIES: */
 static void album_clear (void *, GtkWidget * widget)
 {
-    resetthreads = true;
+    fetch_queue.cancel ();
+    skipArtReInit = false;
     audgui_scaled_image_set (widget, nullptr);
 }
 
@@ -581,7 +486,8 @@ static void hide_dup_art_icon_toggle_fn ()
 
 static void album_cleanup (GtkWidget * widget)
 {
-    resetthreads = true;
+    fetch_queue.cleanup ();
+    album_widget = nullptr;
     aud_set_bool ("albumart", "_isactive", false);
     hook_call ("gtkui toggle infoarea_art", nullptr);
 
@@ -597,6 +503,7 @@ void * AlbumArtPlugin::get_gtk_widget ()
     audgui_init ();
 
     GtkWidget * widget = audgui_scaled_image_new (nullptr);
+    album_widget = widget;
 
     g_signal_connect (widget, "destroy", (GCallback) album_cleanup, nullptr);
 
@@ -0,0 +1 @@
+#include "../ui-common/fetch-queue.cc"
@@ -28,7 +28,10 @@
 */
 
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -118,6 +121,13 @@ const char * const AudAdPlugXMMS::exts[] = {
 // Default AdPlug user's configuration subdirectory
 #define ADPLUG_CONFDIR		".adplug"
 
+// Song length cache, kept next to the database (or in Fauxdacious' config
+// directory if the user has no AdPlug directory)
+#define LENGTHDB_FILE		"songlengths.db"
+
+// Song length limit, as in CPlayer::songlength(): 10 minutes
+#define MAX_SONGLENGTH		600000
+
 /***** Global variables *****/
 
 // Configuration (and defaults)
@@ -134,6 +144,14 @@ static struct {
   String filename;
 } plr;
 
+// Song lengths found so far, by content hash and subsong.  Computing a
+// length means playing the whole song, so they are kept across sessions.
+static struct {
+  std::mutex mutex;
+  std::map<std::pair<uint64_t, int>, unsigned long> lengths;
+  std::string path;
+} lengthdb;
+
 /***** Debugging *****/
 
 #ifdef DEBUG
@@ -154,12 +172,141 @@ dbg_printf (const char *fmt, ...)
 #define dbg_printf AUDINFO
 #endif
 
+/***** Song length cache *****/
+
+// 64-bit FNV-1a over the file contents, including the size
+static uint64_t content_hash (const Index<char> & data)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t) data.len ();
+
+  for (char c : data)
+  {
+    hash ^= (unsigned char) c;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+// rewrites the file with only the entries in memory, replacing it atomically
+static void lengthdb_compact ()
+{
+  std::string tmppath = lengthdb.path + ".tmp";
+
+  FILE *f = fopen (tmppath.c_str (), "w");
+  if (! f)
+    return;
+
+  for (auto & entry : lengthdb.lengths)
+    fprintf (f, "%016llx %d %lu\n", (unsigned long long) entry.first.first,
+     entry.first.second, entry.second);
+
+  if (fclose (f) || rename (tmppath.c_str (), lengthdb.path.c_str ()))
+  {
+    AUDWARN ("Could not compact %s.\n", lengthdb.path.c_str ());
+    remove (tmppath.c_str ());
+  }
+}
+
+static void lengthdb_load ()
+{
+  const char *homedir = getenv ("HOME");
+  StringBuf confdir = homedir ? str_concat ({homedir, "/" ADPLUG_CONFDIR}) : StringBuf ();
+
+  if (confdir && VFSFile::test_file (filename_to_uri (confdir), VFS_IS_DIR))
+    lengthdb.path = std::string (confdir) + "/" LENGTHDB_FILE;
+  else
+    lengthdb.path = std::string (aud_get_path (AudPath::UserDir)) + "/adplug-" LENGTHDB_FILE;
+
+  FILE *f = fopen (lengthdb.path.c_str (), "r");
+  if (! f)
+    return;
+
+  char line[128];
+  unsigned long long hash;
+  int subsong;
+  unsigned long length;
+
+  int lines = 0;
+
+  // one "hash subsong length" line per entry; later lines take precedence
+  while (fgets (line, sizeof line, f))
+  {
+    if (sscanf (line, "%llx %d %lu", & hash, & subsong, & length) == 3)
+      lengthdb.lengths[std::make_pair ((uint64_t) hash, subsong)] = length;
+
+    lines ++;
+  }
+
+  fclose (f);
+
+  // entries are only ever appended, so drop the superseded and unreadable
+  // ones here to keep the file from growing without bound
+  if (lines > (int) lengthdb.lengths.size ())
+    lengthdb_compact ();
+
+  dbg_printf (" (%d cached song lengths)", (int) lengthdb.lengths.size ());
+}
+
+static bool lengthdb_lookup (uint64_t hash, int subsong, unsigned long & length)
+{
+  std::lock_guard<std::mutex> lock (lengthdb.mutex);
+
+  auto it = lengthdb.lengths.find (std::make_pair (hash, subsong));
+  if (it == lengthdb.lengths.end ())
+    return false;
+
+  length = it->second;
+  return true;
+}
+
+// new entries are appended, so nothing is lost if we are not shut down cleanly
+static void lengthdb_store (uint64_t hash, int subsong, unsigned long length)
+{
+  std::lock_guard<std::mutex> lock (lengthdb.mutex);
+
+  lengthdb.lengths[std::make_pair (hash, subsong)] = length;
+
+  FILE *f = fopen (lengthdb.path.c_str (), "a");
+  if (f)
+  {
+    fprintf (f, "%016llx %d %lu\n", (unsigned long long) hash, subsong, length);
+    fclose (f);
+  }
+}
+
+// OPL device for length scans:  register writes go nowhere and nothing is
+// ever emulated or mixed, so a scan costs only the player's own update()s.
+class CNullopl final : public Copl
+{
+public:
+  void write (int reg, int val) {}
+  void setchip (int n) {}
+  int getchip () { return 0; }
+  void init () {}
+  void update (short * buf, int samples) {}
+};
+
+// Same result as CPlayer::songlength(), but for a player that will be thrown
+// away afterwards and was created with a CNullopl already:  no OPL is
+// swapped in and the player is not rewound again at the end.
+static unsigned long scan_songlength (CPlayer *p, int subsong)
+{
+  float slength = 0.0f;
+
+  p->rewind (subsong);
+  while (p->update () && slength < MAX_SONGLENGTH)
+    slength += 1000.0f / p->getrefresh ();
+
+  return (unsigned long) slength;
+}
+
 /***** Main player (!! threaded !!) *****/
 
 bool AudAdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tuple,
  Index<char> * image)
 {
-  CSilentopl tmpopl;
+  CNullopl tmpopl;
 
   CFileProvider fp (file);
 
@@ -167,11 +314,30 @@ bool AudAdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tup
   if (! strncmp (filename, "stdin://-.d00", 13))
       return false;
 
+  // the file provider rewinds the file before the player reads it
+  bool cacheable = strncmp (filename, "stdin://", 8);
+  uint64_t hash = 0;
+
+  if (cacheable)
+  {
+    Index<char> data = file.read_all ();
+    cacheable = (data.len () > 0);
+    hash = content_hash (data);
+  }
+
   CPlayer *p = CAdPlug::factory (filename, &tmpopl, fp);
 
   if (! p)
     return false;
 
+  unsigned long length;
+  if (! cacheable || ! lengthdb_lookup (hash, plr.subsong, length))
+  {
+    length = scan_songlength (p, plr.subsong);
+    if (cacheable)
+      lengthdb_store (hash, plr.subsong, length);
+  }
+
   if (! p->getauthor().empty())
     tuple.set_str (Tuple::Artist, p->getauthor().c_str());
 
@@ -182,7 +348,7 @@ bool AudAdPlugXMMS::read_tag (const char * filename, VFSFile & file, Tuple & tup
 
   tuple.set_str (Tuple::Codec, p->gettype().c_str());
   tuple.set_str (Tuple::Quality, _("sequenced"));
-  tuple.set_int (Tuple::Length, p->songlength (plr.subsong));
+  tuple.set_int (Tuple::Length, length);
   tuple.set_int (Tuple::Channels, 2);
   delete p;
 
@@ -375,6 +541,7 @@ bool AudAdPlugXMMS::init ()
       }
     }
   }
+  lengthdb_load ();
   dbg_printf (".\n");
 
   return true;
@@ -387,6 +554,8 @@ void AudAdPlugXMMS::cleanup ()
   if (plr.db)
     delete plr.db;
 
+  lengthdb.lengths.clear ();
+
   plr.filename = String ();
 
   aud_set_bool (CFG_VERSION, "16bit", conf.bit16);
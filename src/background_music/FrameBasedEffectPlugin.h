@@ -24,7 +24,6 @@
 class FrameBasedEffectPlugin : public EffectPlugin
 {
     Index<float> frame_in;
-    Index<float> frame_out;
     Index<float> output;
     int current_channels = 0, current_rate = 0, channel_last_read = 0;
     LoudnessFrameProcessor detection;
@@ -47,7 +46,6 @@ public:
     {
         output.clear();
         frame_in.clear();
-        frame_out.clear();
     }
 
     void start(int & channels, int & rate) final
@@ -58,37 +56,49 @@ public:
 
         detection.start(channels, rate);
         frame_in.resize(current_channels);
-        frame_out.resize(current_channels);
 
         flush(false);
     }
 
     Index<float> & process(Index<float> & data) final
     {
-        detection.update_config();
+        detection.update_config_if_changed();
 
-        int output_samples = 0;
-        output.resize(0);
+        const float * in = data.begin();
+        int samples = data.len();
+        int output_frames = 0;
+        output.resize((samples / current_channels + 1) * current_channels);
 
         // It is assumed data always contains a multiple of channels, but we
-        // don't care.
-        for (const float sample : data)
+        // don't care: a partial frame is completed by the next call.
+        if (channel_last_read > 0)
         {
-            frame_in[channel_last_read++] = sample;
+            while (samples > 0 && channel_last_read < current_channels)
+            {
+                frame_in[channel_last_read++] = *in++;
+                samples--;
+            }
             if (channel_last_read == current_channels)
             {
-                // Processing happens per frame. Because of read-ahead there is
-                // not always output available yet.
-                if (detection.process_has_output(frame_in, frame_out))
-                {
-                    output.move_from(frame_out, 0, output_samples,
-                                     current_channels, true, false);
-                    output_samples += current_channels;
-                }
+                output_frames +=
+                    detection.process(frame_in.begin(), 1, output.begin());
                 channel_last_read = 0;
             }
         }
 
+        // Because of read-ahead there is not always output available yet.
+        const int frames = samples / current_channels;
+        output_frames += detection.process(
+            in, frames, output.begin() + output_frames * current_channels);
+
+        in += frames * current_channels;
+        samples -= frames * current_channels;
+        while (samples-- > 0)
+        {
+            frame_in[channel_last_read++] = *in++;
+        }
+
+        output.resize(output_frames * current_channels);
         return output;
     }
 
@@ -22,7 +22,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
-#include <libfauxdcore/ringbuf.h>
+#include <libfauxdcore/index.h>
 
 /**
  * Tools to detect perceived loudness.
@@ -83,43 +83,19 @@ class PerceptiveRMS
     static constexpr float INPUT_SCALE = 4e9f;
     static constexpr float OUTPUT_SCALE = 1.0f / INPUT_SCALE;
 
-    class WindowedRMS
-    {
-        uint64_t window_sum_ = 0;
-        int window_size_ = 0;
-        int latency_minus_one = 0;
-        float scale_ = 0.0;
-        float output_ = 0.0;
-
-    public:
-
-        float add_and_take_and_get(uint64_t add, uint64_t take)
-        {
-            window_sum_ += add;
-            window_sum_ -= take;
-            const auto sum = static_cast<float>(window_sum_);
-            output_ = scale_ * sum;
-            return output_;
-        }
-
-        void configure(const Loudness::Metrics & metrics)
-        {
-            window_size_ = metrics.window_samples;
-            latency_minus_one = std::max(0, metrics.latency_samples - 1);
-            scale_ = metrics.weight * metrics.weight /
-                     static_cast<float>(window_size_);
-            window_sum_ = 0;
-            output_ = 0;
-        }
-
-        [[nodiscard]] int delayed_sample_index() const
-        {
-            return latency_minus_one;
-        }
-    };
-
-    RingBuf<uint64_t> buffer_;
-    WindowedRMS rms_[STEPS + 1];
+    /*
+     * All windows end at the current sample, so rather than keeping a running
+     * sum per window, a single history of running totals is kept, and the sum
+     * over any window is the difference between the current total and the
+     * total the window length ago. The totals wrap around, but as unsigned
+     * arithmetic is modular the difference is still exact.
+     */
+    Index<uint64_t> totals_;
+    uint64_t total_ = 0;
+    int mask_ = 0;
+    int position_ = 0;
+    int window_[STEPS + 1] = {};
+    float scale_[STEPS + 1] = {};
     int sample_rate_ = 0;
     int latency_ = 0;
     FastAttackSmoothRelease smooth_release_;
@@ -132,11 +108,34 @@ class PerceptiveRMS
         smooth_release_.set_samples(max_metrics.window_samples,
                                     max_metrics.window_samples);
 
+        int longest = 0;
         for (int step = 0; step <= STEPS; step++)
         {
-            rms_[step].configure(
-                Loudness::get_metrics(step, STEPS, sample_rate_));
+            const auto metrics =
+                Loudness::get_metrics(step, STEPS, sample_rate_);
+            /*
+             * The widest window spans the full latency, the others end one
+             * sample short of their own latency, so that none of them looks
+             * further back than the read-ahead provides.
+             */
+            window_[step] = step == 0
+                                ? latency_
+                                : std::max(0, metrics.latency_samples - 1);
+            scale_[step] = metrics.weight * metrics.weight /
+                           static_cast<float>(metrics.window_samples);
+            longest = std::max(longest, window_[step]);
         }
+
+        int size = 1;
+        while (size <= longest)
+        {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        position_ = 0;
+        total_ = 0;
+        totals_.resize(0);
+        totals_.insert(0, size);
     }
 
     [[nodiscard]] uint64_t static squared_value_to_internal_value(
@@ -146,6 +145,13 @@ class PerceptiveRMS
             fabsf(std::round(squared_value * INPUT_SCALE)));
     }
 
+    [[nodiscard]] float window_value(const int step) const
+    {
+        const uint64_t sum =
+            total_ - totals_[(position_ - window_[step]) & mask_];
+        return scale_[step] * static_cast<float>(sum);
+    }
+
 public:
     void set_rate_and_value(int sample_rate, float squared_initial_value)
     {
@@ -155,9 +161,6 @@ public:
         }
         sample_rate_ = sample_rate;
         init_detection();
-        buffer_.discard();
-        buffer_.alloc(latency_);
-        buffer_.fill_with(0);
 
         for (int i = 0; i <= latency_; i++)
         {
@@ -171,20 +174,16 @@ public:
     {
         const uint64_t internal_value =
             squared_value_to_internal_value(squared_input);
-        const uint64_t oldest = buffer_.pop();
-        buffer_.push(internal_value);
+        total_ += internal_value;
+        position_ = (position_ + 1) & mask_;
+        totals_[position_] = total_;
 
-        float max = rms_[0].add_and_take_and_get(internal_value, oldest);
+        float max = window_value(0);
         max = std::max(max, static_cast<float>(internal_value) * peak_weight_);
 
         for (int step = 1; step <= STEPS; step++)
         {
-            WindowedRMS & rms = rms_[step];
-            const auto delayed_input =
-                buffer_.nth_from_last(rms.delayed_sample_index());
-            const auto step_value =
-                rms.add_and_take_and_get(internal_value, delayed_input);
-            max = std::max(max, step_value);
+            max = std::max(max, window_value(step));
         }
         max *= OUTPUT_SCALE;
         return smooth_release_.get_envelope(max);
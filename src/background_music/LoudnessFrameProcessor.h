@@ -21,7 +21,9 @@
 #include "Integrator.h"
 #include "Loudness.h"
 #include "basic_config.h"
+#include <algorithm>
 #include <cmath>
+#include <libfauxdcore/ringbuf.h>
 #include <libfauxdcore/runtime.h>
 
 class LoudnessFrameProcessor
@@ -44,8 +46,9 @@ class LoudnessFrameProcessor
     float perception_slow_balance = 0.3;
     float minimum_detection = 1e-6;
     RingBuf<float> read_ahead_buffer;
+    Index<float> gains;
     int channels_ = 0;
-    int processed_frames = 0;
+    int config_generation = -1;
 
     static float get_clamped_value(const char * variable, const double minimum,
                                    const double maximum)
@@ -84,7 +87,6 @@ public:
     {
         update_config();
         channels_ = channels;
-        processed_frames = 0;
         release_integration.set_seconds_for_rate(SHORT_INTEGRATION, rate, 0);
         long_integration.set_seconds_for_rate(LONG_INTEGRATION / 2.0, rate,
                                               slow_weight);
@@ -105,8 +107,24 @@ public:
         }
     }
 
+    /*
+     * Reading the configuration involves several lookups with locking, so it
+     * is only done when the preferences actually changed.
+     */
+    void update_config_if_changed()
+    {
+        const int generation = background_music_config_generation.load(
+            std::memory_order_acquire);
+        if (generation != config_generation)
+        {
+            update_config();
+        }
+    }
+
     void update_config()
     {
+        config_generation = background_music_config_generation.load(
+            std::memory_order_acquire);
         target_level = get_clamped_decibel_value(CONF_TARGET_LEVEL_VARIABLE,
                                                  CONF_TARGET_LEVEL_MIN,
                                                  CONF_TARGET_LEVEL_MAX);
@@ -122,61 +140,84 @@ public:
         long_integration.set_scale(slow_weight);
     }
 
-    bool process_has_output(const Index<float> & frame_in,
-                            Index<float> & frame_out)
+    /**
+     * Processes a block of interleaved frames. As the output is delayed by
+     * the read-ahead latency, fewer frames than were put in may come out; the
+     * number of output frames is returned and never exceeds frames.
+     */
+    int process(const float * in, const int frames, float * out)
     {
-        bool has_output_data = processed_frames >= latency();
-        if (has_output_data)
-        {
-            read_ahead_buffer.move_out(frame_out.begin(), channels_);
-        }
-        else
-        {
-            processed_frames++;
-        }
-        read_ahead_buffer.copy_in(frame_in.begin(), channels_);
-
         /*
-         * Following calculations need to happen to anticipate the (future)
-         * output.
+         * First run the detection over the whole block, which yields the gain
+         * to apply to the frame that leaves the read-ahead buffer as each
+         * input frame enters it.
          */
+        gains.resize(frames);
 
-        float square_sum = 0.0;
-        float square_max = 0.0;
-        for (const float sample : frame_in)
+        for (int frame = 0; frame < frames; frame++)
         {
-            const float square = sample * sample;
-            square_max = std::max(square_max, square);
-            square_sum += square;
+            const float * samples = in + frame * channels_;
+            float square_sum = 0.0;
+            float square_max = 0.0;
+            for (int channel = 0; channel < channels_; channel++)
+            {
+                const float square = samples[channel] * samples[channel];
+                square_max = std::max(square_max, square);
+                square_sum += square;
+            }
+            gains[frame] =
+                square_sum / static_cast<float>(channels_) + square_max;
         }
-        square_sum /= static_cast<float>(channels_);
-        square_sum += square_max;
-        const float perceived = FAST_VU_FUDGE_FACTOR *
-                                perceivedLoudness.get_mean_squared(square_sum);
-        const double weighted =
-            std::max(long_integration.integrate(square_sum), perceived);
 
-        const double rms = sqrt(weighted);
-
-        const float gain =
-            target_level /
-            std::max(minimum_detection,
-                     static_cast<float>(release_integration.get_envelope(rms)));
+        for (float & gain : gains)
+        {
+            const float square_sum = gain;
+            const float perceived =
+                FAST_VU_FUDGE_FACTOR *
+                perceivedLoudness.get_mean_squared(square_sum);
+            const double weighted =
+                std::max(long_integration.integrate(square_sum), perceived);
+
+            const double rms = sqrt(weighted);
+
+            gain = target_level /
+                   std::max(minimum_detection,
+                            static_cast<float>(
+                                release_integration.get_envelope(rms)));
+        }
 
-        if (has_output_data)
+        /*
+         * Then move the audio through the read-ahead buffer in bulk: output
+         * starts with whatever is buffered and continues with the start of
+         * the input, while the remainder of the input is buffered.
+         */
+        const int buffered = read_ahead_buffer.len() / channels_;
+        const int first_gain = latency() - buffered;
+        const int out_frames = std::max(0, frames - first_gain);
+        const int from_buffer = std::min(out_frames, buffered);
+        const int from_input = out_frames - from_buffer;
+
+        read_ahead_buffer.move_out(out, from_buffer * channels_);
+        std::copy(in, in + from_input * channels_,
+                  out + from_buffer * channels_);
+        read_ahead_buffer.copy_in(in + from_input * channels_,
+                                  (frames - from_input) * channels_);
+
+        for (int frame = 0; frame < out_frames; frame++)
         {
-            for (float & sample : frame_out)
+            const float gain = gains[first_gain + frame];
+            float * samples = out + frame * channels_;
+            for (int channel = 0; channel < channels_; channel++)
             {
-                sample *= gain;
+                samples[channel] *= gain;
             }
         }
 
-        return has_output_data;
+        return out_frames;
     }
 
     void flush()
     {
-        processed_frames = 0;
         read_ahead_buffer.discard();
     }
 };
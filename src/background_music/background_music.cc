@@ -24,17 +24,20 @@ static constexpr const PreferencesWidget background_music_widgets[] = {
     WidgetLabel(N_("<b>Background music</b>")),
     WidgetSpin(N_("Target level:"),
                WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC,
-                           CONF_TARGET_LEVEL_VARIABLE),
+                           CONF_TARGET_LEVEL_VARIABLE,
+                           background_music_config_changed),
                {CONF_TARGET_LEVEL_MIN, CONF_TARGET_LEVEL_MAX, 1.0, N_("dB")}),
     WidgetSpin(N_("Maximum amplification:"),
                WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC,
-                           CONF_MAX_AMPLIFICATION_VARIABLE),
+                           CONF_MAX_AMPLIFICATION_VARIABLE,
+                           background_music_config_changed),
                {CONF_MAX_AMPLIFICATION_MIN, CONF_MAX_AMPLIFICATION_MAX, 1.0,
                 N_("dB")}),
     WidgetLabel(N_("<b>Advanced</b>")),
     WidgetSpin(
         N_("Slow detection weight:"),
-        WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC, CONF_SLOW_WEIGHT_VARIABLE),
+        WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC, CONF_SLOW_WEIGHT_VARIABLE,
+                    background_music_config_changed),
         {CONF_SLOW_WEIGHT_MIN, CONF_SLOW_WEIGHT_MAX, 0.1}),
     WidgetLabel(N_("<b>Hint</b>")),
     WidgetLabel(
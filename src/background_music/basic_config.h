@@ -19,6 +19,8 @@
  * the use of this software.
  */
 
+#include <atomic>
+
 static constexpr const char * const CONFIG_SECTION_BACKGROUND_MUSIC =
     "background_music";
 
@@ -47,4 +49,16 @@ static constexpr const char * const background_music_defaults[] = {
     //
     nullptr};
 
+/*
+ * Incremented by the preferences widgets whenever a setting changes, so that
+ * the audio thread only needs to re-read the configuration when it differs
+ * from the generation it last read.
+ */
+static std::atomic<int> background_music_config_generation(0);
+
+static void background_music_config_changed()
+{
+    background_music_config_generation.fetch_add(1, std::memory_order_release);
+}
+
 #endif // AUDACIOUS_PLUGINS_BGM_BASIC_CONFIG_H
@@ -0,0 +1 @@
+#include "../ui-common/blur-scope-core.cc"
@@ -25,8 +25,6 @@
  */
 
 #include <math.h>
-#include <string.h>
-#include <glib-2.0/glib.h>
 
 #include <QWidget>
 #include <QImage>
@@ -38,6 +36,8 @@
 #include <libfauxdcore/preferences.h>
 #include <libfauxdqt/colorbutton.h>
 
+#include "../ui-common/blur-scope-core.h"
+
 static void /* QWidget */ * bscope_get_color_chooser ();
 
 static const PreferencesWidget bscope_widgets[] = {
@@ -58,96 +58,55 @@ public:
     BlurScopeWidget (QWidget * parent = nullptr);
     ~BlurScopeWidget ();
 
-    void resize (int w, int h);
-
-    void clear ();
-    void blur ();
-    void draw_vert_line (int x, int y1, int y2);
-
 protected:
     void resizeEvent (QResizeEvent *);
     void paintEvent (QPaintEvent *);
-
-private:
-    int m_width = 0, m_height = 0, m_image_size = 0;
-    uint32_t * m_image = nullptr, * m_corner = nullptr;
 };
 
 static BlurScopeWidget *s_widget = nullptr;
 
+static void redraw (void *)
+{
+    if (s_widget)
+        s_widget->update ();
+}
+
+/* frames are rendered in a separate thread; we only paint them */
+static BlurScopeCore s_core (redraw, nullptr);
+
 BlurScopeWidget::BlurScopeWidget (QWidget * parent) :
     QWidget (parent)
 {
-    resize (width (), height ());
+    s_core.resize (width (), height ());
+    s_core.start ();
 }
 
 BlurScopeWidget::~BlurScopeWidget ()
 {
-    g_free(m_image);
-    m_image = nullptr;
+    s_core.stop ();
     s_widget = nullptr;
 }
 
 void BlurScopeWidget::paintEvent (QPaintEvent *)
 {
-    QImage img((unsigned char *) m_image, m_width, m_height, QImage::Format_RGB32);
-    QPainter p (this);
-
-    p.drawImage (0, 0, img);
-}
-
-void BlurScopeWidget::resizeEvent (QResizeEvent *)
-{
-    resize (width (), height ());
-}
-
-void BlurScopeWidget::resize (int w, int h)
-{
-    m_width = w;
-    m_height = h;
-    m_image_size = (m_width << 2) * (m_height + 2);
-    m_image = (uint32_t *) g_realloc (m_image, m_image_size);
-    memset (m_image, 0, m_image_size);
-    m_corner = m_image + m_width + 1;
-}
-
-void BlurScopeWidget::clear ()
-{
-    memset (m_image, 0, m_image_size);
-    update ();
-}
+    int width, height, stride;
+    const uint32_t * frame = s_core.lock_frame (width, height, stride);
 
-void BlurScopeWidget::blur ()
-{
-    for (int y = 0; y < m_height; y ++)
+    if (frame)
     {
-        uint32_t * p = m_corner + m_width * y;
-        uint32_t * end = p + m_width;
-        uint32_t * plast = p - m_width;
-        uint32_t * pnext = p + m_width;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
+        QImage img ((const unsigned char *) frame, width, height, stride << 2,
+         QImage::Format_RGB32);
+        QPainter p (this);
+
+        p.drawImage (0, 0, img);
     }
+
+    s_core.unlock_frame ();
 }
 
-void BlurScopeWidget::draw_vert_line (int x, int y1, int y2)
+void BlurScopeWidget::resizeEvent (QResizeEvent *)
 {
-    int y, h;
-
-    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
-    else if (y2 < y1) {y = y2; h = y1 - y2;}
-    else {y = y1; h = 1;}
-
-    uint32_t * p = m_corner + y * m_width + x;
-
-    for (; h --; p += m_width)
-        * p = bscope_color;
+    s_core.resize (width (), height ());
 }
 
 class BlurScopeQt : public VisPlugin
@@ -178,6 +137,7 @@ bool BlurScopeQt::init ()
 {
     aud_config_set_defaults ("BlurScope", bscope_defaults);
     bscope_color = aud_get_int ("BlurScope", "color");
+    s_core.set_color (bscope_color);
 
     return true;
 }
@@ -185,35 +145,18 @@ bool BlurScopeQt::init ()
 void BlurScopeQt::cleanup ()
 {
     aud_set_int ("BlurScope", "color", bscope_color);
+
+    s_core.stop ();
 }
 
 void BlurScopeQt::clear ()
 {
-    if (s_widget)
-        s_widget->clear ();
+    s_core.clear ();
 }
 
 void BlurScopeQt::render_mono_pcm (const float * pcm)
 {
-    g_assert(s_widget);
-
-    s_widget->blur ();
-
-    int width = s_widget->width ();
-    int height = s_widget->height ();
-
-    int prev_y = (0.5 + pcm[0]) * height;
-    prev_y = aud::clamp (prev_y, 0, height - 1);
-
-    for (int i = 0; i < width; i ++)
-    {
-        int y = (0.5 + pcm[i * 512 / width]) * height;
-        y = aud::clamp (y, 0, height - 1);
-        s_widget->draw_vert_line (i, prev_y, y);
-        prev_y = y;
-    }
-
-    s_widget->update ();
+    s_core.add_pcm (pcm);
 }
 
 void * BlurScopeQt::get_qt_widget ()
@@ -239,6 +182,7 @@ void ColorChooserWidget::onColorChanged ()
     col.getRgb(&r, &g, &b);
 
     bscope_color = r << 16 | g << 8 | b;
+    s_core.set_color (bscope_color);
 }
 
 static void * bscope_get_color_chooser ()
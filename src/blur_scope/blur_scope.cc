@@ -24,7 +24,6 @@
  */
 
 #include <math.h>
-#include <string.h>
 
 #include <gtk/gtk.h>
 
@@ -34,6 +33,8 @@
 #include <libfauxdcore/preferences.h>
 #include <libfauxdgui/gtk-compat.h>
 
+#include "../ui-common/blur-scope-core.h"
+
 static void /* GtkWidget */ * bscope_get_color_chooser ();
 
 static const PreferencesWidget bscope_widgets[] = {
@@ -70,13 +71,11 @@ public:
     void clear ();
     void render_mono_pcm (const float * pcm);
 
+    static BlurScopeCore core;
+
 private:
-    void resize (int w, int h);
     void draw_to_cairo (cairo_t * cr);
-    void draw ();
-
-    void blur ();
-    void draw_vert_line (int x, int y1, int y2);
+    static void draw (void * user);
 
     static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event, void * user);
 #ifdef USE_GTK3
@@ -84,18 +83,21 @@ private:
 #else
     static gboolean draw_event (GtkWidget * widget, GdkEventExpose * event, void * user);
 #endif
+    static void destroy_event (GtkWidget * widget, void * user);
 
     GtkWidget * area = nullptr;
-    int width = 0, height = 0, stride = 0, image_size = 0;
-    uint32_t * image = nullptr, * corner = nullptr;
 };
 
 EXPORT BlurScope aud_plugin_instance;
 
+/* frames are rendered in a separate thread; we only draw them */
+BlurScopeCore BlurScope::core (BlurScope::draw, & aud_plugin_instance);
+
 bool BlurScope::init ()
 {
     aud_config_set_defaults ("BlurScope", bscope_defaults);
     bscope_color = aud_get_int ("BlurScope", "color");
+    core.set_color (bscope_color);
 
     return true;
 }
@@ -104,32 +106,30 @@ void BlurScope::cleanup ()
 {
     aud_set_int ("BlurScope", "color", bscope_color);
 
-    g_free (image);
-    image = nullptr;
-}
-
-void BlurScope::resize (int w, int h)
-{
-    width = w;
-    height = h;
-    stride = width + 2;
-    image_size = (stride << 2) * (height + 2);
-    image = (uint32_t *) g_realloc (image, image_size);
-    memset (image, 0, image_size);
-    corner = image + stride + 1;
+    core.stop ();
 }
 
 void BlurScope::draw_to_cairo (cairo_t * cr)
 {
-    cairo_surface_t * surf = cairo_image_surface_create_for_data
-     ((unsigned char *) image, CAIRO_FORMAT_RGB24, width, height, stride << 2);
-    cairo_set_source_surface (cr, surf, 0, 0);
-    cairo_paint (cr);
-    cairo_surface_destroy (surf);
+    int width, height, stride;
+    const uint32_t * frame = core.lock_frame (width, height, stride);
+
+    if (frame)
+    {
+        cairo_surface_t * surf = cairo_image_surface_create_for_data
+         ((unsigned char *) frame, CAIRO_FORMAT_RGB24, width, height, stride << 2);
+        cairo_set_source_surface (cr, surf, 0, 0);
+        cairo_paint (cr);
+        cairo_surface_destroy (surf);
+    }
+
+    core.unlock_frame ();
 }
 
-void BlurScope::draw ()
+void BlurScope::draw (void * user)
 {
+    GtkWidget * area = ((BlurScope *) user)->area;
+
 #ifdef USE_GTK3
     if (area)
         gtk_widget_queue_draw (area);
@@ -138,14 +138,14 @@ void BlurScope::draw ()
         return;
 
     cairo_t * cr = gdk_cairo_create (gtk_widget_get_window (area));
-    draw_to_cairo (cr);
+    ((BlurScope *) user)->draw_to_cairo (cr);
     cairo_destroy (cr);
 #endif
 }
 
 gboolean BlurScope::configure_event (GtkWidget * widget, GdkEventConfigure * event, void * user)
 {
-    ((BlurScope *) user)->resize (event->width, event->height);
+    core.resize (event->width, event->height);
     return true;
 }
 
@@ -158,80 +158,41 @@ gboolean BlurScope::draw_event (GtkWidget * widget, cairo_t * cr, void * user)
 #else
 gboolean BlurScope::draw_event (GtkWidget * widget, GdkEventExpose * event, void * user)
 {
-    ((BlurScope *) user)->draw ();
+    draw (user);
     return true;
 }
 #endif
 
+void BlurScope::destroy_event (GtkWidget * widget, void * user)
+{
+    core.stop ();
+    ((BlurScope *) user)->area = nullptr;
+}
+
 void * BlurScope::get_gtk_widget ()
 {
     area = gtk_drawing_area_new ();
 
     g_signal_connect (area, AUDGUI_DRAW_SIGNAL, (GCallback) draw_event, this);
     g_signal_connect (area, "configure-event", (GCallback) configure_event, this);
-    g_signal_connect (area, "destroy", (GCallback) gtk_widget_destroyed, & area);
+    g_signal_connect (area, "destroy", (GCallback) destroy_event, this);
 
     GtkWidget * frame = gtk_frame_new (nullptr);
     gtk_frame_set_shadow_type ((GtkFrame *) frame, GTK_SHADOW_IN);
     gtk_container_add ((GtkContainer *) frame, area);
+
+    core.start ();
     return frame;
 }
 
 void BlurScope::clear ()
 {
-    memset (image, 0, image_size);
-    draw ();
-}
-
-void BlurScope::blur ()
-{
-    for (int y = 0; y < height; y ++)
-    {
-        uint32_t * p = corner + stride * y;
-        uint32_t * end = p + width;
-        uint32_t * plast = p - stride;
-        uint32_t * pnext = p + stride;
-
-        /* We do a quick and dirty average of four color values, first masking
-         * off the lowest two bits.  Over a large area, this masking has the net
-         * effect of subtracting 1.5 from each value, which by a happy chance
-         * is just right for a gradual fade effect. */
-        for (; p < end; p ++)
-            * p = ((* plast ++ & 0xFCFCFC) + (p[-1] & 0xFCFCFC) + (p[1] &
-             0xFCFCFC) + (* pnext ++ & 0xFCFCFC)) >> 2;
-    }
-}
-
-void BlurScope::draw_vert_line (int x, int y1, int y2)
-{
-    int y, h;
-
-    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
-    else if (y2 < y1) {y = y2; h = y1 - y2;}
-    else {y = y1; h = 1;}
-
-    uint32_t * p = corner + y * stride + x;
-
-    for (; h --; p += stride)
-        * p = bscope_color;
+    core.clear ();
 }
 
 void BlurScope::render_mono_pcm (const float * pcm)
 {
-    blur ();
-
-    int prev_y = (0.5 + pcm[0]) * height;
-    prev_y = aud::clamp (prev_y, 0, height - 1);
-
-    for (int i = 0; i < width; i ++)
-    {
-        int y = (0.5 + pcm[i * 512 / width]) * height;
-        y = aud::clamp (y, 0, height - 1);
-        draw_vert_line (i, prev_y, y);
-        prev_y = y;
-    }
-
-    draw ();
+    core.add_pcm (pcm);
 }
 
 static void color_set_cb (GtkWidget * chooser)
@@ -249,6 +210,8 @@ static void color_set_cb (GtkWidget * chooser)
     gtk_color_button_get_color ((GtkColorButton *) chooser, & gdk_color);
     bscope_color = ((gdk_color.red & 0xff00) << 8) | (gdk_color.green & 0xff00) | (gdk_color.blue >> 8);
 #endif
+
+    BlurScope::core.set_color (bscope_color);
 }
 
 static void /* GtkWidget */ * bscope_get_color_chooser ()
@@ -60,11 +60,13 @@ extern "C" {
 #include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
 
+#include "sector-reader.h"
+#include "toc-cache.h"
+
 #define MIN_DISC_SPEED 2
 #define MAX_DISC_SPEED 24
 
-#define MAX_RETRIES 10
-#define MAX_SKIPS 10
+#define READ_AHEAD_SECONDS 4
 
 static const char * const cdaudio_schemes[] = {"cdda", nullptr};
 
@@ -121,6 +123,8 @@ static Index<trackinfo_t> trackinfo;
 static QueuedFunc purge_func;
 
 static bool scan_cd ();
+static bool load_cached_info (const char * key);
+static void store_cached_info (const char * key);
 static bool refresh_trackinfo (bool warning);
 static void reset_trackinfo ();
 static int calculate_track_length (int startlsn, int endlsn);
@@ -140,6 +144,7 @@ const char * const CDAudio::defaults[] = {
  "disc_speed", "2",
  "use_cdtext", "TRUE",
  "use_cddb", "TRUE",
+ "use_disc_cache", "TRUE",
  "cddbhttp", "FALSE",
  "cddbserver", "gnudb.gnudb.org",  // SEE: https://www.gnudb.org/
  "cddbport", "8880",
@@ -174,6 +179,8 @@ const PreferencesWidget CDAudio::widgets[] = {
         WidgetInt ("CDDA", "cddbport"),
         {0, 65535, 1},
         WIDGET_CHILD),
+    WidgetCheck (N_("Remember discs (for use offline)"),
+        WidgetBool ("CDDA", "use_disc_cache")),
     WidgetCheck (N_("Allow Custom Tag-files"),
         WidgetBool ("CDDA", "use_customtagfiles")),
     WidgetCheck (N_("Seek Track Albumart (ymmv)"),
@@ -295,64 +302,44 @@ bool CDAudio::play (const char * name, VFSFile & file)
     int speed = aud_get_int ("CDDA", "disc_speed");
     speed = aud::clamp (speed, MIN_DISC_SPEED, MAX_DISC_SPEED);
     int sectors = aud::clamp (buffer_size / 2, 50, 250) * speed * 75 / 1000;
-    int currlsn = startlsn;
-    int retry_count = 0, skip_count = 0;
 
-    Index<unsigned char> buffer;
-    buffer.insert (0, 2352 * sectors);
+    /* the reader thread keeps a few seconds ahead, so that a scratch does not
+     * stall playback while it is retried */
+    int read_ahead = aud::max (READ_AHEAD_SECONDS * 75, 2 * sectors);
+    int chunk = aud::min (sectors, 75);
 
-    while (! check_stop ())
-    {
-        int seek_time = check_seek ();
-        if (seek_time >= 0)
-            currlsn = startlsn + (seek_time * 75 / 1000);
+    Index<unsigned char> buffer;
+    buffer.insert (0, SECTOR_SIZE * chunk);
 
-        sectors = aud::min (sectors, endlsn + 1 - currlsn);
-        if (sectors < 1)
-            break;
+    /* unlock mutex here to avoid blocking
+     * other threads must be careful not to close drive handle */
+    pthread_mutex_unlock (& mutex);
 
-        /* unlock mutex here to avoid blocking
-         * other threads must be careful not to close drive handle */
-        pthread_mutex_unlock (& mutex);
+    {
+        SectorReader reader (pcdrom_drive->p_cdio, startlsn, endlsn, sectors, read_ahead);
 
-        int ret = cdio_read_audio_sectors (pcdrom_drive->p_cdio,
-         buffer.begin (), currlsn, sectors);
+        while (! check_stop ())
+        {
+            int seek_time = check_seek ();
+            if (seek_time >= 0)
+                reader.seek (startlsn + (seek_time * 75 / 1000));
 
-        if (ret == DRIVER_OP_SUCCESS)
-            write_audio (buffer.begin (), 2352 * sectors);
+            int got = reader.read (buffer.begin (), chunk);
+            if (got < 0)
+            {
+                if (reader.failed ())
+                    cdaudio_error (_("Error reading audio CD."));
 
-        pthread_mutex_lock (& mutex);
+                break;
+            }
 
-        if (ret == DRIVER_OP_SUCCESS)
-        {
-            currlsn += sectors;
-            retry_count = 0;
-            skip_count = 0;
-        }
-        else if (sectors > 16)
-        {
-            /* maybe a smaller read size will help */
-            sectors /= 2;
-        }
-        else if (retry_count < MAX_RETRIES)
-        {
-            /* still failed; retry a few times */
-            retry_count ++;
-        }
-        else if (skip_count < MAX_SKIPS)
-        {
-            /* maybe the disk is scratched; try skipping ahead */
-            currlsn = aud::min (currlsn + 75, endlsn + 1);
-            skip_count ++;
-        }
-        else
-        {
-            /* still failed; give it up */
-            cdaudio_error (_("Error reading audio CD."));
-            break;
+            if (got > 0)
+                write_audio (buffer.begin (), SECTOR_SIZE * got);
         }
     }
 
+    pthread_mutex_lock (& mutex);
+
     playing = false;
 
     pthread_mutex_unlock (& mutex);
@@ -799,9 +786,57 @@ static bool scan_cd ()
             n_audio_tracks++;
     }
 
+    String disc_key;
+
+    // JWT: FETCH DISK-ID ANYWAY FOR COVERART QUERY:
+    if (! trackinfo[0].discidstr)
+    {
+        cddb_disc_t *pcddb_disc = nullptr;
+        cddb_track_t *pcddb_track = nullptr;
+        lba_t lba;              /* Logical Block Address */
+        Index<int> lbas;
+
+        pcddb_disc = cddb_disc_new ();
+
+        lba = cdio_get_track_lba (pcdrom_drive->p_cdio,
+                                  CDIO_CDROM_LEADOUT_TRACK);
+        cddb_disc_set_length (pcddb_disc, FRAMES_TO_SECONDS (lba));
+
+        for (int trackno = firsttrackno; trackno <= lasttrackno; trackno++)
+        {
+            pcddb_track = cddb_track_new ();
+            cddb_track_set_frame_offset (pcddb_track,
+                                         cdio_get_track_lba (
+                                             pcdrom_drive->p_cdio,
+                                             trackno));
+            cddb_disc_add_track (pcddb_disc, pcddb_track);
+            lbas.append (cdio_get_track_lba (pcdrom_drive->p_cdio, trackno));
+        }
+
+        lbas.append (lba);
+        cddb_disc_calc_discid (pcddb_disc);
+
+        unsigned discid = cddb_disc_get_discid (pcddb_disc);
+        cddb_disc_destroy (pcddb_disc);
+        AUDINFO ("CDDB2 disc id = %x\n", discid);
+        disc_key = String (toc_cache_key (discid, lbas));
+        trackinfo[0].discidstr = String (str_printf("%x", discid));
+        if (trackinfo[0].discidstr && trackinfo[0].discidstr[0])
+            aud_set_str (nullptr, "playingdiskid", trackinfo[0].discidstr);
+        else
+        {
+            AUDINFO ("w:no Disc ID available (no custom tag file possible & edits saved to tmp_tag_data)!\n");
+            aud_set_str (nullptr, "playingdiskid", "tmp_tag_data");
+        }
+    }
+
+    /* discs seen before need neither CD-Text nor CDDB */
+    bool use_disc_cache = aud_get_bool ("CDDA", "use_disc_cache") && disc_key;
+    bool cached = use_disc_cache && load_cached_info (disc_key);
+
     /* get trackinfo[0] cdtext information (the disc) */
     cdtext_t *pcdtext = nullptr;
-    if (aud_get_bool ("CDDA", "use_cdtext"))
+    if (! cached && aud_get_bool ("CDDA", "use_cdtext"))
     {
         AUDDBG ("getting cd-text information for disc\n");
 #if LIBCDIO_VERSION_NUM >= 90
@@ -832,7 +867,7 @@ static bool scan_cd ()
     for (int trackno = firsttrackno; trackno <= lasttrackno; trackno++)
     {
 #if LIBCDIO_VERSION_NUM < 90
-        if (aud_get_bool ("CDDA", "use_cdtext"))
+        if (! cached && aud_get_bool ("CDDA", "use_cdtext"))
         {
             AUDDBG ("getting cd-text information for track %d\n", trackno);
             pcdtext = cdio_get_cdtext (pcdrom_drive->p_cdio, trackno);
@@ -860,44 +895,7 @@ static bool scan_cd ()
         }
     }
 
-    // JWT: FETCH DISK-ID ANYWAY FOR COVERART QUERY:
-    if (! trackinfo[0].discidstr)
-    {
-        cddb_disc_t *pcddb_disc = nullptr;
-        cddb_track_t *pcddb_track = nullptr;
-        lba_t lba;              /* Logical Block Address */
-
-        pcddb_disc = cddb_disc_new ();
-
-        lba = cdio_get_track_lba (pcdrom_drive->p_cdio,
-                                  CDIO_CDROM_LEADOUT_TRACK);
-        cddb_disc_set_length (pcddb_disc, FRAMES_TO_SECONDS (lba));
-
-        for (int trackno = firsttrackno; trackno <= lasttrackno; trackno++)
-        {
-            pcddb_track = cddb_track_new ();
-            cddb_track_set_frame_offset (pcddb_track,
-                                         cdio_get_track_lba (
-                                             pcdrom_drive->p_cdio,
-                                             trackno));
-            cddb_disc_add_track (pcddb_disc, pcddb_track);
-        }
-
-        cddb_disc_calc_discid (pcddb_disc);
-
-        unsigned discid = cddb_disc_get_discid (pcddb_disc);
-        AUDINFO ("CDDB2 disc id = %x\n", discid);
-        trackinfo[0].discidstr = String (str_printf("%x", discid));
-        if (trackinfo[0].discidstr && trackinfo[0].discidstr[0])
-            aud_set_str (nullptr, "playingdiskid", trackinfo[0].discidstr);
-        else
-        {
-            AUDINFO ("w:no Disc ID available (no custom tag file possible & edits saved to tmp_tag_data)!\n");
-            aud_set_str (nullptr, "playingdiskid", "tmp_tag_data");
-        }
-    }
-
-    if (! cdtext_was_available)
+    if (! cached && ! cdtext_was_available)
     {
         if (aud_get_bool ("CDDA", "use_cdtext"))
             AUDERR ("i:No CD-text data available on disk.\n");
@@ -1055,16 +1053,58 @@ static bool scan_cd ()
             cddb_destroy (pcddb_conn);
     }
 
+    if (use_disc_cache && ! cached)
+        store_cached_info (disc_key);
+
     return true;
 }
 
+/* mutex must be locked */
+static bool load_cached_info (const char * key)
+{
+    Index<TocCacheEntry> entries;
+    if (! toc_cache_lookup (key, entries) || entries.len () != trackinfo.len ())
+        return false;
+
+    for (int trackno = 0; trackno < entries.len (); trackno++)
+    {
+        trackinfo[trackno].performer = entries[trackno].performer;
+        trackinfo[trackno].name = entries[trackno].name;
+        trackinfo[trackno].genre = entries[trackno].genre;
+
+        if (entries[trackno].performer || entries[trackno].name || entries[trackno].genre)
+            trackinfo[trackno].tag_source = 1; // WE FETCHED FROM THE CACHE (ORIGINALLY CD[-TEXT|DB]).
+    }
+
+    return true;
+}
+
+/* mutex must be locked */
+static void store_cached_info (const char * key)
+{
+    Index<TocCacheEntry> entries;
+    bool found = false;
+
+    for (const trackinfo_t & info : trackinfo)
+    {
+        entries.append (TocCacheEntry {info.performer, info.name, info.genre});
+        if (info.tag_source == 1)
+            found = true;
+    }
+
+    /* don't remember that nothing was found; CDDB may know more later */
+    if (found)
+        toc_cache_store (key, entries);
+}
+
 /* mutex must be locked */
 static bool refresh_trackinfo (bool warning)
 {
     if (! open_cd () || ! check_disc_mode (warning))
         goto fail;
 
-    if (! trackinfo.len () || cdio_get_media_changed (pcdrom_drive->p_cdio))
+    /* disc images (BIN/CUE, NRG, ...) answer DRIVER_OP_UNSUPPORTED here */
+    if (! trackinfo.len () || cdio_get_media_changed (pcdrom_drive->p_cdio) > 0)
     {
         if (! scan_cd ())
             goto fail;
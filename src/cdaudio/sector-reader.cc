@@ -0,0 +1,301 @@
+/*
+ * Audio CD Plugin - read-ahead thread
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; under version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include <string.h>
+#include <time.h>
+
+/* prevent libcdio from redefining PACKAGE, VERSION, etc. */
+#define EXTERNAL_LIBCDIO_CONFIG_H
+
+#include <cdio/cdio.h>
+#include <cdio/audio.h>
+
+#include <libfauxdcore/runtime.h>
+
+#include "sector-reader.h"
+
+#define MAX_RETRIES 10     /* for a single sector */
+#define MAX_REAPPROACH 4   /* sectors to seek back by when retrying */
+#define MAX_LOST 4         /* sectors lost in a row before skipping ahead */
+#define MAX_SKIPS 10       /* seconds skipped in a row before giving up */
+#define SKIP_SECTORS 75
+
+#define WAIT_MS 100        /* for read() to wait for the reader */
+
+SectorReader::SectorReader (CdIo_t * cdio, int startlsn, int endlsn, int block, int capacity) :
+    m_cdio (cdio),
+    m_startlsn (startlsn),
+    m_endlsn (endlsn),
+    m_max_block (aud::clamp (block, 1, capacity)),
+    m_capacity (capacity),
+    m_next_lsn (startlsn),
+    m_block (m_max_block)
+{
+    pthread_mutex_init (& m_mutex, nullptr);
+    pthread_cond_init (& m_cond, nullptr);
+
+    m_ring.insert (0, SECTOR_SIZE * m_capacity);
+    m_block_buf.insert (0, SECTOR_SIZE * aud::max (m_max_block, SKIP_SECTORS));
+    m_retry_buf.insert (0, SECTOR_SIZE * (MAX_REAPPROACH + 1));
+
+    pthread_create (& m_thread, nullptr, run_cb, this);
+}
+
+SectorReader::~SectorReader ()
+{
+    pthread_mutex_lock (& m_mutex);
+    m_stop = true;
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    /* a read already started cannot be interrupted */
+    pthread_join (m_thread, nullptr);
+
+    log_errors ();
+
+    pthread_cond_destroy (& m_cond);
+    pthread_mutex_destroy (& m_mutex);
+}
+
+void SectorReader::seek (int lsn)
+{
+    pthread_mutex_lock (& m_mutex);
+
+    m_serial ++;
+    m_head = m_count = 0;
+    m_next_lsn = aud::clamp (lsn, m_startlsn, m_endlsn + 1);
+    m_failed = false;
+
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+int SectorReader::read (unsigned char * buf, int max)
+{
+    pthread_mutex_lock (& m_mutex);
+
+    if (! m_count && ! m_failed && m_next_lsn <= m_endlsn)
+    {
+        timespec ts {};
+        clock_gettime (CLOCK_REALTIME, & ts);
+
+        ts.tv_nsec += WAIT_MS * 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec ++;
+            ts.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait (& m_cond, & m_mutex, & ts);
+    }
+
+    int n;
+
+    if (m_count)
+    {
+        n = aud::min (max, m_count);
+
+        int first = aud::min (n, m_capacity - m_head);
+        memcpy (buf, & m_ring[SECTOR_SIZE * m_head], SECTOR_SIZE * first);
+        memcpy (buf + SECTOR_SIZE * first, m_ring.begin (), SECTOR_SIZE * (n - first));
+
+        m_head = (m_head + n) % m_capacity;
+        m_count -= n;
+
+        pthread_cond_broadcast (& m_cond);
+    }
+    else
+        n = (m_failed || m_next_lsn > m_endlsn) ? -1 : 0;
+
+    pthread_mutex_unlock (& m_mutex);
+    return n;
+}
+
+bool SectorReader::failed ()
+{
+    pthread_mutex_lock (& m_mutex);
+    bool failed = m_failed;
+    pthread_mutex_unlock (& m_mutex);
+    return failed;
+}
+
+bool SectorReader::interrupted (int serial)
+{
+    pthread_mutex_lock (& m_mutex);
+    bool interrupted = m_stop || serial != m_serial;
+    pthread_mutex_unlock (& m_mutex);
+    return interrupted;
+}
+
+void SectorReader::run ()
+{
+    int last_serial = -1;
+
+    pthread_mutex_lock (& m_mutex);
+
+    while (! m_stop)
+    {
+        if (m_failed || m_count == m_capacity || m_next_lsn > m_endlsn)
+        {
+            pthread_cond_wait (& m_cond, & m_mutex);
+            continue;
+        }
+
+        int lsn = m_next_lsn;
+        int serial = m_serial;
+        int room = aud::min (m_capacity - m_count, m_endlsn + 1 - lsn);
+
+        /* after seeking, start over with full-sized reads */
+        if (serial != last_serial)
+        {
+            m_block = m_max_block;
+            m_lost_run = m_skips = 0;
+            last_serial = serial;
+        }
+
+        /* unlock mutex here so that playback can go on meanwhile */
+        pthread_mutex_unlock (& m_mutex);
+
+        int got = read_block (lsn, aud::min (m_block, room), room, serial);
+
+        pthread_mutex_lock (& m_mutex);
+
+        /* seeked meanwhile; what was read is of no use */
+        if (serial != m_serial)
+            continue;
+
+        if (got < 0)
+        {
+            m_failed = true;
+            pthread_cond_broadcast (& m_cond);
+            continue;
+        }
+
+        int tail = (m_head + m_count) % m_capacity;
+        int first = aud::min (got, m_capacity - tail);
+        memcpy (& m_ring[SECTOR_SIZE * tail], m_block_buf.begin (), SECTOR_SIZE * first);
+        memcpy (m_ring.begin (), & m_block_buf[SECTOR_SIZE * first], SECTOR_SIZE * (got - first));
+
+        m_count += got;
+        m_next_lsn += got;
+
+        if (got)
+            pthread_cond_broadcast (& m_cond);
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+}
+
+/* returns the number of sectors now in m_block_buf (0 to try again with a
+ * smaller read), or -1 if the disc cannot be read any further */
+int SectorReader::read_block (int lsn, int sectors, int room, int serial)
+{
+    if (cdio_read_audio_sectors (m_cdio, m_block_buf.begin (), lsn, sectors) == DRIVER_OP_SUCCESS)
+    {
+        m_block = aud::min (m_block * 2, m_max_block);
+        m_lost_run = m_skips = 0;
+        return sectors;
+    }
+
+    if (sectors > 1)
+    {
+        /* narrow down where the error is */
+        m_block = sectors / 2;
+        return 0;
+    }
+
+    return retry_sector (lsn, room, serial);
+}
+
+int SectorReader::retry_sector (int lsn, int room, int serial)
+{
+    if (m_lost_run >= MAX_LOST)
+    {
+        /* the disc is damaged here; rather than spend ages on every sector,
+         * skip over the next second */
+        if (m_skips >= MAX_SKIPS)
+        {
+            AUDERR ("Too many unreadable sectors, giving up at %d.\n", lsn);
+            return -1;
+        }
+
+        int n = aud::min (SKIP_SECTORS, room);
+        AUDWARN ("Skipping sectors %d to %d.\n", lsn, lsn + n - 1);
+
+        memset (m_block_buf.begin (), 0, SECTOR_SIZE * n);
+        for (int i = 0; i < n; i ++)
+            m_errors.append (SectorError {lsn + i, 0, true});
+
+        m_lost_run = 0;
+        m_skips ++;
+        return n;
+    }
+
+    /* in the middle of a damaged stretch, don't dwell on each sector */
+    int retries = m_lost_run ? 0 : MAX_RETRIES;
+
+    for (int i = 1; i <= retries; i ++)
+    {
+        if (interrupted (serial))
+            return 0;
+
+        /* drives lose track of the exact position after an error (jitter), so
+         * approach the sector from a little further back each time */
+        int back = aud::min (aud::min (i, MAX_REAPPROACH), lsn - m_startlsn);
+
+        if (cdio_read_audio_sectors (m_cdio, m_retry_buf.begin (), lsn - back,
+         back + 1) == DRIVER_OP_SUCCESS)
+        {
+            AUDDBG ("Sector %d read after %d retries.\n", lsn, i);
+
+            memcpy (m_block_buf.begin (), & m_retry_buf[SECTOR_SIZE * back], SECTOR_SIZE);
+            m_errors.append (SectorError {lsn, i, false});
+            m_lost_run = 0;
+            return 1;
+        }
+    }
+
+    AUDWARN ("Sector %d could not be read, replaced by silence.\n", lsn);
+
+    memset (m_block_buf.begin (), 0, SECTOR_SIZE);
+    m_errors.append (SectorError {lsn, retries, true});
+    m_lost_run ++;
+    return 1;
+}
+
+void SectorReader::log_errors ()
+{
+    if (! m_errors.len ())
+        return;
+
+    int recovered = 0, lost = 0, retries = 0;
+
+    for (const SectorError & error : m_errors)
+    {
+        retries += error.retries;
+        if (error.lost)
+            lost ++;
+        else
+            recovered ++;
+    }
+
+    AUDINFO ("Read errors: %d sector(s) recovered, %d lost; %d retries in all.\n",
+     recovered, lost, retries);
+
+    for (const SectorError & error : m_errors)
+        AUDDBG (" - sector %d: %d retries%s\n", error.lsn, error.retries,
+         error.lost ? ", lost" : "");
+}
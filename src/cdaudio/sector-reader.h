@@ -0,0 +1,94 @@
+/*
+ * Audio CD Plugin - read-ahead thread
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; under version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef CDAUDIO_SECTOR_READER_H
+#define CDAUDIO_SECTOR_READER_H
+
+#include <pthread.h>
+
+#include <libfauxdcore/index.h>
+
+#define SECTOR_SIZE 2352
+
+typedef struct _CdIo CdIo_t;
+
+/* Reads the sectors of one track from a thread of its own, into a ring
+ * buffer kept ahead of playback, so that a slow or failing read does not stop
+ * the audio until the buffer runs dry.
+ *
+ * Reads start with the given number of sectors, are halved on each error down
+ * to a single sector, and doubled again on each success.  A single sector that
+ * cannot be read is retried, each time starting a few sectors earlier so that
+ * the drive seeks back and syncs up again; if it still cannot be read, it is
+ * replaced by silence, and after a run of such sectors, a whole second is
+ * skipped over.  Sectors needing retries are logged when the reader is
+ * destroyed. */
+class SectorReader
+{
+public:
+    SectorReader (CdIo_t * cdio, int startlsn, int endlsn, int block, int capacity);
+    ~SectorReader ();
+
+    /* drops what was read ahead and goes on from lsn */
+    void seek (int lsn);
+
+    /* copies up to max sectors into buf, waiting a little if none are there
+     * yet; returns the number copied, 0 if none were ready, or -1 at the end
+     * of the track (see failed()) */
+    int read (unsigned char * buf, int max);
+
+    bool failed ();
+
+private:
+    struct SectorError {
+        int lsn;
+        int retries;
+        bool lost;     /* replaced by silence */
+    };
+
+    CdIo_t * m_cdio;
+    const int m_startlsn, m_endlsn;
+    const int m_max_block, m_capacity;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    pthread_t m_thread;
+    bool m_stop = false;
+
+    /* lock the mutex to read / set these */
+    Index<unsigned char> m_ring;
+    int m_head = 0, m_count = 0;  /* in sectors */
+    int m_next_lsn;               /* next one to be read */
+    int m_serial = 0;             /* bumped by seeking */
+    bool m_failed = false;
+
+    /* reader thread only */
+    Index<unsigned char> m_block_buf, m_retry_buf;
+    int m_block;
+    int m_lost_run = 0, m_skips = 0;
+    Index<SectorError> m_errors;
+
+    static void * run_cb (void * me)
+        { ((SectorReader *) me)->run (); return nullptr; }
+
+    void run ();
+    int read_block (int lsn, int sectors, int room, int serial);
+    int retry_sector (int lsn, int room, int serial);
+    bool interrupted (int serial);
+    void log_errors ();
+};
+
+#endif
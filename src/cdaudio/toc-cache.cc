@@ -0,0 +1,165 @@
+/*
+ * Audio CD Plugin - disc information cache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; under version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/runtime.h>
+#include <libfauxdcore/vfs.h>
+
+#include "toc-cache.h"
+
+/* The cache is a single text file in the config directory, appended to
+ * whenever information is found for a new disc:
+ *
+ *   disc <key> <entries>
+ *   <performer> TAB <name> TAB <genre>    (once per entry)
+ *
+ * A disc is only looked up once per insertion, so the file is simply read
+ * through; if a disc is listed more than once, the last listing wins. */
+
+static StringBuf cache_uri ()
+{
+    return filename_to_uri (filename_build ({aud_get_path (AudPath::UserDir), "cdda-disc-cache"}));
+}
+
+StringBuf toc_cache_key (unsigned discid, const Index<int> & lbas)
+{
+    /* FNV-1a */
+    unsigned hash = 2166136261u;
+    for (int lba : lbas)
+    {
+        for (int i = 0; i < 4; i ++)
+        {
+            hash ^= (lba >> (i * 8)) & 0xff;
+            hash *= 16777619u;
+        }
+    }
+
+    return str_printf ("%08x-%d-%08x", discid, lbas.len () - 1, hash);
+}
+
+static String field (const char * start, const char * end)
+{
+    return (end > start) ? String (str_copy (start, end - start)) : String ();
+}
+
+static void parse_entry (const char * line, const char * end, TocCacheEntry & entry)
+{
+    const char * tab1 = (const char *) memchr (line, '\t', end - line);
+    const char * tab2 = tab1 ? (const char *) memchr (tab1 + 1, '\t', end - tab1 - 1) : nullptr;
+
+    if (! tab2)
+    {
+        entry = TocCacheEntry ();
+        return;
+    }
+
+    entry.performer = field (line, tab1);
+    entry.name = field (tab1 + 1, tab2);
+    entry.genre = field (tab2 + 1, end);
+}
+
+bool toc_cache_lookup (const char * key, Index<TocCacheEntry> & entries)
+{
+    StringBuf uri = cache_uri ();
+    if (! VFSFile::test_file (uri, VFS_EXISTS))
+        return false;
+
+    VFSFile file (uri, "r");
+    if (! file)
+        return false;
+
+    Index<char> data = file.read_all ();
+    data.append (0);
+
+    StringBuf header = str_concat ({"disc ", key, " "});
+    int header_len = strlen (header);
+    bool found = false;
+
+    const char * p = data.begin ();
+    while (* p)
+    {
+        const char * end = strchr (p, '\n');
+        if (! end)
+            end = p + strlen (p);
+
+        if (end - p > header_len && ! strncmp (p, header, header_len))
+        {
+            int n = atoi (p + header_len);
+            const char * q = (* end) ? end + 1 : end;
+
+            entries.clear ();
+            entries.insert (0, aud::max (n, 0));
+
+            for (int i = 0; i < n && * q; i ++)
+            {
+                const char * line_end = strchr (q, '\n');
+                if (! line_end)
+                    line_end = q + strlen (q);
+
+                parse_entry (q, line_end, entries[i]);
+                q = (* line_end) ? line_end + 1 : line_end;
+            }
+
+            found = true;
+        }
+
+        p = (* end) ? end + 1 : end;
+    }
+
+    if (found)
+        AUDINFO ("Disc %s found in cache.\n", key);
+
+    return found;
+}
+
+/* tabs and line breaks would break the file up wrong */
+static StringBuf clean (const char * str)
+{
+    StringBuf buf = str_copy (str ? str : "");
+    for (char * c = buf; * c; c ++)
+    {
+        if (* c == '\t' || * c == '\n' || * c == '\r')
+            * c = ' ';
+    }
+
+    return buf;
+}
+
+void toc_cache_store (const char * key, const Index<TocCacheEntry> & entries)
+{
+    VFSFile file (cache_uri (), "a");
+    if (! file)
+    {
+        AUDWARN ("Cannot write to the disc cache.\n");
+        return;
+    }
+
+    StringBuf text = str_printf ("disc %s %d\n", key, entries.len ());
+
+    for (const TocCacheEntry & entry : entries)
+    {
+        text.combine (str_concat ({clean (entry.performer), "\t", clean (entry.name),
+         "\t", clean (entry.genre), "\n"}));
+    }
+
+    if (file.fwrite (text, 1, text.len ()) != text.len ())
+        AUDWARN ("Cannot write to the disc cache.\n");
+    else
+        AUDINFO ("Disc %s added to cache.\n", key);
+}
@@ -0,0 +1,41 @@
+/*
+ * Audio CD Plugin - disc information cache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; under version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef CDAUDIO_TOC_CACHE_H
+#define CDAUDIO_TOC_CACHE_H
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/objects.h>
+
+struct TocCacheEntry
+{
+    String performer;
+    String name;
+    String genre;
+};
+
+/* The CDDB disc ID is computed from the track offsets rounded to seconds, so
+ * different discs sometimes share one.  The key adds the number of tracks and
+ * a hash of the exact offsets (lbas holds the start of each track and then
+ * the lead-out). */
+StringBuf toc_cache_key (unsigned discid, const Index<int> & lbas);
+
+/* entries[0] is the disc, entries[n] track n; returns false if the disc has
+ * not been seen before */
+bool toc_cache_lookup (const char * key, Index<TocCacheEntry> & entries);
+void toc_cache_store (const char * key, const Index<TocCacheEntry> & entries);
+
+#endif
@@ -13,6 +13,8 @@
 #include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/runtime.h>
 
+#include "../ui-common/length-scanner.h"
+
 #include "configure.h"
 #include "plugin.h"
 #include "Music_Emu.h"
@@ -21,6 +23,15 @@
 static const int fade_threshold = 10 * 1000;
 static const int fade_length    = 8 * 1000;
 
+// length detection: nothing is heard, so a low sample rate is fine, and a
+// detected end needs only a short fade since the sound has died away
+static const int scan_sample_rate = 22050;
+static const int scan_fade_length = 1000;
+
+static int scan_track_length(const char *filename, const Index<char> &data, int track);
+
+LengthScanner console_length_scanner("console", scan_track_length);
+
 static bool log_err(blargg_err_t err)
 {
     if (err)
@@ -49,9 +60,12 @@ public:
     // Parses path and identifies file type
     ConsoleFileHandler(const char* path, VFSFile &fd);
 
+    // Same, for a file already read into memory
+    ConsoleFileHandler(const char* path, const Index<char> &data);
+
     // Creates emulator and returns 0. If this wasn't a music file or
     // emulator couldn't be created, returns 1.
-    int load(int sample_rate);
+    int load(int sample_rate, int quality = gme_quality_normal);
 
     // Deletes owned emu and closes file
     ~ConsoleFileHandler();
@@ -59,10 +73,31 @@ public:
 private:
     char m_header[4];
     Vfs_File_Reader vfs_in;
+    SmartPtr<Mem_File_Reader> mem_in;
     Gzip_Reader gzip_in;
+
+    void parse_path(const char *path);
+    void identify(File_Reader *in);
 };
 
 ConsoleFileHandler::ConsoleFileHandler(const char *path, VFSFile &fd)
+{
+    parse_path(path);
+
+    // open vfs
+    vfs_in.reset(fd);
+    identify(&vfs_in);
+}
+
+ConsoleFileHandler::ConsoleFileHandler(const char *path, const Index<char> &data)
+{
+    parse_path(path);
+
+    mem_in.capture(new Mem_File_Reader(data.begin(), data.len()));
+    identify(mem_in.get());
+}
+
+void ConsoleFileHandler::parse_path(const char *path)
 {
     m_emu   = nullptr;
     m_type  = 0;
@@ -73,12 +108,12 @@ ConsoleFileHandler::ConsoleFileHandler(const char *path, VFSFile &fd)
     m_path = String (str_copy (path, sub - path));
 
     m_track -= 1;
+}
 
-    // open vfs
-    vfs_in.reset(fd);
-
-    // now open gzip_reader on top of vfs
-    if (log_err(gzip_in.open(&vfs_in)))
+void ConsoleFileHandler::identify(File_Reader *in)
+{
+    // now open gzip_reader on top of the file
+    if (log_err(gzip_in.open(in)))
         return;
 
     // read and identify header
@@ -99,12 +134,12 @@ ConsoleFileHandler::~ConsoleFileHandler()
     gme_delete(m_emu);
 }
 
-int ConsoleFileHandler::load(int sample_rate)
+int ConsoleFileHandler::load(int sample_rate, int quality)
 {
     if (!m_type)
         return 1;
 
-    m_emu = gme_new_emu(m_type, sample_rate);
+    m_emu = gme_new_emu_quality(m_type, sample_rate, quality);
     if (m_emu == nullptr)
     {
         log_err("Out of memory allocating emulator engine. Fatal error.");
@@ -144,6 +179,11 @@ int ConsoleFileHandler::load(int sample_rate)
     return 0;
 }
 
+static bool has_track_length(const track_info_t &info)
+{
+    return info.length > 0 || info.intro_length + 2 * info.loop_length > 0;
+}
+
 static int get_track_length(const track_info_t &info)
 {
     int length = info.length;
@@ -158,6 +198,48 @@ static int get_track_length(const track_info_t &info)
     return length;
 }
 
+// Runs on a length scanner thread.  The emulator is left to play through
+// silence, so that the end is found by SilenceTracker.
+static int scan_track_length(const char *filename, const Index<char> &data, int track)
+{
+    ConsoleFileHandler fh(filename, data);
+
+    // the length doesn't depend on how well it sounds
+    if (fh.load(fh.m_type == gme_spc_type ? 32000 : scan_sample_rate, gme_quality_fast))
+        return -1;
+
+    fh.m_emu->ignore_silence();
+    if (log_err(fh.m_emu->start_track(track)))
+        return -1;
+
+    SilenceTracker tracker(fh.m_emu->sample_rate(), 2);
+
+    int const buf_size = 4096;
+    Music_Emu::sample_t buf[buf_size];
+
+    while (!console_length_scanner.cancelled())
+    {
+        if (fh.m_emu->play(buf_size, buf) || !tracker.feed(buf, buf_size) ||
+         fh.m_emu->track_ended())
+            break;
+    }
+
+    return tracker.length_ms(fh.m_emu->track_ended());
+}
+
+// length found by an earlier scan, or -1; reads the whole file
+static int get_scanned_length(const char *filename, VFSFile &file, int track, bool queue)
+{
+    if (file.fseek(0, VFS_SEEK_SET) < 0)
+        return -1;
+
+    int length;
+    if (!console_length_scanner.get_length(filename, file.read_all(), track, length, queue))
+        return -1;
+
+    return length;
+}
+
 bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image)
 {
     ConsoleFileHandler fh(filename, file);
@@ -191,7 +273,18 @@ bool ConsolePlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple,
     else
         tuple.set_subtunes(info.track_count, nullptr);
 
-    tuple.set_int (Tuple::Length, get_track_length (info));
+    int length = get_track_length (info);
+
+    // an entry that will be split into subtunes is not worth scanning
+    if (audcfg.scan_lengths && !has_track_length(info) &&
+     (fh.m_track >= 0 || info.track_count == 1))
+    {
+        int scanned = get_scanned_length(filename, file, aud::max(fh.m_track, 0), true);
+        if (scanned > 0)
+            length = scanned;
+    }
+
+    tuple.set_int (Tuple::Length, length);
     tuple.set_int (Tuple::Channels, 2);
 
     return true;
@@ -220,7 +313,7 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
         sample_rate = 44100;
 
     // create emulator and load file
-    if (fh.load(sample_rate))
+    if (fh.load(sample_rate, audcfg.resample_quality))
         return false;
 
     // stereo echo depth
@@ -244,6 +337,7 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
 
     // get info
     length = -1;
+    bool scanned = false;
     if (!log_err(fh.m_emu->track_info(&info, fh.m_track)))
     {
         if (fh.m_type == gme_spc_type && audcfg.ignore_spc_length)
@@ -251,6 +345,16 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
 
         length = get_track_length(info);
         set_stream_bitrate(fh.m_emu->voice_count() * 1000);
+
+        if (audcfg.scan_lengths && !has_track_length(info))
+        {
+            int scanned_length = get_scanned_length(filename, file, fh.m_track, false);
+            if (scanned_length > 0)
+            {
+                length = scanned_length;
+                scanned = true;
+            }
+        }
     }
 
     // start track
@@ -262,11 +366,16 @@ bool ConsolePlugin::play(const char *filename, VFSFile &file)
     open_audio(FMT_S16_NE, sample_rate, 2);
 
     // set fade time
-    if (length <= 0)
-        length = audcfg.loop_length * 1000;
-    if (length >= fade_threshold + fade_length)
-        length -= fade_length / 2;
-    fh.m_emu->set_fade(length, fade_length);
+    if (scanned)
+        fh.m_emu->set_fade(length, scan_fade_length);
+    else
+    {
+        if (length <= 0)
+            length = audcfg.loop_length * 1000;
+        if (length >= fade_threshold + fade_length)
+            length -= fade_length / 2;
+        fh.m_emu->set_fade(length, fade_length);
+    }
 
     while (!check_stop())
     {
@@ -14,6 +14,8 @@ public:
 
 	typedef short dsample_t;
 
+	// Quality is one of the gme_quality_ values; must be set before setup()
+	void set_quality( int );
 	double setup( double oversample, double rolloff, double gain );
 	blargg_err_t reset( int max_pairs );
 	void resize( int pairs_per_frame );
@@ -31,11 +33,16 @@ private:
 	int buf_pos;
 	int resampler_size;
 
-	Fir_Resampler<12> resampler;
+	Fir_Resampler<24> resampler;
 	void mix_samples( Blip_Buffer&, dsample_t* );
 	void play_frame_( Blip_Buffer&, dsample_t* );
 };
 
+inline void Dual_Resampler::set_quality( int quality )
+{
+	resampler.set_width( Fir_Resampler_::quality_width( quality, 12 ) );
+}
+
 inline double Dual_Resampler::setup( double oversample, double rolloff, double gain )
 {
 	return resampler.time_ratio( oversample, rolloff, gain * 0.5 );
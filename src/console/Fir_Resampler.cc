@@ -7,6 +7,12 @@
 #include <stdio.h>
 #include <math.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* Copyright (C) 2004-2006 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -52,9 +58,10 @@ static void gen_sinc( double rolloff, int width, double offset, double spacing,
 	}
 }
 
-Fir_Resampler_::Fir_Resampler_( int width, sample_t* impulses_ ) :
-	width_( width ),
-	write_offset( width * stereo - stereo ),
+Fir_Resampler_::Fir_Resampler_( int max_width, sample_t* impulses_ ) :
+	width_( max_width ),
+	max_width_( max_width ),
+	write_offset( max_width * stereo - stereo ),
 	impulses( impulses_ )
 {
 	write_pos = 0;
@@ -67,6 +74,24 @@ Fir_Resampler_::Fir_Resampler_( int width, sample_t* impulses_ ) :
 
 Fir_Resampler_::~Fir_Resampler_() { }
 
+void Fir_Resampler_::set_width( int width )
+{
+	require( width >= 4 && width % 2 == 0 && width <= max_width_ );
+	width_ = width;
+	write_offset = width * stereo - stereo;
+	buf.clear();
+	write_pos = 0;
+}
+
+int Fir_Resampler_::quality_width( int quality, int normal_width )
+{
+	if ( quality == quality_fast )
+		return max( (normal_width / 2 + 1) & ~1, 4 );
+	if ( quality == quality_high )
+		return normal_width * 2;
+	return normal_width;
+}
+
 void Fir_Resampler_::clear()
 {
 	imp_phase = 0;
@@ -197,3 +222,159 @@ int Fir_Resampler_::skip_input( long count )
 
 	return count;
 }
+
+#ifdef __SSE2__
+// L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 R0 R1 L2 L3 R2 R3, so that _mm_madd_epi16()
+// adds up products of the same channel
+static inline __m128i load_pairs( short const* in )
+{
+	__m128i i = _mm_loadu_si128( (__m128i const*) in );
+	i = _mm_shufflelo_epi16( i, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+	return _mm_shufflehi_epi16( i, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+}
+#endif
+
+// Accumulate products of 'width' impulse points and stereo input in extended
+// precision. The sums wrap around the same way as the scalar version, so the
+// results are identical.
+static inline void fir_mac( short const* imp, short const* in, int width,
+		blargg_long* l_out, blargg_long* r_out )
+{
+	blargg_long l = 0;
+	blargg_long r = 0;
+	int n = width;
+
+#ifdef __SSE2__
+	__m128i sum = _mm_setzero_si128();
+	for ( ; n >= 8; n -= 8 )
+	{
+		// p0 p1 p2 p3 ... -> p0 p1 p0 p1 p2 p3 p2 p3 ...
+		__m128i pt = _mm_loadu_si128( (__m128i const*) imp );
+		__m128i pt0 = _mm_unpacklo_epi32( pt, pt );
+		__m128i pt1 = _mm_unpackhi_epi32( pt, pt );
+
+		sum = _mm_add_epi32( sum, _mm_madd_epi16( load_pairs( in ), pt0 ) );
+		sum = _mm_add_epi32( sum, _mm_madd_epi16( load_pairs( in + 8 ), pt1 ) );
+		imp += 8;
+		in  += 16;
+	}
+	if ( n >= 4 )
+	{
+		__m128i pt = _mm_loadl_epi64( (__m128i const*) imp );
+		pt = _mm_unpacklo_epi32( pt, pt );
+
+		sum = _mm_add_epi32( sum, _mm_madd_epi16( load_pairs( in ), pt ) );
+		imp += 4;
+		in  += 8;
+		n   -= 4;
+	}
+	// L01 R01 L23 R23 -> L R
+	sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	l = _mm_cvtsi128_si32( sum );
+	r = _mm_cvtsi128_si32( _mm_shuffle_epi32( sum, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+#elif defined(__ARM_NEON)
+	int32x4_t sum_l = vdupq_n_s32( 0 );
+	int32x4_t sum_r = vdupq_n_s32( 0 );
+	for ( ; n >= 4; n -= 4 )
+	{
+		int16x4x2_t i = vld2_s16( in );
+		int16x4_t pt = vld1_s16( imp );
+		sum_l = vmlal_s16( sum_l, i.val [0], pt );
+		sum_r = vmlal_s16( sum_r, i.val [1], pt );
+		imp += 4;
+		in  += 8;
+	}
+	int32x2_t half = vpadd_s32( vadd_s32( vget_low_s32( sum_l ), vget_high_s32( sum_l ) ),
+			vadd_s32( vget_low_s32( sum_r ), vget_high_s32( sum_r ) ) );
+	l = vget_lane_s32( half, 0 );
+	r = vget_lane_s32( half, 1 );
+#endif
+
+	for ( ; n; n -= 2 )
+	{
+		int pt0 = imp [0];
+		l += pt0 * in [0];
+		r += pt0 * in [1];
+		int pt1 = imp [1];
+		imp += 2;
+		l += pt1 * in [2];
+		r += pt1 * in [3];
+		in += 4;
+	}
+
+	*l_out = l;
+	*r_out = r;
+}
+
+template<int fixed_width>
+int Fir_Resampler_::read_( sample_t* out_begin, blargg_long count )
+{
+	sample_t* out = out_begin;
+	const sample_t* in = buf.begin();
+	sample_t* end_pos = write_pos;
+	blargg_ulong skip = skip_bits >> imp_phase;
+	int const width = fixed_width ? fixed_width : width_;
+	sample_t const* imp = impulses + imp_phase * width;
+	int remain = res - imp_phase;
+	int const step = this->step;
+
+	count >>= 1;
+
+	if ( end_pos - in >= width * stereo )
+	{
+		end_pos -= width * stereo;
+		do
+		{
+			count--;
+
+			if ( count < 0 )
+				break;
+
+			blargg_long l, r;
+			fir_mac( imp, in, width, &l, &r );
+			imp += width;
+
+			remain--;
+
+			l >>= 15;
+			r >>= 15;
+
+			in += (skip * stereo) & stereo;
+			skip >>= 1;
+			in += step;
+
+			if ( !remain )
+			{
+				imp = impulses;
+				skip = skip_bits;
+				remain = res;
+			}
+
+			out [0] = (sample_t) l;
+			out [1] = (sample_t) r;
+			out += 2;
+		}
+		while ( in <= end_pos );
+	}
+
+	imp_phase = res - remain;
+
+	int left = write_pos - in;
+	write_pos = &buf [left];
+	memmove( buf.begin(), in, left * sizeof *in );
+
+	return out - out_begin;
+}
+
+int Fir_Resampler_::read( sample_t* out, blargg_long count )
+{
+	// let the compiler unroll the convolution for the widths used by emulators
+	switch ( width_ )
+	{
+	case 6:  return read_<6> ( out, count );
+	case 12: return read_<12>( out, count );
+	case 24: return read_<24>( out, count );
+	case 48: return read_<48>( out, count );
+	default: return read_<0> ( out, count );
+	}
+}
@@ -10,7 +10,17 @@
 class Fir_Resampler_ {
 public:
 
-	// Use Fir_Resampler<width> (below)
+	// Use Fir_Resampler<max_width> (below)
+
+	// Filter quality, trading rolloff effectiveness for speed
+	enum quality_t { quality_fast, quality_normal, quality_high };
+
+	// Set number of points in FIR, at most max_width. Must be even and 4 or more.
+	// Must be called before buffer_size() and time_ratio().
+	void set_width( int );
+
+	// Width for given quality, where normal_width is the one used for quality_normal
+	static int quality_width( int quality, int normal_width );
 
 	// Set input/output resampling ratio and optionally low-pass rolloff and gain.
 	// Returns actual ratio used (rounded to internal precision).
@@ -53,6 +63,9 @@ public:
 	// Number of output samples available
 	int avail() const { return avail_( write_pos - &buf [width_ * stereo] ); }
 
+	// Read at most 'count' samples. Returns number of samples actually read.
+	int read( sample_t* out, blargg_long count );
+
 public:
 	~Fir_Resampler_();
 protected:
@@ -62,30 +75,29 @@ protected:
 	sample_t* write_pos;
 	int res;
 	int imp_phase;
-	int const width_;
-	int const write_offset;
+	int width_;
+	int const max_width_;
+	int write_offset;
 	blargg_ulong skip_bits;
 	int step;
 	int input_per_cycle;
 	double ratio_;
 	sample_t* impulses;
 
-	Fir_Resampler_( int width, sample_t* );
+	Fir_Resampler_( int max_width, sample_t* );
 	int avail_( blargg_long input_count ) const;
+	template<int fixed_width> int read_( sample_t*, blargg_long ); // 0 = width_
 };
 
-// Width is number of points in FIR. Must be even and 4 or more. More points give
-// better quality and rolloff effectiveness, and take longer to calculate.
-template<int width>
+// Max_width is maximum number of points in FIR, which is also the default. Must be
+// even and 4 or more. More points give better quality and rolloff effectiveness,
+// and take longer to calculate.
+template<int max_width>
 class Fir_Resampler : public Fir_Resampler_ {
-	BOOST_STATIC_ASSERT( width >= 4 && width % 2 == 0 );
-	short impulses [max_res] [width];
+	BOOST_STATIC_ASSERT( max_width >= 4 && max_width % 2 == 0 );
+	short impulses [max_res] [max_width];
 public:
-	Fir_Resampler() : Fir_Resampler_( width, impulses [0] ) { }
-
-	// Read at most 'count' samples. Returns number of samples actually read.
-	typedef short sample_t;
-	int read( sample_t* out, blargg_long count );
+	Fir_Resampler() : Fir_Resampler_( max_width, impulses [0] ) { }
 };
 
 // End of public interface
@@ -96,76 +108,4 @@ inline void Fir_Resampler_::write( long count )
 	assert( write_pos <= buf.end() );
 }
 
-template<int width>
-int Fir_Resampler<width>::read( sample_t* out_begin, blargg_long count )
-{
-	sample_t* out = out_begin;
-	const sample_t* in = buf.begin();
-	sample_t* end_pos = write_pos;
-	blargg_ulong skip = skip_bits >> imp_phase;
-	sample_t const* imp = impulses [imp_phase];
-	int remain = res - imp_phase;
-	int const step = this->step;
-
-	count >>= 1;
-
-	if ( end_pos - in >= width * stereo )
-	{
-		end_pos -= width * stereo;
-		do
-		{
-			count--;
-
-			// accumulate in extended precision
-			blargg_long l = 0;
-			blargg_long r = 0;
-
-			const sample_t* i = in;
-			if ( count < 0 )
-				break;
-
-			for ( int n = width / 2; n; --n )
-			{
-				int pt0 = imp [0];
-				l += pt0 * i [0];
-				r += pt0 * i [1];
-				int pt1 = imp [1];
-				imp += 2;
-				l += pt1 * i [2];
-				r += pt1 * i [3];
-				i += 4;
-			}
-
-			remain--;
-
-			l >>= 15;
-			r >>= 15;
-
-			in += (skip * stereo) & stereo;
-			skip >>= 1;
-			in += step;
-
-			if ( !remain )
-			{
-				imp = impulses [0];
-				skip = skip_bits;
-				remain = res;
-			}
-
-			out [0] = (sample_t) l;
-			out [1] = (sample_t) r;
-			out += 2;
-		}
-		while ( in <= end_pos );
-	}
-
-	imp_phase = res - remain;
-
-	int left = write_pos - in;
-	write_pos = &buf [left];
-	memmove( buf.begin(), in, left * sizeof *in );
-
-	return out - out_begin;
-}
-
 #endif
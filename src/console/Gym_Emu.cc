@@ -173,6 +173,7 @@ blargg_err_t Gym_Emu::set_sample_rate_( long sample_rate )
 	dac_synth.treble_eq( eq );
 	apu.volume( 0.135 * fm_gain * gain() );
 	dac_synth.volume( 0.125 / 256 * fm_gain * gain() );
+	Dual_Resampler::set_quality( resampler_quality() );
 	double factor = Dual_Resampler::setup( oversample_factor, 0.990, fm_gain * gain() );
 	fm_sample_rate = sample_rate * factor;
 
@@ -56,6 +56,7 @@ Music_Emu::Music_Emu()
 	mute_mask_   = 0;
 	tempo_       = 1.0;
 	gain_        = 1.0;
+	resampler_quality_ = gme_quality_normal;
 
 	// defaults
 	max_initial_silence = 2;
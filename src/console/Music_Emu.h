@@ -78,6 +78,10 @@ public:
 	// Must be called before set_sample_rate().
 	void set_gain( double );
 
+	// Set quality of resampling, if any, as one of the gme_quality_ values in gme.h.
+	// Must be called before set_sample_rate().
+	void set_resampler_quality( int );
+
 	// Request use of custom multichannel buffer. Only supported by "classic" emulators;
 	// on others this has no effect. Should be called only once *before* set_sample_rate().
 	virtual void set_buffer( Multi_Buffer* ) { }
@@ -111,6 +115,7 @@ protected:
 	void set_voice_names( const char* const* names );
 	void set_track_ended()                      { emu_track_ended_ = true; }
 	double gain() const                         { return gain_; }
+	int resampler_quality() const               { return resampler_quality_; }
 	double tempo() const                        { return tempo_; }
 	void remute_voices();
 
@@ -135,6 +140,7 @@ private:
 	int mute_mask_;
 	double tempo_;
 	double gain_;
+	int resampler_quality_;
 
 	long sample_rate_;
 	blargg_long msec_to_samples( blargg_long msec ) const;
@@ -166,6 +172,7 @@ private:
 
 	Multi_Buffer* effects_buffer;
 	friend Music_Emu* gme_new_emu( gme_type_t, int );
+	friend Music_Emu* gme_new_emu_quality( gme_type_t, int, int );
 	friend void gme_set_stereo_depth( Music_Emu*, double );
 };
 
@@ -215,4 +222,10 @@ inline void Music_Emu::set_gain( double g )
 	gain_ = g;
 }
 
+inline void Music_Emu::set_resampler_quality( int q )
+{
+	assert( !sample_rate() ); // you must set quality before setting sample rate
+	resampler_quality_ = q;
+}
+
 #endif
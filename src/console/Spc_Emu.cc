@@ -255,6 +255,7 @@ blargg_err_t Spc_Emu::set_sample_rate_( long sample_rate )
 	enable_accuracy( false );
 	if ( sample_rate != native_sample_rate )
 	{
+		resampler.set_width( Fir_Resampler_::quality_width( resampler_quality(), 24 ) );
 		RETURN_ERR( resampler.buffer_size( native_sample_rate / 20 * 2 ) );
 		resampler.time_ratio( (double) native_sample_rate / sample_rate, 0.9965 );
 	}
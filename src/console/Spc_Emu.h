@@ -70,7 +70,7 @@ protected:
 private:
 	byte const* file_data;
 	long        file_size;
-	Fir_Resampler<24> resampler;
+	Fir_Resampler<48> resampler;
 	SPC_Filter filter;
 	Snes_Spc apu;
 
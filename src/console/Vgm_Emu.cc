@@ -231,6 +231,7 @@ void Vgm_Emu::set_tempo_( double t )
 blargg_err_t Vgm_Emu::set_sample_rate_( long sample_rate )
 {
 	RETURN_ERR( blip_buf.set_sample_rate( sample_rate, 1000 / 30 ) );
+	Dual_Resampler::set_quality( resampler_quality() );
 	return Classic_Emu::set_sample_rate_( sample_rate );
 }
 
@@ -13,6 +13,8 @@
 
 #include <libfauxdcore/runtime.h>
 
+#include "../ui-common/length-scanner.h"
+
 #define CON_CFGID "console"
 
 AudaciousConsoleConfig audcfg;
@@ -21,11 +23,13 @@ const char * const ConsolePlugin::defaults[] = {
  "loop_length", "180",
  "resample", "FALSE",
  "resample_rate", "32000",
+ "resample_quality", "1",
  "treble", "0",
  "bass", "0",
  "ignore_spc_length", "FALSE",
  "echo", "0",
  "inc_spc_reverb", "FALSE",
+ "scan_lengths", "FALSE",
  nullptr};
 
 bool ConsolePlugin::init ()
@@ -35,11 +39,15 @@ bool ConsolePlugin::init ()
     audcfg.loop_length = aud_get_int (CON_CFGID, "loop_length");
     audcfg.resample = aud_get_bool (CON_CFGID, "resample");
     audcfg.resample_rate = aud_get_int (CON_CFGID, "resample_rate");
+    audcfg.resample_quality = aud_get_int (CON_CFGID, "resample_quality");
     audcfg.treble = aud_get_int (CON_CFGID, "treble");
     audcfg.bass = aud_get_int (CON_CFGID, "bass");
     audcfg.ignore_spc_length = aud_get_bool (CON_CFGID, "ignore_spc_length");
     audcfg.echo = aud_get_int (CON_CFGID, "echo");
     audcfg.inc_spc_reverb = aud_get_bool (CON_CFGID, "inc_spc_reverb");
+    audcfg.scan_lengths = aud_get_bool (CON_CFGID, "scan_lengths");
+
+    console_length_scanner.init ();
 
     return true;
 }
@@ -49,9 +57,13 @@ void ConsolePlugin::cleanup ()
     aud_set_int (CON_CFGID, "loop_length", audcfg.loop_length);
     aud_set_bool (CON_CFGID, "resample", audcfg.resample);
     aud_set_int (CON_CFGID, "resample_rate", audcfg.resample_rate);
+    aud_set_int (CON_CFGID, "resample_quality", audcfg.resample_quality);
     aud_set_int (CON_CFGID, "treble", audcfg.treble);
     aud_set_int (CON_CFGID, "bass", audcfg.bass);
     aud_set_bool (CON_CFGID, "ignore_spc_length", audcfg.ignore_spc_length);
     aud_set_int (CON_CFGID, "echo", audcfg.echo);
     aud_set_bool (CON_CFGID, "inc_spc_reverb", audcfg.inc_spc_reverb);
+    aud_set_bool (CON_CFGID, "scan_lengths", audcfg.scan_lengths);
+
+    console_length_scanner.cleanup ();
 }
@@ -13,13 +13,18 @@ typedef struct {
 	int loop_length;           /* length of tracks that lack timing information */
 	bool resample;          /* whether or not to resample */
 	int resample_rate;         /* rate to resample at */
+	int resample_quality;      /* one of gme_quality_fast, _normal or _high */
 	int treble;                /* -100 to +100 */
 	int bass;                  /* -100 to +100 */
 	bool ignore_spc_length; /* if true, ignore length from SPC tags */
 	int echo;                  /* 0 to +100 */
 	bool inc_spc_reverb;    /* if true, increases the default reverb */
+	bool scan_lengths;      /* if true, find the end of songs without timing information */
 } AudaciousConsoleConfig;
 
 extern AudaciousConsoleConfig audcfg;
 
+class LengthScanner;
+extern LengthScanner console_length_scanner;
+
 #endif /* AUD_CONSOLE_CONFIGURE_H */
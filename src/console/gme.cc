@@ -188,6 +188,11 @@ BLARGG_EXPORT gme_err_t gme_open_file( const char* path, Music_Emu** out, int sa
 }
 
 BLARGG_EXPORT Music_Emu* gme_new_emu( gme_type_t type, int rate )
+{
+	return gme_new_emu_quality( type, rate, gme_quality_normal );
+}
+
+BLARGG_EXPORT Music_Emu* gme_new_emu_quality( gme_type_t type, int rate, int quality )
 {
 	if ( type )
 	{
@@ -208,6 +213,7 @@ BLARGG_EXPORT Music_Emu* gme_new_emu( gme_type_t type, int rate )
 			if ( !(type->flags_ & 1) || me->effects_buffer )
 		#endif
 			{
+				me->set_resampler_quality( quality );
 				if ( !me->set_sample_rate( rate ) )
 				{
 					check( me->type() == type );
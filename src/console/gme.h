@@ -199,6 +199,13 @@ gme_err_t gme_identify_file( const char path [], gme_type_t* type_out );
 track information, pass gme_info_only for sample_rate. */
 Music_Emu* gme_new_emu( gme_type_t, int sample_rate );
 
+/* Quality of resampling done by emulators that generate sound at a fixed rate
+(SPC, and FM sound chips in GYM and VGM). Higher quality takes more time. */
+enum { gme_quality_fast = 0, gme_quality_normal = 1, gme_quality_high = 2 };
+
+/* Same as gme_new_emu(), but with given resampling quality */
+Music_Emu* gme_new_emu_quality( gme_type_t, int sample_rate, int quality );
+
 /* Load music file into emulator */
 gme_err_t gme_load_file( Music_Emu*, const char path [] );
 
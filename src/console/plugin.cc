@@ -8,6 +8,7 @@
 
 #include "configure.h"
 #include "plugin.h"
+#include "gme.h"
 
 EXPORT ConsolePlugin aud_plugin_instance;
 
@@ -25,6 +26,12 @@ const char * const ConsolePlugin::exts[] = {
     "vgm", "vgz", nullptr
 };
 
+static const ComboItem quality_combo[] = {
+    ComboItem (N_("Fast"), gme_quality_fast),
+    ComboItem (N_("Normal"), gme_quality_normal),
+    ComboItem (N_("High"), gme_quality_high)
+};
+
 const PreferencesWidget ConsolePlugin::widgets[] = {
     WidgetLabel (N_("<b>Playback</b>")),
     WidgetSpin (N_("Bass:"),
@@ -39,6 +46,8 @@ const PreferencesWidget ConsolePlugin::widgets[] = {
     WidgetSpin (N_("Default song length:"),
         WidgetInt (audcfg.loop_length),
         {1, 7200, 1, N_("seconds")}),
+    WidgetCheck (N_("Detect length of songs without timing information"),
+        WidgetBool (audcfg.scan_lengths)),
     WidgetLabel (N_("<b>Resampling</b>")),
     WidgetCheck (N_("Enable audio resampling"),
         WidgetBool (audcfg.resample)),
@@ -46,6 +55,9 @@ const PreferencesWidget ConsolePlugin::widgets[] = {
         WidgetInt (audcfg.resample_rate),
         {11025, 96000, 100, N_("Hz")},
         WIDGET_CHILD),
+    WidgetCombo (N_("Resampling quality:"),
+        WidgetInt (audcfg.resample_quality),
+        {{quality_combo}}),
     WidgetLabel (N_("<b>SPC</b>")),
     WidgetCheck (N_("Ignore length from SPC tags"),
         WidgetBool (audcfg.ignore_spc_length)),
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <glib.h>  /* for g_get_current_dir, g_path_is_absolute */
+#include <glib/gstdio.h>  /* for g_stat */
 #include <pthread.h>
 
 #ifdef HAVE_LIBCUE2
@@ -60,12 +61,250 @@ static bool is_year (const char * s)
            is_digit (s[2]) && is_digit (s[3]) && ! s[4];
 }
 
+/* Referenced audio files are probed on a small pool of threads, since
+ * aud_file_find_decoder () and aud_file_read_tag () may each have to open and
+ * parse a (possibly remote) file.  Each distinct file is probed only once. */
+#define MAX_PROBE_THREADS 4
+
+/* Results of a load are cached, keyed by the cue sheet's URI and validated
+ * against the modification times of the sheet and of the files it refers to,
+ * so that re-adding the same sheet does not probe everything again. */
+#define MAX_CACHED_SHEETS 16
+
+struct ProbedFile {
+    String filename;
+    PluginHandle * decoder = nullptr;
+    Tuple tuple;
+};
+
+struct ProbeQueue {
+    Index<ProbedFile> & files;
+    Cd * cd;
+    int next = 0;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    ProbeQueue (Index<ProbedFile> & files, Cd * cd) :
+        files (files), cd (cd) {}
+};
+
+struct CachedFile {
+    String filename;
+    int64_t mtime;
+
+    CachedFile (const String & filename, int64_t mtime) :
+        filename (filename), mtime (mtime) {}
+};
+
+struct CachedSheet {
+    String cue_filename;
+    int64_t mtime;
+    Index<CachedFile> files;
+    Index<PlaylistAddItem> items;
+};
+
+static Index<CachedSheet> sheet_cache;
+static pthread_mutex_t sheet_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* returns -1 for anything that is not a local file or cannot be stat'ed */
+static int64_t get_mtime (const char * uri)
+{
+    StringBuf path = uri_to_filename (uri);
+    GStatBuf statbuf;
+
+    if (! path || g_stat (path, & statbuf) != 0)
+        return -1;
+
+    return (int64_t) statbuf.st_mtime;
+}
+
+static void copy_items (const Index<PlaylistAddItem> & from, Index<PlaylistAddItem> & to)
+{
+    for (auto & item : from)
+        to.append (String (item.filename), item.tuple.ref (), item.decoder);
+}
+
+static bool cache_lookup (const char * cue_filename, int64_t mtime,
+ Index<PlaylistAddItem> & items)
+{
+    bool found = false;
+
+    pthread_mutex_lock (& sheet_cache_mutex);
+
+    for (int i = 0; i < sheet_cache.len (); i ++)
+    {
+        CachedSheet & sheet = sheet_cache[i];
+        if (strcmp (sheet.cue_filename, cue_filename))
+            continue;
+
+        bool valid = (sheet.mtime == mtime);
+        for (auto & file : sheet.files)
+        {
+            if (! valid)
+                break;
+            valid = (get_mtime (file.filename) == file.mtime);
+        }
+
+        if (valid)
+        {
+            copy_items (sheet.items, items);
+
+            /* move to the end, so that the least recently used sheet is first */
+            CachedSheet moved = std::move (sheet);
+            sheet_cache.remove (i, 1);
+            sheet_cache.append (std::move (moved));
+            found = true;
+        }
+        else
+            sheet_cache.remove (i, 1);
+
+        break;
+    }
+
+    pthread_mutex_unlock (& sheet_cache_mutex);
+    return found;
+}
+
+static void cache_store (const char * cue_filename, int64_t mtime,
+ const Index<ProbedFile> & files, const Index<PlaylistAddItem> & items)
+{
+    CachedSheet sheet;
+    sheet.cue_filename = String (cue_filename);
+    sheet.mtime = mtime;
+
+    for (auto & file : files)
+    {
+        int64_t file_mtime = get_mtime (file.filename);
+        if (file_mtime < 0)
+            return;  /* can't validate a remote or missing file later */
+
+        sheet.files.append (file.filename, file_mtime);
+    }
+
+    copy_items (items, sheet.items);
+
+    pthread_mutex_lock (& sheet_cache_mutex);
+
+    for (int i = 0; i < sheet_cache.len (); i ++)
+    {
+        if (! strcmp (sheet_cache[i].cue_filename, cue_filename))
+        {
+            sheet_cache.remove (i, 1);
+            break;
+        }
+    }
+
+    if (sheet_cache.len () >= MAX_CACHED_SHEETS)
+        sheet_cache.remove (0, 1);
+
+    sheet_cache.append (std::move (sheet));
+
+    pthread_mutex_unlock (& sheet_cache_mutex);
+}
+
+static void probe_file (ProbedFile & probed, Cd * cd)
+{
+    VFSFile file;
+
+    probed.decoder = aud_file_find_decoder (probed.filename, false, file);
+
+    if (! probed.decoder || ! aud_file_read_tag (probed.filename, probed.decoder,
+     file, probed.tuple))
+        return;
+
+    Tuple & base_tuple = probed.tuple;
+    Cdtext * cdtext = cd_get_cdtext (cd);
+
+    if (cdtext)
+    {
+        const char * s;
+        if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
+            base_tuple.set_str (Tuple::AlbumArtist, s);
+        if ((s = cdtext_get (PTI_TITLE, cdtext)))
+            base_tuple.set_str (Tuple::Album, s);
+        if ((s = cdtext_get (PTI_GENRE, cdtext)))
+            base_tuple.set_str (Tuple::Genre, s);
+        if ((s = cdtext_get (PTI_COMPOSER, cdtext)))
+            base_tuple.set_str (Tuple::Composer, s);
+    }
+
+    Rem * rem = cd_get_rem (cd);
+
+    if (rem)
+    {
+        const char * s;
+
+        if ((s = rem_get (REM_DATE, rem)))
+        {
+            if (is_year (s))
+                base_tuple.set_int (Tuple::Year, str_to_int (s));
+            else
+                base_tuple.set_str (Tuple::Date, s);
+        }
+
+        if ((s = rem_get (REM_REPLAYGAIN_ALBUM_GAIN, rem)))
+            base_tuple.set_gain (Tuple::AlbumGain, Tuple::GainDivisor, s);
+        if ((s = rem_get (REM_REPLAYGAIN_ALBUM_PEAK, rem)))
+            base_tuple.set_gain (Tuple::AlbumPeak, Tuple::PeakDivisor, s);
+    }
+}
+
+static void * probe_worker (void * data)
+{
+    auto queue = (ProbeQueue *) data;
+
+    while (1)
+    {
+        pthread_mutex_lock (& queue->mutex);
+        int i = queue->next ++;
+        pthread_mutex_unlock (& queue->mutex);
+
+        if (i >= queue->files.len ())
+            break;
+
+        probe_file (queue->files[i], queue->cd);
+    }
+
+    return nullptr;
+}
+
+static void probe_files (Index<ProbedFile> & files, Cd * cd)
+{
+    ProbeQueue queue (files, cd);
+    int n_threads = aud::min (files.len (), MAX_PROBE_THREADS);
+
+    /* the calling thread is one of the workers */
+    pthread_t threads[MAX_PROBE_THREADS];
+    int started = 0;
+
+    for (; started < n_threads - 1; started ++)
+    {
+        if (pthread_create (& threads[started], nullptr, probe_worker, & queue))
+            break;
+    }
+
+    probe_worker (& queue);
+
+    for (int i = 0; i < started; i ++)
+        pthread_join (threads[i], nullptr);
+
+    AUDDBG ("Probed %d file(s) using %d thread(s).\n", files.len (), started + 1);
+}
+
 bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
  Index<PlaylistAddItem> & items)
 {
     // XXX: cue_parse_string crashes if called concurrently
     static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
+    bool from_stdin = ! strncmp (cue_filename, "stdin://", 8);
+    int64_t cue_mtime = from_stdin ? -1 : get_mtime (cue_filename);
+
+    if (cue_mtime >= 0 && cache_lookup (cue_filename, cue_mtime, items))
+    {
+        AUDDBG ("Using cached entries for %s.\n", cue_filename);
+        return true;
+    }
+
     Index<char> buffer = file.read_all ();
     if (! buffer.len ())
         return false;
@@ -78,150 +317,149 @@ bool CueLoader::load (const char * cue_filename, VFSFile & file, String & title,
 
     int tracks = cd ? cd_get_ntrack (cd) : 0;
     if (tracks < 1)
+    {
+        if (cd)
+            cd_delete (cd);
         return false;
+    }
 
-    Track * cur = cd_get_track (cd, 1);
-    const char * cur_name = cur ? track_get_filename (cur) : nullptr;
-
-    if (! cur_name)
-        return false;
-
-    bool from_stdin;
-    bool same_file = false;
-    String filename;
-    PluginHandle * decoder = nullptr;
-    Tuple base_tuple;
+    /* first pass: collect the distinct files referenced by the sheet */
+    Index<ProbedFile> files;
+    Index<int> track_file;  /* index into files for each track, or -1 */
+    const char * prev_name = nullptr;
 
     for (int track = 1; track <= tracks; track ++)
     {
-        if (! same_file)
+        Track * cur = cd_get_track (cd, track);
+        const char * cur_name = cur ? track_get_filename (cur) : nullptr;
+
+        if (! cur_name)
+            break;
+
+        if (prev_name && ! strcmp (cur_name, prev_name))
         {
-            filename = String (uri_construct (cur_name, cue_filename));
-            from_stdin = ! strncmp (cue_filename, "stdin://", 8);
-            if (from_stdin)  // WE'RE PIPING IN FROM STDIN:
-            {
-                char * cur = g_get_current_dir ();
-                String cur_path = String (filename_to_uri (filename_build ({cur, cue_filename+8})));
-                filename = String (uri_construct (cur_name, cur_path));
-                g_free (cur);
-            }
-            else
-                filename = String (uri_construct (cur_name, cue_filename));
+            track_file.append (track_file[track_file.len () - 1]);
+            continue;
+        }
 
-            decoder = nullptr;
-            base_tuple = Tuple ();
+        prev_name = cur_name;
 
-            VFSFile file;
+        String filename;
+        if (from_stdin)  // WE'RE PIPING IN FROM STDIN:
+        {
+            char * cur = g_get_current_dir ();
+            String cur_path = String (filename_to_uri (filename_build ({cur, cue_filename+8})));
+            filename = String (uri_construct (cur_name, cur_path));
+            g_free (cur);
+        }
+        else
+            filename = String (uri_construct (cur_name, cue_filename));
 
-            if (filename)
-                decoder = aud_file_find_decoder (filename, false, file);
-            else
-                AUDWARN ("Unable to construct URI for track '%s' in cuesheet '%s'\n",
-                        cur_name, cue_filename);
+        if (! filename)
+        {
+            AUDWARN ("Unable to construct URI for track '%s' in cuesheet '%s'\n",
+                    cur_name, cue_filename);
+            track_file.append (-1);
+            continue;
+        }
 
-            if (decoder && aud_file_read_tag (filename, decoder, file, base_tuple))
+        /* a file may be referenced again after other files in between */
+        int found = -1;
+        for (int i = 0; i < files.len (); i ++)
+        {
+            if (! strcmp (files[i].filename, filename))
             {
-                Cdtext * cdtext = cd_get_cdtext (cd);
-
-                if (cdtext)
-                {
-                    const char * s;
-                    if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
-                        base_tuple.set_str (Tuple::AlbumArtist, s);
-                    if ((s = cdtext_get (PTI_TITLE, cdtext)))
-                        base_tuple.set_str (Tuple::Album, s);
-                    if ((s = cdtext_get (PTI_GENRE, cdtext)))
-                        base_tuple.set_str (Tuple::Genre, s);
-                    if ((s = cdtext_get (PTI_COMPOSER, cdtext)))
-                        base_tuple.set_str (Tuple::Composer, s);
-                }
-
-                Rem * rem = cd_get_rem (cd);
-
-                if (rem)
-                {
-                    const char * s;
-
-                    if ((s = rem_get (REM_DATE, rem)))
-                    {
-                        if (is_year (s))
-                            base_tuple.set_int (Tuple::Year, str_to_int (s));
-                        else
-                            base_tuple.set_str (Tuple::Date, s);
-                    }
-
-                    if ((s = rem_get (REM_REPLAYGAIN_ALBUM_GAIN, rem)))
-                        base_tuple.set_gain (Tuple::AlbumGain, Tuple::GainDivisor, s);
-                    if ((s = rem_get (REM_REPLAYGAIN_ALBUM_PEAK, rem)))
-                        base_tuple.set_gain (Tuple::AlbumPeak, Tuple::PeakDivisor, s);
-                }
+                found = i;
+                break;
             }
         }
 
-        Track * next = (track + 1 <= tracks) ? cd_get_track (cd, track + 1) : nullptr;
-        const char * next_name = next ? track_get_filename (next) : nullptr;
+        if (found < 0)
+        {
+            found = files.len ();
+            files.append ().filename = std::move (filename);
+        }
+
+        track_file.append (found);
+    }
 
-        same_file = (next_name && ! strcmp (next_name, cur_name));
+    if (! track_file.len ())
+    {
+        cd_delete (cd);
+        return false;
+    }
 
-        if (base_tuple.valid ())
-        {
-            StringBuf tfilename = from_stdin ? str_copy (filename) : str_printf ("%s?%d", cue_filename, track);
-            Tuple tuple = base_tuple.ref ();
-            tuple.set_filename (tfilename);
-            tuple.set_int (Tuple::Track, track);
-            tuple.set_str (Tuple::AudioFile, filename);
+    probe_files (files, cd);
 
-            int begin = (int64_t) track_get_start (cur) * 1000 / 75;
-            tuple.set_int (Tuple::StartTime, begin);
+    /* second pass: build the playlist entries from the probed files */
+    tracks = track_file.len ();
 
-            if (same_file)
-            {
-                int end = (int64_t) track_get_start (next) * 1000 / 75;
-                tuple.set_int (Tuple::EndTime, end);
-                tuple.set_int (Tuple::Length, end - begin);
-            }
-            else
-            {
-                int length = base_tuple.get_int (Tuple::Length);
-                if (length > 0)
-                    tuple.set_int (Tuple::Length, length - begin);
-            }
+    for (int track = 1; track <= tracks; track ++)
+    {
+        int f = track_file[track - 1];
+        if (f < 0 || ! files[f].tuple.valid ())
+            continue;
 
-            Cdtext * cdtext = track_get_cdtext (cur);
+        const String & filename = files[f].filename;
+        const Tuple & base_tuple = files[f].tuple;
 
-            if (cdtext)
-            {
-                const char * s;
-                if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
-                    tuple.set_str (Tuple::Artist, s);
-                if ((s = cdtext_get (PTI_TITLE, cdtext)))
-                    tuple.set_str (Tuple::Title, s);
-                if ((s = cdtext_get (PTI_GENRE, cdtext)))
-                    tuple.set_str (Tuple::Genre, s);
-            }
+        Track * cur = cd_get_track (cd, track);
+        Track * next = (track < tracks) ? cd_get_track (cd, track + 1) : nullptr;
+        bool same_file = (next && track_file[track] == f);
 
-            Rem * rem = track_get_rem (cur);
+        StringBuf tfilename = from_stdin ? str_copy (filename) : str_printf ("%s?%d", cue_filename, track);
+        Tuple tuple = base_tuple.ref ();
+        tuple.set_filename (tfilename);
+        tuple.set_int (Tuple::Track, track);
+        tuple.set_str (Tuple::AudioFile, filename);
 
-            if (rem)
-            {
-                const char * s;
-                if ((s = rem_get (REM_REPLAYGAIN_TRACK_GAIN, rem)))
-                    tuple.set_gain (Tuple::TrackGain, Tuple::GainDivisor, s);
-                if ((s = rem_get (REM_REPLAYGAIN_TRACK_PEAK, rem)))
-                    tuple.set_gain (Tuple::TrackPeak, Tuple::PeakDivisor, s);
-            }
+        int begin = (int64_t) track_get_start (cur) * 1000 / 75;
+        tuple.set_int (Tuple::StartTime, begin);
+
+        if (same_file)
+        {
+            int end = (int64_t) track_get_start (next) * 1000 / 75;
+            tuple.set_int (Tuple::EndTime, end);
+            tuple.set_int (Tuple::Length, end - begin);
+        }
+        else
+        {
+            int length = base_tuple.get_int (Tuple::Length);
+            if (length > 0)
+                tuple.set_int (Tuple::Length, length - begin);
+        }
+
+        Cdtext * cdtext = track_get_cdtext (cur);
 
-            items.append (String (tfilename), std::move (tuple), decoder);
+        if (cdtext)
+        {
+            const char * s;
+            if ((s = cdtext_get (PTI_PERFORMER, cdtext)))
+                tuple.set_str (Tuple::Artist, s);
+            if ((s = cdtext_get (PTI_TITLE, cdtext)))
+                tuple.set_str (Tuple::Title, s);
+            if ((s = cdtext_get (PTI_GENRE, cdtext)))
+                tuple.set_str (Tuple::Genre, s);
         }
 
-        if (! next_name)
-            break;
+        Rem * rem = track_get_rem (cur);
 
-        cur = next;
-        cur_name = next_name;
+        if (rem)
+        {
+            const char * s;
+            if ((s = rem_get (REM_REPLAYGAIN_TRACK_GAIN, rem)))
+                tuple.set_gain (Tuple::TrackGain, Tuple::GainDivisor, s);
+            if ((s = rem_get (REM_REPLAYGAIN_TRACK_PEAK, rem)))
+                tuple.set_gain (Tuple::TrackPeak, Tuple::PeakDivisor, s);
+        }
+
+        items.append (String (tfilename), std::move (tuple), files[f].decoder);
     }
-    if (cd)
-        cd_delete (cd);  // free.
+
+    cd_delete (cd);  // free.
+
+    if (cue_mtime >= 0)
+        cache_store (cue_filename, cue_mtime, files, items);
 
     return true;
 }
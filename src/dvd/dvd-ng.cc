@@ -50,6 +50,7 @@ extern "C" {
 // #define RAW_PACKET_BUFFER_SIZE 32768
 
 #include "../ffaudio/ffaudio-stdinc.h"
+#include "../ui-common/av-core.h"
 
 /* prevent libcdio from redefining PACKAGE, VERSION, etc. */
 #define EXTERNAL_LIBDVDNAV_CONFIG_H
@@ -85,42 +86,6 @@ extern "C" {
 #define FFMIN(a,b) ((a) > (b) ? (b) : (a))
 #define FFMINMAX(c,a,b) FFMIN(FFMAX(c, a), b)
 
-#if CHECK_LIBAVFORMAT_VERSION (57, 33, 100, 57, 5, 0)
-#define ALLOC_CONTEXT 1
-#endif
-
-#if CHECK_LIBAVCODEC_VERSION (57, 37, 100, 57, 16, 0)
-#define SEND_PACKET 1
-#endif
-
-typedef struct
-{
-    int stream_idx;
-    AVStream * stream;
-    AVCodecContext * context;  // JWT:ADDED
-    AVCodec * codec;
-}
-CodecInfo;
-
-struct ScopedFrame
-{
-#if CHECK_LIBAVCODEC_VERSION (55, 45, 101, 55, 28, 1)
-    AVFrame * ptr = av_frame_alloc ();
-#else
-    AVFrame * ptr = avcodec_alloc_frame ();
-#endif
-
-    AVFrame * operator-> () { return ptr; }
-
-#if CHECK_LIBAVCODEC_VERSION (55, 45, 101, 55, 28, 1)
-    ~ScopedFrame () { av_frame_free (& ptr); }
-#elif CHECK_LIBAVCODEC_VERSION (54, 59, 100, 54, 28, 0)
-    ~ScopedFrame () { avcodec_free_frame (& ptr); }
-#else
-    ~ScopedFrame () { av_free (ptr); }
-#endif
-};
-
 static const char * const dvd_schemes[] = {"dvd", nullptr};
 
 class DVD : public InputPlugin
@@ -147,11 +112,6 @@ public:
     bool is_our_file (const char * filename, VFSFile & file);
     bool read_tag (const char * filename, VFSFile & file, Tuple & tuple, Index<char> * image);
     bool play (const char * filename, VFSFile & file);
-    void write_audioframe (CodecInfo * cinfo, AVPacket * pkt, int out_fmt, bool planar);
-    bool write_videoframe (SDL_Renderer * renderer, CodecInfo * vcinfo,
-            SDL_Texture * bmp, AVPacket *pkt, int video_width, 
-            int video_height, bool * last_resized, bool * windowIsStable,
-            int * resized_window_width, int * resized_window_height);
     void draw_highlight_buttons (SDL_Renderer * renderer, bool highlightall, int action);
 private:
 #ifdef _WIN32
@@ -223,7 +183,6 @@ typedef enum {
 } dvdnav_state_t;
 
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
 static bool playing;            /* From Audacious - TRUE WHILE DVD IS ACTIVELY PLAYING. */
 static bool play_video;  /* JWT: TRUE IF USER IS CURRENTLY PLAYING VIDEO (KILLING VID. WINDOW TURNS OFF)! */
 static bool stop_playback;      /* SIGNAL FROM USER TO STOP PLAYBACK */
@@ -234,11 +193,6 @@ static bool menubuttons_adjusted;  /* TRUE SIGNALS WINDOW HAS CHANGED SZ/RATIO &
 static bool checkcodecs;        /* SIGNAL THAT WE NEED TO RELOAD THE CODECS (TRACK CHANGE, ETC.) */
 static bool readblock;          /* PREVENT READER/DEMUXER THREAD FROM CONTINUING UNTIL DATA READY TO READ */
 static bool initted = false;    /* JWT:TRUE AFTER libav/ffaudio stuff initialized. */
-static int as_decor_fudge_x = 0; // MUST CAPTURE WxH OF WINDOW-DECORATIONS FOR AfterStep WM FOR PROPER WINDOW PLACEMENT!
-static int as_decor_fudge_y = 0;
-#if SDL_COMPILEDVERSION > 4600
-static bool as_decor_fudge_set = false;
-#endif
 
 #ifdef _WIN32
 static HANDLE output_fd;        /* OUTPUT FILE-HANDLE TO PIPE */
@@ -651,29 +605,6 @@ static void close_input_file (AVFormatContext * c)
     }
 }
 
-// from audacious:
-static bool convert_format (int ff_fmt, int & aud_fmt, bool & planar)
-{
-    switch (ff_fmt)
-    {
-        case AV_SAMPLE_FMT_U8: aud_fmt = FMT_U8; planar = false; break;
-        case AV_SAMPLE_FMT_S16: aud_fmt = FMT_S16_NE; planar = false; break;
-        case AV_SAMPLE_FMT_S32: aud_fmt = FMT_S32_NE; planar = false; break;
-        case AV_SAMPLE_FMT_FLT: aud_fmt = FMT_FLOAT; planar = false; break;
-
-        case AV_SAMPLE_FMT_U8P: aud_fmt = FMT_U8; planar = true; break;
-        case AV_SAMPLE_FMT_S16P: aud_fmt = FMT_S16_NE; planar = true; break;
-        case AV_SAMPLE_FMT_S32P: aud_fmt = FMT_S32_NE; planar = true; break;
-        case AV_SAMPLE_FMT_FLTP: aud_fmt = FMT_FLOAT; planar = true; break;
-
-    default:
-        AUDERR ("Unsupported audio format %d\n", (int) ff_fmt);
-        return false;
-    }
-
-    return true;
-}
-
 /* from audacious:  mutex must be locked */
 static bool check_disk_status ()
 {
@@ -695,68 +626,6 @@ static bool check_disk_status ()
 #endif
 }
 
-/* from fauxdacious:ffaudio: blits each video frame to the sdl_window: */
-bool DVD::write_videoframe (SDL_Renderer * renderer, CodecInfo * vcinfo,
-        SDL_Texture * bmp, AVPacket *pkt, int video_width, 
-        int video_height, bool * last_resized, bool * windowIsStable,
-        int * resized_window_width, int * resized_window_height)
-{
-#ifdef SEND_PACKET
-    if (LOG (avcodec_send_packet, vcinfo->context, pkt) < 0)
-        return false;
-#else
-    int subframeCnt = 0;
-    int frameFinished = 0;
-    int len = 0;
-    while (subframeCnt < 16)
-    {
-#endif
-        ScopedFrame vframe;
-#ifdef SEND_PACKET
-        int res = avcodec_receive_frame (vcinfo->context, vframe.ptr);
-        if (res < 0)
-            return false;  /* read next packet (continue past errors) */
-        else if (! pkt->size)
-            avcodec_flush_buffers (vcinfo->context);
-#else
-        frameFinished = 0;
-        len = LOG (avcodec_decode_video2, vcinfo->context, vframe.ptr, & frameFinished, pkt);
-        /* Did we get a video frame? */
-        if (len < 0)
-        {
-            AUDERR ("e:decode_video() failed, code %d\n", len);
-            return false;
-        }
-        if (frameFinished)
-        {
-#endif
-            if (last_resized)  /* BLIT THE FRAME, BUT ONLY IF WE'RE NOT CURRENTLY RESIZING THE WINDOW! */
-            {
-                SDL_UpdateYUVTexture (bmp, nullptr, vframe->data[0], vframe->linesize[0], 
-                    vframe->data[1], vframe->linesize[1], vframe->data[2], vframe->linesize[2]);
-                SDL_RenderCopy (renderer, bmp, nullptr, nullptr);  // USE NULL TO GET IMAGE TO FIT WINDOW!
-                (*windowIsStable) = true;
-                return true;
-            }
-            return false;
-#ifndef SEND_PACKET
-        }
-        else
-        {
-            if (pkt->size <= 0 || pkt->data < 0)
-                return false;
-            pkt->size -= len;
-            pkt->data += len;
-            if (pkt->size <= 0)
-                return false;
-        }
-        ++subframeCnt;
-    }
-    AUDERR ("w:write_videoframe: runaway frame skipped (more than 16 parts)\n");
-    return false;
-#endif
-}
-
 // DRAW A RECTANGLE AROUND EACH MENU BUTTON (USER-OPTION, SINCE WE DON'T CURRENTLY DO SUBPICTURES):
 void DVD::draw_highlight_buttons (SDL_Renderer * renderer, bool highlightall, int action)
 {
@@ -787,281 +656,6 @@ void DVD::draw_highlight_buttons (SDL_Renderer * renderer, bool highlightall, in
     SDL_RenderPresent (renderer);
 }
 
-// CREATE AN SDL "RENDERER":
-static SDL_Renderer * createSDL2Renderer (SDL_Window * sdl_window, bool myplay_video)
-{
-    SDL_Renderer * renderer = nullptr;
-    if (sdl_window && myplay_video)
-        renderer = SDL_CreateRenderer (sdl_window, -1, 0);
-
-    return renderer;
-}
-
-// CREATE AN SDL "TEXTURE":
-static SDL_Texture * createSDL2Texture (SDL_Window * sdl_window, SDL_Renderer * renderer, bool myplay_video, int width, int height)
-{
-    SDL_Texture * texture = nullptr;
-    if (myplay_video && renderer)
-    {
-        texture = SDL_CreateTexture (renderer, SDL_PIXELFORMAT_YV12, SDL_TEXTUREACCESS_STREAMING, width, height);
-        if (! texture)
-            AUDERR ("e:Could not create texture (%s)\n", SDL_GetError ());
-        else
-        {
-            SDL_SetRenderDrawColor (renderer, 128, 128, 128, 255);
-            SDL_RenderFillRect (renderer, nullptr);
-            SDL_RenderPresent (renderer);
-            if (aud_get_bool ("audacious", "video_display"))
-                SDL_ShowWindow (sdl_window);  // ONLY SHOW WINDOW IF video_display VISUALIZATION PLUGIN ON!
-
-            /* NOTIFY video_display VISUALIZATION PLUGIN WE'RE NOW DEMUXING VIDEO. */
-            aud_set_bool ("audacious", "_video_playing", true);
-        }
-    }
-
-    return texture;
-}
-
-/* WHEN EXITING PLAY, WE SAVE THE WINDOW-POSITION & SIZE SO WINDOW CAN POP UP IN SAME POSITION NEXT TIME! */
-void save_window_xy (SDL_Window * sdl_window, int video_window_x, int video_window_y,
-        int init_window_x, int init_window_y, int video_display_at_startup)
-{
-    int x = 0;
-    int y = 0;
-    int w = 0;
-    int h = 0;
-
-    SDL_GetWindowSize (sdl_window, &w, &h);
-    if (w < 1 || h < 1 || w > 9999 || h > 9999)  /* SDL RETURNED BAD WINDOW INFO, DON'T SAVE! */
-        return;
-
-    /* JWT:NOTE:  FETCH WINDOW'S CURRENT COORDS, BUT LATEST SDL VERSION RETURNS SDL COORDINATES
-       *ONLY* IF WINDOW WAS "MOVED" (EITHER BY USER OR BY INITIAL (RE)PLACEMENT ON 1ST VIDEO PLAY),
-       OTHERWISE, IT NOW (IN LATEST SDL) SEEMS TO RETURN WM COORDINATES?!
-       (PREV. SDL VSNS RETURNED SDL COORDINATES ALWAYS)!
-    */
-    SDL_GetWindowPosition (sdl_window, &x, &y);  /* FETCH WINDOW'S CURRENT (SDL) COORDS: */
-    AUDDBG ("--SAVING: WINDOW AT (%d, %d), FUDGE=(%d, %d) VW=(%d, %d)\n", x, y, as_decor_fudge_x, as_decor_fudge_y, video_window_x, video_window_y);
-
-#if SDL_COMPILEDVERSION > 4600
-    /* IF WINDOW "MOVED", WE'LL HAVE SDL COORDS, SO CONVERT TO WM COORDS, (OTHERWISE */
-    /* WE ALREADY HAVE WM COORDS): NOTE:  OLDER SDL VSNS ALWAYS RETURNED SDL COORDS): */
-    if (! video_display_at_startup)
-    {
-        if (! as_decor_fudge_set && aud_get_bool ("audacious", "video_display"))
-        {
-            /* STARTED OUT W/VIDEO OFF, BUT TURNED ON, NOW NEED TO CALCULATE FUDGE NOW: */
-            as_decor_fudge_x = video_window_x - x;
-            as_decor_fudge_y = video_window_y - y;
-            AUDDBG ("--FUDGE SET IN SAVE (%d, %d) B/C VIDEO TOGGLED ON DURING PLAY B4 FUDGE CALCULATED.\n", as_decor_fudge_x, as_decor_fudge_y);
-            as_decor_fudge_set = true;
-        }
-        x = video_window_x;  // NO VIDEO AT STARTUP, BUT WE HAVE WM COORDS ALREADY (NOT MOVED):
-        y = video_window_y;
-    }
-    else if (x != init_window_x || y != init_window_y  // WE HAVE "SDL" COORDS. IF ANY OF THIS IS TRUE:
-            || aud_get_bool ("audacious", "video_display") || aud_get_bool ("audacious", "afterstep"))
-#else
-    if (! video_display_at_startup && aud_get_bool ("audacious", "video_display"))
-    {
-        /* JWT:MUST RECALCULATE FUDGE HERE IFF WINDOW STARTED PLAY HIDDEN (UNDECORATED), */
-        as_decor_fudge_x = video_window_x - x;
-        as_decor_fudge_y = video_window_y - y;
-        AUDDBG ("FUDGE RE-SET(x=%d y=%d) vw=(%d, %d) F=(%d, %d)\n", x, y, video_window_x,
-                video_window_y, as_decor_fudge_x, as_decor_fudge_y);
-    }
-#endif
-    {
-        AUDDBG ("--MOVED?  ADD FUDGE!  init=(%d, %d)\n", init_window_x, init_window_y);
-        x += as_decor_fudge_x;  /* APPLY CALCULATED FUDGE-FACTOR (WE HAVE SDL COORDS): */
-        if (x < 0 || x > 9999)
-            x = 0;              // DON'T ALLOW WEIRD OR OFF LEFT/TOP OF SCREEN!
-        y += as_decor_fudge_y;
-        if (y < 0 || x > 9999)
-            y = 0;
-    }
-    aud_set_int ("dvd", "video_window_x", x);  // SAVE TO CONFIG-FILE AS WM COORDS!:
-    aud_set_int ("dvd", "video_window_y", y);
-    aud_set_int ("dvd", "video_window_w", w);
-    aud_set_int ("dvd", "video_window_h", h);
-    AUDDBG ("--save_window_xy(%d, %d)\n", x, y);
-}
-
-// SEND EACH AUDIO FRAME TO THE SPEAKERS:
-void DVD::write_audioframe (CodecInfo * cinfo, AVPacket * pkt, int out_fmt, bool planar)
-{
-    int size = 0;
-    Index<char> buf;
-#ifdef SEND_PACKET
-    if (LOG (avcodec_send_packet, cinfo->context, pkt) < 0)
-        return;
-#else
-    int decoded = 0;
-    int len = 0;
-#endif
-
-#if CHECK_LIBAVCODEC_VERSION(59, 37, 100, 59, 37, 100)
-    int channels = cinfo->context->ch_layout.nb_channels;
-#else
-    int channels = cinfo->context->channels;
-#endif
-
-    while (pkt->size > 0)
-    {
-        ScopedFrame frame;
-#ifdef SEND_PACKET
-        if (LOG (avcodec_receive_frame, cinfo->context, frame.ptr) < 0)
-            break;  /* read next packet (continue past errors) */
-#else
-        decoded = 0;
-        len = LOG (avcodec_decode_audio4, cinfo->context, frame.ptr, & decoded, pkt);
-        if (len < 0)
-        {
-            AUDERR ("e:decode_audio() failed, code %d\n", len);
-            break;
-        }
-
-        pkt->size -= len;
-        pkt->data += len;
-
-        if (! decoded)
-        {
-            if (pkt->size > 0)
-                continue; /* process more of current packet */
-
-            break;
-        }
-#endif
-        size = FMT_SIZEOF (out_fmt) * channels * frame->nb_samples;
-        if (planar)
-        {
-            if (size > buf.len ())
-                buf.resize (size);
-
-            audio_interlace ((const void * *) frame->data, out_fmt,
-                    channels, buf.begin (), frame->nb_samples);
-            write_audio (buf.begin (), size);
-        }
-        else
-            write_audio (frame->data[0], size);
-    }
-    return;
-}
-
-/* 
-    JWT: ADDED ALL THIS QUEUE STUFF TO SMOOTH VIDEO PERFORMANCE SO THAT VIDEO FRAMES WOULD 
-    BE OUTPUT MORE INTERLACED WITH THE AUDIO FRAMES BY QUEUEING VIDEO FRAMES UNTIL AN 
-    AUDIO FRAME IS PROCESSED, THEN DEQUEUEING AND PROCESSING 'EM WITH EACH AUDIO FRAME.  
-    THE SIZE OF THIS QUEUE IS SET BY video_qsize CONFIG PARAMETER AND DEFAULTS TO 8.
-    HAVING TOO MANY CAN RESULT IN DELAYED VIDEO, SO EXPERIMENT.  IDEALLY, PACKETS SHOULD 
-    BE PROCESSED:  V A V A V A..., BUT THIS HANDLES:  
-    V1 V2 V3 V4 V5 A1 A2 A3 A4 A5 A6 A7 V7 A8... AS: 
-    (q:V1 V2 V3 V4 V5 V6) A1 A2 dq:V1 A3 A4 dq:V2 A5 A6 dq:V3 A7 A8...
-    WE DON'T WANT TO INTERRUPT AUDIO PERFORMANCE AND I DON'T KNOW HOW TO THREAD IT UP,
-    BUT THIS SIMPLE APPROACH SEEMS TO WORK PRETTY SMOOTH FOR ME!  OTHERWISE TRY 
-    INCREASING video_qsize IN config file OTHERWISE.
-    BORROWED THESE FUNCTIONS FROM:
-    http://www.thelearningpoint.net/computer-science/data-structures-queues--with-c-program-source-code
-*/
-
-typedef struct 
-{
-    int capacity;
-    int size;
-    int front;
-    int rear;
-    AVPacket * * elements;
-}
-pktQueue;
-
-pktQueue * createQueue (int maxElements)
-{
-    /* Create a Queue */
-    pktQueue * Q = (pktQueue *) malloc (sizeof (pktQueue));
-    /* Initialise its properties */
-    Q->elements = (AVPacket * *) malloc (sizeof (AVPacket *) * maxElements);
-    Q->size = 0;
-    Q->capacity = maxElements;
-    Q->front = 0;
-    Q->rear = -1;
-    /* Return the pointer */
-    return Q;
-}
-
-bool Dequeue (pktQueue *Q)
-{
-    /* If Queue size is zero then it is empty. So we cannot pop */
-    if (! Q->size)
-        return false;
-    /* Removing an element is equivalent to incrementing index of front by one */
-    else
-    {
-        pthread_mutex_lock (& queue_mutex);  // (READER THREAD IS ENQUEUING MORE AT SAME TIME)!
-
-        Q->size--;
-        av_packet_free (& Q->elements[Q->front]);
-
-        Q->front++;
-        /* As we fill elements in circular fashion */
-        if (Q->front == Q->capacity)
-            Q->front = 0;
-
-        pthread_mutex_unlock (& queue_mutex);
-    }
-    return true;
-}
-
-/* JWT:FLUSH AND FREE EVERYTHING IN THE QUEUE */
-void QFlush (pktQueue *Q)
-{
-    pthread_mutex_lock (& queue_mutex);  // DON'T ALLOW THREADS TO ENQUEUE OR DEQUEUE WHILST FLUSHING!
-
-    while (Q->size > 0)
-    {
-        Q->size--;
-        av_packet_free (& Q->elements[Q->front]);
-
-        Q->front++;
-        /* As we fill elements in circular fashion */
-        if (Q->front == Q->capacity)
-            Q->front = 0;
-    }
-
-    pthread_mutex_unlock (& queue_mutex);
-}
-
-bool Enqueue (pktQueue *Q, AVPacket * element)
-{
-    /* If the Queue is full, we cannot push an element into it as there is no space for it.*/
-    if (Q->size == Q->capacity)
-        return false;
-    else
-    {
-        pthread_mutex_lock (& queue_mutex);  // (MAIN THREAD IS DEQUEUING THEM AT SAME TIME)!
-
-        Q->rear++;
-        /* As we fill the queue in circular fashion */
-        if (Q->rear == Q->capacity)
-            Q->rear = 0;
-        /* Insert the element in its rear side */
-        Q->elements[Q->rear] = element;
-        Q->size++;
-
-        pthread_mutex_unlock (& queue_mutex);
-    }
-    return true;
-}
-
-void destroyQueue (pktQueue *Q)
-{
-    QFlush (Q);
-    free (Q->elements);
-    free (Q);
-    Q = nullptr;
-}
-
-/* JWT:END OF ADDED VIDEO PACKET QUEUEING FUNCTIONS */
-
 static int read_cb (void * input_fd_p, unsigned char * buf, int size)
 {
     int red = 0;
@@ -1223,30 +817,15 @@ void DVD::reader_demuxer ()
 {
     AUDDBG ("---- reader_demuxer started! ----\n");
     int ret;
-    int video_window_x = 0;  // VIDEO WINDOW POSITION AND SIZE WHEN PROGRAM LAST CLOSED:
-    int video_window_y = 0;
-    int video_window_w = 0;
-    int video_window_h = 0;
-    int video_xmove = 1;
-    int video_resizedelay = 1;     // MIN. TIME TO WAIT AFTER USER RESIZES VIDEO WINDOW BEFORE RE-ASPECTING (SEC.)
     uint32_t video_default_width = 720;   // WINDOW-SIZE REQUESTED BY VIDEO STREAM ITSELF (just initialize for sanity).
     uint32_t video_default_height = 480;
-    int video_doreset_width = 0;   // WINDOW-SIZE BELOW WHICH WINDOW WILL SNAP BACK TO SIZE REQUESTED BY VIDEO STREAM:
-    int video_doreset_height = 0;
-    bool needWinSzFudge = true;    // TRUE UNTIL A FRAME HAS BEEN BLITTED & WE'RE NOT LETTING VIDEO DECIDE WINDOW SIZE.
-    SDL_Window * sdl_window = nullptr; // JWT: MUST DECLARE VIDEO SCREEN-WINDOW HERE
-    bool video_display_at_startup = aud_get_bool ("audacious", "video_display"); // TRUE IF VIDIO VISUALIZATION ON AT PLAY START.
-    int init_window_x = 0;         // INITIAL (SDL) COORDINATES OF WINDOW FIRST PLACED (BEFORE USER CAN MOVE IT):
-    int init_window_y = 0;
-    bool noresize_optimizations = aud_get_bool ("ffaudio", "noresize_optimizations");
-
-#if SDL_COMPILEDVERSION < 4601
-    as_decor_fudge_x = 0;
-    as_decor_fudge_y = 0;
-#endif
+    VideoWindow video ("dvd");     // THE POPUP VIDEO WINDOW (SIZE, ASPECT AND PLACEMENT).
 
     /* SET UP THE VIDEO SCREEN */
     play_video = aud_get_bool ("dvd", "play_video");   /* JWT:RESET PLAY-VIDEO, CASE TURNED OFF ON PREV. PLAY. */
+    if (play_video && ! video.open ())
+        play_video = false;
+
     if (play_video)
     {
         AUDDBG ("--(INIT) PLAYING VIDEO!\n");
@@ -1254,79 +833,28 @@ void DVD::reader_demuxer ()
         String song_title;
         // song_title = trackinfo[dvdnav_priv->track].title;
         song_title = trackinfo[0].title;
-        if (noresize_optimizations)
-        {
-            /* JWT: time in seconds to wait for user to stop dragging before resetting window aspect */
-            video_resizedelay = aud_get_int ("ffaudio", "video_resizedelay");
-            if (video_resizedelay <= 0 or video_resizedelay > 9)
-                video_resizedelay = 1;
-        }
-        /* JWT: size below which window is reset to video's original requested size. */
-        video_doreset_width = aud_get_int ("ffaudio", "video_doreset_width");
-        if ( video_doreset_width <= 0)
-            video_doreset_width = 149;
-        video_doreset_height = aud_get_int ("ffaudio", "video_doreset_height");
-        if ( video_doreset_height <= 0)
-            video_doreset_height = 149;
-
-        sdl_window = fauxd_get_sdl_window ();
-        if (! sdl_window)
-        {
-            AUDERR ("e:Failed to create SDL window (no video playing): %s.\n", SDL_GetError ());
-            play_video = false;
-            goto breakout1;
-        }
         video_windowtitle = aud_get_str ("dvd", "video_windowtitle");
         if (song_title && song_title[0])
         {
             StringBuf titleBuf = (video_windowtitle && video_windowtitle[0])
                     ? str_printf ("%s - %s", (const char *) song_title, (const char *) video_windowtitle)
                     : str_copy ((const char *) song_title, -1);
-            str_replace_char (titleBuf, '_', ' ');
-            SDL_SetWindowTitle (sdl_window, (const char *) titleBuf);
+            video.set_title (titleBuf);
         }
         else
         {
             StringBuf titleBuf = (video_windowtitle && video_windowtitle[0])
                     ? str_printf ("%s", (const char *) video_windowtitle)
                     : str_printf ("%s", "Untitled DVD");
-            SDL_SetWindowTitle (sdl_window, (const char *) titleBuf);
+            video.set_title (titleBuf);
         }
         song_title = String ();
         video_windowtitle = String ();
-        /* NOW CALCULATE THE WIDTH, HEIGHT, & ASPECT BASED ON VIDEO'S SIZE & AND ANY USER PARAMATERS GIVEN:
-            IDEALLY, ONE SHOULD ONLY SET X OR Y AND LET Fauxdacious CALCULATE THE OTHER DIMENSION,
-            SO THAT THE ASPECT RATIO IS MAINTAINED, THOUGH ONE CAN SPECIFY BOTH AND FORCE
-            THE ASPECT TO BE ADJUSTED TO FIT.  IF A SINGLE ONE IS SPECIFIED AS "-1", THEN
-            THE NEW WINDOW WILL KEEP THE SAME VALUE FOR THAT DIMENSION AS THE PREV. WINDOW,
-            AND ADJUST THE OTHER DIMENTION ACCORDINGLY TO FIT THE NEW VIDEO'S ASPECT RATIO.
-            IF BOTH ARE SPECIFIED AS "-1", USE PREVIOUSLY-SAVED WINDOW SIZE REGUARDLESS OF ASPECT RATIO.
-        */
-        video_xmove = aud_get_int ("dvd", "video_xmove");
-        if (video_xmove == 0)
-            video_xmove = 1;
-        /*  -1: Always let windowmanager place (random);
-            0(UNSPECIFIED): DEFAULT to 1.
-            1(default): Relocate window via SDL;
-        */
-        /* GET SAVED PREV. VIDEO WINDOW LOCN. AND SIZE AND TRY TO PLACE NEW WINDOW ACCORDINGLY: */
-        /* JWT: I ADDED THIS TO AVOID NEW VID. WINDOW RANDOMLY POPPING UP IN NEW LOCN., IE. WHEN REPEATING A VIDEO. */
-        video_window_x = aud_get_int ("dvd", "video_window_x");
-        video_window_y = aud_get_int ("dvd", "video_window_y");
-        video_window_w = aud_get_int ("dvd", "video_window_w");
-        video_window_h = aud_get_int ("dvd", "video_window_h");
-        if (video_xmove == -1)
-            needWinSzFudge = false;  // NO FUDGING NEEDED IF WINDOW TO BE PLACED RANDOMLY BY WINDOWMANAGER!
-#if SDL_COMPILEDVERSION < 4601
-        if (video_xmove > 0)
-            SDL_SetWindowPosition (sdl_window, video_window_x, video_window_y);
-#endif
     }
 
-breakout1:
     /* SUBSCOPE FOR DECLARING SDL2 RENDERER AS SCOPED SMARTPOINTER: */
     {   
-    SmartPtr<SDL_Renderer, SDL_DestroyRenderer> renderer (createSDL2Renderer (sdl_window, play_video));
+    SmartPtr<SDL_Renderer, SDL_DestroyRenderer> renderer (play_video ? av_create_renderer (video.window ()) : nullptr);
 #ifdef _WIN32
     /* OPEN THE INPUT PIPE HERE (ONCE WHEN THREAD STARTS UP, IN *NIX, THE FIFO'S OPENED UP EACH 
        TIME THE CODECS CHANGE LATER IN open_input_file()! (IT ONLY WORKS THIS WAY) */
@@ -1372,24 +900,16 @@ startover:
     AUDDBG ("WE-RE STARTING OVER!-------------------------\n");
     bool myplay_video;           // WHETHER OR NOT TO DISPLAY THE VIDEO.
     bool videohasnowh = false;   // TRUE IF VIDEO CONTEXT DID NOT PROVIDE A WIDTH OR HEIGHT.
-    bool windowIsStable = false; // JWT:SAVING AND RECREATING WINDOW CAUSES POSN. TO DIFFER BY THE WINDOW DECORATION SIZES, SO WE HAVE TO FUDGE FOR THAT!
     bool codec_opened = false;   // TRUE IF SUCCESSFULLY OPENED CODECS:
     bool vcodec_opened = false;
     bool planar = 0;             // USED BY Audacious.
     bool eof = false;            // BECOMES TRUE WHEN EOF REACHED BY THE READER/DECODER. 
     bool pause_reading = false;  // BECOMES TRUE WHEN "EOF"/"ERROR" REACHED WHILST SITTING IN A MENU.
-    bool last_resized = true;    // TRUE IF VIDEO-WINDOW HAS BEEN RE-ASPECTED SINCE LAST RESIZE EVENT (HAS CORRECT ASPECT RATIO).
     bool menu_flushed = false;   // TRUE AFTER FLUSHING SINGLE-IMAGE MENU.
     bool menu_written = false;   // TRUE AFTER ANY PART OF MENU DISPLAYED.
     bool menuawaitingclick = false;  // TRUE IF WE'RE WAITING DURATION SECONDS ON MENU-EOF FOR A BUTTON TO BE PRESSED.
     int out_fmt = 0;             // USED BY Audacious.
     int errcount = 0;            // LIMIT FRAME READ RETRIES.
-    int vx = 0;
-    int vy = 0;
-    int video_width = 0;         // INITIAL VIDEO WINDOW-SIZE:
-    int video_height = 0;
-    int resized_window_width = 720;  // VIDEO WINDOW-SIZE AFTER LAST RESIZE.
-    int resized_window_height = 480;
     int video_qsize = 0;         // MAX. NO. OF VIDEO PACKETS TO QUEUE AT ONE TIME.
     int videoStream = -1;        // AVCODEC STREAM IDS.
     int audioStream = -1;
@@ -1398,15 +918,20 @@ startover:
     uint32_t last_requested_width = 720;  // WINDOW-SIZE AFTER LAST RESIZE (NEEDED FOR MENU-BUTTON ADJUSTMENT).
     uint32_t last_requested_height = 480;
     float video_aspect_ratio = 0;    // ASPECT RATIO OF VIDEO, SAVED TO PERMIT RE-ASPECTING AFTER USER RESIZES (WARPS) WINDOW.
-    time_t last_resizeevent_time = time (nullptr);  // TIME OF LAST RESIZE EVENT, SO WE CAN DETERMINE WHEN SAFE TO RE-ASPECT.
     time_t last_menuframe_time = time (nullptr);  // TIME OF LAST MENU FRAME, TO FORCE DISPLAY WHEN "DONE".
     time_t scene_start_time;     // START TIME OF CURRENTLY-PLAYING STREAM.
     SDL_Event       event;       // SDL EVENTS, IE. RESIZE, KILL WINDOW, ETC.
 
     CodecInfo cinfo, vcinfo;     // AUDIO AND VIDEO CODECS.
     AVPacket * pkt;
-    pktQueue * pktQ = nullptr;    // QUEUE FOR VIDEO-PACKET QUEUEING.
-    pktQueue * apktQ = nullptr;   // QUEUE FOR AUDIO-PACKET QUEUEING.
+    PacketQueue * pktQ = nullptr;    // QUEUE FOR VIDEO-PACKET QUEUEING.
+    PacketQueue * apktQ = nullptr;   // QUEUE FOR AUDIO-PACKET QUEUEING.
+    Index<char> audio_buf;       // SCRATCH SPACE FOR INTERLEAVING PLANAR AUDIO (KEPT BETWEEN PACKETS).
+
+    auto write = [this] (const void * data, int size) { write_audio (data, size); };
+    auto write_audioframe = [&] (AVPacket * apkt) {
+        av_decode_audio (cinfo, apkt, out_fmt, planar, audio_buf, write);
+    };
 
     AUDINFO ("---- reader_demuxer starting over! ----\n");
     video_default_width = 720;   // WINDOW-SIZE DEFAULTS FOR DVDS (just initialize for sanity).
@@ -1591,7 +1116,7 @@ AUDDBG("---INPUT PIPE OPENED!\n");
             codec_opened = false;
         }
     }
-    if (codec_opened && ! convert_format (cinfo.context->sample_fmt, out_fmt, planar))
+    if (codec_opened && ! av_convert_format (cinfo.context->sample_fmt, out_fmt, planar))
     {
 #ifdef ALLOC_CONTEXT
             avcodec_free_context (& cinfo.context);
@@ -1643,67 +1168,13 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                     ? (float)vcinfo.context->width / (float)vcinfo.context->height : 1.0;
 
         AUDINFO ("---ASPECT RATIO=%f= code=%d=\n", video_aspect_ratio, dvd_video_aspect_ratio_code);
-        vx = aud_get_int ("dvd", "video_xsize");
-        vy = aud_get_int ("dvd", "video_ysize");
-        video_requested_width = vcinfo.context->width;
-        video_requested_height = vcinfo.context->height;
         last_requested_width = vcinfo.context->width;
         last_requested_height = vcinfo.context->height;
-        if (!vx && vy)     /* User specified (or saved) height only, calc. width based on aspect: */
-        {
-            video_height = (vy == -1) ? (video_window_h ? video_window_h : video_default_height) : vy;
-            video_width = (int)((float)video_height * video_aspect_ratio);
-        }
-        else if (vx && !vy)   /* User specified (or saved) width only, calc. height based on aspect: */
-        {
-            video_width = (vx == -1) ? (video_window_w ? video_window_w : video_default_width) : vx;
-            video_height = (int)((float)video_width / video_aspect_ratio);
-        }
-        else if (vx && vy)      /* User specified fixed width and height: */
-        {
-            if (vx == -1 && vy == -1)  /* Use same (saved) settings or video's settings (SCREW THE ASPECT)! */
-            {
-                video_width = video_window_w ? video_window_w : video_default_width;
-                video_height = video_window_h ? video_window_h : video_default_height;
-            }
-            else if (vy == -1)  /* Use same (saved) width & calculate new height based on aspect: */
-            {
-                video_width = vx;
-                video_height = (int)((float)video_width / video_aspect_ratio);
-                //video_default_height = (int)((float)video_default_width / video_aspect_ratio);
-            }
-            else if (vx == -1)  /* Use same (saved) height & calculate new width based on aspect: */
-            {
-                video_height = vy;
-                video_width = (int)((float)video_height * video_aspect_ratio);
-                //video_default_width = (int)((float)video_default_height * video_aspect_ratio);
-            }
-            else  /* User specified window size (SCREW THE ASPECT)! */
-            {
-                video_width = vx;
-                video_height = vy;
-            }
-        }
-        else   /* User specified nothing, use the video's desired wXh (& ignore saved settings!): */
-        {
-            video_width = video_default_width;
-            video_height = video_default_height;
-        }
-        AUDINFO ("---VIDEO W x H SET TO (%d x %d)!\n", video_width, video_height);
+        video.set_video_size (vcinfo.context->width, vcinfo.context->height,
+                video_default_width, video_default_height, video_aspect_ratio);
         if (playing_a_menu && ! menubuttons_adjusted && menubuttons.len () > 0)
-            menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video_width,
-                    last_requested_height, (uint32_t)video_height);
-
-        video_aspect_ratio = video_height
-            ? (float)video_width / (float)video_height : 1.0;   /* Fall thru to square to avoid possibliity of "/0"! */
-
-        /* NOW "RESIZE" sdl_window to user's wXh, if user set something: */
-        SDL_SetWindowSize (sdl_window, video_width, video_height);
-
-        if (aud_get_str ("dvd", "video_render_scale"))
-            SDL_SetHint (SDL_HINT_RENDER_SCALE_QUALITY, aud_get_str ("dvd", "video_render_scale"));
-        else
-            SDL_SetHint (SDL_HINT_RENDER_SCALE_QUALITY, "1");
+            menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video.width (),
+                    last_requested_height, (uint32_t)video.height ());
     }
 
     /* JWT:video_qsize:  MAX # PACKETS TO QUEUE UP FOR INTERLACING TO SMOOTH VIDEO
@@ -1719,27 +1190,32 @@ AUDDBG("---INPUT PIPE OPENED!\n");
         video_qsize = 6;
 
     /* TYPICALLY THERE'S TWICE AS MANY AUDIO PACKETS AS VIDEO, SO THIS IS COUNTER-INTUITIVE, BUT IT WORKS BEST! */
-    pktQ = playing_a_menu ? createQueue (1) : createQueue (2 * video_qsize);
-    apktQ = createQueue (video_qsize);
+    pktQ = new PacketQueue (playing_a_menu ? 1 : 2 * video_qsize);
+    apktQ = new PacketQueue (video_qsize);
 
     /* SUBSCOPE FOR DECLARING SDL2 TEXTURE: */
     {
-    bool windowNowExposed = false;  // JWT:NEEDED TO PREVENT RESIZING WINDOW BEFORE EXPOSING ON MS-WINDOWS?!
     int seek_value;
     bool highlightbuttons = playing_a_menu ? aud_get_bool ("dvd", "highlightbuttons") : false;
     SDL_Texture * bmp = nullptr;
+    auto write_videoframe = [&] (AVPacket * vpkt) {
+        if (! av_decode_video (vcinfo, vpkt, renderer.get (), bmp, ! video.resizing ()))
+            return false;
+        video.frame_shown ();
+        return true;
+    };
     int minmenushowsec = aud_get_int ("dvd", "minmenushowsec");
     if (minmenushowsec < 1)
         minmenushowsec = 16;
 
     if (! renderer)
-    {
-        if (myplay_video)
-            AUDERR ("e:SDL: could not create video renderer - no video play (%s)\n", SDL_GetError ());
         myplay_video = false;
-    }
     else if (myplay_video)  // CAN'T SMARTPTR THIS IN WINBLOWS SINCE FATAL ERROR (ON renderer.get IF NO RENDERER) IF VIDEO-PLAY TURNED OFF (COMPILER DIFFERENCE)!
-        bmp = createSDL2Texture (sdl_window, renderer.get (), myplay_video, vcinfo.context->width, vcinfo.context->height);
+    {
+        SDL_SetRenderDrawColor (renderer.get (), 128, 128, 128, 255);
+        SDL_RenderFillRect (renderer.get (), nullptr);
+        bmp = av_create_texture (video.window (), renderer.get (), vcinfo.context->width, vcinfo.context->height);
+    }
 
     if (myplay_video && ! bmp)
     {
@@ -1749,10 +1225,10 @@ AUDDBG("---INPUT PIPE OPENED!\n");
 
     update_title_len ();
 
-    if (myplay_video && sdl_window)
+    if (myplay_video)
     {
 #if SDL_COMPILEDVERSION >= 2005
-        SDL_SetWindowInputFocus (sdl_window);  //TRY TO SET INPUT FOCUS ON VIDEO WINDOW FOR EASIER (1-CLICK) MENU-SELECTION:
+        SDL_SetWindowInputFocus (video.window ());  //TRY TO SET INPUT FOCUS ON VIDEO WINDOW FOR EASIER (1-CLICK) MENU-SELECTION:
 #endif
         if (highlightbuttons)
             SDL_SetRenderDrawBlendMode (renderer.get (), SDL_BLENDMODE_BLEND);
@@ -1785,8 +1261,8 @@ AUDDBG("---INPUT PIPE OPENED!\n");
         if (checkcodecs)  /* WE NEED TO START OVER - CHANNEL CHANGE, NEED TO RESCAN CODECS / STREAMS! */
         {
             AUDDBG ("--CODEC CHECK REQUESTED, FLUSH VIDEO QUEUES!\n");
-            QFlush (apktQ);      // FLUSH PACKET QUEUES:
-            QFlush (pktQ);
+            apktQ->flush ();      // FLUSH PACKET QUEUES:
+            pktQ->flush ();
             if (bmp)
                 SDL_DestroyTexture (bmp);
             goto error_exit;
@@ -1801,8 +1277,8 @@ AUDDBG("---INPUT PIPE OPENED!\n");
             /* JWT:FIRST, FLUSH ANY PACKETS SITTING IN THE QUEUES TO CLEAR THE QUEUES! */
             if (! playing_a_menu && faudlen > 0)  // NO SEEKING IN MENUS, PRETTY POINTLESS!
             {
-                QFlush (apktQ);
-                QFlush (pktQ);
+                apktQ->flush ();
+                pktQ->flush ();
                 // if (LOG (av_seek_frame, ic.get (), -1, (int64_t) seek_value *
                 //        AV_TIME_BASE / 1000, AVSEEK_FLAG_BACKWARD) >= 0)
                 uint32_t dvpos = 0, dvlen = 0;
@@ -1850,33 +1326,30 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                 {
                     if (playing_a_menu) AUDDBG ("i:EOF reached in menu, continue\n"); else AUDDBG ("i:EOF reached in movie ********************\n");
                     /* FIRST, PROCESS ANYTHING STILL IN THE QUEUES: */
-                    while (apktQ->size > 0 || pktQ->size > 0)
+                    while (apktQ->size () > 0 || pktQ->size () > 0)
                     {
                         while (1)   // WE PREFER TO OUTPUT ORDERED AS AUDIO, VIDEO, AUDIO, ...
                         {
-                            if (apktQ->size > 0)  // PROCESS NEXT AUDIO FRAME IN QUEUE:
+                            if (apktQ->size () > 0)  // PROCESS NEXT AUDIO FRAME IN QUEUE:
                             {
-                                write_audioframe (& cinfo, apktQ->elements[apktQ->front], out_fmt, planar);
-                                Dequeue (apktQ);
+                                write_audioframe (apktQ->front ());
+                                apktQ->pop ();
                             }
-                            if (pktQ->size > 0)  // PROCESS NEXT VIDEO FRAME IN QUEUE:
+                            if (pktQ->size () > 0)  // PROCESS NEXT VIDEO FRAME IN QUEUE:
                             {
                                 if (myplay_video && vcodec_opened
-                                        && write_videoframe (renderer.get (), & vcinfo, bmp,
-                                                pktQ->elements[pktQ->front],
-                                                video_width, video_height, & last_resized, & windowIsStable,
-                                                & resized_window_width, & resized_window_height))
+                                        && write_videoframe (pktQ->front ()))
                                     SDL_RenderPresent (renderer.get ());
 
-                                Dequeue (pktQ);
+                                pktQ->pop ();
                             }
                             else
                                 break;
 
-                            if (apktQ->size > 0)  // PROCESS A 2ND AUDIO FRAME IN QUEUE (DO 2 AUDIOS PER VIDEO!):
+                            if (apktQ->size () > 0)  // PROCESS A 2ND AUDIO FRAME IN QUEUE (DO 2 AUDIOS PER VIDEO!):
                             {
-                                write_audioframe (& cinfo, apktQ->elements[apktQ->front], out_fmt, planar);
-                                Dequeue (apktQ);
+                                write_audioframe (apktQ->front ());
+                                apktQ->pop ();
                             }
                             else
                                 break;
@@ -1886,17 +1359,15 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                     {
                         if (myplay_video && vcodec_opened && ! menu_flushed)  /* FLUSH VIDEO CODEC TO ENSURE USER SEES ALL OF THE MENU SCREEN: */
                         {
-                            AUDINFO ("WE'RE PLAYING A MENU, FLUSH VIDEO PACKETS (writes a video frame)! Qsize=%d=\n", pktQ->size);
+                            AUDINFO ("WE'RE PLAYING A MENU, FLUSH VIDEO PACKETS (writes a video frame)! Qsize=%d=\n", pktQ->size ());
                             AVPacket * emptypkt = av_packet_alloc ();
                             if (emptypkt)
                             {
-                                if (write_videoframe (renderer.get (), & vcinfo, bmp, emptypkt,
-                                        video_width, video_height, & last_resized, & windowIsStable,
-                                        & resized_window_width, & resized_window_height))
+                                if (write_videoframe (emptypkt))
                                 {
                                     if (! menubuttons_adjusted && menubuttons.len () > 0)
-                                        menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video_width,
-                                                last_requested_height, (uint32_t)video_height);
+                                        menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video.width (),
+                                                last_requested_height, (uint32_t)video.height ());
 
                                     draw_highlight_buttons (renderer.get (), highlightbuttons, 0);
                                 }
@@ -2022,26 +1493,21 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                 // USER MAY GET A BLANK SCREEN WITH NOTHING BUT BUTTON RECTANGLES UNTIL IT HITS EOF OR
                 // UNTIL THE MUSIC / ANIMATION ENDS:
                 menu_flushed = true;    // SEEMS TO NEED TO BE HERE RATHER THAN 25 LINES BELOW?!
-                while (pktQ->size > 0)  // PROCESS REMAINING VIDEO FRAME(S) IN QUEUE:
+                while (pktQ->size () > 0)  // PROCESS REMAINING VIDEO FRAME(S) IN QUEUE:
                 {
-                    if (bmp && renderer && write_videoframe (renderer.get (), & vcinfo, bmp,
-                                pktQ->elements[pktQ->front],
-                                video_width, video_height, & last_resized, & windowIsStable,
-                                & resized_window_width, & resized_window_height))
+                    if (bmp && renderer && write_videoframe (pktQ->front ()))
                         SDL_RenderPresent (renderer.get ());
 
-                    Dequeue (pktQ);
+                    pktQ->pop ();
                 }
                 AVPacket * emptypkt = av_packet_alloc ();
                 if (emptypkt)
                 {
-                    if (bmp && renderer && write_videoframe (renderer.get (), & vcinfo, bmp, emptypkt,
-                          video_width, video_height, & last_resized, & windowIsStable,
-                          & resized_window_width, & resized_window_height))
+                    if (bmp && renderer && write_videoframe (emptypkt))
                     {
                         if (! menubuttons_adjusted && menubuttons.len () > 0)
-                            menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video_width,
-                                last_requested_height, (uint32_t)video_height);
+                            menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video.width (),
+                                last_requested_height, (uint32_t)video.height ());
 
                         draw_highlight_buttons (renderer.get (), highlightbuttons, 0);
                     }
@@ -2054,29 +1520,26 @@ AUDDBG("---INPUT PIPE OPENED!\n");
            WAITING PACKETS UNTIL AT LEAST ONE QUEUE IS EMPTIED, ORDERING OUTPUT AS AUDIO, VIDEO, AUDIO, ... 
            SINCE WE TYPICALLY HAVE TWICE AS MANY AUDIO PACKETS AS VIDEO.  THIS IS THE SECRET TO KEEPING 
            OUTPUT SYNCED & SMOOTH! */
-        if (apktQ->size == apktQ->capacity || pktQ->size == pktQ->capacity)  // ONE OF THE PACKET QUEUES IS FULL:
+        if (apktQ->full () || pktQ->full ())  // ONE OF THE PACKET QUEUES IS FULL:
         {
             while (1)  // TRY TO READ AT LEAST 1 AUDIO, THEN 1 VIDEO, BUT KEEP GOING UNTIL ONE QUEUE IS EMPTY:
             {
-                if (apktQ->size > 0)  // PROCESS NEXT AUDIO FRAME IN QUEUE:
+                if (apktQ->size () > 0)  // PROCESS NEXT AUDIO FRAME IN QUEUE:
                 {
-                    write_audioframe (& cinfo, apktQ->elements[apktQ->front], out_fmt, planar);
-                    Dequeue (apktQ);
+                    write_audioframe (apktQ->front ());
+                    apktQ->pop ();
                 }
-                if (pktQ->size > 0)  // PROCESS NEXT VIDEO FRAME IN QUEUE:
+                if (pktQ->size () > 0)  // PROCESS NEXT VIDEO FRAME IN QUEUE:
                 {
                     if (myplay_video && vcodec_opened)
                     {
-                        if (write_videoframe (renderer.get (), & vcinfo, bmp,
-                                pktQ->elements[pktQ->front],
-                                video_width, video_height, & last_resized, & windowIsStable,
-                                & resized_window_width, & resized_window_height))
+                        if (write_videoframe (pktQ->front ()))
                         {
                             if (playing_a_menu && codec_opened && ! checkcodecs)  // SHOULD ONLY NEED FOR MENUS PLAYING MUSIC:
                             {
                                 if (! menubuttons_adjusted && menubuttons.len () > 0)
-                                    menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video_width,
-                                            last_requested_height, (uint32_t)video_height);
+                                    menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video.width (),
+                                            last_requested_height, (uint32_t)video.height ());
 
                                 draw_highlight_buttons (renderer.get (), highlightbuttons, 0);
                             }
@@ -2089,26 +1552,23 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                             menu_written = true;
                         }
                     }
-                    Dequeue (pktQ);
+                    pktQ->pop ();
                 }
                 else
                     break;
 
-                if (apktQ->size > 0)  // PROCESS A 2ND AUDIO FRAME IN QUEUE (DO 2 AUDIOS PER VIDEO!):
+                if (apktQ->size () > 0)  // PROCESS A 2ND AUDIO FRAME IN QUEUE (DO 2 AUDIOS PER VIDEO!):
                 {
-                    write_audioframe (& cinfo, apktQ->elements[apktQ->front], out_fmt, planar);
-                    Dequeue (apktQ);
+                    write_audioframe (apktQ->front ());
+                    apktQ->pop ();
                 }
                 else
                 {
-                    if (pktQ->size > 2)
+                    if (pktQ->size () > 2)
                     {   // PROCESS AN EXTRA VIDEO PKT WHEN AUDIO Q EMPTY & A BUNCH OF VIDEO PKTS REMAIN, IE. HD VIDEOS (MAKES 'EM SMOOTHER):
                         if (myplay_video && vcodec_opened)
                         {
-                            if (write_videoframe (renderer.get (), & vcinfo, bmp,
-                                    pktQ->elements[pktQ->front],
-                                    video_width, video_height, & last_resized, & windowIsStable,
-                                    & resized_window_width, & resized_window_height) && playing_a_menu)
+                            if (write_videoframe (pktQ->front ()) && playing_a_menu)
                             {
                                 draw_highlight_buttons (renderer.get (), highlightbuttons, 0);
                                 if (playing_a_menu)
@@ -2118,7 +1578,7 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                                 }
                             }
                         }
-                        Dequeue (pktQ);
+                        pktQ->pop ();
                     }
                     break;
                 }
@@ -2131,14 +1591,14 @@ AUDDBG("---INPUT PIPE OPENED!\n");
             {
                 if (codec_opened && pkt && pkt->stream_index == cinfo.stream_idx)  /* WE READ AN AUDIO PACKET: */
                 {
-                    if (! Enqueue (apktQ, pkt))
+                    if (! apktQ->push (pkt))
                         av_packet_free (& pkt);
                 }
                 else
                 {
                     if (vcodec_opened)
                     {
-                        if (pkt && (pkt->stream_index != vcinfo.stream_idx || ! Enqueue (pktQ, pkt)))  /* WE READ A VIDEO PACKET: */
+                        if (pkt && (pkt->stream_index != vcinfo.stream_idx || ! pktQ->push (pkt)))  /* WE READ A VIDEO PACKET: */
                             av_packet_free (& pkt);
                     }
                     else   /* IGNORE ANY OTHER SUBSTREAMS */
@@ -2236,49 +1696,25 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                     }
                     break;
                 case SDL_WINDOWEVENT:
+                    if (video.handle_event (event.window))
+                        break;
+
                     bool moved = false;
                     switch (event.window.event)
                     {
-                        case SDL_WINDOWEVENT_CLOSE:  /* USER CLICKED THE "X" IN UPPER-RIGHT CORNER, KILL VIDEO WINDOW BUT KEEP PLAYING AUDIO! */
-                            AUDINFO ("i:SDL_CLOSE (User killed video window for this play)!\n");
-                            if (sdl_window)
-                            {
-                                /* DISABLE "video_display" VISUALIZATION PLUGIN (WHICH WILL HIDE THE VIDEO WINDOW! */
-                                /* (THIS IS HOW ALL OTHER VISUALIZATION PLUGINS WORK) */
-                                save_window_xy (sdl_window, video_window_x, video_window_y,
-                                        init_window_x, init_window_y, video_display_at_startup);
-                                PluginHandle * visHandle = aud_plugin_lookup_basename ("video_display");
-                                aud_plugin_enable (visHandle, false);  // DISABLE VIDEO VISUALIZATION PLUGIN!
-                            }
-                            break;
-                        case SDL_WINDOWEVENT_RESIZED:  /* WINDOW CHANGED SIZE EITHER BY US OR BY USER DRAGGING WINDOW CORNER (WE DON'T KNOW WHICH HERE) */
-                            AUDINFO ("i:SDL_RESIZE!!!!!! rvw=%d h=%d\n", resized_window_width, resized_window_height);
-                            // if (! windowNowExposed)
-                            if (! windowNowExposed && ! windowIsStable)  // ADDED STABLE TEST TO ALLOW SOME MENUS TO BE USER-RESIZED.
-                                break;
-
-                            /* Resize the sdl_window. */
-                            resized_window_width = event.window.data1;  // window's reported new size
-                            resized_window_height = event.window.data2;
-                            last_resized = false;  // false means now we'll need re-aspecting, so stop blitting!
-                            if (noresize_optimizations)
-                                last_resizeevent_time = time (nullptr);  // reset the wait counter for when to assume user's done dragging window corner.
-                            // menubuttons_adjusted = false;
-
-                            break;
                         // NOTE: ON LINUX, AT LEAST, MOVING OR RESIZING WINDOW SPEWS "EXPOSED" EVENTS WHILST CHANGING!:
                         case SDL_WINDOWEVENT_MOVED:  // USER MOVED WINDOW.
                             AUDINFO ("i:WINDOW MOVED, EXPOSING!\n");
                             moved = true;
                         case SDL_WINDOWEVENT_EXPOSED:  // WINDOW WENT FROM UNDERNEITH ANOTHER TO VISIBLE (CLICKED ON?)
-                            if (last_resized && (moved || difftime (time (nullptr), last_resizeevent_time) > video_resizedelay))
+                            if (! video.resizing () && (moved || video.since_resize () > video.resize_delay ()))
                             {
-                                if (windowNowExposed) AUDINFO ("i:WINDOW (was) EXPOSED!\n"); else AUDINFO ("i:WINDOW (was NOT) EXPOSED!\n");
+                                if (video.exposed ()) AUDINFO ("i:WINDOW (was) EXPOSED!\n"); else AUDINFO ("i:WINDOW (was NOT) EXPOSED!\n");
                                 if (playing_a_menu)
                                 {
                                     if (! menubuttons_adjusted && playing_a_menu && menubuttons.len () > 0)
-                                        menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video_width,
-                                                last_requested_height, (uint32_t)video_height);
+                                        menubuttons_adjusted = adjust_menubuttons (last_requested_width, (uint32_t)video.width (),
+                                                last_requested_height, (uint32_t)video.height ());
 
                                     SDL_RenderCopy (renderer.get (), bmp, nullptr, nullptr);
                                     draw_highlight_buttons (renderer.get (), highlightbuttons, 0);
@@ -2286,186 +1722,27 @@ AUDDBG("---INPUT PIPE OPENED!\n");
                                 else
                                     SDL_RenderPresent (renderer.get ());
 
-                                windowNowExposed = true;
+                                video.set_exposed ();
                             }
-                            last_resizeevent_time = time (nullptr);  // reset the wait counter for when to assume user's done dragging window corner.
-                            break;
-                        case SDL_WINDOWEVENT_HIDDEN:
-                            /* SOME WMS SEEM TO SEND A "SHOW" EVENT IMMEDIATELY AFTER SOME "HIDE" EVENTS?! */
-                            break;
-                        case SDL_WINDOWEVENT_SHOWN:
-                            /* UNDO IMMEDIATE (RE)SHOW-ON-HIDE CAUSED BY SOME WMS! */
-                            if (! aud_get_bool ("audacious", "video_display"))
-                                SDL_HideWindow (sdl_window);
+                            video.restart_resize_wait ();  // reset the wait counter for when to assume user's done dragging window corner.
                             break;
                     }
             }
         }
-        if (! last_resized)  /* IF WINDOW CHANGED SIZE (SINCE LAST RE-ASPECTING): */
-        {
-            if (! noresize_optimizations  // OPTIMIZE MOSTLY MEANS NOT NEEDING TIMER/DELAY:
-                    || ! windowIsStable || difftime (time (nullptr), last_resizeevent_time) > video_resizedelay)
-            {
-                AUDDBG ("----RESIZE THE WINDOW!----\n");
-                float new_aspect_ratio;  // ASPECT (for comparing), W, & H OF WINDOW AFTER USER DONE RESIZING:
-                int new_video_width;     // WILL ADJUST ONE OF THESE TO RESTORE TO VIDEO'S PROPER ASPECT
-                int new_video_height;    // THEN RESIZE (RE-ASPECT) THE WINDOW TO KEEP ASPECT CONSTANT!
-                last_requested_width = video_width;
-                last_requested_height = video_height;
-                /* CALCULATE THE RESIZED WINDOW'S ASPECT RATIO */
-                new_aspect_ratio = resized_window_height
-                    ? (float)resized_window_width / (float)resized_window_height : 1.0;
-                if (videohasnowh)
-                {
-                    video_aspect_ratio = new_aspect_ratio;
-                    AUDINFO ("---RESIZE(videohasnowh): NEW RATIO=%f=\n", video_aspect_ratio);
-                    videohasnowh = false;
-                }
-                /* NOW MANUALLY ADJUST EITHER THE WIDTH OR HEIGHT BASED ON USER'S CONFIG. TO RESTORE
-                   THE NEW WINDOW TO THE PROPER ASPECT RATIO FOR THE CURRENTLY-PLAYING VIDEO:
-                */
-                /* USER SHRANK THE WINDOW BELOW "DORESET" THRESHOLD (user-configurable) SO RESIZE TO VIDEO'S ORIGINALLY REQUESTED (IDEAL) SIZE: */
-                if (resized_window_width <  video_doreset_width && resized_window_height <  video_doreset_height)
-                {
-                    new_video_width = video_requested_width;
-                    new_video_height = video_requested_height;
-                }
-                else if (vy == -1)  // USER SAYS ADJUST HEIGHT TO MATCH WIDTH:
-                {
-                    new_video_height = resized_window_height;
-                    new_video_width = (int)(video_aspect_ratio * (float)new_video_height);
-                }
-                else if (vx == -1)  // USER SAYS ADJUST WIDTH TO MATCH HEIGHT:
-                {
-                    new_video_width = resized_window_width;
-                    new_video_height = (int)((float)new_video_width / video_aspect_ratio);
-                }
-                /* USER DOESN'T CARE, SO WE DECIDE WHICH TO ADJUST: */
-                else if (resized_window_width < video_width || resized_window_height < video_height)
-                {
-                    if (new_aspect_ratio > video_aspect_ratio)  // WINDOW SHRANK & BECAME MORE HORIZONTAL - ADJUST WIDTH TO NEW HEIGHT:
-                    {
-                        new_video_height = resized_window_height;
-                        new_video_width = (int)(video_aspect_ratio * (float)new_video_height);
-                    }
-                    else  // WINDOW SHRANK & BECAME MORE VERTICAL - ADJUST HEIGHT TO NEW WIDTH:
-                    {
-                        new_video_width = resized_window_width;
-                        new_video_height = (int)((float)new_video_width / video_aspect_ratio);
-                    }
-                }
-                else if (new_aspect_ratio > video_aspect_ratio)  // WINDOW GREW & BECAME MORE HORIZONTAL - ADJUST HEIGHT TO NEW WIDTH:
-                {
-                    new_video_width = resized_window_width;
-                    new_video_height = (int)((float)new_video_width / video_aspect_ratio);
-                }
-                else  // WINDOW GREW & BECAME MORE VERTICAL - ADJUST WIDTH TO NEW HEIGHT:
-                {
-                    new_video_height = resized_window_height;
-                    new_video_width = (int)(video_aspect_ratio * (float)new_video_height);
-                }
-                video_width = new_video_width;
-                video_height = new_video_height;
-                /* NOW MANUALLY RESIZE (RE-ASPECT) WINDOW BASED ON VIDEO'S ORIGINALLY-CALCULATED ASPECT RATIO: */
-                SDL_SetWindowSize (sdl_window, video_width, video_height);
-                SDL_Delay (50);
-                last_resized = true;  // WE'VE RE-ASPECTED, SO ALLOW BLITTING TO RESUME!
-                SDL_RenderPresent (renderer.get ());  // only blit a single frame at startup will get refreshed!
-                windowNowExposed = true;
-            }
-        }
-        if (needWinSzFudge && windowIsStable && aud_get_bool ("audacious", "video_display"))
+        if (video.reaspect_due (! video.stable ()))  /* IF WINDOW CHANGED SIZE (SINCE LAST RE-ASPECTING): */
         {
-#if SDL_COMPILEDVERSION < 4601
-            int x, y;
-
-            /* FETCH UNDECORATED WINDOW'S (SDL) COORDS AFTER (RANDOM?) INITIAL W/M PLACEMENT: */
-            SDL_GetWindowPosition (sdl_window, &x, &y);
-            as_decor_fudge_x = video_window_x - x;
-            as_decor_fudge_y = video_window_y - y;
-            AUDDBG ("FUDGE SET(x=%d y=%d) vw=(%d, %d) F=(%d, %d)\n", x, y, video_window_x,
-                    video_window_y, init_window_x, init_window_y);
-            if ((as_decor_fudge_x || as_decor_fudge_y)
-                    && (! aud_get_bool ("audacious", "afterstep")))
-            {
-                /* JWT:FOR RECENT SDL2 VSNS (SEE ABOVE), AFTERSTEP NEEDS THIS TOO!
-                   MOST WMS PLACE WINDOWS BASED ON THE RAW WINDOW EXCLUDING DECORATIONS, BUT
-                   AFTERSTEP, AND PERHAPS SOME OTHERS?, INCLUDE DECORATIONS, RESULTING IN WINDOWS
-                   BEING PLACED A BIT LOWER AND TO RIGHT (RESULTING IN THIS RECALCULATED FUDGE-FACTOR
-                   BEING THE WxH OF THE WINDOW'S DECORATIONS - NORMALLY WILL BE 0, 0 FOR MOST WMS)!:
-                */
-                SDL_SetWindowPosition (sdl_window, x+as_decor_fudge_x, y+as_decor_fudge_y);
-                SDL_GetWindowPosition (sdl_window, &x, &y);
-                as_decor_fudge_x = video_window_x - x;
-                as_decor_fudge_y = video_window_y - y;
-                AUDDBG ("WINDOW MOVED BY FUDGE AND FUDGE RESET TO 0,0 (WERE NOT RUNNING AFTERSTEP)!\n");
-            }
-#else
-            int x, y, sdl_init_fudge_x, sdl_init_fudge_y;
-            /* FETCH UNDECORATED WINDOW'S (SDL) COORDS AFTER (RANDOM?) INITIAL W/M PLACEMENT: */
-            SDL_GetWindowPosition (sdl_window, &x, &y);
-            /* JWT:FOR RECENT SDL2 VSNS (SEE ABOVE), AFTERSTEP NEEDS THIS TOO (BUT WILL HAVE A FUDGE
-               FOR DECORATIONS)!
-               MOST WMS PLACE WINDOWS BASED ON THE RAW WINDOW EXCLUDING DECORATIONS, BUT AFTERSTEP,
-               AND PERHAPS SOME OTHER OLDER ONES, INCLUDE DECORATIONS, RESULTING IN WINDOWS
-               BEING PLACED A BIT LOWER AND TO RIGHT (RESULTING IN THIS RECALCULATED FUDGE-FACTOR
-               BEING THE WxH OF THE WINDOW'S DECORATIONS - NORMALLY WILL BE 0, 0 FOR MOST WMS)!:
-               NOTE:  THERE ARE ACTUALLY 2 "FUDGE" FACTORS (OFFSETS) WE HAVE TO ACCOUNT FOR:
-               1)  SDL / WINDOW-MANAGER RETURNING RANDOM COORDINATES BEFORE 1ST BLIT (as_decor_fudge_*), AND
-               2)  THE WxH OF WINDOW-DECORATIONS (FOR AfterStep & PERHAPS SOME OTHER WMs) THAT
-               PLACE WINDOWS BASED TON UPPER-LEFT CORNER OF THE TITALBAR AND SDL, WHICH USES THE
-               UPPER-LEFT CORNER OF THE UNDECORATED WINDOW! (sdl_init_*).
-               THE FORMER ONLY APPLIES ON INITIAL PLACEMENT, THE OTHER, AFFECTS EVERY Get/SetWindowPosition().
-            */
-            if (as_decor_fudge_set)  // CONVERT WM'S COORDS TO SDL'S (UNDECORATED WINDOW) COORDS:
-            {
-                if (video_display_at_startup)
-                {
-                    sdl_init_fudge_x = as_decor_fudge_x;  // USUALLY 0,0 (SAME) FOR MODERN WMs BUT NOT Afterstep!
-                    sdl_init_fudge_y = as_decor_fudge_y;
-                }
-                else
-                    sdl_init_fudge_x = sdl_init_fudge_y = 0;  // USUALLY 0,0 (SAME) FOR MODERN WMs BUT NOT Afterstep!
-
-                AUDDBG ("--ASD FUDGE IS SET: (%d, %d) VW(%d, %d) - FETCHEDxy(%d, %d)\n",
-                        sdl_init_fudge_x, sdl_init_fudge_y, video_window_x, video_window_y, x,y);
-                if (sdl_init_fudge_x == 0 && sdl_init_fudge_y == 0
-                        && aud_get_bool ("audacious", "afterstep"))  //JWT:NOTE: MAY NOT NEED AS-TEST HERE?
-                {
-                    x = video_window_x; //JWT:IGNORE CURRENT PLACEMENT IF INITIAL FUDGE IS (0,0):
-                    y = video_window_y;
-                }
-            }
-            else  // CALCULATE HOW FAR WINDOW WILL BE "MOVED" WHEN WE PLACE IT (ONLY HAPPENS ON 1ST VIDEO PLAYED):
+            AUDDBG ("----RESIZE THE WINDOW!----\n");
+            last_requested_width = video.width ();
+            last_requested_height = video.height ();
+            if (videohasnowh)
             {
-                sdl_init_fudge_x = video_window_x - x;  // WHERE WE WANT IT - WHERE IT WAS INITIALLY PLACED.
-                sdl_init_fudge_y = video_window_y - y;
-                AUDDBG ("--ASD FUDGE NOT SET: VW(%d, %d) - FETCHEDxy(%d, %d)\n", video_window_x,
-                        video_window_y, x,y);
+                video.take_window_aspect ();
+                videohasnowh = false;
             }
-            /* PLACE IT WHERE WE WANT IT. (SDL COORDINATES MATCHING  SAVED IN CONFIG FILE): */
-            AUDDBG ("--SET WINDOW TO (%d, %d) USING INIT FUDGE (%d, %d):\n", x+sdl_init_fudge_x,
-                    y+sdl_init_fudge_y, sdl_init_fudge_x, sdl_init_fudge_y);
-            SDL_Delay (50);
-            /* NOW FETCH BACK THE COORDINATES (WILL BE SDL COORDINATES (UNDECORATED WINDOW)): */
-            SDL_GetWindowPosition (sdl_window, & init_window_x, & init_window_y);
-            if (! as_decor_fudge_set) // 1ST VIDEO: SAVE WINDOW-DECORATION W/H (FOR AfterStep, etc.):
-            {
-                as_decor_fudge_x = video_window_x - init_window_x;  // DECORATION W,H FOR AfterStep,
-                as_decor_fudge_y = video_window_y - init_window_y;  // OR 0,0 FOR (MOST) OTHER WMs.
-                if (video_display_at_startup)
-                    as_decor_fudge_set = true;
-
-                AUDDBG ("---SET ASDECOR FUDGE:=VW(%d, %d) - FETCHED INITxy(%d, %d)\n", video_window_x,
-                        video_window_y, init_window_x, init_window_y);
-                init_window_x += as_decor_fudge_x;  // CONVERT SET SDL COORDS BACK TO WM COORDINATES
-                init_window_y += as_decor_fudge_y;  // USED WHEN SAVING TO SEE IF WINDOW MOVED BY USER:
-            }
-            AUDDBG ("--PLACED WINDOW REQ(%d, %d) INIT=(%d, %d)\n", video_window_x, video_window_y,
-                    init_window_x, init_window_y);
-#endif
-            needWinSzFudge = false;  // WE HAVE OUR DECORATION FUDGE-FACTOR (IF ANY)!
+            video.reaspect ();
+            SDL_RenderPresent (renderer.get ());  // only blit a single frame at startup will get refreshed!
         }
+        video.place ();
     }  // END PACKET-PROCESSING LOOP.
 
     }  // END OF SUBSCOPE FOR DECLARING SDL2 TEXTURE AS SCOPED SMARTPOINTER (FREES TEXTURE).
@@ -2473,32 +1750,16 @@ AUDDBG("---INPUT PIPE OPENED!\n");
 error_exit:  /* WE END UP HERE WHEN PLAYBACK IS STOPPED: */
 
     AUDINFO ("end of playback.\n");
-    if (apktQ)
-        destroyQueue (apktQ);
-    apktQ = nullptr;     // QUEUE FOR AUDIO-PACKET QUEUEING.
-    if (pktQ)
-        destroyQueue (pktQ);
-    pktQ = nullptr;      // QUEUE FOR VIDEO-PACKET QUEUEING.
+    delete apktQ;        // QUEUE FOR AUDIO-PACKET QUEUEING.
+    apktQ = nullptr;
+    delete pktQ;         // QUEUE FOR VIDEO-PACKET QUEUEING.
+    pktQ = nullptr;
 
     /* CLOSE UP THE CODECS, ETC.: */
     if (codec_opened)
-    {
-#ifdef ALLOC_CONTEXT
-        avcodec_free_context (& cinfo.context);
-        av_free (cinfo.context);
-#else
-        avcodec_close (cinfo.context);
-#endif
-    }
+        av_close_codec (cinfo);
     if (vcodec_opened)
-    {
-#ifdef ALLOC_CONTEXT
-        avcodec_free_context (& vcinfo.context);
-        av_free (vcinfo.context);
-#else
-        avcodec_close (vcinfo.context);
-#endif
-    }
+        av_close_codec (vcinfo);
 
     }  // END OF SUBSCOPE FOR STARTOVER (FREES AVStuff)!
     if (checkcodecs)
@@ -2518,16 +1779,8 @@ error_exit:  /* WE END UP HERE WHEN PLAYBACK IS STOPPED: */
 
     }  // END OF SUBSCOPE FOR DECLARING SDL2 RENDERER AS SCOPED SMARTPOINTER (FREES RENDERER).
 
-    if (sdl_window)  // bmp ALREADY FREED & NOW OUT OF SCOPE BUT MAKE SURE VIDEO WINDOW IS FREED & GONE!
-    {
-        if (! needWinSzFudge)
-            save_window_xy (sdl_window, video_window_x, video_window_y,
-                    init_window_x, init_window_y, video_display_at_startup);
-
-        SDL_HideWindow (sdl_window);
-        /* NOTIFY video_display VISUALIZATION PLUGIN WE'RE NOT DEMUXING VIDEO. */
-        aud_set_bool ("audacious", "_video_playing", false);
-    }
+    /* bmp ALREADY FREED & NOW OUT OF SCOPE BUT MAKE SURE VIDEO WINDOW IS HIDDEN & GONE! */
+    video.finish (video.placed ());
     playback_thread_running = false;
     AUDINFO ("READER THREAD RETURNING!\n");
 
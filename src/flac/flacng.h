@@ -69,6 +69,7 @@ struct callback_info
     unsigned buffer_used = 0;
     VFSFile *fd = nullptr;
     int bitrate = 0;
+    FLAC__uint64 frame_sample = 0;  /* first sample of the decoded frame */
 
     void alloc()
     {
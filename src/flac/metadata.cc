@@ -138,6 +138,31 @@ static void insert_int_tuple_to_vc (FLAC__StreamMetadata * vc_block,
         vc_block->data.vorbis_comment.num_comments, entry, true);
 }
 
+/* a tuple without ReplayGain values leaves those in the file alone */
+static void insert_gain_tuple_to_vc (FLAC__StreamMetadata * vc_block,
+ const Tuple & tuple, Tuple::Field field, Tuple::Field divisor_field,
+ const char * field_name)
+{
+    FLAC__StreamMetadata_VorbisComment_Entry entry;
+    int divisor = tuple.get_int (divisor_field);
+
+    if (tuple.get_value_type (field) != Tuple::Int || divisor <= 0)
+        return;
+
+    FLAC__metadata_object_vorbiscomment_remove_entries_matching (vc_block,
+        field_name);
+
+    double val = (double) tuple.get_int (field) / divisor;
+    StringBuf str = (divisor_field == Tuple::PeakDivisor) ?
+        str_printf ("%s=%.6f", field_name, val) :
+        str_printf ("%s=%.2f dB", field_name, val);
+
+    entry.entry = (FLAC__byte *) (char *) str;
+    entry.length = strlen(str);
+    FLAC__metadata_object_vorbiscomment_insert_comment(vc_block,
+        vc_block->data.vorbis_comment.num_comments, entry, true);
+}
+
 bool FLACng::write_tuple(const char *filename, VFSFile &file, const Tuple &tuple)
 {
     AUDDBG ("Update song tuple.\n");
@@ -197,6 +222,11 @@ bool FLACng::write_tuple(const char *filename, VFSFile &file, const Tuple &tuple
     insert_str_tuple_to_vc(vc_block, tuple, Tuple::CatalogNum, "CATALOGNUMBER");
     insert_str_tuple_to_vc(vc_block, tuple, Tuple::Performer, "PERFORMER");
 
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::TrackGain, Tuple::GainDivisor, "REPLAYGAIN_TRACK_GAIN");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::TrackPeak, Tuple::PeakDivisor, "REPLAYGAIN_TRACK_PEAK");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::AlbumGain, Tuple::GainDivisor, "REPLAYGAIN_ALBUM_GAIN");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::AlbumPeak, Tuple::PeakDivisor, "REPLAYGAIN_ALBUM_PEAK");
+
     FLAC__metadata_iterator_delete(iter);
     FLAC__metadata_chain_sort_padding(chain);
 
@@ -30,6 +30,28 @@ EXPORT FLACng aud_plugin_instance;
 static FLAC__StreamDecoder *decoder, *ogg_decoder;
 static callback_info *cinfo;
 
+/* When a cue sheet splits one large image into several playlist entries, each
+ * entry is played by a separate call to play () that would normally reset the
+ * decoder, re-read the metadata and seek.  Instead, when a segment is stopped
+ * at its end time, we keep the decoder state (and the last decoded frame, part
+ * of which belongs to the next segment) so that if the next segment of the same
+ * file starts where this one ended, decoding simply continues. */
+static struct {
+    String filename;
+    FLAC__StreamDecoder *decoder = nullptr;
+    int64_t file_pos = 0;
+    FLAC__uint64 frame_sample = 0;
+    unsigned frame_samples = 0;     /* per channel */
+    Index<char> frame;              /* holds the converted output of the last frame */
+} segment;
+
+static void segment_clear()
+{
+    segment.filename = String();
+    segment.decoder = nullptr;
+    segment.frame.clear();
+}
+
 bool FLACng::init()
 {
     FLAC__StreamDecoderInitStatus ret;
@@ -83,6 +105,7 @@ bool FLACng::init()
 
 void FLACng::cleanup()
 {
+    segment_clear();
     if (ogg_decoder)  FLAC__stream_decoder_delete(ogg_decoder);
     FLAC__stream_decoder_delete(decoder);
     delete cinfo;
@@ -159,17 +182,21 @@ bool FLACng::play(const char *filename, VFSFile &file)
 {
     Index<char> play_buffer;
     bool error = false;
+    bool stopped = false;
     bool stream = (file.fsize () < 0);
-    Tuple tuple;
+    Tuple tuple = get_playback_tuple ();
+    bool is_segment = (! stream && tuple.get_int (Tuple::EndTime) > 0);
+    int start_time = tuple.get_int (Tuple::StartTime);
+    FLAC__uint64 last_sample = 0;
+    unsigned last_samples = 0;
+    bool resuming = false;
+
     if (stream)
     {
-        tuple = get_playback_tuple ();
         if (audtag::read_tag (file, tuple, nullptr))
             set_playback_tuple (tuple.ref ());
     }
 
-    cinfo->fd = &file;
-
     FLAC__StreamDecoder *which_decoder = decoder;
     if (FLAC_API_SUPPORTS_OGG_FLAC && ogg_decoder)
     {
@@ -177,14 +204,32 @@ bool FLACng::play(const char *filename, VFSFile &file)
         if (mime && strstr(mime, "ogg"))  which_decoder = ogg_decoder;
     }
 
-    if (read_metadata(which_decoder, cinfo) == false)
+    cinfo->fd = &file;
+
+    if (segment.filename && start_time > 0 && ! stream
+            && ! strcmp(segment.filename, filename) && segment.decoder == which_decoder
+            && ! file.fseek (segment.file_pos, VFS_SEEK_SET))
     {
-        AUDERR ("Could not prepare file for playing!\n");
-        error = true;
-        goto ERR_NO_CLOSE;
+        AUDDBG("Continuing decoder session at %d ms.\n", start_time);
+        resuming = true;
+        play_buffer = std::move(segment.frame);
+        last_sample = segment.frame_sample;
+        last_samples = segment.frame_samples;
     }
 
-    play_buffer.resize(BUFFER_SIZE_BYTE);
+    segment_clear();
+
+    if (! resuming)
+    {
+        if (read_metadata(which_decoder, cinfo) == false)
+        {
+            AUDERR ("Could not prepare file for playing!\n");
+            error = true;
+            goto ERR_NO_CLOSE;
+        }
+
+        play_buffer.resize(BUFFER_SIZE_BYTE);
+    }
 
     set_stream_bitrate(cinfo->bitrate);
 
@@ -196,12 +241,39 @@ bool FLACng::play(const char *filename, VFSFile &file)
     while (FLAC__stream_decoder_get_state(which_decoder) != FLAC__STREAM_DECODER_END_OF_STREAM)
     {
         if (check_stop ())
+        {
+            stopped = true;
             break;
+        }
 
         int seek_value = check_seek ();
+
+        /* the core should already have asked us to seek to the start time */
+        if (resuming && seek_value < 0)
+            seek_value = start_time;
+
         if (seek_value >= 0)
-            FLAC__stream_decoder_seek_absolute (which_decoder, (int64_t)
-             seek_value * cinfo->sample_rate / 1000);
+        {
+            FLAC__uint64 target = (int64_t) seek_value * cinfo->sample_rate / 1000;
+
+            if (resuming && target >= last_sample && target <= last_sample + last_samples)
+            {
+                /* the start of the segment is in (or just after) the retained frame */
+                unsigned frame_size = cinfo->channels * SAMPLE_SIZE(cinfo->bits_per_sample);
+                unsigned skip = target - last_sample;
+
+                if (skip < last_samples)
+                    write_audio(play_buffer.begin() + skip * frame_size,
+                     (last_samples - skip) * frame_size);
+            }
+            else
+                FLAC__stream_decoder_seek_absolute (which_decoder, target);
+
+            resuming = false;
+            continue;
+        }
+
+        resuming = false;
 
         /* Try to decode a single frame of audio */
         if (FLAC__stream_decoder_process_single(which_decoder) == false)
@@ -219,9 +291,32 @@ bool FLACng::play(const char *filename, VFSFile &file)
         write_audio(play_buffer.begin(), cinfo->buffer_used *
          SAMPLE_SIZE(cinfo->bits_per_sample));
 
+        last_sample = cinfo->frame_sample;
+        last_samples = cinfo->channels ? cinfo->buffer_used / cinfo->channels : 0;
+
         cinfo->reset();
     }
 
+    if (is_segment && stopped && ! error)
+    {
+        int64_t pos = file.ftell ();
+
+        if (pos >= 0)
+        {
+            segment.filename = String(filename);
+            segment.decoder = which_decoder;
+            segment.file_pos = pos;
+            segment.frame_sample = last_sample;
+            segment.frame_samples = last_samples;
+            segment.frame = std::move(play_buffer);
+
+            /* keep the decoder state; the next segment may continue from here */
+            cinfo->reset();
+            cinfo->fd = nullptr;
+            return true;
+        }
+    }
+
 ERR_NO_CLOSE:
     cinfo->reset();
 
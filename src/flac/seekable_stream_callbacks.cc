@@ -125,6 +125,10 @@ FLAC__StreamDecoderWriteStatus write_callback(const FLAC__StreamDecoder *decoder
     if (!info->output_buffer.len())
         info->alloc();
 
+    /* libFLAC always reports a sample number here, trimmed to the seek target */
+    if (frame->header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER)
+        info->frame_sample = frame->header.number.sample_number;
+
     for (unsigned sample = 0; sample < frame->header.blocksize; sample++)
     {
         for (unsigned channel = 0; channel < frame->header.channels; channel++)
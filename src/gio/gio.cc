@@ -22,12 +22,15 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <utility>
+
 #include <gio/gio.h>
 
 #include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/i18n.h>
 #include <libfauxdcore/interface.h>
 #include <libfauxdcore/plugin.h>
+#include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
 
 static const char gio_about[] =
@@ -39,10 +42,16 @@ static const char * const gio_schemes[] = {"ftp", "sftp", "smb", "mtp"};
 class GIOTransport : public TransportPlugin
 {
 public:
-    static constexpr PluginInfo info = {N_("GIO Plugin"), PACKAGE, gio_about};
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {N_("GIO Plugin"), PACKAGE, gio_about, & prefs};
 
     constexpr GIOTransport () : TransportPlugin (info, gio_schemes) {}
 
+    bool init ();
+
     VFSImpl * fopen (const char * path, const char * mode, String & error);
     VFSFileTest test_file (const char * filename, VFSFileTest test, String & error);
     Index<String> read_folder (const char * filename, String & error);
@@ -50,6 +59,25 @@ public:
 
 EXPORT GIOTransport aud_plugin_instance;
 
+const char * const GIOTransport::defaults[] = {
+    "readahead_kb", "256",
+    nullptr
+};
+
+const PreferencesWidget GIOTransport::widgets[] = {
+    WidgetSpin (N_("Read-ahead buffer:"),
+        WidgetInt ("gio", "readahead_kb"),
+        {0, 4096, 64, N_("KiB (0 = off)")})
+};
+
+const PluginPreferences GIOTransport::prefs = {{widgets}};
+
+bool GIOTransport::init ()
+{
+    aud_config_set_defaults ("gio", defaults);
+    return true;
+}
+
 class GIOFile : public VFSImpl
 {
 public:
@@ -82,6 +110,40 @@ private:
     GOutputStream * m_ostream = nullptr;
     GSeekable * m_seekable = nullptr;
     bool m_eof = false;
+
+    /* Files opened read-only are read in blocks of m_bufsize bytes, and the
+     * next block is requested asynchronously while the current one is being
+     * consumed, so that small reads and seeks on network mounts don't each
+     * cost a round trip.  m_buf holds file data starting at m_buf_start; the
+     * logical position is m_buf_start + m_buf_pos. */
+    int m_bufsize = 0;
+    Index<char> m_buf;
+    int64_t m_buf_start = 0;
+    int m_buf_pos = 0;
+
+    Index<char> m_next;             /* block being prefetched */
+    int64_t m_next_start = 0;
+    bool m_prefetching = false;     /* read in progress into m_next */
+    bool m_next_valid = false;      /* m_next holds a completed read */
+    bool m_stream_eof = false;      /* underlying stream is at its end */
+    GMainContext * m_context = nullptr;
+
+    int64_t m_stream_pos = 0;       /* position of the underlying stream */
+    int64_t m_size = -1;            /* from g_file_query_info, if read-only */
+
+    /* statistics, reported at close */
+    int m_reads = 0;
+    int64_t m_read_bytes = 0;
+    int m_round_trips = 0;
+    int m_local_seeks = 0;
+
+    int64_t read_direct (void * buf, int64_t size);
+    bool refill ();
+    void start_prefetch ();
+    void finish_prefetch ();
+    void drop_buffers ();
+
+    static void prefetch_done (GObject * source, GAsyncResult * result, void * data);
 };
 
 #define CHECK_ERROR(op, name) do { \
@@ -125,6 +187,26 @@ GIOFile::GIOFile (const char * filename, const char * mode) :
             m_istream = (GInputStream *) g_file_read (m_file, 0, & error);
             CHECK_AND_SAVE_ERROR ("open", filename);
             m_seekable = (GSeekable *) m_istream;
+
+            /* the size can't change while we have the file open for reading
+             * only, so it is looked up once here; decoders take a size to
+             * mean the file can be seeked, so streams that can't be have none */
+            GFileInfo * info = g_seekable_can_seek (m_seekable) ?
+             g_file_query_info (m_file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+             G_FILE_QUERY_INFO_NONE, nullptr, nullptr) : nullptr;
+
+            if (info)
+            {
+                if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+                    m_size = g_file_info_get_size (info);
+
+                g_object_unref (info);
+            }
+
+            m_bufsize = aud::clamp (aud_get_int ("gio", "readahead_kb"), 0, 4096) * 1024;
+
+            if (m_bufsize)
+                m_context = g_main_context_new ();
         }
         break;
     case 'w':
@@ -177,6 +259,17 @@ GIOFile::~GIOFile ()
 {
     GError * error = nullptr;
 
+    if (m_bufsize)
+    {
+        finish_prefetch ();
+        g_main_context_unref (m_context);
+    }
+
+    if (m_reads)
+        AUDDBG ("%s: %d reads averaging %d bytes, %d round trips, %d seeks "
+         "within the buffer.\n", (const char *) m_filename, m_reads,
+         (int) (m_read_bytes / m_reads), m_round_trips, m_local_seeks);
+
     if (m_iostream)
     {
         g_io_stream_close (m_iostream, 0, & error);
@@ -214,25 +307,24 @@ VFSImpl * GIOTransport::fopen (const char * filename, const char * mode, String
     }
 }
 
-int64_t GIOFile::fread (void * buf, int64_t size, int64_t nitems)
+int64_t GIOFile::read_direct (void * buf, int64_t size)
 {
     GError * error = nullptr;
-
-    if (! m_istream)
-    {
-        AUDERR ("Cannot read from %s: not open for reading.\n", (const char *) m_filename);
-        return 0;
-    }
-
     int64_t total = 0;
-    int64_t remain = size * nitems;
+    int64_t remain = size;
 
     while (remain > 0)
     {
         int64_t part = g_input_stream_read (m_istream, buf, remain, 0, & error);
+        m_round_trips ++;
         CHECK_ERROR ("read from", m_filename);
 
-        m_eof = (part == 0);
+        /* with read-ahead, reaching the end of the stream does not mean the
+         * caller has; feof() works that out from the buffers */
+        if (m_bufsize)
+            m_stream_eof = (part == 0);
+        else
+            m_eof = (part == 0);
 
         if (part <= 0)
             break;
@@ -243,6 +335,145 @@ int64_t GIOFile::fread (void * buf, int64_t size, int64_t nitems)
     }
 
 FAILED:
+    return total;
+}
+
+void GIOFile::prefetch_done (GObject * source, GAsyncResult * result, void * data)
+{
+    auto file = (GIOFile *) data;
+    GError * error = nullptr;
+
+    int64_t len = g_input_stream_read_finish ((GInputStream *) source, result, & error);
+
+    if (error)
+    {
+        AUDERR ("Cannot read from %s: %s.\n", (const char *) file->m_filename, error->message);
+        g_error_free (error);
+        len = 0;
+    }
+
+    file->m_next.resize (len);
+    file->m_stream_pos += len;
+    file->m_stream_eof = (len == 0);
+    file->m_prefetching = false;
+    file->m_next_valid = true;
+}
+
+/* The read is issued on a private main context, which we iterate whenever
+ * we are waiting for (or just checking on) the result. */
+void GIOFile::start_prefetch ()
+{
+    m_next.resize (m_bufsize);
+    m_next_start = m_stream_pos;
+    m_prefetching = true;
+    m_round_trips ++;
+
+    g_main_context_push_thread_default (m_context);
+    g_input_stream_read_async (m_istream, m_next.begin (), m_bufsize,
+     G_PRIORITY_DEFAULT, nullptr, prefetch_done, this);
+    g_main_context_pop_thread_default (m_context);
+}
+
+void GIOFile::finish_prefetch ()
+{
+    while (m_prefetching)
+        g_main_context_iteration (m_context, true);
+}
+
+void GIOFile::drop_buffers ()
+{
+    finish_prefetch ();
+
+    m_buf.resize (0);
+    m_buf_pos = 0;
+    m_next.resize (0);
+    m_next_valid = false;
+}
+
+/* Replaces the (consumed) buffer with the next block of the file, and starts
+ * fetching the one after that.  Returns false at end of file. */
+bool GIOFile::refill ()
+{
+    finish_prefetch ();
+
+    if (m_next_valid)
+    {
+        std::swap (m_buf, m_next);
+        m_buf_start = m_next_start;
+        m_next_valid = false;
+    }
+    else
+    {
+        m_buf_start = m_stream_pos;
+        m_buf.resize (m_bufsize);
+        m_buf.resize (read_direct (m_buf.begin (), m_bufsize));
+        m_stream_pos += m_buf.len ();
+    }
+
+    m_buf_pos = 0;
+
+    if (! m_buf.len ())
+        return false;
+
+    start_prefetch ();
+    return true;
+}
+
+int64_t GIOFile::fread (void * buf, int64_t size, int64_t nitems)
+{
+    if (! m_istream)
+    {
+        AUDERR ("Cannot read from %s: not open for reading.\n", (const char *) m_filename);
+        return 0;
+    }
+
+    int64_t remain = size * nitems;
+
+    m_reads ++;
+    m_read_bytes += remain;
+
+    if (! m_bufsize)
+    {
+        int64_t total = read_direct (buf, remain);
+        return (size > 0) ? total / size : 0;
+    }
+
+    /* let a pending prefetch make progress */
+    if (m_prefetching)
+        g_main_context_iteration (m_context, false);
+
+    int64_t total = 0;
+
+    while (remain > 0)
+    {
+        int avail = m_buf.len () - m_buf_pos;
+
+        if (avail > 0)
+        {
+            int part = aud::min ((int64_t) avail, remain);
+            memcpy (buf, m_buf.begin () + m_buf_pos, part);
+
+            m_buf_pos += part;
+            buf = (char *) buf + part;
+            total += part;
+            remain -= part;
+        }
+        else if (remain >= m_bufsize && ! m_prefetching && ! m_next_valid)
+        {
+            /* large reads go straight to the caller's buffer */
+            int64_t part = read_direct (buf, remain);
+
+            m_stream_pos += part;
+            m_buf.resize (0);
+            m_buf_start = m_stream_pos;
+            m_buf_pos = 0;
+            total += part;
+            break;
+        }
+        else if (! refill ())
+            break;
+    }
+
     return (size > 0) ? total / size : 0;
 }
 
@@ -297,10 +528,65 @@ int GIOFile::fseek (int64_t offset, VFSSeekType whence)
         return -1;
     }
 
+    if (m_bufsize && (whence != VFS_SEEK_END || m_size >= 0))
+    {
+        int64_t target = offset;
+
+        if (whence == VFS_SEEK_CUR)
+            target += m_buf_start + m_buf_pos;
+        else if (whence == VFS_SEEK_END)
+            target += m_size;
+
+        /* within the current or the prefetched block? */
+        if (target >= m_buf_start && target <= m_buf_start + m_buf.len ())
+        {
+            m_buf_pos = target - m_buf_start;
+            m_local_seeks ++;
+            return 0;
+        }
+
+        finish_prefetch ();
+
+        if (m_next_valid && target >= m_next_start && target <= m_next_start + m_next.len ())
+        {
+            std::swap (m_buf, m_next);
+            m_buf_start = m_next_start;
+            m_buf_pos = target - m_buf_start;
+            m_next_valid = false;
+            m_local_seeks ++;
+            return 0;
+        }
+
+        if (! g_seekable_can_seek (m_seekable))
+        {
+            AUDERR ("Cannot seek within %s: stream is not seekable.\n", (const char *) m_filename);
+            return -1;
+        }
+
+        drop_buffers ();
+
+        g_seekable_seek (m_seekable, target, G_SEEK_SET, nullptr, & error);
+        m_round_trips ++;
+        CHECK_ERROR ("seek within", m_filename);
+
+        m_stream_pos = m_buf_start = target;
+        m_stream_eof = (m_size >= 0 && target >= m_size);
+        return 0;
+    }
+
+    if (m_bufsize)
+        drop_buffers ();
+
     g_seekable_seek (m_seekable, offset, gwhence, nullptr, & error);
     CHECK_ERROR ("seek within", m_filename);
 
-    m_eof = (whence == VFS_SEEK_END && offset == 0);
+    if (m_bufsize)
+    {
+        m_stream_pos = m_buf_start = g_seekable_tell (m_seekable);
+        m_stream_eof = (whence == VFS_SEEK_END && offset == 0);
+    }
+    else
+        m_eof = (whence == VFS_SEEK_END && offset == 0);
 
     return 0;
 
@@ -310,11 +596,18 @@ FAILED:
 
 int64_t GIOFile::ftell ()
 {
+    if (m_bufsize)
+        return m_buf_start + m_buf_pos;
+
     return g_seekable_tell (m_seekable);
 }
 
 bool GIOFile::feof ()
 {
+    /* at the end only once everything read ahead has been consumed too */
+    if (m_bufsize)
+        return m_buf_pos >= m_buf.len () && ! (m_next_valid && m_next.len ()) && m_stream_eof;
+
     return m_eof;
 }
 
@@ -338,10 +631,33 @@ int64_t GIOFile::fsize ()
     if (! g_seekable_can_seek (m_seekable))
         return -1;
 
+    if (m_size >= 0)
+    {
+        if (! m_bufsize)
+            m_eof = (ftell () >= m_size);
+
+        return m_size;
+    }
+
     GError * error = nullptr;
-    int64_t saved_pos = g_seekable_tell (m_seekable);
+    int64_t saved_pos;
     int64_t size = -1;
 
+    /* the seeks below bypass the read-ahead buffer, so put the stream back
+     * at the logical position first */
+    if (m_bufsize)
+    {
+        int64_t pos = ftell ();
+        drop_buffers ();
+
+        g_seekable_seek (m_seekable, pos, G_SEEK_SET, nullptr, & error);
+        CHECK_ERROR ("seek within", m_filename);
+
+        m_stream_pos = m_buf_start = pos;
+    }
+
+    saved_pos = g_seekable_tell (m_seekable);
+
     g_seekable_seek (m_seekable, 0, G_SEEK_END, nullptr, & error);
     CHECK_ERROR ("seek within", m_filename);
 
@@ -350,7 +666,10 @@ int64_t GIOFile::fsize ()
     g_seekable_seek (m_seekable, saved_pos, G_SEEK_SET, nullptr, & error);
     CHECK_ERROR ("seek within", m_filename);
 
-    m_eof = (saved_pos >= size);
+    if (m_bufsize)
+        m_stream_eof = (saved_pos >= size);
+    else
+        m_eof = (saved_pos >= size);
 
 FAILED:
     return size;
@@ -22,10 +22,13 @@
  */
 
 #include <math.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/i18n.h>
 #include <libfauxdcore/plugin.h>
+#include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
 #include <libfauxdgui/gtk-compat.h>
 
@@ -53,6 +56,12 @@
 #define BAR_SPACING (3.2f / NUM_BANDS)
 #define BAR_WIDTH (0.8f * BAR_SPACING)
 
+/* top, two sides and front of each bar, drawn as quads */
+#define VERTICES_PER_BAR 16
+#define NUM_VERTICES (NUM_BANDS * NUM_BANDS * VERTICES_PER_BAR)
+
+#define CFG_ID "glspectrum"
+
 static const char gl_about[] =
  N_("OpenGL Spectrum Analyzer for Audacious\n"
     "Copyright 2013 Christophe Budé, John Lindgren, and Carlo Bramini\n\n"
@@ -64,11 +73,15 @@ static const char gl_about[] =
 class GLSpectrum : public VisPlugin
 {
 public:
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
     static constexpr PluginInfo info = {
         N_("OpenGL Spectrum Analyzer"),
         PACKAGE,
         gl_about,
-        nullptr, // prefs
+        & prefs,
         PluginGLibOnly
     };
 
@@ -84,9 +97,46 @@ public:
 
 EXPORT GLSpectrum aud_plugin_instance;
 
+const char * const GLSpectrum::defaults[] = {
+    "show_fps", "FALSE",
+    nullptr
+};
+
+static void show_fps_changed ();
+
+const PreferencesWidget GLSpectrum::widgets[] = {
+    WidgetCheck (N_("Show frame rate and frame time"),
+        WidgetBool (CFG_ID, "show_fps", show_fps_changed))
+};
+
+const PluginPreferences GLSpectrum::prefs = {{widgets}};
+
 static float logscale[NUM_BANDS + 1];
 static float colors[NUM_BANDS][NUM_BANDS][3];
 
+/* The geometry of a bar never changes except for its height, so it is
+ * described once here: each vertex as an offset from the bar's corner (in
+ * bar widths), whether it is at the top, and the shading of its face. */
+static const struct {
+    uint8_t x, top, z;
+    float shade;
+} bar_template[VERTICES_PER_BAR] = {
+    {0, 1, 0, 1}, {1, 1, 0, 1}, {1, 1, 1, 1}, {0, 1, 1, 1},  /* top */
+    {0, 0, 0, 0.65f}, {0, 1, 0, 0.65f}, {0, 1, 1, 0.65f}, {0, 0, 1, 0.65f},  /* left */
+    {1, 1, 0, 0.65f}, {1, 0, 0, 0.65f}, {1, 0, 1, 0.65f}, {1, 1, 1, 0.65f},  /* right */
+    {0, 0, 0, 0.8f}, {1, 0, 0, 0.8f}, {1, 1, 0, 0.8f}, {0, 1, 0, 0.8f}  /* front */
+};
+
+struct Vertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+
+/* All the bars, drawn with a single call; rebuilt only when new data
+ * arrives, not on every redraw. */
+static Vertex s_vertices[NUM_VERTICES];
+static bool s_vertices_valid = false;
+
 #ifdef GDK_WINDOWING_X11
 static Display * s_display;
 static Window s_xwindow;
@@ -100,6 +150,12 @@ static HGLRC s_glrc;
 #endif
 
 static GtkWidget * s_widget = nullptr;
+static GtkWidget * s_fps_label = nullptr;
+
+/* frame statistics for the overlay, reset every second */
+static int64_t s_stats_start = 0;
+static int64_t s_stats_busy = 0;
+static int s_stats_frames = 0;
 
 static int s_pos = 0;
 static float s_angle = 25, s_anglespeed = 0.05f;
@@ -118,6 +174,8 @@ bool GLSpectrum::init ()
     for (int i = 0; i <= NUM_BANDS; i ++)
         logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
 
+    aud_config_set_defaults (CFG_ID, defaults);
+
     for (int y = 0; y < NUM_BANDS; y ++)
     {
         float yf = (float) y / (NUM_BANDS - 1);
@@ -182,6 +240,8 @@ void GLSpectrum::render_freq (const float * freq)
     if (s_angle > 45 || s_angle < -45)
         s_anglespeed = -s_anglespeed;
 
+    s_vertices_valid = false;
+
     if (s_widget)
         gtk_widget_queue_draw (s_widget);
 }
@@ -189,77 +249,104 @@ void GLSpectrum::render_freq (const float * freq)
 void GLSpectrum::clear ()
 {
     memset (s_bars, 0, sizeof s_bars);
+    s_vertices_valid = false;
 
     if (s_widget)
         gtk_widget_queue_draw (s_widget);
 }
 
-static void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
- float z2, float r, float g, float b)
+/* the tops of the tallest bars are shaded brighter than full colour;
+ * glColor3f () clamped them, and so must we */
+static uint8_t color_byte (float c)
 {
-    glColor3f (r, g, b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y2, z2);
-    glVertex3f (x1, y2, z2);
-    glEnd ();
-
-    glColor3f (0.65f * r, 0.65f * g, 0.65f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x1, y2, z2);
-    glVertex3f (x1, y1, z2);
-    glEnd ();
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y1, z2);
-    glVertex3f (x2, y2, z2);
-    glEnd ();
-
-    glColor3f (0.8f * r, 0.8f * g, 0.8f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x1, y2, z1);
-    glEnd ();
+    return (uint8_t) (aud::clamp (c, 0.0f, 1.0f) * 255 + 0.5f);
 }
 
-static void draw_bar (float x, float z, float h, float r, float g, float b)
+static void build_vertices ()
 {
-    draw_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
-     r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
+    Vertex * v = s_vertices;
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+        const float * row = s_bars[(s_pos + i) % NUM_BANDS];
+
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float x = 1.6f - BAR_SPACING * j;
+            float h = row[j] * 1.6f;
+            float bright = 0.2f + 0.8f * h;
+
+            for (auto & t : bar_template)
+            {
+                float shade = bright * t.shade;
+
+                v->x = x + t.x * BAR_WIDTH;
+                v->y = t.top ? h : 0;
+                v->z = z + t.z * BAR_WIDTH;
+                v->r = color_byte (colors[i][j][0] * shade);
+                v->g = color_byte (colors[i][j][1] * shade);
+                v->b = color_byte (colors[i][j][2] * shade);
+                v->a = 255;
+                v ++;
+            }
+        }
+    }
+
+    s_vertices_valid = true;
 }
 
 static void draw_bars ()
 {
+    if (! s_vertices_valid)
+        build_vertices ();
+
     glPushMatrix ();
     glTranslatef (0.0f, -0.5f, -5.0f);
     glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
     glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
 
-    for (int i = 0; i < NUM_BANDS; i ++)
-    {
-        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+    glEnableClientState (GL_VERTEX_ARRAY);
+    glEnableClientState (GL_COLOR_ARRAY);
+    glVertexPointer (3, GL_FLOAT, sizeof (Vertex), & s_vertices[0].x);
+    glColorPointer (4, GL_UNSIGNED_BYTE, sizeof (Vertex), & s_vertices[0].r);
 
-        for (int j = 0; j < NUM_BANDS; j ++)
-        {
-            draw_bar (1.6f - BAR_SPACING * j, z,
-             s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
-             colors[i][j][0], colors[i][j][1], colors[i][j][2]);
-        }
-    }
+    glDrawArrays (GL_QUADS, 0, NUM_VERTICES);
+
+    glDisableClientState (GL_COLOR_ARRAY);
+    glDisableClientState (GL_VERTEX_ARRAY);
 
     glPopMatrix ();
 }
 
+static void update_stats (int64_t frame_start)
+{
+    int64_t now = g_get_monotonic_time ();
+
+    s_stats_busy += now - frame_start;
+    s_stats_frames ++;
+
+    if (! s_stats_start)
+        s_stats_start = frame_start;
+
+    int64_t elapsed = now - s_stats_start;
+    if (elapsed < G_USEC_PER_SEC)
+        return;
+
+    /* update the label only once a second, so as not to redraw too often */
+    if (s_fps_label)
+    {
+        StringBuf text = str_printf (_("%.1f fps, %.2f ms/frame"),
+         (double) s_stats_frames * G_USEC_PER_SEC / elapsed,
+         (double) s_stats_busy / s_stats_frames / 1000);
+        gtk_label_set_text ((GtkLabel *) s_fps_label, text);
+    }
+
+    s_stats_start = now;
+    s_stats_busy = 0;
+    s_stats_frames = 0;
+}
+
 #ifdef USE_GTK3
 static gboolean draw_cb (GtkWidget * widget, cairo_t * cr)
 #else
@@ -276,6 +363,8 @@ static gboolean draw_cb (GtkWidget * widget)
         return false;
 #endif
 
+    int64_t frame_start = g_get_monotonic_time ();
+
     glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     draw_bars ();
@@ -288,6 +377,9 @@ static gboolean draw_cb (GtkWidget * widget)
     SwapBuffers (s_hdc);
 #endif
 
+    if (s_fps_label && gtk_widget_get_visible (s_fps_label))
+        update_stats (frame_start);
+
     return true;
 }
 
@@ -393,6 +485,7 @@ static void widget_realized ()
 static void widget_destroyed ()
 {
     s_widget = nullptr;
+    s_fps_label = nullptr;
 
 #ifdef GDK_WINDOWING_X11
     if (s_context)
@@ -428,12 +521,29 @@ static void widget_resize (GtkWidget * widget, GdkEvent * event, gpointer data)
     aspect_viewport (event->configure.width, event->configure.height);
 }
 
+static void show_fps_changed ()
+{
+    if (! s_fps_label)
+        return;
+
+    bool show = aud_get_bool (CFG_ID, "show_fps");
+    gtk_widget_set_visible (s_fps_label, show);
+
+    s_stats_start = 0;
+    s_stats_busy = 0;
+    s_stats_frames = 0;
+
+    if (show)
+        gtk_label_set_text ((GtkLabel *) s_fps_label, "");
+}
+
 void * GLSpectrum::get_gtk_widget ()
 {
     if (s_widget)
-        return s_widget;
+        return gtk_widget_get_parent (s_widget);
 
     s_widget = gtk_drawing_area_new ();
+    s_fps_label = gtk_label_new ("");
 
     g_signal_connect (s_widget, AUDGUI_DRAW_SIGNAL, (GCallback) draw_cb, nullptr);
     g_signal_connect (s_widget, "realize", (GCallback) widget_realized, nullptr);
@@ -445,5 +555,15 @@ void * GLSpectrum::get_gtk_widget ()
     gtk_widget_set_double_buffered (s_widget, false);
 #endif
 
-    return s_widget;
+    /* the frame statistics go below the GL area rather than over it, so that
+     * no text has to be drawn with OpenGL */
+    GtkWidget * vbox = audgui_vbox_new (0);
+    gtk_box_pack_start ((GtkBox *) vbox, s_widget, true, true, 0);
+    gtk_box_pack_start ((GtkBox *) vbox, s_fps_label, false, false, 0);
+
+    gtk_widget_show_all (vbox);
+    gtk_widget_set_no_show_all (s_fps_label, true);
+    show_fps_changed ();
+
+    return vbox;
 }
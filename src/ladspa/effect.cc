@@ -18,14 +18,234 @@
  */
 
 #include <assert.h>
+#include <string.h>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "ladspa.h"
 #include "plugin.h"
+#include "worker-pool.h"
 
 #include <libfauxdcore/runtime.h>
 
+#define MAX_WORKERS 7
+
 static int ladspa_channels, ladspa_rate;
 
+/* The audio is deinterleaved once per block into one of two sets of planar
+ * buffers (LADSPA_BUFLEN samples per channel).  Each plugin reads one set and
+ * writes the other, and only the output of the last one is interleaved
+ * again. */
+static Index<float> chain_bufs[2];
+static WorkerPool workers;
+
+static float * chain_buf (int set, int channel)
+{
+    return & chain_bufs[set][LADSPA_BUFLEN * channel];
+}
+
+static void deinterleave (const float * data, int frames)
+{
+    int channels = ladspa_channels;
+    int f = 0;
+
+    if (channels == 1)
+    {
+        memcpy (chain_buf (0, 0), data, sizeof (float) * frames);
+        return;
+    }
+
+    if (channels == 2)
+    {
+        float * left = chain_buf (0, 0);
+        float * right = chain_buf (0, 1);
+
+#ifdef __SSE2__
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128 a = _mm_loadu_ps (data + 2 * f);
+            __m128 b = _mm_loadu_ps (data + 2 * f + 4);
+            _mm_storeu_ps (left + f, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+            _mm_storeu_ps (right + f, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+        }
+#elif defined(__ARM_NEON)
+        for (; f + 4 <= frames; f += 4)
+        {
+            float32x4x2_t v = vld2q_f32 (data + 2 * f);
+            vst1q_f32 (left + f, v.val[0]);
+            vst1q_f32 (right + f, v.val[1]);
+        }
+#endif
+
+        for (; f < frames; f ++)
+        {
+            left[f] = data[2 * f];
+            right[f] = data[2 * f + 1];
+        }
+
+        return;
+    }
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    if (channels == 4)
+    {
+        float * out[4];
+        for (int c = 0; c < 4; c ++)
+            out[c] = chain_buf (0, c);
+
+        for (; f + 4 <= frames; f += 4)
+        {
+#ifdef __SSE2__
+            __m128 v0 = _mm_loadu_ps (data + 4 * f);
+            __m128 v1 = _mm_loadu_ps (data + 4 * f + 4);
+            __m128 v2 = _mm_loadu_ps (data + 4 * f + 8);
+            __m128 v3 = _mm_loadu_ps (data + 4 * f + 12);
+            _MM_TRANSPOSE4_PS (v0, v1, v2, v3);
+            _mm_storeu_ps (out[0] + f, v0);
+            _mm_storeu_ps (out[1] + f, v1);
+            _mm_storeu_ps (out[2] + f, v2);
+            _mm_storeu_ps (out[3] + f, v3);
+#else
+            float32x4x4_t v = vld4q_f32 (data + 4 * f);
+            for (int c = 0; c < 4; c ++)
+                vst1q_f32 (out[c] + f, v.val[c]);
+#endif
+        }
+    }
+#endif
+
+    /* other layouts (5.1 and so on): one frame at a time, so that the
+     * interleaved data is still read in order */
+    for (; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            chain_bufs[0][LADSPA_BUFLEN * c + f] = data[channels * f + c];
+    }
+}
+
+static void interleave (int set, float * data, int frames)
+{
+    int channels = ladspa_channels;
+    int f = 0;
+
+    if (channels == 1)
+    {
+        memcpy (data, chain_buf (set, 0), sizeof (float) * frames);
+        return;
+    }
+
+    if (channels == 2)
+    {
+        const float * left = chain_buf (set, 0);
+        const float * right = chain_buf (set, 1);
+
+#ifdef __SSE2__
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128 l = _mm_loadu_ps (left + f);
+            __m128 r = _mm_loadu_ps (right + f);
+            _mm_storeu_ps (data + 2 * f, _mm_unpacklo_ps (l, r));
+            _mm_storeu_ps (data + 2 * f + 4, _mm_unpackhi_ps (l, r));
+        }
+#elif defined(__ARM_NEON)
+        for (; f + 4 <= frames; f += 4)
+        {
+            float32x4x2_t v = {{vld1q_f32 (left + f), vld1q_f32 (right + f)}};
+            vst2q_f32 (data + 2 * f, v);
+        }
+#endif
+
+        for (; f < frames; f ++)
+        {
+            data[2 * f] = left[f];
+            data[2 * f + 1] = right[f];
+        }
+
+        return;
+    }
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    if (channels == 4)
+    {
+        const float * in[4];
+        for (int c = 0; c < 4; c ++)
+            in[c] = chain_buf (set, c);
+
+        for (; f + 4 <= frames; f += 4)
+        {
+#ifdef __SSE2__
+            __m128 v0 = _mm_loadu_ps (in[0] + f);
+            __m128 v1 = _mm_loadu_ps (in[1] + f);
+            __m128 v2 = _mm_loadu_ps (in[2] + f);
+            __m128 v3 = _mm_loadu_ps (in[3] + f);
+            _MM_TRANSPOSE4_PS (v0, v1, v2, v3);
+            _mm_storeu_ps (data + 4 * f, v0);
+            _mm_storeu_ps (data + 4 * f + 4, v1);
+            _mm_storeu_ps (data + 4 * f + 8, v2);
+            _mm_storeu_ps (data + 4 * f + 12, v3);
+#else
+            float32x4x4_t v;
+            for (int c = 0; c < 4; c ++)
+                v.val[c] = vld1q_f32 (in[c] + f);
+            vst4q_f32 (data + 4 * f, v);
+#endif
+        }
+    }
+#endif
+
+    for (; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+            data[channels * f + c] = chain_bufs[set][LADSPA_BUFLEN * c + f];
+    }
+}
+
+/* main thread only; the mutex must be locked */
+void update_workers_locked ()
+{
+    int threads = 0;
+
+    if (aud_get_bool ("ladspa", "parallel"))
+        threads = aud::clamp ((int) std::thread::hardware_concurrency () - 1, 0, MAX_WORKERS);
+
+    if (threads != workers.threads ())
+    {
+        AUDDBG ("Using %d worker thread(s).\n", threads);
+
+        if (threads)
+            workers.start (threads);
+        else
+            workers.stop ();
+    }
+}
+
+/* main thread only; the mutex must be locked */
+void stop_workers_locked ()
+{
+    workers.stop ();
+}
+
+static void connect_audio (LoadedPlugin & loaded, int instance, int in_set)
+{
+    PluginData & plugin = loaded.plugin;
+    const LADSPA_Descriptor & desc = plugin.desc;
+    LADSPA_Handle handle = loaded.instances[instance];
+
+    int ports = plugin.in_ports.len ();
+
+    for (int p = 0; p < ports; p ++)
+    {
+        int channel = ports * instance + p;
+        desc.connect_port (handle, plugin.in_ports[p], chain_buf (in_set, channel));
+        desc.connect_port (handle, plugin.out_ports[p], chain_buf (in_set ^ 1, channel));
+    }
+}
+
 static void start_plugin (LoadedPlugin & loaded)
 {
     if (loaded.active)
@@ -53,9 +273,6 @@ static void start_plugin (LoadedPlugin & loaded)
 
     int instances = ladspa_channels / ports;
 
-    loaded.in_bufs.insert (0, ladspa_channels);
-    loaded.out_bufs.insert (0, ladspa_channels);
-
     for (int i = 0; i < instances; i ++)
     {
         LADSPA_Handle handle = desc.instantiate (& desc, ladspa_rate);
@@ -65,75 +282,71 @@ static void start_plugin (LoadedPlugin & loaded)
         for (int c = 0; c < controls; c ++)
             desc.connect_port (handle, plugin.controls[c].port, & loaded.values[c]);
 
-        for (int p = 0; p < ports; p ++)
-        {
-            int channel = ports * i + p;
-
-            Index<float> & in = loaded.in_bufs[channel];
-            in.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.in_ports[p], in.begin ());
-
-            Index<float> & out = loaded.out_bufs[channel];
-            out.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.out_ports[p], out.begin ());
-        }
+        /* reconnected before each run, to whichever set is the input then */
+        connect_audio (loaded, i, 0);
 
         if (desc.activate)
             desc.activate (handle);
     }
 }
 
-static void run_plugin (LoadedPlugin & loaded, float * data, int samples)
+struct RunJob {
+    LoadedPlugin * loaded;
+    int in_set;
+    int frames;
+};
+
+/* may be called from a worker thread; each instance has channels of its own */
+static void run_instance (void * data, int instance)
+{
+    auto job = (RunJob *) data;
+
+    connect_audio (* job->loaded, instance, job->in_set);
+    job->loaded->plugin.desc.run (job->loaded->instances[instance], job->frames);
+}
+
+/* returns false if the plugin is not running; its output is then still in the
+ * input set */
+static bool run_plugin (LoadedPlugin & loaded, int in_set, int frames)
 {
     if (! loaded.instances.len ())
-        return;
+        return false;
 
-    PluginData & plugin = loaded.plugin;
-    const LADSPA_Descriptor & desc = plugin.desc;
+    assert (loaded.plugin.in_ports.len () * loaded.instances.len () == ladspa_channels);
 
-    int ports = plugin.in_ports.len ();
-    int instances = loaded.instances.len ();
-    assert (ports * instances == ladspa_channels);
+    RunJob job = {& loaded, in_set, frames};
+    workers.run (run_instance, & job, loaded.instances.len ());
+
+    return true;
+}
+
+static void run_chain (float * data, int samples)
+{
+    bool any_running = false;
+    for (auto & loaded : loadeds)
+    {
+        if (loaded->instances.len ())
+            any_running = true;
+    }
+
+    if (! any_running)
+        return;
 
     while (samples / ladspa_channels > 0)
     {
         int frames = aud::min (samples / ladspa_channels, LADSPA_BUFLEN);
+        int set = 0;
 
-        for (int i = 0; i < instances; i ++)
+        deinterleave (data, frames);
+
+        for (auto & loaded : loadeds)
         {
-            LADSPA_Handle handle = loaded.instances[i];
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                float * get = data + channel;
-                float * in = loaded.in_bufs[channel].begin ();
-                float * in_end = in + frames;
-
-                while (in < in_end)
-                {
-                    * in ++ = * get;
-                    get += ladspa_channels;
-                }
-            }
-
-            desc.run (handle, frames);
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                float * set = data + channel;
-                float * out = loaded.out_bufs[channel].begin ();
-                float * out_end = out + frames;
-
-                while (out < out_end)
-                {
-                    * set = * out ++;
-                    set += ladspa_channels;
-                }
-            }
+            if (run_plugin (* loaded, set, frames))
+                set ^= 1;
         }
 
+        interleave (set, data, frames);
+
         data += ladspa_channels * frames;
         samples -= ladspa_channels * frames;
     }
@@ -181,8 +394,6 @@ void shutdown_plugin_locked (LoadedPlugin & loaded)
     }
 
     loaded.instances.clear ();
-    loaded.in_bufs.clear ();
-    loaded.out_bufs.clear ();
 }
 
 void LADSPAHost::start (int & channels, int & rate)
@@ -195,6 +406,12 @@ void LADSPAHost::start (int & channels, int & rate)
     ladspa_channels = channels;
     ladspa_rate = rate;
 
+    for (auto & bufs : chain_bufs)
+    {
+        bufs.clear ();
+        bufs.insert (0, LADSPA_BUFLEN * channels);
+    }
+
     pthread_mutex_unlock (& mutex);
 }
 
@@ -203,10 +420,9 @@ Index<float> & LADSPAHost::process (Index<float> & data)
     pthread_mutex_lock (& mutex);
 
     for (auto & loaded : loadeds)
-    {
         start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
-    }
+
+    run_chain (data.begin (), data.len ());
 
     pthread_mutex_unlock (& mutex);
     return data;
@@ -228,11 +444,13 @@ Index<float> & LADSPAHost::finish (Index<float> & data, bool end_of_playlist)
     pthread_mutex_lock (& mutex);
 
     for (auto & loaded : loadeds)
-    {
         start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
 
-        if (end_of_playlist)
+    run_chain (data.begin (), data.len ());
+
+    if (end_of_playlist)
+    {
+        for (auto & loaded : loadeds)
             shutdown_plugin_locked (* loaded);
     }
 
@@ -37,6 +37,7 @@
 
 const char * const LADSPAHost::defaults[] = {
  "plugin_count", "0",
+ "parallel", "FALSE",
  nullptr};
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -310,6 +311,7 @@ bool LADSPAHost::init ()
 
     open_modules ();
     load_enabled_from_config ();
+    update_workers_locked ();
 
     pthread_mutex_unlock (& mutex);
     return true;
@@ -321,6 +323,7 @@ void LADSPAHost::cleanup ()
 
     aud_set_str ("ladspa", "module_path", module_path);
     save_enabled_to_config ();
+    stop_workers_locked ();
     close_modules ();
 
     modules.clear ();
@@ -560,8 +563,17 @@ const char LADSPAHost::about[] =
  N_("LADSPA Host for Audacious\n"
     "Copyright 2011 John Lindgren");
 
+static void parallel_changed ()
+{
+    pthread_mutex_lock (& mutex);
+    update_workers_locked ();
+    pthread_mutex_unlock (& mutex);
+}
+
 const PreferencesWidget LADSPAHost::widgets[] = {
-    WidgetCustomGTK (make_config_widget)
+    WidgetCustomGTK (make_config_widget),
+    WidgetCheck (N_("Run multi-channel instances in parallel"),
+        WidgetBool ("ladspa", "parallel", parallel_changed))
 };
 
 const PluginPreferences LADSPAHost::prefs = {{widgets}};
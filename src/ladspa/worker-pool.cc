@@ -0,0 +1,124 @@
+/*
+ * LADSPA Host for Audacious
+ * Copyright 2011 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "worker-pool.h"
+
+#include <libfauxdcore/runtime.h>
+
+void WorkerPool::start (int threads)
+{
+    stop ();
+
+    pthread_mutex_lock (& m_mutex);
+    m_quit = false;
+    pthread_mutex_unlock (& m_mutex);
+
+    for (int i = 0; i < threads; i ++)
+    {
+        pthread_t thread;
+        if (pthread_create (& thread, nullptr, worker, this))
+        {
+            AUDERR ("Cannot start worker thread.\n");
+            break;
+        }
+
+        m_threads.append (thread);
+    }
+}
+
+void WorkerPool::stop ()
+{
+    if (! m_threads.len ())
+        return;
+
+    pthread_mutex_lock (& m_mutex);
+    m_quit = true;
+    pthread_cond_broadcast (& m_work_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    for (pthread_t thread : m_threads)
+        pthread_join (thread, nullptr);
+
+    m_threads.clear ();
+}
+
+/* takes the next job, if any, and runs it with the mutex unlocked */
+bool WorkerPool::run_one_locked ()
+{
+    if (m_next >= m_jobs)
+        return false;
+
+    int job = m_next ++;
+
+    pthread_mutex_unlock (& m_mutex);
+    m_func (m_data, job);
+    pthread_mutex_lock (& m_mutex);
+
+    if (! -- m_pending)
+        pthread_cond_broadcast (& m_done_cond);
+
+    return true;
+}
+
+void * WorkerPool::worker (void * me)
+{
+    auto pool = (WorkerPool *) me;
+
+    pthread_mutex_lock (& pool->m_mutex);
+
+    while (! pool->m_quit)
+    {
+        if (! pool->run_one_locked ())
+            pthread_cond_wait (& pool->m_work_cond, & pool->m_mutex);
+    }
+
+    pthread_mutex_unlock (& pool->m_mutex);
+    return nullptr;
+}
+
+void WorkerPool::run (JobFunc func, void * data, int jobs)
+{
+    if (! m_threads.len () || jobs < 2)
+    {
+        for (int job = 0; job < jobs; job ++)
+            func (data, job);
+
+        return;
+    }
+
+    pthread_mutex_lock (& m_mutex);
+
+    m_func = func;
+    m_data = data;
+    m_jobs = jobs;
+    m_next = 0;
+    m_pending = jobs;
+
+    pthread_cond_broadcast (& m_work_cond);
+
+    while (run_one_locked ())
+        ;
+
+    while (m_pending)
+        pthread_cond_wait (& m_done_cond, & m_mutex);
+
+    m_jobs = m_next = 0;
+
+    pthread_mutex_unlock (& m_mutex);
+}
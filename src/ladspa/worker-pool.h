@@ -0,0 +1,63 @@
+/*
+ * LADSPA Host for Audacious
+ * Copyright 2011 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUD_LADSPA_WORKER_POOL_H
+#define AUD_LADSPA_WORKER_POOL_H
+
+#include <pthread.h>
+
+#include <libfauxdcore/index.h>
+
+/* A few threads waiting to run the instances of a plugin side by side.  The
+ * calling thread takes part too, and run() only returns once every job is
+ * done, so the output is the same as when running them one after another. */
+class WorkerPool
+{
+public:
+    typedef void (* JobFunc) (void * data, int job);
+
+    ~WorkerPool () { stop (); }
+
+    void start (int threads);
+    void stop ();
+
+    int threads () const { return m_threads.len (); }
+
+    void run (JobFunc func, void * data, int jobs);
+
+private:
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_work_cond = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t m_done_cond = PTHREAD_COND_INITIALIZER;
+
+    Index<pthread_t> m_threads;
+    bool m_quit = false;
+
+    /* lock the mutex to read / set these */
+    JobFunc m_func = nullptr;
+    void * m_data = nullptr;
+    int m_jobs = 0;       /* in the current batch */
+    int m_next = 0;       /* next job to be taken */
+    int m_pending = 0;    /* jobs not yet finished */
+
+    static void * worker (void * me);
+    bool run_one_locked ();
+};
+
+#endif
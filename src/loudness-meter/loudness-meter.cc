@@ -0,0 +1,215 @@
+/*
+ * Loudness Meter Plugin for Fauxdacious
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/*
+ * This effect passes audio through unchanged.  It measures every sample on
+ * its way to the output and publishes the readings to the VU meters.  The
+ * playback thread hands them over through a lock-free queue, holding each
+ * one back until the audio it describes has passed the output buffer.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+#include <libfauxdcore/hook.h>
+#include <libfauxdcore/i18n.h>
+#include <libfauxdcore/mainloop.h>
+#include <libfauxdcore/plugin.h>
+#include <libfauxdcore/runtime.h>
+
+#include "../ui-common/ebur128.h"
+
+#define PUBLISH_MS 40
+#define POLL_MS 20
+#define QUEUE_SIZE 64   /* a power of two */
+
+class LoudnessMeter : public EffectPlugin
+{
+public:
+    static const char about[];
+
+    static constexpr PluginInfo info = {
+        N_("Loudness Meter"),
+        PACKAGE,
+        about
+    };
+
+    /* last in the chain, to measure what is actually played */
+    constexpr LoudnessMeter () : EffectPlugin (info, 10, true) {}
+
+    bool init ();
+    void cleanup ();
+
+    void start (int & channels, int & rate);
+    Index<float> & process (Index<float> & data);
+    bool flush (bool force);
+};
+
+EXPORT LoudnessMeter aud_plugin_instance;
+
+const char LoudnessMeter::about[] =
+ N_("Loudness Meter Plugin for Fauxdacious\n\n"
+    "Measures true peak and EBU R128 loudness (momentary, short-term, "
+    "integrated and loudness range) of everything played, for display "
+    "by the VU Meter.");
+
+struct QueuedReadings {
+    int64_t due;      /* monotonic time in microseconds */
+    int generation;
+    LoudnessReadings readings;
+};
+
+static LoudnessMeasurement measurement;
+static int current_channels, current_rate;
+static int frames_to_publish;
+
+/* written only by the playback thread (head) or the main thread (tail);
+ * flushing bumps the generation, so that the main thread drops the readings
+ * of audio that will never be heard */
+static QueuedReadings queue[QUEUE_SIZE];
+static std::atomic<unsigned> queue_head, queue_tail;
+static std::atomic<int> generation;
+
+static QueuedFunc poll_timer;
+
+static int64_t monotonic_us ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* runs in the main thread; readings that came due together are merged, so
+ * no peak is lost if we fall behind */
+static void poll_readings (void *)
+{
+    int64_t now = monotonic_us ();
+    int gen = generation.load (std::memory_order_relaxed);
+    unsigned tail = queue_tail.load (std::memory_order_relaxed);
+    unsigned head = queue_head.load (std::memory_order_acquire);
+
+    LoudnessReadings merged;
+    bool have = false;
+
+    for (; tail != head; tail ++)
+    {
+        const QueuedReadings & item = queue[tail % QUEUE_SIZE];
+
+        if (item.generation != gen)
+            continue;
+        if (item.due > now)
+            break;
+
+        if (have && merged.channels == item.readings.channels)
+        {
+            for (int c = 0; c < merged.channels; c ++)
+                merged.true_peak[c] = aud::max (merged.true_peak[c],
+                 item.readings.true_peak[c]);
+        }
+        else
+            merged = item.readings;
+
+        merged.momentary = item.readings.momentary;
+        merged.short_term = item.readings.short_term;
+        merged.integrated = item.readings.integrated;
+        merged.range = item.readings.range;
+        have = true;
+    }
+
+    queue_tail.store (tail, std::memory_order_release);
+
+    if (have)
+        hook_call (LOUDNESS_READINGS_HOOK, & merged);
+}
+
+/* runs in the playback thread; if the main thread has stalled and the queue
+ * is full, the readings are dropped rather than waiting */
+static void publish ()
+{
+    unsigned head = queue_head.load (std::memory_order_relaxed);
+    if (head - queue_tail.load (std::memory_order_acquire) >= QUEUE_SIZE)
+    {
+        LoudnessReadings discard;
+        measurement.get_readings (discard);
+        return;
+    }
+
+    QueuedReadings & item = queue[head % QUEUE_SIZE];
+    item.due = monotonic_us () + (int64_t) aud_get_int (nullptr, "output_buffer_size") * 1000;
+    item.generation = generation.load (std::memory_order_relaxed);
+    measurement.get_readings (item.readings);
+
+    queue_head.store (head + 1, std::memory_order_release);
+}
+
+bool LoudnessMeter::init ()
+{
+    poll_timer.start (POLL_MS, poll_readings, nullptr);
+    return true;
+}
+
+void LoudnessMeter::cleanup ()
+{
+    poll_timer.stop ();
+}
+
+void LoudnessMeter::start (int & channels, int & rate)
+{
+    current_channels = channels;
+    current_rate = rate;
+    frames_to_publish = aud::rescale (PUBLISH_MS, 1000, rate);
+
+    measurement.start (channels, rate);
+    generation ++;
+}
+
+Index<float> & LoudnessMeter::process (Index<float> & data)
+{
+    const float * in = data.begin ();
+    int frames = data.len () / current_channels;
+
+    while (frames > 0)
+    {
+        int chunk = aud::min (frames, frames_to_publish);
+
+        measurement.process (in, chunk);
+
+        in += chunk * current_channels;
+        frames -= chunk;
+        frames_to_publish -= chunk;
+
+        if (! frames_to_publish)
+        {
+            publish ();
+            frames_to_publish = aud::rescale (PUBLISH_MS, 1000, current_rate);
+        }
+    }
+
+    return data;
+}
+
+/* after a seek, the integrated loudness starts over */
+bool LoudnessMeter::flush (bool force)
+{
+    measurement.reset ();
+    frames_to_publish = aud::rescale (PUBLISH_MS, 1000, current_rate);
+    generation ++;
+
+    return true;
+}
@@ -24,9 +24,6 @@
 #include <pthread.h>
 
 #include <iostream>
-#include <vector>
-#include <sstream>   // For std::istringstream
-#include <regex>     // For std::regex and std::smatch
 
 #ifdef _WIN32
 #include <windows.h>
@@ -64,6 +61,8 @@
 
 #include <libfauxdqt/libfauxdqt.h>
 
+#include "../ui-common/synced-lyrics.h"
+
 #ifdef S_IRGRP
 #define DIRMODE (S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
 #else
@@ -105,12 +104,8 @@ static int customType = QEvent::registerEventType();
 static Index<String> extlist = str_list_to_index (".mp3,.ogg,.ogm,.oga,.flac,.fla,.wv", ",");
 static QTimer * timer;
 
-struct TimedLyricLine {
-    int timestamp_ms;   // Timestamp in milliseconds
-    String text;        // Lyric text at this timestamp
-};
-
-std::vector<TimedLyricLine> timed_lyrics;  // Stores parsed lyrics with timestamps
+static SyncedLyrics synced_lyrics;  // Parsed lyrics with timestamps, sorted by time
+static int shown_position = -1;     // Position in synced_lyrics currently displayed
 
 class TextEdit : public QTextEdit
 {
@@ -151,49 +146,12 @@ public:
             if (state.is_stream || ! state.synclyrics)
                 return;
 
-            bool have_timestamps = false;
-            // Parse the lyrics and populate timed_lyrics
-            timed_lyrics.clear ();
-            std::istringstream iss (Q_Lyrics.toStdString ());
-            std::string line;
-            // Updated regex to support both SS.SS and SS.SSS formats
-            std::regex re (R"(\[\s*(\d+)\s*:\s*(\d+\.\d{2,3})\s*\]\s*(.*))");
-            std::regex re_offset (R"(\[offset:([+-]?\d+)\])");
-
-            // Add a dummy timestamp line at the beginning to prevent title from being highlighted
-            TimedLyricLine dummy_line;
-            dummy_line.timestamp_ms = 0;
-            dummy_line.text = String ("");
-            timed_lyrics.push_back (dummy_line);
-            int offset_ms = 0;
-
-            while (std::getline (iss, line))
-            {
-                // Sanitize the line: remove leading/trailing spaces and carriage return
-                line.erase(0, line.find_first_not_of (" \t\r"));  // Remove leading whitespace
-                line.erase(line.find_last_not_of (" \t\r") + 1);  // Remove trailing whitespace
-                std::smatch match;
-                if (std::regex_match (line, match, re))
-                {
-                    have_timestamps = true;
-                    int minutes = std::stoi (match[1].str ());    // Convert minutes
-                    float seconds = std::stof (match[2].str ());  // Convert seconds
-                    int timestamp_ms = static_cast<int>(((minutes * 60 + seconds) * 1000) + offset_ms);
-
-                    TimedLyricLine timed_line;
-                    timed_line.timestamp_ms = timestamp_ms;
-                    timed_line.text = String (match[3].str ().c_str ());  // Lyric text
-
-                    timed_lyrics.push_back (timed_line);
-                }
-                else if (std::regex_match (line, match, re_offset))
-                    offset_ms = std::stoi (match[1].str ());    // Convert offset_millisec
-            }
-            if (! have_timestamps)
+            if (! synced_lyrics.parse (str_to_utf8 (state.sholyrics, -1)))
                 state.synclyrics = false;
         }
+        shown_position = -1;
         if (state.synclyrics && ! state.is_stream)
-            timer->start ();  // Start the sync timer
+            timer->start (0);  // Start the sync timer
 
         state.ok2save = ok2save_was;
     }
@@ -274,6 +232,7 @@ const PluginPreferences LyricWikiQt::prefs = {{widgets}};
 static TextEdit * textedit;
 
 void update_lyrics_display ();
+static void resync_lyrics ();
 
 bool LyricWikiQt::init ()
 {
@@ -901,68 +860,42 @@ static void allow_usersave ()
     state.ok2saveTag = state.Wasok2saveTag;
 }
 
-void highlight_lyrics (int current_time_ms)
+/* REDRAW THE SYNCED LYRICS AROUND THE GIVEN POSITION (ONLY CALLED WHEN IT CHANGES): */
+static void highlight_lyrics (int position)
 {
     if (! textedit)
         return;
 
+    const TimedLyricLine * lines[4];
+    int highlight;
+    int count = synced_lyrics.window (position, lines, highlight);
+
     // Clear the current content in the text editor
     textedit->document ()->clear ();
 
-    // Find the current line and its neighbors (up to 4 lines in total)
-    std::vector<TimedLyricLine> lines_to_display;
-
-    // Iterate through the timed lyrics and find the lines closest to the current timestamp
-    for (size_t i = 0; i < timed_lyrics.size (); ++i)
-    {
-        if (timed_lyrics[i].timestamp_ms >= current_time_ms)
-        {
-            // Ensure we have the current line and its neighbors (3 more lines)
-            size_t start_index = (i > 1) ? i - 2 : 0;  // Start 2 lines before the current line
-            size_t end_index = std::min (i + 2, timed_lyrics.size () - 1);  // Limit to 3 more lines after
-
-            // Ensure no more than 4 lines are selected
-            size_t line_count = 0;
-
-            for (size_t j = start_index; j <= end_index && line_count < 4; ++j)
-            {
-                lines_to_display.push_back (timed_lyrics[j]);
-                line_count++;
-            }
-            break;
-        }
-    }
-
     // Create a cursor to insert the selected lines into the text editor
     QTextCursor cursor (textedit->document ());
 
-    // Iterate over the lines to insert and apply formatting
-    for (size_t i = 0; i < lines_to_display.size (); ++i)
+    for (int i = 0; i < count; i ++)
     {
-        const TimedLyricLine &line = lines_to_display[i];
-        std::string text = static_cast<std::string>(line.text);
-
         // Skip empty lines (like our dummy timestamp)
-        if (text.empty ()) continue;
+        if (! lines[i]->text[0])
+            continue;
 
-        // Create a QTextCharFormat for styling
         QTextCharFormat format;
 
-        // Check if it's the second line (index 1) and apply custom formatting
-        if (i == 1)
+        if (i == highlight)
             format.setFontPointSize (16);  // Enlarge text (adjust size as needed)
 
         format.setForeground (Qt::white);  // Set white color for other lines
 
         // Apply the formatting and insert the text for this line
         cursor.setCharFormat (format);
-        cursor.insertText (QString::fromStdString (text));
+        cursor.insertText (QString (lines[i]->text));
 
         // Insert a line break after the lyric line
         cursor.insertHtml ("<br>");
     }
-
-    /* textedit->verticalScrollBar ()->setValue (textedit->verticalScrollBar ()->maximum ()); */
 }
 
 /* CALLED BY BOTH MAIN AND THREAD TO UPDATE LYRICS (FOR LATER DISPLAYING IN THE WIDGET): */
@@ -1239,6 +1172,8 @@ static void lw_cleanup (QObject * object = nullptr)
     hook_dissociate ("playback stop", (HookFunction) kill_thread_eventloop);
     hook_dissociate ("tuple change", (HookFunction) lyricwiki_playback_changed);
     hook_dissociate ("playback ready", (HookFunction) lyricwiki_playback_began);
+    hook_dissociate ("playback seek", (HookFunction) resync_lyrics);
+    hook_dissociate ("playback unpause", (HookFunction) resync_lyrics);
 
     state.filename = String ();
     state.title = String ();
@@ -1250,9 +1185,31 @@ static void lw_cleanup (QObject * object = nullptr)
     textedit = nullptr;
 }
 
+/* SYNC TIMER (SINGLE-SHOT):  RATHER THAN POLLING, EACH RUN SCHEDULES THE NEXT ONE FOR
+   WHEN THE DISPLAYED LINE IS NEXT DUE TO CHANGE (SEEK AND UNPAUSE RESCHEDULE IT EARLY): */
 void update_lyrics_display ()
 {
-    highlight_lyrics (aud_drct_get_time ());  // Update lyrics display based on current time (ONLY WORKS FOR NON-STREAMS!)
+    if (! timer)
+        return;
+
+    int time = aud_drct_get_time ();  // (ONLY WORKS FOR NON-STREAMS!)
+    int position = synced_lyrics.position (time);
+
+    if (position != shown_position)
+    {
+        highlight_lyrics (position);
+        shown_position = position;
+    }
+
+    int delay = aud_drct_get_paused () ? -1 : synced_lyrics.time_to_next (position, time);
+    timer->start ((delay >= 0) ? aud::min (delay, SYNCED_LYRICS_IDLE_MS) : SYNCED_LYRICS_IDLE_MS);
+}
+
+/* CALLED ON SEEK OR UNPAUSE:  THE NEXT LINE CHANGE IS NO LONGER WHERE WE THOUGHT: */
+static void resync_lyrics ()
+{
+    if (timer && timer->isActive ())
+        timer->start (0);
 }
 
 /* CALLED ON STARTUP (WIDGET CREATION): */
@@ -1260,9 +1217,9 @@ void * LyricWikiQt::get_qt_widget ()
 {
     textedit = new TextEdit;
     textedit->setReadOnly (false);
-    // Create a QTimer to call update_lyrics_display every 200ms
+    // Create a QTimer to call update_lyrics_display when the displayed line is due to change
     timer = new QTimer (textedit);
-    timer->setInterval (200);  // Set the interval to 200ms
+    timer->setSingleShot (true);
 
 #ifdef Q_OS_MAC  // Mac-specific font tweaks
     textedit->document ()->setDefaultFont (QApplication::font ("QTipLabel"));
@@ -1278,6 +1235,8 @@ void * LyricWikiQt::get_qt_widget ()
     hook_associate ("playback ready", (HookFunction) lyricwiki_playback_began, nullptr);
     hook_associate ("tuple change", (HookFunction) lyricwiki_playback_changed, nullptr);
     hook_associate ("playback stop", (HookFunction) kill_thread_eventloop, nullptr);
+    hook_associate ("playback seek", (HookFunction) resync_lyrics, nullptr);
+    hook_associate ("playback unpause", (HookFunction) resync_lyrics, nullptr);
     return textedit;
 }
 
@@ -19,9 +19,6 @@
  */
 
 #include <iostream>
-#include <vector>
-#include <sstream>   // For std::istringstream
-#include <regex>     // For std::regex and std::smatch
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <string.h>
@@ -30,7 +27,7 @@
 #include <libxml/tree.h>
 #include <libxml/HTMLparser.h>
 #include <libxml/xpath.h>
-#include <pthread.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -51,6 +48,9 @@
 #include <libfauxdcore/playlist.h>
 #include <libfauxdgui/gtk-compat.h>
 
+#include "../ui-common/fetch-queue.h"
+#include "../ui-common/synced-lyrics.h"
+
 #ifdef S_IRGRP
 #define DIRMODE (S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
 #else
@@ -80,12 +80,8 @@ enum {
     SYNC_ONLY
 };
 
-struct TimedLyricLine {
-    int timestamp_ms;   // Timestamp in milliseconds
-    String text;        // Lyric text at this timestamp
-};
-
-std::vector<TimedLyricLine> timed_lyrics;  // Stores parsed lyrics with timestamps
+static SyncedLyrics synced_lyrics;  // Parsed lyrics with timestamps, sorted by time
+static int shown_position = -1;     // Position in synced_lyrics currently displayed
 
 class LyricWiki : public GeneralPlugin
 {
@@ -112,6 +108,7 @@ public:
 const char * const LyricWiki::defaults[] = {
     "search_internet", "TRUE",  // SEARCH FOR LYRICS FROM WEB (IF NOT FOUND LOCALLY)
     "sync_lyrics", "TRUE",      // ENABLE LYRIC SYNCHRONIZATION
+    "fetch_cache_mb", "8",      // SIZE LIMIT OF THE CACHE OF LYRICS FETCHED BY THE HELPER
     nullptr
 };
 
@@ -160,10 +157,8 @@ static GtkTextView * textview;
 static GtkTextBuffer * textbuffer;
 static guint timer = 0;
 
-static bool resetthreads = false;     // JWT:TRUE STOP ANY THREADS RUNNING ON SONG CHANGE OR SHUTDOWN.
-static bool fromsongstartup = false;  // JWT:TRUE WHEN THREAD STARTED BY SONG CHANGE.
+static bool fromsongstartup = false;  // JWT:TRUE WHEN FETCH REQUESTED BY SONG CHANGE.
 static LyricsState state;
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static Index<String> extlist = str_list_to_index (".mp3,.ogg,.ogm,.oga,.flac,.fla,.wv", ",");
 
 bool LyricWiki::init ()
@@ -367,6 +362,7 @@ static GtkWidget * tag_save_button;
 static void save_lyrics_locally ();
 static void save_lyrics_locally_fromscreen ();
 gboolean update_lyrics_display (gpointer data);
+static void resync_lyrics ();
 
 /* DEPRECIATED: STEP 3 OF 3 (FOR FETCHING LYRICS THE OLD-SCHOOL AUDACIOUS WAY (NO HELPER)): */
 static void get_lyrics_step_3 (const char * uri, const Index<char> & buf, void *)
@@ -427,15 +423,6 @@ static void get_lyrics_step_3 (const char * uri, const Index<char> & buf, void *
     }
 }
 
-/* CALLED BY g_idle_add() TO UPDATE LYRIC WIDGET FROM THREAD: */
-static gboolean lyrics_ready (gpointer data)
-{
-    state.synclyrics = aud_get_bool ("lyricwiki", "sync_lyrics");
-    show_lyrics ();
-
-    return false;
-}
-
 /* DEPRECIATED: STEP 2 OF 3 (FOR FETCHING LYRICS THE OLD-SCHOOL AUDACIOUS WAY (NO HELPER)): */
 static void get_lyrics_step_2 (const char * uri1, const Index<char> & buf, void *)
 {
@@ -477,49 +464,124 @@ static void get_lyrics_step_2 (const char * uri1, const Index<char> & buf, void
     vfs_async_file_get_contents (uri, get_lyrics_step_3, nullptr);
 }
 
-/* (SEPARATE THREAD) HANDLE FETCHING LYRICS FROM WEB VIA HELPER (1-STEP) OR fandom.com? (STEP 1 OF 3): */
-/* NOTE:  WHEN STARTING PLAY, WE WAIT 2 SEC. B/C NORMALLY, A STREAM STILL HAS IT'S LAST-PLAYED
-   TITLE-TUPLE AND, QUICKLY AFTER STARTING PLAY, A TUPLE-CHANGE WILL OCCUR BEFORE THE FIRST THREAD CAN
-   LOOK UP THE "OLD" LYRICS (IF NOT CACHED), IF SO WE WANT TO ABORT THE FIRST THREAD SO THAT ONLY THE
-   NEW THREAD WILL LOOK UP THE CURRENT LYRICS FOR THE NOW-CHANGED TUPLE (TITLE)!  WE STILL HAVE TO
-   INITIATE A LOOKUP ON PLAY-START SINCE OTHERWISE FILES (WHICH HAVE NO TUPLE-CHANGES) WOULD NEVER
-   HAVE THEIR LYRICS LOOKED UP!
+/* JWT:FETCH BACKEND (RUNS ON THE FETCH THREAD) - HAVE THE HELPER FIND/DOWNLOAD LYRICS FOR US,
+   WHICH IT LEAVES IN ~/.config/fauxdacious[_?]/_tmp_lyrics.txt.  THIS MUST *NOT* TOUCH THE
+   WIDGETS OR state, AS THE MAIN THREAD MAY BE USING THEM!
 */
-static void * lyric_helper_thread_fn (void * data)
+static bool fetch_lyrics (FetchQueue & queue, const FetchRequest & request, String & file, int & status)
 {
-    bool abortthisthread = resetthreads;
-    if (abortthisthread)
-    {
-        pthread_exit (nullptr);
-        return nullptr;
-    }
-    if (fromsongstartup && state.is_stream)  // TRUE IF SONG-START, FALSE ON TUPLE-CHANGE!
+    String lyric_helper = aud_get_str ("audacious", "lyric_helper");
+    if (! lyric_helper[0])
+        return false;
+
+    AUDINFO ("i:HELPER FOUND: WILL DO (%s)\n", (const char *) str_concat ({lyric_helper, " \"",
+            (const char *) request.artist, "\" \"",
+            (const char *) request.title, "\" ", aud_get_path (AudPath::UserDir),
+            " \"", (const char *) request.album, "\" '", (const char *) request.options, "' "}));
+
+    Index<String> args;
+    args.append (request.artist);
+    args.append (request.title);
+    args.append (String (aud_get_path (AudPath::UserDir)));
+    args.append (request.album);
+    args.append (request.options);
+
+    time_t started = time (nullptr);
+    status = fetch_run_helper (queue, lyric_helper, args);
+    if (status < 0)
+        return false;
+
+    /* ONLY TAKE LYRICS THE HELPER JUST WROTE, NOT ANY LEFT FROM THE LAST SONG: */
+    String lyric_fid = String (str_concat ({aud_get_path (AudPath::UserDir), "/_tmp_lyrics.txt"}));
+    GStatBuf statbuf;
+    if (g_stat ((const char *) lyric_fid, & statbuf) < 0 || statbuf.st_mtime < started
+            || statbuf.st_size <= 1)
+        return false;
+
+    file = lyric_fid;
+    return true;
+}
+
+/* JWT:CALLED IN THE MAIN THREAD WHEN THE HELPER HAS FETCHED THE CURRENT SONG'S LYRICS (OR NOT): */
+static void lyrics_fetched (const FetchRequest &, const char * path, int status)
+{
+    bool lyrics_found = false;
+
+    if (path)
     {
-        int sleep_msec = aud_get_int ("lyricwiki", "sleep_msec");
-        if (sleep_msec < 1)  sleep_msec = 1600;
-        g_usleep (sleep_msec * 1000);  // SLEEP 2" TO ALLOW FOR ANY IMMEDIATE TUPLE CHANGE TO OVERRIDE! */
-        if (! fromsongstartup || resetthreads)  // CHGD. BY ANOTHER THREAD WHILST WE WERE SLEEPING!
+        VFSFile lyrics_file (path, "r");
+        if (lyrics_file)
         {
-            /* ANOTHER THREAD HAS BEEN STARTED BY TUPLE-CHANGE, WHILE WE SLEPT, SO ABORT THIS
-               THREAD AND LET THE LATTER (TUPLE-CHANGE) THREAD UPDATE THE LYRICS!
-            */
-            pthread_exit (nullptr);
-            return nullptr;
+            Index<char> lyrics = lyrics_file.read_all ();
+            if (lyrics.len () > 1)
+            {
+                lyrics.resize (lyrics.len ()+1);
+                lyrics[lyrics.len ()-1] = '\0';
+                lyrics_found = true;
+                update_lyrics (state.title, state.artist, (const char *) lyrics.begin ());
+                gtk_widget_set_sensitive (save_button, (timer == 0));
+                if (aud_get_bool ("lyricwiki", "cache_lyrics"))
+                {
+                    save_lyrics_locally ();
+                    if (aud_get_bool ("lyricwiki", "search_internet"))
+                        gtk_widget_set_sensitive (refresh_button, true);
+                }
+                AUDINFO ("i:Lyrics came from HELPER!\n");
+                /* JWT:ALLOW 'EM TO EMBED IN TAG, IF POSSIBLE. */
+                if (! strncmp ((const char *) state.filename, "file://", 7))
+                {
+                    for (auto & ext : extlist)
+                    {
+                        if (str_has_suffix_nocase ((const char *) state.filename, (const char *) ext))
+                        {
+                            String error;
+                            VFSFile file (state.filename, "r");
+                            PluginHandle * decoder = aud_file_find_decoder (state.filename, true, file, & error);
+                            bool can_write = aud_file_can_write_tuple (state.filename, decoder);
+                            if (can_write)
+                            {
+                                gtk_widget_set_sensitive (tag_save_button, (timer == 0));
+                                state.Wasok2saveTag = true;
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
         }
     }
+    if (! lyrics_found)
+    {
+        /* HELPER EXITS WITH 4 IF WEB-SEARCH SKIPPED DUE TO USER-CONFIG. */
+        update_lyrics (_("No lyrics Found"),
+                (const char *) str_concat ({"Title: ", (const char *) state.title, "\nArtist: ",
+                (const char *) state.artist}),
+                ((status == 4)
+                        ? str_printf (_("Lyrics fetch skipped (helper config)."))
+                        : str_printf (_("Unable to fetch lyrics."))));
+    }
 
-    pthread_mutex_lock (& mutex);
+    state.synclyrics = aud_get_bool ("lyricwiki", "sync_lyrics");
+    show_lyrics ();
+}
 
-    String lyric_helper = aud_get_str ("audacious", "lyric_helper");
+/* LYRICS FETCHED BY THE HELPER ARE KEPT IN ~/.config/fauxdacious[_?]/fetch-cache/lyricwiki/: */
+static FetchQueue fetch_queue ("lyricwiki", "txt", 8, fetch_lyrics, lyrics_fetched);
 
-    if (resetthreads)
-        goto THREAD_EXIT;
+/* HANDLE FETCHING LYRICS FROM WEB VIA HELPER (1-STEP, IN THE BACKGROUND) OR fandom.com? (STEP 1 OF 3): */
+/* NOTE:  WHEN STARTING PLAY, WE WAIT 2 SEC. B/C NORMALLY, A STREAM STILL HAS IT'S LAST-PLAYED
+   TITLE-TUPLE AND, QUICKLY AFTER STARTING PLAY, A TUPLE-CHANGE WILL OCCUR BEFORE THE FIRST FETCH CAN
+   LOOK UP THE "OLD" LYRICS (IF NOT CACHED), IF SO THE NEWER REQUEST REPLACES THE FIRST ONE SO THAT ONLY
+   THE CURRENT LYRICS FOR THE NOW-CHANGED TUPLE (TITLE) ARE LOOKED UP!  WE STILL HAVE TO INITIATE A
+   LOOKUP ON PLAY-START SINCE OTHERWISE FILES (WHICH HAVE NO TUPLE-CHANGES) WOULD NEVER HAVE THEIR
+   LYRICS LOOKED UP!
+*/
+static void fetch_lyrics_from_web ()
+{
+    String lyric_helper = aud_get_str ("audacious", "lyric_helper");
 
     if (lyric_helper[0])  //JWT:WE HAVE A PERL HELPER, LESSEE IF IT CAN FIND/DOWNLOAD LYRICS FOR US:
     {
-        bool lyrics_found = false;
-        int helper_returncode = 0;
-        GStatBuf statbuf;
         if (! state.album)
             state.album = String ("_");
 
@@ -528,89 +590,38 @@ static void * lyric_helper_thread_fn (void * data)
         if (lyric_format > 1 && state.is_stream)
             lyric_format = 1;  /* DON'T ENFORCE TIMESTAMPPED-LYRICS FETCH FOR STREAMS (IT DON'T WORK)! */
 
-        StringBuf flags = (! state.force_refresh && aud_get_bool ("albumart", "_isactive")
+        FetchRequest request;
+        request.artist = state.artist;
+        request.title = state.title;
+        request.album = state.album;
+        request.filename = state.filename;
+        request.options = String ((! state.force_refresh && aud_get_bool ("albumart", "_isactive")
                 && aud_get_bool ("albumart", "internet_coverartlookup"))
                         ? str_printf ("%s%d", "ALBUMART,SYNC=", lyric_format)
-                        : str_printf ("%s%d", "SYNC=", lyric_format);
-
-        AUDINFO ("i:HELPER FOUND: WILL DO (%s)\n", (const char *) str_concat ({lyric_helper, " \"",
-                (const char *) state.artist, "\" \"",
-                (const char *) state.title, "\" ", aud_get_path (AudPath::UserDir),
-                " \"", (const char *) state.album, "\" '", (const char *) flags, "' "}));
-#ifdef _WIN32
-        WinExec ((const char *) str_concat ({lyric_helper, " \"", (const char *) state.artist, "\" \"",
-                (const char *) state.title, "\" ", aud_get_path (AudPath::UserDir),
-                " \"", (const char *) state.album, "\" '", (const char *) flags, "' "}),
-                SW_HIDE);
-#else
-        helper_returncode = system ((const char *) str_concat ({lyric_helper, " \"", (const char *) state.artist, "\" \"",
-                (const char *) state.title, "\" ", aud_get_path (AudPath::UserDir),
-                " \"", (const char *) state.album, "\" '", flags, "' "}));
-#endif
-        String lyric_fid = String (str_concat ({aud_get_path (AudPath::UserDir), "/_tmp_lyrics.txt"}));
+                        : str_printf ("%s%d", "SYNC=", lyric_format));
+        request.force = state.force_refresh;
 
-        if (! resetthreads)
+        /* JWT:LYRICS THE HELPER FETCHED BEFORE? */
+        String cached = fetch_queue.lookup (request);
+        if (cached)
         {
-// DEPRECIATED:             gtk_widget_set_sensitive (edit_button, false);  /* NO EDITING LYRICS ON HELPER-SERVED SITES! */
-            if (g_stat ((const char *) lyric_fid, & statbuf) == 0)
-            {
-                VFSFile lyrics_file ((const char *) lyric_fid, "r");
-                if (lyrics_file)
-                {
-                    Index<char> lyrics = lyrics_file.read_all ();
-                    if (lyrics.len () > 1)
-                    {
-                        lyrics.resize (lyrics.len ()+1);
-                        lyrics[lyrics.len ()-1] = '\0';
-                        lyrics_found = true;
-                        update_lyrics (state.title, state.artist, (const char *) lyrics.begin ());
-                        gtk_widget_set_sensitive (save_button, (timer == 0));
-                        if (aud_get_bool ("lyricwiki", "cache_lyrics"))
-                        {
-                            save_lyrics_locally ();
-                            if (aud_get_bool ("lyricwiki", "search_internet"))
-                                gtk_widget_set_sensitive (refresh_button, true);
-                        }
-                        AUDINFO ("i:Lyrics came from HELPER!\n");
-                        /* JWT:ALLOW 'EM TO EMBED IN TAG, IF POSSIBLE. */
-                        if (! strncmp ((const char *) state.filename, "file://", 7))
-                        {
-                            for (auto & ext : extlist)
-                            {
-                                if (str_has_suffix_nocase ((const char *) state.filename, (const char *) ext))
-                                {
-                                    String error;
-                                    VFSFile file (state.filename, "r");
-                                    PluginHandle * decoder = aud_file_find_decoder (state.filename, true, file, & error);
-                                    bool can_write = aud_file_can_write_tuple (state.filename, decoder);
-                                    if (can_write)
-                                    {
-                                        gtk_widget_set_sensitive (tag_save_button, (timer == 0));
-                                        state.Wasok2saveTag = true;
-                                    }
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+            fetch_queue.cancel ();
+            lyrics_fetched (request, cached, 0);
+            return;
         }
-        if (! lyrics_found && ! resetthreads)
+
+        int delay_msec = 0;
+        if (fromsongstartup && state.is_stream)  // TRUE IF SONG-START, FALSE ON TUPLE-CHANGE!
         {
-            /* HELPER RETURNS 4 (1024) IF WEB-SEARCH SKIPPED DUE TO USER-CONFIG. */
-            update_lyrics (_("No lyrics Found"),
-                    (const char *) str_concat ({"Title: ", (const char *) state.title, "\nArtist: ",
-                    (const char *) state.artist}),
-                    ((helper_returncode == 1024)
-                            ? str_printf (_("Lyrics fetch skipped (helper config)."))
-                            : str_printf (_("Unable to fetch lyrics."))));
-
-            goto THREAD_EXIT;
+            delay_msec = aud_get_int ("lyricwiki", "sleep_msec");
+            if (delay_msec < 1)  delay_msec = 1600;
         }
+        fetch_queue.request (request, delay_msec);
     }
     else /* DEPRECIATED:NO HELPER, TRY THE OLD SCHOOL "3-STEP C" WAY: (MAYBE fandom.com CAME BACK OR AUDACIOUS FIXED?) */
     {
+        fetch_queue.cancel ();
+
         StringBuf title_buf = str_encode_percent (state.title);
         StringBuf artist_buf = str_encode_percent (state.artist);
 
@@ -619,21 +630,10 @@ static void * lyric_helper_thread_fn (void * data)
                 (const char *) title_buf));
 
         update_lyrics (state.title, state.artist, _("Connecting to lyrics.fandom.com ..."));
+        show_lyrics ();
 // DEPRECIATED:         gtk_widget_set_sensitive (edit_button, false);
         vfs_async_file_get_contents (state.uri, get_lyrics_step_2, nullptr);
     }
-
-THREAD_EXIT:
-    lyric_helper = String ();
-
-    if (! abortthisthread && ! resetthreads)
-        g_idle_add (lyrics_ready, nullptr);
-
-    pthread_mutex_unlock (& mutex);
-
-    pthread_exit (nullptr);
-
-    return nullptr;
 }
 
 /* JWT:HANDLE LYRICS FROM LOCAL LYRICS FILES: */
@@ -869,6 +869,7 @@ static GtkWidget * build_widget ()
     gtk_text_buffer_create_tag (textbuffer, "weight_bold", "weight", PANGO_WEIGHT_BOLD, nullptr);
     gtk_text_buffer_create_tag (textbuffer, "size_x_large", "scale", PANGO_SCALE_X_LARGE, nullptr);
     gtk_text_buffer_create_tag (textbuffer, "style_italic", "style", PANGO_STYLE_ITALIC, nullptr);
+    gtk_text_buffer_create_tag (textbuffer, "enlarge_tag", "scale", 1.5, nullptr);  // SYNCED LYRICS' CURRENT LINE
 
     GtkWidget * hbox = audgui_hbox_new (6);
     gtk_box_pack_start ((GtkBox *) vbox, hbox, false, false, 0);
@@ -946,49 +947,12 @@ static void show_lyrics ()
     if (state.is_stream || ! state.synclyrics)
         return;
 
-    bool have_timestamps = false;
-    // Parse the lyrics and populate timed_lyrics
-    timed_lyrics.clear ();
-    std::istringstream iss (static_cast<std::string>(state.sholyrics)); // Assuming String can be cast to std::string
-    std::string line;
-    // Updated regex to support both SS.SS and SS.SSS formats
-    std::regex re (R"(\[\s*(\d+)\s*:\s*(\d+\.\d{2,3})\s*\]\s*(.*))");
-    std::regex re_offset (R"(\[offset:([+-]?\d+)\])");
-
-    // Add a dummy timestamp line at the beginning to prevent title from being highlighted
-    TimedLyricLine dummy_line;
-    dummy_line.timestamp_ms = 0;
-    dummy_line.text = String ("");
-    timed_lyrics.push_back (dummy_line);
-    int offset_ms = 0;
-
-    while (std::getline (iss, line))
-    {
-        // Sanitize the line: remove leading/trailing spaces and carriage return
-        line.erase(0, line.find_first_not_of (" \t\r"));  // Remove leading whitespace
-        line.erase(line.find_last_not_of (" \t\r") + 1);  // Remove trailing whitespace
-        std::smatch match;
-        if (std::regex_match (line, match, re))
-        {
-            have_timestamps = true;
-            int minutes = std::stoi (match[1].str ());    // Convert minutes
-            float seconds = std::stof (match[2].str ());  // Convert seconds
-            int timestamp_ms = static_cast<int>(((minutes * 60 + seconds) * 1000) + offset_ms);
-
-            TimedLyricLine timed_line;
-            timed_line.timestamp_ms = timestamp_ms;
-            timed_line.text = String (match[3].str ().c_str ());  // Lyric text
-
-            timed_lyrics.push_back (timed_line);
-        }
-        else if (std::regex_match (line, match, re_offset))
-            offset_ms = std::stoi (match[1].str ());    // Convert offset_millisec
-    }
-    if (! have_timestamps)
+    if (! synced_lyrics.parse (state.sholyrics))
         state.synclyrics = false;
 
+    shown_position = -1;
     if (state.synclyrics && ! state.is_stream && timer == 0)
-        timer = g_timeout_add (200, update_lyrics_display, nullptr);  // Start the sync timer
+        timer = g_timeout_add (0, update_lyrics_display, nullptr);  // Start the sync timer
 }
 
 /* CALLED WHENEVER WE NEED LYRICS: */
@@ -1093,6 +1057,7 @@ static void lyricwiki_playback (bool force_refresh)
 
     if (found_lyricfile)  // JWT:WE HAVE LYRICS STORED IN A LOCAL FILE MATCHING FILE NAME!:
     {
+        fetch_queue.cancel ();
         AUDINFO ("i:Local lyric file found (%s).\n", (const char *) lyricStr);
         vfs_async_file_get_contents (lyricStr, get_lyrics_step_0, nullptr);
     }
@@ -1164,6 +1129,7 @@ static void lyricwiki_playback (bool force_refresh)
 
                 if (need_lyrics && found_lyricfile)
                 {
+                    fetch_queue.cancel ();
                     AUDINFO ("i:Global lyric file found by artist/title (%s).\n", (const char *) lyricStr);
                     vfs_async_file_get_contents (lyricStr, get_lyrics_step_0, nullptr);
                     lyricStr = String ();
@@ -1185,6 +1151,7 @@ static void lyricwiki_playback (bool force_refresh)
             show_lyrics ();
             if (! state.artist || ! state.title)
             {
+                fetch_queue.cancel ();
                 update_lyrics (_("Error"), nullptr, _("Missing title and/or artist"));
                 show_lyrics ();
 // DEPRECIATED:                 gtk_widget_set_sensitive (edit_button, false);  /* NO EDITING LYRICS ON HELPER-SERVED SITES! */
@@ -1192,6 +1159,7 @@ static void lyricwiki_playback (bool force_refresh)
             }
             if (! aud_get_bool ("lyricwiki", "search_internet"))
             {
+                fetch_queue.cancel ();
                 update_lyrics (_("No lyrics Found locally"),
                         (const char *) str_concat ({"Title: ", (const char *) state.title, "\nArtist: ",
                         (const char *) state.artist}),
@@ -1200,27 +1168,10 @@ static void lyricwiki_playback (bool force_refresh)
                 return;
             }
 
-            pthread_attr_t thread_attrs;
-            if (! pthread_attr_init (& thread_attrs))
-            {
-                if (! pthread_attr_setdetachstate (& thread_attrs, PTHREAD_CREATE_DETACHED)
-                        || ! pthread_attr_setscope (& thread_attrs, PTHREAD_SCOPE_SYSTEM))
-                {
-                    pthread_t lyric_helper_thread;
-
-                    resetthreads = false;
-                    if (pthread_create (&lyric_helper_thread, nullptr, lyric_helper_thread_fn, nullptr))
-                        AUDERR ("s:Error creating helper thread: %s - Expect Delays!...\n", strerror (errno));
-                }
-                else
-                    AUDERR ("s:Error detatching helper thread: %s!\n", strerror (errno));
-
-                if (pthread_attr_destroy (& thread_attrs))
-                    AUDERR ("s:Error destroying helper thread attributes: %s!\n", strerror (errno));
-            }
-            else
-                AUDERR ("s:Error initializing helper thread attributes: %s!\n", strerror (errno));
+            fetch_lyrics_from_web ();
         }
+        else
+            fetch_queue.cancel ();  // JWT:LYRICS CAME FROM THE EMBEDDED TAG.
     }
 
     gtk_widget_set_sensitive (save_button, (timer == 0));  // NO SAVING (PARTIAL) SYNCED LYRICS!
@@ -1231,7 +1182,6 @@ static void lyricwiki_playback (bool force_refresh)
 /* CALLED WHEN PLAYBACK STARTS: */
 static void lyricwiki_playback_began ()
 {
-    resetthreads = true;
     fromsongstartup = true;
     lyricwiki_playback (false);
 }
@@ -1252,17 +1202,20 @@ static void kill_thread_eventloop ()
         timer = 0;
     }
     gtk_widget_set_sensitive (refresh_button, false);
-    resetthreads = true;
+    fetch_queue.cancel ();
 }
 
 /* CALLED ON SHUTDOWN TO CLEAN UP: */
 static void destroy_cb ()
 {
     kill_thread_eventloop ();
+    fetch_queue.cleanup ();
 
     hook_dissociate ("playback stop", (HookFunction) kill_thread_eventloop);
     hook_dissociate ("tuple change", (HookFunction) lyricwiki_playback_changed);
     hook_dissociate ("playback ready", (HookFunction) lyricwiki_playback_began);
+    hook_dissociate ("playback seek", (HookFunction) resync_lyrics);
+    hook_dissociate ("playback unpause", (HookFunction) resync_lyrics);
 
     state.filename = String ();
     state.title = String ();
@@ -1281,67 +1234,35 @@ static void destroy_cb ()
 // DEPRECIATED:     edit_button = nullptr;
 }
 
-void highlight_lyrics(int current_time_ms) {
-    if (!textbuffer)
+/* REDRAW THE SYNCED LYRICS AROUND THE GIVEN POSITION (ONLY CALLED WHEN IT CHANGES): */
+static void highlight_lyrics (int position)
+{
+    if (! textbuffer)
         return;
 
+    const TimedLyricLine * lines[4];
+    int highlight;
+    int count = synced_lyrics.window (position, lines, highlight);
+
     // Clear the text buffer
     gtk_text_buffer_set_text (textbuffer, "", -1);
     gtk_widget_set_sensitive (save_button, false);  // NO SAVING (PARTIAL) SYNCED LYRICS!
 
-    // Find the 4 lines closest to the current timestamp (current + 3 neighbors)
-    std::vector<TimedLyricLine> lines_to_display;
-
-    // Store up to 4 lines starting from the current one
-    for (size_t i = 0; i < timed_lyrics.size (); ++i)
-    {
-        if (timed_lyrics[i].timestamp_ms >= current_time_ms)
-        {
-            // Ensure we have the current line and its neighbors (3 more lines)
-            size_t start_index = (i > 1) ? i - 2 : 0;  // Start 2 lines before the current line
-            size_t end_index = std::min (i + 2, timed_lyrics.size () - 1);  // Limit to 3 more lines after
-
-            // Ensure no more than 4 lines are selected
-            size_t line_count = 0;
-
-            for (size_t j = start_index; j <= end_index && line_count < 4; ++j)
-            {
-                lines_to_display.push_back (timed_lyrics[j]);
-                line_count++;
-            }
-            break;
-        }
-    }
-
-    // Retrieve the tag table
-    GtkTextTagTable* tag_table = gtk_text_buffer_get_tag_table (textbuffer);
-
-    // Check if the enlarge tag exists, and create it if not
-    GtkTextTag* enlarge_tag = gtk_text_tag_table_lookup (tag_table, "enlarge_tag");
-    if (!enlarge_tag) {
-        enlarge_tag = gtk_text_tag_new ("enlarge_tag");
-        g_object_set (enlarge_tag, "scale", 1.5, NULL); // Enlarge by 1.5 times (adjust as needed)
-        gtk_text_tag_table_add (tag_table, enlarge_tag);
-    }
-
     // Insert the selected lines into the text buffer
     GtkTextIter iter;
     gtk_text_buffer_get_start_iter (textbuffer, &iter);
 
-    for (size_t i = 0; i < lines_to_display.size (); ++i) {
-        const TimedLyricLine &line = lines_to_display[i];
-        std::string text_with_newline = std::string (line.text);
-
+    for (int i = 0; i < count; i ++)
+    {
         // Skip empty lines (like our dummy timestamp)
-        if (text_with_newline.empty ())
+        if (! lines[i]->text[0])
             continue;
 
-        // Apply the enlarge tag to the second line
-        if (i == 1)  // Second line (index 1)
+        if (i == highlight)
             gtk_text_buffer_insert_with_tags_by_name (textbuffer, &iter,
-                    text_with_newline.c_str (), -1, "enlarge_tag", NULL);
+                    lines[i]->text, -1, "enlarge_tag", NULL);
         else
-            gtk_text_buffer_insert(textbuffer, &iter, text_with_newline.c_str (), -1);
+            gtk_text_buffer_insert (textbuffer, &iter, lines[i]->text, -1);
 
         gtk_text_buffer_insert (textbuffer, &iter, "\n", -1);
     }
@@ -1352,11 +1273,34 @@ void highlight_lyrics(int current_time_ms) {
     gtk_text_view_scroll_to_iter (textview, &end_iter, 0, TRUE, 0, 0);
 }
 
+/* SYNC TIMER:  RATHER THAN POLLING, EACH RUN SCHEDULES THE NEXT ONE FOR WHEN THE
+   DISPLAYED LINE IS NEXT DUE TO CHANGE (SEEK AND UNPAUSE RESCHEDULE IT EARLY): */
 gboolean update_lyrics_display (gpointer data)
 {
-    highlight_lyrics (aud_drct_get_time ());  // Update lyrics display based on current time (ONLY WORKS FOR NON-STREAMS!)
+    int time = aud_drct_get_time ();  // (ONLY WORKS FOR NON-STREAMS!)
+    int position = synced_lyrics.position (time);
+
+    if (position != shown_position)
+    {
+        highlight_lyrics (position);
+        shown_position = position;
+    }
 
-    return G_SOURCE_CONTINUE;  // Continue calling this function
+    int delay = aud_drct_get_paused () ? -1 : synced_lyrics.time_to_next (position, time);
+    timer = g_timeout_add ((delay >= 0) ? aud::min (delay, SYNCED_LYRICS_IDLE_MS)
+            : SYNCED_LYRICS_IDLE_MS, update_lyrics_display, nullptr);
+
+    return G_SOURCE_REMOVE;  // Replaced by the timer just scheduled
+}
+
+/* CALLED ON SEEK OR UNPAUSE:  THE NEXT LINE CHANGE IS NO LONGER WHERE WE THOUGHT: */
+static void resync_lyrics ()
+{
+    if (timer > 0)
+    {
+        g_source_remove (timer);
+        timer = g_timeout_add (0, update_lyrics_display, nullptr);
+    }
 }
 
 /* CALLED ON STARTUP (WIDGET CREATION): */
@@ -1367,6 +1311,8 @@ void * LyricWiki::get_gtk_widget ()
     hook_associate ("playback ready", (HookFunction) lyricwiki_playback_began, nullptr);
     hook_associate ("tuple change", (HookFunction) lyricwiki_playback_changed, nullptr);
     hook_associate ("playback stop", (HookFunction) kill_thread_eventloop, nullptr);
+    hook_associate ("playback seek", (HookFunction) resync_lyrics, nullptr);
+    hook_associate ("playback unpause", (HookFunction) resync_lyrics, nullptr);
 
     g_signal_connect (vbox, "destroy", destroy_cb, nullptr);
 
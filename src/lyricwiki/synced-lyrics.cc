@@ -0,0 +1 @@
+#include "../ui-common/synced-lyrics.cc"
@@ -0,0 +1,349 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/runtime.h>
+
+#include "matrix.h"
+
+#define SQRT1_2 0.70710678f
+
+enum Speaker {FL, FR, FC, LFE, BL, BR, SL, SR, BC, N_SPEAKERS};
+
+#define MAX_LAYOUT 8
+
+static const Speaker layouts[MAX_LAYOUT][MAX_LAYOUT] = {
+    {FC},
+    {FL, FR},
+    {FL, FR, FC},
+    {FL, FR, BL, BR},
+    {FL, FR, FC, BL, BR},
+    {FL, FR, FC, LFE, BL, BR},
+    {FL, FR, FC, LFE, BC, SL, SR},
+    {FL, FR, FC, LFE, BL, BR, SL, SR}
+};
+
+/* the matrix between speakers, before it is put in channel order */
+struct SpeakerMatrix
+{
+    float gains[N_SPEAKERS][N_SPEAKERS] {};
+    bool in[N_SPEAKERS] {}, out[N_SPEAKERS] {};
+
+    void add (Speaker o, Speaker i, float gain)
+        { gains[o][i] += gain; }
+
+    /* to the front pair, or to the center when mixing down to mono (every
+     * layout has one or the other); stereo is averaged for mono, as before */
+    void add_front (Speaker i, float left, float right)
+    {
+        if (out[FL])
+        {
+            add (FL, i, left);
+            add (FR, i, right);
+        }
+        else
+            add (FC, i, (left + right) * 0.5f);
+    }
+
+    void add_row (Speaker to, Speaker from, float gain)
+    {
+        for (int i = 0; i < N_SPEAKERS; i ++)
+            gains[to][i] += gains[from][i] * gain;
+    }
+
+    bool fed (Speaker o) const
+    {
+        for (int i = 0; i < N_SPEAKERS; i ++)
+        {
+            if (gains[o][i] != 0)
+                return true;
+        }
+
+        return false;
+    }
+};
+
+/* a surround channel with nowhere else to go; side is -1 (left), 0 (center)
+ * or 1 (right) */
+static void surround_to_front (SpeakerMatrix & m, Speaker i, int side, int downmix)
+{
+    /* matrix-encoded stereo: the surrounds go out of phase, to be steered to
+     * the rear again by a decoder */
+    if (downmix == DOWNMIX_DOLBY || (downmix == DOWNMIX_DPL2 && ! side))
+        m.add_front (i, -0.5f, 0.5f);
+    else if (downmix == DOWNMIX_DPL2)
+        m.add_front (i, (side < 0) ? -0.6124f : -0.3536f, (side < 0) ? 0.3536f : 0.6124f);
+    else if (side)
+        m.add_front (i, (side < 0) ? SQRT1_2 : 0, (side < 0) ? 0 : SQRT1_2);
+    else
+        m.add_front (i, 0.5f, 0.5f);
+}
+
+static void mix_down (SpeakerMatrix & m, bool mono_in, bool mix_lfe, int downmix)
+{
+    for (int s = 0; s < N_SPEAKERS; s ++)
+    {
+        auto i = (Speaker) s;
+
+        if (! m.in[i])
+            continue;
+
+        if (m.out[i])
+        {
+            m.add (i, i, 1);
+            continue;
+        }
+
+        switch (i)
+        {
+        case FL:
+            m.add_front (FL, 1, 0);
+            break;
+        case FR:
+            m.add_front (FR, 0, 1);
+            break;
+        case FC:
+            /* a mono source is not a center speaker; it goes to both sides
+             * in full, as before */
+            if (mono_in)
+                m.add_front (FC, 1, 1);
+            else
+                m.add_front (FC, SQRT1_2, SQRT1_2);
+            break;
+        case LFE:
+            if (mix_lfe)
+                m.add_front (LFE, SQRT1_2, SQRT1_2);
+            break;
+
+        case BL:
+        case BR:
+        {
+            Speaker side = (i == BL) ? SL : SR;
+
+            /* 7.1 to 6.1: the back pair becomes the back center */
+            if (m.out[BC] && m.in[side])
+                m.add (BC, i, SQRT1_2);
+            else if (m.out[side])
+                m.add (side, i, 1);
+            else if (m.out[BC])
+                m.add (BC, i, SQRT1_2);
+            else
+                surround_to_front (m, i, (i == BL) ? -1 : 1, downmix);
+            break;
+        }
+
+        case SL:
+        case SR:
+        {
+            Speaker back = (i == SL) ? BL : BR;
+
+            if (m.out[back])
+                m.add (back, i, 1);
+            else
+                surround_to_front (m, i, (i == SL) ? -1 : 1, downmix);
+            break;
+        }
+
+        case BC:
+            if (m.out[BL])
+            {
+                m.add (BL, BC, SQRT1_2);
+                m.add (BR, BC, SQRT1_2);
+            }
+            else if (m.out[SL])
+            {
+                m.add (SL, BC, SQRT1_2);
+                m.add (SR, BC, SQRT1_2);
+            }
+            else
+                surround_to_front (m, BC, 0, downmix);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/* Speakers left silent get a copy of their neighbours.  The center and LFE
+ * are not made up; stereo sent to them would only narrow the image. */
+static void mix_up (SpeakerMatrix & m)
+{
+    if (m.out[FL] && ! m.fed (FL) && ! m.fed (FR) && m.in[FC] && ! m.out[FC])
+    {
+        m.add (FL, FC, 1);
+        m.add (FR, FC, 1);
+    }
+
+    static const Speaker pairs[][3] = {
+        /* speaker, first choice, second choice */
+        {BL, SL, FL}, {BR, SR, FR},
+        {SL, BL, FL}, {SR, BR, FR}
+    };
+
+    for (auto & pair : pairs)
+    {
+        if (! m.out[pair[0]] || m.fed (pair[0]))
+            continue;
+
+        if (m.out[pair[1]] && m.fed (pair[1]))
+            m.add_row (pair[0], pair[1], 1);
+        else if (m.out[pair[2]])
+            m.add_row (pair[0], pair[2], 1);
+    }
+
+    if (m.out[BC] && ! m.fed (BC))
+    {
+        Speaker left = m.out[BL] ? BL : SL;
+        Speaker right = m.out[BL] ? BR : SR;
+
+        if (m.out[left])
+        {
+            m.add_row (BC, left, 0.5f);
+            m.add_row (BC, right, 0.5f);
+        }
+    }
+}
+
+void mix_matrix_preset (MixMatrix & matrix, int in, int out, bool mix_lfe, int downmix)
+{
+    matrix.in = in;
+    matrix.out = out;
+    memset (matrix.gains, 0, sizeof matrix.gains);
+
+    if (in > MAX_LAYOUT || out > MAX_LAYOUT)
+    {
+        for (int c = 0; c < aud::min (in, out); c ++)
+            matrix.gains[c][c] = 1;
+
+        return;
+    }
+
+    const Speaker * in_layout = layouts[in - 1];
+    const Speaker * out_layout = layouts[out - 1];
+
+    SpeakerMatrix m;
+
+    for (int i = 0; i < in; i ++)
+        m.in[in_layout[i]] = true;
+    for (int o = 0; o < out; o ++)
+        m.out[out_layout[o]] = true;
+
+    /* only for stereo itself, not for the front pair of a bigger layout */
+    if (out != 2)
+        downmix = DOWNMIX_ITU;
+
+    mix_down (m, in == 1, mix_lfe, downmix);
+    mix_up (m);
+
+    for (int o = 0; o < out; o ++)
+    {
+        for (int i = 0; i < in; i ++)
+            matrix.gains[o][i] = m.gains[out_layout[o]][in_layout[i]];
+    }
+}
+
+/* one matrix from the list, without the "in>out:" */
+static bool parse_rows (MixMatrix & matrix, const char * text)
+{
+    Index<String> rows = str_list_to_index (text, "/");
+    if (rows.len () != matrix.out)
+        return false;
+
+    for (int o = 0; o < matrix.out; o ++)
+    {
+        int i = 0;
+
+        for (const String & value : str_list_to_index (rows[o], " ,\t"))
+        {
+            if (! value[0])
+                continue;
+            if (i == matrix.in)
+                return false;
+
+            matrix.gains[o][i ++] = str_to_double (value);
+        }
+
+        if (i != matrix.in)
+            return false;
+    }
+
+    return true;
+}
+
+bool mix_matrix_parse (MixMatrix & matrix, int in, int out, const char * list)
+{
+    if (! list || ! list[0])
+        return false;
+
+    for (const String & entry : str_list_to_index (list, ";"))
+    {
+        int entry_in, entry_out, header = 0;
+
+        if (sscanf (entry, " %d > %d :%n", & entry_in, & entry_out, & header) < 2 || ! header)
+        {
+            if (entry[strspn (entry, " \t")])
+                AUDERR ("Cannot parse custom matrix: %s\n", (const char *) entry);
+
+            continue;
+        }
+
+        if (entry_in != in || entry_out != out)
+            continue;
+
+        matrix.in = in;
+        matrix.out = out;
+        memset (matrix.gains, 0, sizeof matrix.gains);
+
+        if (parse_rows (matrix, entry + header))
+            return true;
+
+        AUDERR ("Custom matrix %d>%d needs %d rows of %d gains.\n", in, out, out, in);
+        return false;
+    }
+
+    return false;
+}
+
+void mix_matrix_normalize (MixMatrix & matrix)
+{
+    float max = 0;
+
+    for (int o = 0; o < matrix.out; o ++)
+    {
+        float sum = 0;
+        for (int i = 0; i < matrix.in; i ++)
+            sum += fabsf (matrix.gains[o][i]);
+
+        max = aud::max (max, sum);
+    }
+
+    if (max <= 1)
+        return;
+
+    for (int o = 0; o < matrix.out; o ++)
+    {
+        for (int i = 0; i < matrix.in; i ++)
+            matrix.gains[o][i] /= max;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef MIXER_MATRIX_H
+#define MIXER_MATRIX_H
+
+#include <libfauxdcore/audio.h>
+
+enum {
+    DOWNMIX_ITU,     /* ITU-R BS.775 */
+    DOWNMIX_DOLBY,   /* Dolby Surround (Lt/Rt) */
+    DOWNMIX_DPL2     /* Dolby Pro Logic II */
+};
+
+/* gains[o][i] is how much of input channel i goes to output channel o */
+struct MixMatrix
+{
+    int in = 0, out = 0;
+    float gains[AUD_MAX_CHANNELS][AUD_MAX_CHANNELS];
+};
+
+/* Channels are taken to be in the usual (WAVE/FFmpeg) order:
+ *
+ *   1: C                  5: FL FR FC BL BR
+ *   2: FL FR              6: FL FR FC LFE BL BR  (5.1)
+ *   3: FL FR FC           7: FL FR FC LFE BC SL SR  (6.1)
+ *   4: FL FR BL BR        8: FL FR FC LFE BL BR SL SR  (7.1)
+ *
+ * Above 8 channels, the first ones are passed through as they are.  The
+ * downmix style only matters when mixing surround channels down to stereo. */
+void mix_matrix_preset (MixMatrix & matrix, int in, int out, bool mix_lfe, int downmix);
+
+/* Looks for a matrix from in to out channels in a list such as
+ * "6>2: 1 0 .7 0 .7 0 / 0 1 .7 0 0 .7; 1>2: 1 / 1", which has one row of
+ * input gains per output channel. */
+bool mix_matrix_parse (MixMatrix & matrix, int in, int out, const char * list);
+
+/* scales the whole matrix down, if need be, so that no output can clip */
+void mix_matrix_normalize (MixMatrix & matrix);
+
+#endif
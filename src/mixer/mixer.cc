@@ -17,8 +17,7 @@
  * the use of this software.
  */
 
-/* TODO: implement more surround converters.
-         There should be more options for in * out cases (for example,
+/* TODO: There should be more options for in * out cases (for example,
          the user may wish to mix stereo up to quadro but keep 5.1 as-is,
          rather than downmixing 5.1 to quadro). A possible design might
          be a choice of output channels for each input channel count that
@@ -27,11 +26,23 @@
 
 #include <stdlib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/i18n.h>
 #include <libfauxdcore/runtime.h>
 #include <libfauxdcore/plugin.h>
 #include <libfauxdcore/preferences.h>
 
+#include "matrix.h"
+
+/* outputs are mixed four at a time */
+#define MAX_VECTORS ((AUD_MAX_CHANNELS + 3) / 4)
+
 class ChannelMixer : public EffectPlugin
 {
 public:
@@ -59,186 +70,150 @@ public:
 
 EXPORT ChannelMixer aud_plugin_instance;
 
-typedef Index<float> & (* Converter) (Index<float> & data);
-
 static Index<float> mixer_buf;
 
-static Index<float> & mono_to_stereo (Index<float> & data)
-{
-    int frames = data.len ();
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        float val = * get ++;
-        * set ++ = val;
-        * set ++ = val;
-    }
-
-    return mixer_buf;
-}
-
-static Index<float> & stereo_to_mono (Index<float> & data)
-{
-    int frames = data.len () / 2;
-    mixer_buf.resize (frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        float val = * get ++;
-        val += * get ++;
-        * set ++ = val / 2;
-    }
-
-    return mixer_buf;
-}
-
-static Index<float> & quadro_to_stereo (Index<float> & data)
-{
-    int frames = data.len () / 4;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float back_left   = * get ++;
-        float back_right  = * get ++;
-        * set ++ = front_left + (back_left * 0.7);
-        * set ++ = front_right + (back_right * 0.7);
-    }
-
-    return mixer_buf;
-}
-
-static Index<float> & stereo_to_quadro (Index<float> & data)
-{
-    int frames = data.len () / 2;
-    mixer_buf.resize (4 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        float left  = * get ++;
-        float right = * get ++;
-        * set ++ = left;   // front left
-        * set ++ = right;  // front right
-        * set ++ = left;   // rear left
-        * set ++ = right;  // rear right
-    }
+static int input_channels, output_channels;
+static bool mixing;
 
-    return mixer_buf;
-}
+/* The matrix by input channel: each column holds the gains of one input for
+ * all the outputs, padded to whole vectors.  Inputs that go nowhere are left
+ * out. */
+static int n_columns, n_vectors;
+static int column_input[AUD_MAX_CHANNELS];
+static float columns[AUD_MAX_CHANNELS][4 * MAX_VECTORS];
 
-static Index<float> & surround_5p1_to_stereo (Index<float> & data)
+static void set_matrix (const MixMatrix & matrix)
 {
-    int frames = data.len () / 6;
-    mixer_buf.resize (2 * frames);
-
-    float * get = data.begin ();
-    float * set = mixer_buf.begin ();
+    n_columns = 0;
+    n_vectors = (matrix.out + 3) / 4;
 
-    while (frames --)
+    for (int i = 0; i < matrix.in; i ++)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float lfe    = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + (lfe * 0.5) + (rear_left * 0.5);
-        * set ++ = front_right + (center * 0.5) + (lfe * 0.5) + (rear_right * 0.5);
+        float * column = columns[n_columns];
+        bool used = false;
+
+        for (int o = 0; o < 4 * n_vectors; o ++)
+        {
+            column[o] = (o < matrix.out) ? matrix.gains[o][i] : 0;
+            if (column[o] != 0)
+                used = true;
+        }
+
+        if (used)
+            column_input[n_columns ++] = i;
     }
-
-    return mixer_buf;
 }
 
-/* 5 channels case. Quad + center channel */
-static Index<float> & quadro_5_to_stereo (Index<float> & data)
+/* Each frame is mixed as a sum of columns, each scaled by one input sample.
+ * The stores of a frame run on into the next one (which overwrites the
+ * excess), so the buffer has room for a whole vector more. */
+static Index<float> & mix (Index<float> & data)
 {
-    int frames = data.len () / 5;
-    mixer_buf.resize (2 * frames);
+    int frames = data.len () / input_channels;
+    mixer_buf.resize (output_channels * frames + 4 * MAX_VECTORS);
 
-    float * get = data.begin ();
+    const float * get = data.begin ();
     float * set = mixer_buf.begin ();
 
     while (frames --)
     {
-        float front_left  = * get ++;
-        float front_right = * get ++;
-        float center = * get ++;
-        float rear_left   = * get ++;
-        float rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + rear_left;
-        * set ++ = front_right + (center * 0.5) + rear_right;
+#ifdef __SSE2__
+        __m128 acc[MAX_VECTORS];
+        for (int v = 0; v < n_vectors; v ++)
+            acc[v] = _mm_setzero_ps ();
+
+        for (int c = 0; c < n_columns; c ++)
+        {
+            __m128 sample = _mm_set1_ps (get[column_input[c]]);
+            for (int v = 0; v < n_vectors; v ++)
+                acc[v] = _mm_add_ps (acc[v], _mm_mul_ps (sample, _mm_loadu_ps (& columns[c][4 * v])));
+        }
+
+        for (int v = 0; v < n_vectors; v ++)
+            _mm_storeu_ps (set + 4 * v, acc[v]);
+#elif defined(__ARM_NEON)
+        float32x4_t acc[MAX_VECTORS];
+        for (int v = 0; v < n_vectors; v ++)
+            acc[v] = vdupq_n_f32 (0);
+
+        for (int c = 0; c < n_columns; c ++)
+        {
+            float sample = get[column_input[c]];
+            for (int v = 0; v < n_vectors; v ++)
+                acc[v] = vmlaq_n_f32 (acc[v], vld1q_f32 (& columns[c][4 * v]), sample);
+        }
+
+        for (int v = 0; v < n_vectors; v ++)
+            vst1q_f32 (set + 4 * v, acc[v]);
+#else
+        for (int o = 0; o < output_channels; o ++)
+            set[o] = 0;
+
+        for (int c = 0; c < n_columns; c ++)
+        {
+            float sample = get[column_input[c]];
+            for (int o = 0; o < output_channels; o ++)
+                set[o] += sample * columns[c][o];
+        }
+#endif
+
+        get += input_channels;
+        set += output_channels;
     }
 
+    mixer_buf.resize (set - mixer_buf.begin ());
     return mixer_buf;
 }
 
-static Converter get_converter (int in, int out)
-{
-    if (in == 1 && out == 2)
-        return mono_to_stereo;
-    if (in == 2 && out == 1)
-        return stereo_to_mono;
-    if (in == 2 && out == 4)
-        return stereo_to_quadro;
-    if (in == 4 && out == 2)
-        return quadro_to_stereo;
-    if (in == 5 && out == 2)
-        return quadro_5_to_stereo;
-    if (in == 6 && out == 2)
-        return surround_5p1_to_stereo;
-
-    return nullptr;
-}
-
-static int input_channels, output_channels;
-
 void ChannelMixer::start (int & channels, int & rate)
 {
     input_channels = channels;
-    output_channels = aud_get_int ("mixer", "channels");
-
-    if (input_channels == output_channels)
+    output_channels = aud::clamp (aud_get_int ("mixer", "channels"), 1, AUD_MAX_CHANNELS);
+    mixing = false;
+
+    MixMatrix matrix;
+    String custom = aud_get_str ("mixer", "custom_matrices");
+
+    if (mix_matrix_parse (matrix, input_channels, output_channels, custom))
+        AUDINFO ("Using custom matrix for %d to %d channels.\n", input_channels, output_channels);
+    else if (input_channels != output_channels)
+        mix_matrix_preset (matrix, input_channels, output_channels,
+         aud_get_bool ("mixer", "mix_lfe"), aud_get_int ("mixer", "stereo_downmix"));
+    else
         return;
 
-    if (! get_converter (input_channels, output_channels))
+    if (aud_get_bool ("mixer", "normalize"))
+        mix_matrix_normalize (matrix);
+
+    for (int o = 0; o < output_channels; o ++)
     {
-        AUDERR ("Converting %d to %d channels is not implemented.\n",
-         input_channels, output_channels);
-        return;
+        StringBuf row = str_printf ("Output %d:", o);
+        for (int i = 0; i < input_channels; i ++)
+            row.combine (str_printf (" %.3f", matrix.gains[o][i]));
+
+        AUDDBG ("%s\n", (const char *) row);
     }
 
+    set_matrix (matrix);
+
+    mixing = true;
     channels = output_channels;
 }
 
 Index<float> & ChannelMixer::process (Index<float> & data)
 {
-    if (input_channels == output_channels)
+    if (! mixing)
         return data;
 
-    Converter converter = get_converter (input_channels, output_channels);
-    if (converter)
-        return converter (data);
-
-    return data;
+    return mix (data);
 }
 
 const char * const ChannelMixer::defaults[] = {
  "channels", "2",
+ "stereo_downmix", "0",  /* DOWNMIX_ITU */
+ "mix_lfe", "FALSE",
+ "normalize", "FALSE",
+ "custom_matrices", "",
   nullptr};
 
 bool ChannelMixer::init ()
@@ -256,11 +231,29 @@ const char ChannelMixer::about[] =
  N_("Channel Mixer Plugin for Audacious\n"
     "Copyright 2011-2012 John Lindgren and Michał Lipski");
 
+static const ComboItem downmix_combo[] = {
+    ComboItem (N_("ITU-R BS.775"), DOWNMIX_ITU),
+    ComboItem (N_("Dolby Surround"), DOWNMIX_DOLBY),
+    ComboItem (N_("Dolby Pro Logic II"), DOWNMIX_DPL2)
+};
+
 const PreferencesWidget ChannelMixer::widgets[] = {
     WidgetLabel (N_("<b>Channel Mixer</b>")),
     WidgetSpin (N_("Output channels:"),
         WidgetInt ("mixer", "channels"),
-        {1, AUD_MAX_CHANNELS, 1})
+        {1, AUD_MAX_CHANNELS, 1}),
+    WidgetCombo (N_("Downmix to stereo:"),
+        WidgetInt ("mixer", "stereo_downmix"),
+        {{downmix_combo}}),
+    WidgetCheck (N_("Mix LFE into the other channels"),
+        WidgetBool ("mixer", "mix_lfe")),
+    WidgetCheck (N_("Normalize to avoid clipping"),
+        WidgetBool ("mixer", "normalize")),
+    WidgetLabel (N_("<b>Custom Matrices</b>")),
+    WidgetEntry (N_("Matrices:"),
+        WidgetString ("mixer", "custom_matrices")),
+    WidgetLabel (N_("One row of input gains per output channel, such as\n"
+                    "\"2>1: 0.5 0.5; 1>2: 1 / 1\".  Changes apply to the next song."))
 };
 
 const PluginPreferences ChannelMixer::prefs = {{widgets}};
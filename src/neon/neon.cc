@@ -19,6 +19,7 @@
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <string.h>
@@ -49,6 +50,7 @@
 #endif
 
 #include "cert_verification.h"
+#include "range-cache.h"
 
 #define NEON_NETBLKSIZE     (4096)
 #define NEON_ICY_BUFSIZE    (4096)
@@ -56,6 +58,20 @@
 #define NEON_RETRY_COUNT 6
 #define NEON_TIMEOUTSEC 10
 
+/* Data already delivered is kept this long so that short backward seeks (as
+ * demuxers issue while probing) need not go back to the server. */
+#define NEON_BACKBUF_SIZE (64 * 1024)
+
+/* In parallel download mode, files at least this large are fetched as a
+ * series of bounded range requests spread over several connections.  The
+ * block size adapts so that each request takes about NEON_CHUNK_TARGET_MS,
+ * keeping the per-request round trip small compared to the transfer. */
+#define NEON_PARALLEL_MIN_SIZE (2 * 1024 * 1024)
+#define NEON_CHUNK_MIN (64 * 1024)
+#define NEON_CHUNK_MAX (4 * 1024 * 1024)
+#define NEON_CHUNK_TARGET_MS 500
+#define NEON_PREFETCH_AHEAD (8 * 1024 * 1024)  /* fetched but not yet buffered */
+
 enum FillBufferResult {
     FILL_BUFFER_SUCCESS,
     FILL_BUFFER_ERROR,
@@ -91,6 +107,18 @@ struct reader_status
     }
 };
 
+struct PrefetchChunk
+{
+    int64_t start;
+    int len;
+    bool done = false;
+    int committed = 0;      /* bytes already moved into the ring buffer */
+    Index<char> data;
+
+    PrefetchChunk (int64_t start, int len) :
+        start (start), len (len) {}
+};
+
 struct icy_metadata
 {
     String stream_name;
@@ -141,6 +169,9 @@ const char * const NeonTransport::defaults[] = {
     "neon_timeoutsec", aud::numeric_string<NEON_TIMEOUTSEC>::str,
     "ignore_ssl_certs", "0",
     "user_agent", "Fauxdacious/" PACKAGE_VERSION,
+    "disk_cache", "FALSE",
+    "disk_cache_mb", "256",
+    "parallel_connections", "1",
     nullptr
 };
 
@@ -172,6 +203,7 @@ public:
     ~NeonFile ();
 
     int open_handle (int64_t startbyte, String * error = nullptr);
+    void open_cache ();
 
 protected:
     int64_t fread (void * ptr, int64_t size, int64_t nmemb);
@@ -207,6 +239,28 @@ private:
     bool m_prebuffering = true;
 
     RingBuf<char> m_rb;           /* Ringbuffer for our data */
+    RingBuf<char> m_back;         /* Most recently delivered data, for backward seeks */
+    int m_buffered_seeks = 0;     /* Seeks satisfied without a new request */
+    int m_session_reuses = 0;     /* New requests made on the existing session */
+
+    RangeCache m_cache;           /* Data of seekable files kept on disk, if enabled */
+    String m_validator;           /* ETag or Last-Modified, identifying the file version */
+    bool m_detached = false;      /* m_pos has moved away from the network stream, */
+    int64_t m_net_pos = 0;        /* which is still positioned here */
+
+    int64_t m_fetch_pos = 0;      /* Next byte to request from the network */
+    bool m_parallel = false;      /* Reader is using parallel range requests */
+    int m_connections = 1;        /* Number of connections in parallel mode */
+    int m_chunk_size = NEON_CHUNK_MIN;
+    Index<PrefetchChunk> m_chunks;  /* Requested ranges not yet fully buffered, in order */
+
+    /* download statistics for the current request */
+    int64_t m_request_time = 0;   /* When the request was started */
+    int64_t m_fetched_bytes = 0;
+    int64_t m_fetch_busy_us = 0;  /* Time at least one download was in progress */
+    int64_t m_fetch_busy_since = 0;
+    int m_fetching = 0;           /* Downloads in progress */
+    int64_t m_prebuffer_us = 0;   /* Time taken to first fill the prebuffer */
     int neon_netblksize;
     int neon_prebuffer_ratio;
     char * buffer;
@@ -223,11 +277,25 @@ private:
     reader_status m_reader_status;
 
     void kill_reader ();
+    ne_session * create_session ();
+    ne_request * create_request (ne_session * session);
     int server_auth (const char * realm, int attempt, char * username, char * password);
     void handle_headers ();
     int open_request (int64_t startbyte, String * error);
+    int reopen_request (int64_t startbyte);
+    void consume_buffer (char * ptr, int len);
+    bool seek_in_buffer (int64_t newpos);
+    int seek_network (int64_t newpos);
     FillBufferResult fill_buffer ();
     void reader ();
+    void parallel_reader ();
+    void prefetch_worker ();
+    bool fetch_range (ne_session * session, int64_t start, int len, Index<char> & data);
+    void commit_chunks ();
+    void fetch_started ();
+    void fetch_finished (int64_t bytes);
+    int prebuffer_size ();
+    int download_rate ();
     void wait_for_prebuffer ();
     int64_t try_fread (void * ptr, int64_t size, int64_t nmemb, bool & data_read);
 
@@ -237,6 +305,8 @@ private:
 
     static void * reader_thread (void * data)
         { ((NeonFile *) data)->reader (); return nullptr; }
+    static void * prefetch_thread (void * data)
+        { ((NeonFile *) data)->prefetch_worker (); return nullptr; }
 };
 
 NeonFile::NeonFile (const char * url) :
@@ -253,6 +323,7 @@ NeonFile::NeonFile (const char * url) :
     neon_retry_count = aud_get_int("neon", "neon_retries");
     if (neon_retry_count <= 0)
         neon_retry_count = NEON_RETRY_COUNT;
+    m_connections = aud::clamp (aud_get_int ("neon", "parallel_connections"), 1, 8);
     neon_timeoutsec = aud_get_int("neon", "neon_timeoutsec");
     if (neon_timeoutsec <= 0)
         neon_timeoutsec = NEON_TIMEOUTSEC;
@@ -268,6 +339,16 @@ NeonFile::NeonFile (const char * url) :
 
 NeonFile::~NeonFile ()
 {
+    if (m_buffered_seeks || m_session_reuses)
+        AUDDBG ("<%p> Avoided reconnects: %d seek(s) served from buffer, "
+         "%d request(s) on a kept-alive session\n", this, m_buffered_seeks,
+         m_session_reuses);
+
+    if (m_fetched_bytes)
+        AUDDBG ("<%p> Downloaded %" PRId64 " bytes at %d KiB/s%s, prebuffered in %d ms\n",
+         this, m_fetched_bytes, download_rate () / 1024, m_parallel ? " (parallel)" : "",
+         (int) (m_prebuffer_us / 1000));
+
     if (m_reader_status.reading)
         kill_reader ();
 
@@ -463,6 +544,18 @@ void NeonFile::handle_headers ()
             else
                 AUDERR ("Invalid content length header: %s\n", value);
         }
+        else if (str_has_prefix_nocase (name, "etag"))
+        {
+            /* identifies the version of the file; preferred over the
+             * modification time */
+            AUDDBG ("ETag: %s\n", value);
+            m_validator = String (str_concat ({"etag:", value}));
+        }
+        else if (str_has_prefix_nocase (name, "last-modified"))
+        {
+            if (! m_validator || ! str_has_prefix_nocase (m_validator, "etag:"))
+                m_validator = String (str_concat ({"modified:", value}));
+        }
         else if (str_has_prefix_nocase (name, "content-type"))
         {
             /* The server sent us a content type. Save it for later */
@@ -518,19 +611,24 @@ static int neon_proxy_auth_cb (void * userdata, const char * realm, int attempt,
     return attempt;
 }
 
+ne_request * NeonFile::create_request (ne_session * session)
+{
+    if (m_purl.query && * (m_purl.query))
+    {
+        StringBuf tmp = str_concat ({m_purl.path, "?", m_purl.query});
+        return ne_request_create (session, "GET", tmp);
+    }
+
+    return ne_request_create (session, "GET", m_purl.path);
+}
+
 int NeonFile::open_request (int64_t startbyte, String * error)
 {
     int ret;
     const ne_status * status;
     ne_uri * rediruri;
 
-    if (m_purl.query && * (m_purl.query))
-    {
-        StringBuf tmp = str_concat ({m_purl.path, "?", m_purl.query});
-        m_request = ne_request_create (m_session, "GET", tmp);
-    }
-    else
-        m_request = ne_request_create (m_session, "GET", m_purl.path);
+    m_request = create_request (m_session);
 
     if (startbyte > 0)
         ne_print_request_header (m_request, "Range", "bytes=%" PRIu64 "-", startbyte);
@@ -587,7 +685,14 @@ int NeonFile::open_request (int64_t startbyte, String * error)
             AUDDBG ("<%p> URL opened OK\n", this);
             m_content_start = startbyte;
             m_pos = startbyte;
+            m_fetch_pos = startbyte;
+            m_request_time = g_get_monotonic_time ();
+            m_prebuffer_us = 0;
             handle_headers ();
+
+            if (! m_back.size () && m_can_ranges && m_content_length >= 0 && ! m_icy_metaint)
+                m_back.alloc (NEON_BACKBUF_SIZE);
+
             return 0;
         }
         else if (status->code == 416)
@@ -665,9 +770,10 @@ static void trust_win32_root_certs (ne_session * m_session)
 }
 #endif
 
-int NeonFile::open_handle (int64_t startbyte, String * error)
+/* Creates a session to the server of m_purl, set up according to the
+ * proxy and plugin settings. */
+ne_session * NeonFile::create_session ()
 {
-    int ret;
     String proxy_host;
     int proxy_port = 0;
     String proxy_user (""); // ne_session_socks_proxy requires non NULL user and password
@@ -694,10 +800,57 @@ int NeonFile::open_handle (int64_t startbyte, String * error)
             socks_type = aud_get_int (nullptr, "socks_type") == 0 ? NE_SOCK_SOCKSV4A : NE_SOCK_SOCKSV5;
     }
 
+    AUDDBG ("<%p> Creating session to %s://%s:%d\n", this,
+     m_purl.scheme, m_purl.host, m_purl.port);
+    ne_session * session = ne_session_create (m_purl.scheme,
+     m_purl.host, m_purl.port);
+    ne_redirect_register (session);
+    ne_add_server_auth (session, NE_AUTH_BASIC, server_auth_callback, this);
+    ne_set_session_flag (session, NE_SESSFLAG_ICYPROTO, 1);
+    ne_set_session_flag (session, NE_SESSFLAG_PERSIST, 1);
+    ne_set_connect_timeout (session, neon_timeoutsec);
+    ne_set_read_timeout (session, neon_timeoutsec);
+    ne_set_useragent (session, user_agent);
+
+    if (use_proxy)
+    {
+        AUDDBG ("<%p> Using proxy: %s:%d\n", this, (const char *) proxy_host, proxy_port);
+        if (socks_proxy)
+            ne_session_socks_proxy (session, socks_type, proxy_host, proxy_port, proxy_user, proxy_pass);
+        else
+            ne_session_proxy (session, proxy_host, proxy_port);
+
+        if (use_proxy_auth)
+        {
+            AUDDBG ("<%p> Using proxy authentication\n", this);
+            ne_add_proxy_auth (session, NE_AUTH_BASIC,
+                    neon_proxy_auth_cb, (void *) this);
+        }
+    }
+
+    if (! strcmp ("https", m_purl.scheme))
+    {
+        AUDDBG ("<%p> Verifying certificate\n", this);
+        ne_ssl_trust_default_ca (session);
+#ifdef _WIN32
+        trust_win32_root_certs (session);
+#endif
+        ne_ssl_set_verify (session,
+                neon_vfs_verify_environment_ssl_certs, session);
+    }
+
+    return session;
+}
+
+int NeonFile::open_handle (int64_t startbyte, String * error)
+{
+    int ret;
+
     m_redircount = 0;
 
     AUDDBG ("<%p> Parsing URL\n", this);
 
+    ne_uri_free (& m_purl);
     if (ne_uri_parse (m_url, & m_purl) != 0)
     {
         if (error)
@@ -712,44 +865,7 @@ int NeonFile::open_handle (int64_t startbyte, String * error)
         if (! m_purl.port)
             m_purl.port = ne_uri_defaultport (m_purl.scheme);
 
-        AUDDBG ("<%p> Creating session to %s://%s:%d\n", this,
-         m_purl.scheme, m_purl.host, m_purl.port);
-        m_session = ne_session_create (m_purl.scheme,
-         m_purl.host, m_purl.port);
-        ne_redirect_register (m_session);
-        ne_add_server_auth (m_session, NE_AUTH_BASIC, server_auth_callback, this);
-        ne_set_session_flag (m_session, NE_SESSFLAG_ICYPROTO, 1);
-        ne_set_session_flag (m_session, NE_SESSFLAG_PERSIST, 0);
-        ne_set_connect_timeout (m_session, neon_timeoutsec);
-        ne_set_read_timeout (m_session, neon_timeoutsec);
-        ne_set_useragent (m_session, user_agent);
-
-        if (use_proxy)
-        {
-            AUDDBG ("<%p> Using proxy: %s:%d\n", this, (const char *) proxy_host, proxy_port);
-            if (socks_proxy)
-                ne_session_socks_proxy (m_session, socks_type, proxy_host, proxy_port, proxy_user, proxy_pass);
-            else
-                ne_session_proxy (m_session, proxy_host, proxy_port);
-
-            if (use_proxy_auth)
-            {
-                AUDDBG ("<%p> Using proxy authentication\n", this);
-                ne_add_proxy_auth (m_session, NE_AUTH_BASIC,
-                        neon_proxy_auth_cb, (void *) this);
-            }
-        }
-
-        if (! strcmp ("https", m_purl.scheme))
-        {
-            AUDDBG ("<%p> Verifying certificate\n", this);
-            ne_ssl_trust_default_ca (m_session);
-#ifdef _WIN32
-            trust_win32_root_certs (m_session);
-#endif
-            ne_ssl_set_verify (m_session,
-                    neon_vfs_verify_environment_ssl_certs, m_session);
-        }
+        m_session = create_session ();
 
         /* JWT:USER MAY TIRE OF WAITING TO CONNECT AND HIT STOP BUTTON, IF SO, WE MUST CLEAN UP!: */
         if (stop_playback)
@@ -789,13 +905,79 @@ int NeonFile::open_handle (int64_t startbyte, String * error)
     return 1;
 }
 
+/* Starts a new request for a different range on the session we already have,
+ * so that its resolved address, authentication and TLS session are reused, as
+ * is the connection itself if the previous response was read completely. */
+int NeonFile::reopen_request (int64_t startbyte)
+{
+    if (m_reader_status.status == NEON_READER_EOF && ! m_parallel)
+        ne_end_request (m_request);
+    else
+        ne_close_connection (m_session);  /* the rest of the body is unwanted */
+
+    ne_request_destroy (m_request);
+    m_request = nullptr;
+    m_redircount = 0;
+
+    if (stop_playback || open_request (startbyte, nullptr) != 0)
+    {
+        AUDDBG ("<%p> Could not reuse session, reconnecting\n", this);
+        ne_session_destroy (m_session);
+        m_session = nullptr;
+        return -1;
+    }
+
+    m_session_reuses ++;
+    return 0;
+}
+
+/* Amount of data to buffer before playback of a stream starts, which is
+ * also what the reported prebuffer time refers to. */
+int NeonFile::prebuffer_size ()
+{
+    int ratio = (neon_prebuffer_ratio > 0) ? neon_prebuffer_ratio : NEON_PREBUFFER_RATIO;
+    return aud::clamp ((int) (m_rb.size () / ratio), neon_netblksize, 128 * 1024);
+}
+
+/* The download rate is measured only over the time data was actually being
+ * transferred, not while the reader was waiting for buffer space.  These
+ * must be called with the reader mutex held. */
+void NeonFile::fetch_started ()
+{
+    if (! m_fetching ++)
+        m_fetch_busy_since = g_get_monotonic_time ();
+}
+
+void NeonFile::fetch_finished (int64_t bytes)
+{
+    if (! -- m_fetching)
+        m_fetch_busy_us += g_get_monotonic_time () - m_fetch_busy_since;
+
+    m_fetched_bytes += bytes;
+}
+
+/* bytes per second */
+int NeonFile::download_rate ()
+{
+    pthread_mutex_lock (& m_reader_status.mutex);
+
+    int64_t busy = m_fetch_busy_us;
+    if (m_fetching)
+        busy += g_get_monotonic_time () - m_fetch_busy_since;
+
+    int rate = (busy > 0) ? (int) aud::min (m_fetched_bytes * 1000000 / busy,
+     (int64_t) INT_MAX) : 0;
+
+    pthread_mutex_unlock (& m_reader_status.mutex);
+    return rate;
+}
+
 void NeonFile::wait_for_prebuffer ()
 {
     if (neon_prebuffer_ratio <= 0)
         m_prebuffering = false;
     else {
-        int prebuffer = aud::clamp ((int) (m_rb.size () / neon_prebuffer_ratio),
-                neon_netblksize, 128 * 1024);
+        int prebuffer = prebuffer_size ();
 
         pthread_mutex_lock (& m_reader_status.mutex);
 
@@ -817,10 +999,15 @@ FillBufferResult NeonFile::fill_buffer ()
 
     pthread_mutex_lock (& m_reader_status.mutex);
     to_read = aud::min (m_rb.space (), neon_netblksize);
+    fetch_started ();
     pthread_mutex_unlock (& m_reader_status.mutex);
 
     int bsize = ne_read_response_block (m_request, buffer, to_read);
 
+    pthread_mutex_lock (& m_reader_status.mutex);
+    fetch_finished (aud::max (bsize, 0));
+    pthread_mutex_unlock (& m_reader_status.mutex);
+
     if (! bsize)
     {
         AUDDBG ("<%p> End of file encountered\n", this);
@@ -843,6 +1030,11 @@ FillBufferResult NeonFile::fill_buffer ()
 
     pthread_mutex_lock (& m_reader_status.mutex);
     m_rb.copy_in (buffer, bsize);
+    m_fetch_pos += bsize;
+
+    if (! m_prebuffer_us && m_rb.len () >= prebuffer_size ())
+        m_prebuffer_us = g_get_monotonic_time () - m_request_time;
+
     pthread_mutex_unlock (& m_reader_status.mutex);
 
     return FILL_BUFFER_SUCCESS;
@@ -850,6 +1042,15 @@ FillBufferResult NeonFile::fill_buffer ()
 
 void NeonFile::reader ()
 {
+    m_parallel = (m_connections > 1 && m_can_ranges && ! m_icy_metaint &&
+     m_content_length >= NEON_PARALLEL_MIN_SIZE);
+
+    if (m_parallel)
+    {
+        parallel_reader ();
+        return;
+    }
+
     pthread_mutex_lock (& m_reader_status.mutex);
 
     while (m_reader_status.reading)
@@ -896,6 +1097,229 @@ void NeonFile::reader ()
     pthread_mutex_unlock (& m_reader_status.mutex);
 }
 
+/* Moves completed chunks into the ring buffer, in order, as far as there is
+ * space.  Must be called with the reader mutex held. */
+void NeonFile::commit_chunks ()
+{
+    bool committed = false;
+
+    while (m_chunks.len () && m_chunks[0].done && m_rb.space ())
+    {
+        PrefetchChunk & chunk = m_chunks[0];
+        int len = aud::min (m_rb.space (), chunk.len - chunk.committed);
+
+        m_rb.copy_in (chunk.data.begin () + chunk.committed, len);
+        chunk.committed += len;
+        committed = true;
+
+        if (chunk.committed == chunk.len)
+            m_chunks.remove (0, 1);
+    }
+
+    if (committed)
+    {
+        if (! m_prebuffer_us && m_rb.len () >= prebuffer_size ())
+            m_prebuffer_us = g_get_monotonic_time () - m_request_time;
+
+        pthread_cond_broadcast (& m_reader_status.cond);
+    }
+}
+
+/* Fetches one bounded range on the given session; the connection is kept
+ * alive for the next range if the response was read completely. */
+bool NeonFile::fetch_range (ne_session * session, int64_t start, int len, Index<char> & data)
+{
+    ne_request * request = create_request (session);
+    ne_print_request_header (request, "Range", "bytes=%" PRId64 "-%" PRId64,
+     start, start + len - 1);
+
+    int ret = ne_begin_request (request);
+    const ne_status * status = ne_get_status (request);
+
+    /* a 200 means the server ignored the range */
+    bool ok = (ret == NE_OK && status->code == 206);
+    if (! ok)
+        AUDDBG ("<%p> Range request at %" PRId64 " failed: %d (%d)\n", this,
+         start, ret, status->code);
+
+    data.resize (len);
+    int got = 0;
+
+    while (ok && got < len)
+    {
+        pthread_mutex_lock (& m_reader_status.mutex);
+        ok = m_reader_status.reading;
+        pthread_mutex_unlock (& m_reader_status.mutex);
+
+        if (! ok)
+            break;
+
+        int bsize = ne_read_response_block (request, data.begin () + got,
+         aud::min (len - got, NEON_CHUNK_MIN));
+
+        if (bsize > 0)
+            got += bsize;
+        else
+            ok = false;
+    }
+
+    if (ok)
+        ne_end_request (request);
+    else
+        ne_close_connection (session);
+
+    ne_request_destroy (request);
+    return ok;
+}
+
+void NeonFile::prefetch_worker ()
+{
+    ne_session * session = create_session ();
+    Index<char> data;
+
+    pthread_mutex_lock (& m_reader_status.mutex);
+
+    int64_t end = m_content_start + m_content_length;
+
+    while (m_reader_status.reading && m_reader_status.status == NEON_READER_RUN &&
+     m_fetch_pos < end)
+    {
+        commit_chunks ();
+
+        /* don't run too far ahead of playback */
+        int64_t ahead = 0;
+        for (auto & chunk : m_chunks)
+            ahead += chunk.len - chunk.committed;
+
+        if (ahead >= NEON_PREFETCH_AHEAD)
+        {
+            pthread_cond_wait (& m_reader_status.cond, & m_reader_status.mutex);
+            continue;
+        }
+
+        int64_t start = m_fetch_pos;
+        int len = (int) aud::min ((int64_t) m_chunk_size, end - start);
+        m_fetch_pos += len;
+        m_chunks.append (start, len);
+        fetch_started ();
+
+        pthread_mutex_unlock (& m_reader_status.mutex);
+
+        int64_t time = g_get_monotonic_time ();
+        bool ok = fetch_range (session, start, len, data);
+
+        for (int retries = 0; ! ok && retries < neon_retry_count && ! stop_playback; retries ++)
+        {
+            /* a seek or close (or another worker's error) ends the reader;
+             * don't reconnect just to find that out */
+            pthread_mutex_lock (& m_reader_status.mutex);
+            bool running = m_reader_status.reading && m_reader_status.status == NEON_READER_RUN;
+            pthread_mutex_unlock (& m_reader_status.mutex);
+
+            if (! running)
+                break;
+
+            AUDDBG ("<%p> Retrying range at %" PRId64 " (%d of %d)\n", this,
+             start, retries + 1, neon_retry_count);
+            ne_session_destroy (session);
+            session = create_session ();
+            time = g_get_monotonic_time ();
+            ok = fetch_range (session, start, len, data);
+        }
+
+        time = g_get_monotonic_time () - time;
+
+        pthread_mutex_lock (& m_reader_status.mutex);
+
+        fetch_finished (ok ? len : 0);
+
+        if (! ok)
+        {
+            /* also reached when stopped; the caller then ignores the status */
+            if (m_reader_status.status == NEON_READER_RUN)
+            {
+                AUDERR ("<%p> Error while fetching range at %" PRId64 "\n", this, start);
+                m_reader_status.status = NEON_READER_ERROR;
+            }
+
+            pthread_cond_broadcast (& m_reader_status.cond);
+            break;
+        }
+
+        for (auto & chunk : m_chunks)
+        {
+            if (chunk.start == start)
+            {
+                chunk.data = std::move (data);
+                chunk.done = true;
+                break;
+            }
+        }
+
+        /* aim for NEON_CHUNK_TARGET_MS per request at the observed rate */
+        int64_t target = (int64_t) len * NEON_CHUNK_TARGET_MS * 1000 / aud::max (time, (int64_t) 1);
+        m_chunk_size = aud::clamp ((int) aud::min ((m_chunk_size + target) / 2,
+         (int64_t) NEON_CHUNK_MAX), NEON_CHUNK_MIN, NEON_CHUNK_MAX);
+
+        commit_chunks ();
+    }
+
+    pthread_mutex_unlock (& m_reader_status.mutex);
+
+    ne_session_destroy (session);
+}
+
+/* Runs in place of the sequential reader:  the upcoming part of the file is
+ * fetched by several workers in parallel, this thread being one of them, and
+ * the results are moved into the ring buffer in order. */
+void NeonFile::parallel_reader ()
+{
+    pthread_t threads[8];
+    int started = 0;
+
+    AUDDBG ("<%p> Starting parallel download with %d connections\n", this, m_connections);
+
+    /* the rest of the initial response is fetched in ranges instead */
+    ne_close_connection (m_session);
+
+    pthread_mutex_lock (& m_reader_status.mutex);
+    m_chunk_size = aud::clamp (m_chunk_size, NEON_CHUNK_MIN, NEON_CHUNK_MAX);
+    pthread_mutex_unlock (& m_reader_status.mutex);
+
+    for (; started < m_connections - 1; started ++)
+    {
+        if (pthread_create (& threads[started], nullptr, prefetch_thread, this))
+            break;
+    }
+
+    prefetch_worker ();
+
+    for (int i = 0; i < started; i ++)
+        pthread_join (threads[i], nullptr);
+
+    pthread_mutex_lock (& m_reader_status.mutex);
+
+    /* the remaining chunks are buffered as playback makes room for them */
+    while (m_reader_status.reading && m_reader_status.status == NEON_READER_RUN &&
+     m_chunks.len ())
+    {
+        commit_chunks ();
+        if (m_chunks.len ())
+            pthread_cond_wait (& m_reader_status.cond, & m_reader_status.mutex);
+    }
+
+    if (! m_reader_status.reading)
+        m_reader_status.status = NEON_READER_TERM;
+    else if (m_reader_status.status == NEON_READER_RUN)
+        m_reader_status.status = NEON_READER_EOF;
+
+    m_chunks.clear ();
+    pthread_cond_broadcast (& m_reader_status.cond);
+    pthread_mutex_unlock (& m_reader_status.mutex);
+
+    AUDDBG ("<%p> Parallel download finished\n", this);
+}
+
 VFSImpl * NeonTransport::fopen (const char * path, const char * mode, String & error)
 {
     NeonFile * file = new NeonFile (path);
@@ -909,9 +1333,19 @@ VFSImpl * NeonTransport::fopen (const char * path, const char * mode, String & e
         return nullptr;
     }
 
+    file->open_cache ();
+
     return file;
 }
 
+/* Only whole, seekable files with a validator can be cached, since anything
+ * else could differ the next time it is requested. */
+void NeonFile::open_cache ()
+{
+    if (m_can_ranges && m_content_start == 0 && m_content_length > 0 && ! m_icy_metaint)
+        m_cache.open (m_url, m_validator, m_content_length);
+}
+
 int64_t NeonFile::try_fread (void * ptr, int64_t size, int64_t nmemb, bool & data_read)
 {
     if (! m_request)
@@ -1093,7 +1527,7 @@ int64_t NeonFile::try_fread (void * ptr, int64_t size, int64_t nmemb, bool & dat
     }
 
     nmemb = aud::min (belem, nmemb);
-    m_rb.move_out ((char *) ptr, nmemb * size);
+    consume_buffer ((char *) ptr, nmemb * size);
 
     /* Signal the network thread to continue reading */
     if (m_reader_status.status == NEON_READER_EOF)
@@ -1120,6 +1554,87 @@ int64_t NeonFile::try_fread (void * ptr, int64_t size, int64_t nmemb, bool & dat
     return nmemb;
 }
 
+/* Moves data out of the ring buffer, remembering the tail of it in the
+ * back-buffer.  Must be called with the reader mutex held. */
+void NeonFile::consume_buffer (char * ptr, int len)
+{
+    m_rb.move_out (ptr, len);
+
+    if (! m_back.size ())
+        return;
+
+    if (len >= m_back.size ())
+    {
+        m_back.discard ();
+        m_back.copy_in (ptr + len - m_back.size (), m_back.size ());
+    }
+    else
+    {
+        if (len > m_back.space ())
+            m_back.discard (len - m_back.space ());
+
+        m_back.copy_in (ptr, len);
+    }
+}
+
+/* Satisfies a seek from data we already have, if possible:  forward within
+ * the ring buffer, or backward within the back-buffer.  Returns false if a new
+ * request is needed. */
+bool NeonFile::seek_in_buffer (int64_t newpos)
+{
+    /* with ICY metadata, stream positions do not map onto buffered bytes */
+    if (m_icy_metaint || m_icy_len)
+        return false;
+
+    bool done = false;
+
+    pthread_mutex_lock (& m_reader_status.mutex);
+
+    if (newpos > m_pos && newpos - m_pos <= m_rb.len ())
+    {
+        int skip = newpos - m_pos;
+        char scrap[NEON_NETBLKSIZE];
+
+        while (skip > 0)
+        {
+            int part = aud::min (skip, (int) sizeof scrap);
+            consume_buffer (scrap, part);
+            skip -= part;
+        }
+
+        /* Signal the network thread to continue reading */
+        pthread_cond_broadcast (& m_reader_status.cond);
+        done = true;
+    }
+    else if (newpos < m_pos && m_pos - newpos <= m_back.len () &&
+     m_pos - newpos <= m_rb.space () - neon_netblksize)
+    {
+        /* Put the data back in front of the ring buffer.  Space for one more
+         * network block is kept, since the reader thread may be about to
+         * add one. */
+        int back = m_pos - newpos;
+        Index<char> data;
+
+        m_back.move_out (data, -1, m_back.len ());
+        m_back.copy_in (data.begin (), data.len () - back);
+        m_rb.move_out (data, -1, m_rb.len ());
+        m_rb.copy_in (data.begin () + m_back.len (), data.len () - m_back.len ());
+        done = true;
+    }
+
+    pthread_mutex_unlock (& m_reader_status.mutex);
+
+    if (done)
+    {
+        AUDDBG ("<%p> Seek to %" PRId64 " served from buffer\n", this, newpos);
+        m_pos = newpos;
+        m_eof = false;
+        m_buffered_seeks ++;
+    }
+
+    return done;
+}
+
 /* try_fread will do only a partial read if the buffer underruns, so we
  * must call it repeatedly until we have read the full request. */
 int64_t NeonFile::fread (void * buffer, int64_t size, int64_t count)
@@ -1130,11 +1645,61 @@ int64_t NeonFile::fread (void * buffer, int64_t size, int64_t count)
 
     while (count > 0)
     {
+        if (m_cache.is_open ())
+        {
+            int64_t avail = aud::min (m_cache.available (m_pos), size * count) / size;
+
+            if (avail > 0)
+            {
+                if (! m_detached)
+                {
+                    m_detached = true;
+                    m_net_pos = m_pos;
+                }
+
+                int64_t part = m_cache.read (m_pos, buffer, size * avail) / size;
+
+                if (part > 0)
+                {
+                    m_pos += size * part;
+                    buffer = (char *) buffer + size * part;
+                    total += part;
+                    count -= part;
+                    continue;
+                }
+            }
+
+            if (m_pos >= fsize ())
+            {
+                m_eof = true;
+                break;
+            }
+        }
+
+        /* the cache has a gap here; bring the network stream back to m_pos */
+        if (m_detached)
+        {
+            int64_t target = m_pos;
+            m_pos = m_net_pos;
+            m_detached = false;
+
+            if (seek_network (target) != 0)
+            {
+                m_pos = target;
+                m_eof = true;
+                break;
+            }
+        }
+
+        int64_t pos = m_pos;
         bool data_read = false;
         int64_t part = try_fread (buffer, size, count, data_read);
         if (! data_read)
             break;
 
+        if (m_cache.is_open ())
+            m_cache.write (pos, buffer, size * part);
+
         buffer = (char *) buffer + size * part;
         total += part;
         count -= part;
@@ -1207,8 +1772,15 @@ int NeonFile::fseek (int64_t offset, VFSSeekType whence)
     case VFS_SEEK_END:
         if (offset == 0)
         {
+            if (m_cache.is_open () && ! m_detached)
+            {
+                m_detached = true;
+                m_net_pos = m_pos;
+            }
+
             m_pos = content_length;
             m_eof = true;
+            m_back.discard ();  /* no longer precedes m_pos */
             return 0;
         }
 
@@ -1238,32 +1810,65 @@ int NeonFile::fseek (int64_t offset, VFSSeekType whence)
     if (newpos == m_pos)
         return 0;
 
+    /* With the cache, the network stream is only repositioned when a read
+     * needs data that is not in the cache. */
+    if (m_cache.is_open ())
+    {
+        if (! m_detached)
+        {
+            m_detached = true;
+            m_net_pos = m_pos;
+        }
+
+        m_pos = newpos;
+        m_eof = false;
+        return 0;
+    }
+
+    return seek_network (newpos);
+}
+
+int NeonFile::seek_network (int64_t newpos)
+{
+    if (newpos == m_pos)
+        return 0;
+
+    if (seek_in_buffer (newpos))
+        return 0;
+
     /* To seek to the new position we have to
      * - stop the current reader thread, if there is one
-     * - destroy the current request
      * - dump all data currently in the ringbuffer
-     * - create a new request starting at newpos */
+     * - create a new request starting at newpos, on the current session
+     *   if possible, otherwise on a new one */
     if (m_reader_status.reading)
         kill_reader ();
 
-    if (m_request)
-    {
-        ne_request_destroy (m_request);
-        m_request = nullptr;
-    }
-
-    if (m_session)
-    {
-        ne_session_destroy (m_session);
-        m_session = nullptr;
-    }
-
     m_rb.discard ();
+    m_back.discard ();
     m_prebuffering = true;
     m_icy_buf.clear ();
     m_icy_len = 0;
 
-    if (open_handle (newpos) != 0)
+    bool reopened = (m_session && m_request && reopen_request (newpos) == 0);
+    m_reader_status.status = NEON_READER_INIT;
+
+    if (! reopened)
+    {
+        if (m_request)
+        {
+            ne_request_destroy (m_request);
+            m_request = nullptr;
+        }
+
+        if (m_session)
+        {
+            ne_session_destroy (m_session);
+            m_session = nullptr;
+        }
+    }
+
+    if (! reopened && open_handle (newpos) != 0)
     {
         AUDERR ("<%p> Error while creating new request!\n", this);
         return -1;
@@ -1298,6 +1903,14 @@ String NeonFile::get_metadata (const char * field)
     if (! strcmp (field, "stream-genre"))
         return m_icy_metadata.stream_genre;
 
+    /* bytes per second, measured while data was being transferred */
+    if (! strcmp (field, "download-rate"))
+        return String (int_to_str (download_rate ()));
+
+    /* milliseconds from starting the request to filling the prebuffer */
+    if (! strcmp (field, "prebuffer-time"))
+        return m_prebuffer_us ? String (int_to_str (m_prebuffer_us / 1000)) : String ();
+
     return String ();
 }
 
@@ -1331,6 +1944,14 @@ const PreferencesWidget NeonTransport::widgets[] = {
         {1, 30, 1}),
     WidgetEntry (N_("User Agent:"),
         WidgetString ("neon", "user_agent")),
+    WidgetSpin (N_("Parallel connections for large files:"),
+        WidgetInt ("neon", "parallel_connections"),
+        {1, 8, 1}),
+    WidgetCheck (N_("Cache seekable files on disk"),
+        WidgetBool ("neon", "disk_cache")),
+    WidgetSpin (N_("Disk cache size (MiB):"),
+        WidgetInt ("neon", "disk_cache_mb"),
+        {16, 16384, 16}, WIDGET_CHILD),
 };
 
 const PluginPreferences NeonTransport::prefs = {{widgets}};
\ No newline at end of file
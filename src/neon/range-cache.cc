@@ -0,0 +1,376 @@
+/*
+ *  Disk-backed range cache for the neon HTTP transport
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/runtime.h>
+
+#include "range-cache.h"
+
+#define NEON_CACHE_DEFAULT_MB 256
+
+/* serializes index updates and eviction between open files */
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct CacheEntryInfo {
+    String key;
+    int64_t size;
+    int64_t mtime;
+};
+
+static StringBuf cache_dir ()
+{
+    StringBuf dir = filename_build ({aud_get_path (AudPath::UserDir), "neon-cache"});
+
+    if (g_mkdir_with_parents (dir, 0700) < 0)
+    {
+        AUDWARN ("Cannot create cache directory %s\n", (const char *) dir);
+        return StringBuf ();
+    }
+
+    return dir;
+}
+
+static int64_t cache_limit ()
+{
+    int mb = aud_get_int ("neon", "disk_cache_mb");
+    return (int64_t) (mb > 0 ? mb : NEON_CACHE_DEFAULT_MB) << 20;
+}
+
+/* space actually taken up on disk; data files are sparse */
+static int64_t disk_usage (const GStatBuf & statbuf)
+{
+#ifdef _WIN32
+    return statbuf.st_size;
+#else
+    return (int64_t) statbuf.st_blocks * 512;
+#endif
+}
+
+/* removes the least recently used entries (other than keep) until the
+ * cache is within its size limit; must be called with cache_mutex held */
+static void trim_cache (const char * dir, const char * keep)
+{
+    GDir * handle = g_dir_open (dir, 0, nullptr);
+    if (! handle)
+        return;
+
+    Index<CacheEntryInfo> entries;
+    int64_t total = 0;
+    const char * name;
+
+    while ((name = g_dir_read_name (handle)))
+    {
+        if (! str_has_suffix_nocase (name, ".data"))
+            continue;
+
+        StringBuf path = filename_build ({dir, name});
+        GStatBuf statbuf;
+
+        if (g_stat (path, & statbuf) < 0)
+            continue;
+
+        auto & entry = entries.append ();
+        entry.key = String (str_copy (name, strlen (name) - 5));
+        entry.size = disk_usage (statbuf);
+        entry.mtime = statbuf.st_mtime;
+
+        /* the index is rewritten whenever the entry is closed */
+        StringBuf index_path = filename_build ({dir, str_concat ({entry.key, ".idx"})});
+        if (g_stat (index_path, & statbuf) == 0)
+            entry.mtime = aud::max (entry.mtime, (int64_t) statbuf.st_mtime);
+
+        total += entry.size;
+    }
+
+    g_dir_close (handle);
+
+    int64_t limit = cache_limit ();
+    if (total <= limit)
+        return;
+
+    std::sort (entries.begin (), entries.end (),
+     [] (const CacheEntryInfo & a, const CacheEntryInfo & b)
+        { return a.mtime < b.mtime; });
+
+    for (auto & entry : entries)
+    {
+        if (total <= limit)
+            break;
+        if (keep && ! strcmp (entry.key, keep))
+            continue;
+
+        AUDDBG ("Evicting cache entry %s (%" PRId64 " bytes)\n",
+         (const char *) entry.key, entry.size);
+
+        g_unlink (filename_build ({dir, str_concat ({entry.key, ".data"})}));
+        g_unlink (filename_build ({dir, str_concat ({entry.key, ".idx"})}));
+        total -= entry.size;
+    }
+}
+
+void RangeCache::add_range (Index<Range> & ranges, int64_t start, int64_t end)
+{
+    Index<Range> merged;
+    bool placed = false;
+
+    for (const Range & range : ranges)
+    {
+        if (range.end < start)
+            merged.append (range);
+        else if (range.start > end)
+        {
+            if (! placed)
+            {
+                merged.append (Range {start, end});
+                placed = true;
+            }
+            merged.append (range);
+        }
+        else
+        {
+            start = aud::min (start, range.start);
+            end = aud::max (end, range.end);
+        }
+    }
+
+    if (! placed)
+        merged.append (Range {start, end});
+
+    ranges = std::move (merged);
+}
+
+/* index format: URL, total length, then one "start end" line per range */
+bool RangeCache::load_index (const char * path, const char * url, int64_t length,
+ Index<Range> & ranges)
+{
+    char * text = nullptr;
+    if (! g_file_get_contents (path, & text, nullptr, nullptr))
+        return false;
+
+    char * * lines = g_strsplit (text, "\n", -1);
+    g_free (text);
+
+    bool valid = (lines[0] && ! strcmp (lines[0], url) && lines[1] &&
+     strtoll (lines[1], nullptr, 10) == length);
+
+    if (valid)
+    {
+        for (int i = 2; lines[i]; i ++)
+        {
+            char * end;
+            int64_t a = strtoll (lines[i], & end, 10);
+            int64_t b = strtoll (end, nullptr, 10);
+
+            if (a >= 0 && b > a && b <= length)
+                add_range (ranges, a, b);
+        }
+    }
+
+    g_strfreev (lines);
+    return valid;
+}
+
+/* another file may have cached other ranges of the same entry meanwhile,
+ * so the index on disk is merged rather than overwritten */
+void RangeCache::save_index ()
+{
+    StringBuf dir = cache_dir ();
+    if (! dir)
+        return;
+
+    StringBuf data_path = filename_build ({dir, str_concat ({m_key, ".data"})});
+    StringBuf index_path = filename_build ({dir, str_concat ({m_key, ".idx"})});
+
+    pthread_mutex_lock (& cache_mutex);
+
+    /* evicted while we had it open */
+    if (! g_file_test (data_path, G_FILE_TEST_EXISTS))
+    {
+        pthread_mutex_unlock (& cache_mutex);
+        return;
+    }
+
+    Index<Range> on_disk;
+    if (load_index (index_path, m_url, m_length, on_disk))
+    {
+        for (const Range & range : on_disk)
+            add_range (m_ranges, range.start, range.end);
+    }
+
+    StringBuf text = str_printf ("%s\n%" PRId64 "\n", (const char *) m_url, m_length);
+    for (const Range & range : m_ranges)
+        str_append_printf (text, "%" PRId64 " %" PRId64 "\n", range.start, range.end);
+
+    if (! g_file_set_contents (index_path, text, text.len (), nullptr))
+        AUDWARN ("Cannot write cache index %s\n", (const char *) index_path);
+
+    trim_cache (dir, m_key);
+
+    pthread_mutex_unlock (& cache_mutex);
+}
+
+bool RangeCache::open (const char * url, const char * validator, int64_t length)
+{
+    close ();
+
+    if (! aud_get_bool ("neon", "disk_cache") || ! validator || ! validator[0] || length <= 0)
+        return false;
+
+    StringBuf dir = cache_dir ();
+    if (! dir)
+        return false;
+
+    char * sum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+     str_concat ({url, "\n", validator}), -1);
+    m_key = String (sum);
+    g_free (sum);
+
+    StringBuf data_path = filename_build ({dir, str_concat ({m_key, ".data"})});
+    StringBuf index_path = filename_build ({dir, str_concat ({m_key, ".idx"})});
+
+    pthread_mutex_lock (& cache_mutex);
+
+    trim_cache (dir, m_key);
+
+    bool exists = g_file_test (data_path, G_FILE_TEST_EXISTS);
+    if (exists && ! load_index (index_path, url, length, m_ranges))
+        m_ranges.clear ();
+
+    m_data = VFSFile (filename_to_uri (data_path), exists ? "r+" : "w+");
+
+    pthread_mutex_unlock (& cache_mutex);
+
+    if (! m_data)
+    {
+        AUDWARN ("Cannot open cache file %s\n", (const char *) data_path);
+        m_key = String ();
+        m_ranges.clear ();
+        return false;
+    }
+
+    m_url = String (url);
+    m_length = length;
+    m_bytes_read = m_bytes_written = 0;
+
+    AUDDBG ("Cache entry %s for %s: %d range(s) present\n",
+     (const char *) m_key, url, m_ranges.len ());
+
+    return true;
+}
+
+void RangeCache::close ()
+{
+    if (! m_data)
+        return;
+
+    m_data = VFSFile ();
+
+    /* rewrite the index even if nothing was added, to mark it as recently used */
+    save_index ();
+
+    AUDDBG ("Cache entry %s closed: %" PRId64 " bytes read from disk, %" PRId64
+     " bytes stored\n", (const char *) m_key, m_bytes_read, m_bytes_written);
+
+    m_key = String ();
+    m_url = String ();
+    m_length = -1;
+    m_ranges.clear ();
+}
+
+/* closes the entry and removes it from the cache, after an I/O error */
+void RangeCache::drop ()
+{
+    StringBuf dir = cache_dir ();
+
+    m_data = VFSFile ();
+
+    if (dir)
+    {
+        pthread_mutex_lock (& cache_mutex);
+        g_unlink (filename_build ({dir, str_concat ({m_key, ".data"})}));
+        g_unlink (filename_build ({dir, str_concat ({m_key, ".idx"})}));
+        pthread_mutex_unlock (& cache_mutex);
+    }
+
+    m_key = String ();
+    m_url = String ();
+    m_length = -1;
+    m_ranges.clear ();
+}
+
+int64_t RangeCache::available (int64_t pos) const
+{
+    for (const Range & range : m_ranges)
+    {
+        if (range.start > pos)
+            break;
+        if (range.end > pos)
+            return range.end - pos;
+    }
+
+    return 0;
+}
+
+int64_t RangeCache::read (int64_t pos, void * ptr, int64_t len)
+{
+    if (! m_data || m_data.fseek (pos, VFS_SEEK_SET) < 0)
+        return 0;
+
+    int64_t got = m_data.fread (ptr, 1, len);
+
+    if (got < len)
+    {
+        /* the file was truncated or removed behind our back */
+        AUDWARN ("Short read from cache entry %s; removing it\n", (const char *) m_key);
+        drop ();
+    }
+
+    m_bytes_read += got;
+    return got;
+}
+
+void RangeCache::write (int64_t pos, const void * ptr, int64_t len)
+{
+    if (! m_data || len <= 0 || pos + len > m_length)
+        return;
+
+    /* data delivered again after a backward seek is already here */
+    if (available (pos) >= len)
+        return;
+
+    if (m_data.fseek (pos, VFS_SEEK_SET) < 0 || m_data.fwrite (ptr, 1, len) != len)
+    {
+        AUDWARN ("Cannot write to cache entry %s; removing it\n", (const char *) m_key);
+        drop ();
+        return;
+    }
+
+    add_range (m_ranges, pos, pos + len);
+    m_bytes_written += len;
+}
@@ -0,0 +1,70 @@
+/*
+ *  Disk-backed range cache for the neon HTTP transport
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef NEON_RANGE_CACHE_H
+#define NEON_RANGE_CACHE_H
+
+#include <stdint.h>
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/objects.h>
+#include <libfauxdcore/vfs.h>
+
+/* A sparse copy of a remote file on disk.  Each entry is a data file, written
+ * at the offsets the data came from, and an index listing the byte ranges
+ * present.  Entries are keyed by URL and validator (ETag or Last-Modified), so
+ * a changed file simply gets a new entry; the least recently used entries are
+ * removed when the cache grows beyond its size limit. */
+class RangeCache
+{
+public:
+    ~RangeCache () { close (); }
+
+    /* returns false if caching is disabled or the entry cannot be opened */
+    bool open (const char * url, const char * validator, int64_t length);
+    void close ();
+
+    bool is_open () const { return (bool) m_data; }
+
+    /* number of bytes that can be read from the cache at pos without a gap */
+    int64_t available (int64_t pos) const;
+
+    int64_t read (int64_t pos, void * ptr, int64_t len);
+    void write (int64_t pos, const void * ptr, int64_t len);
+
+private:
+    struct Range {
+        int64_t start, end;
+    };
+
+    String m_key;
+    String m_url;
+    int64_t m_length = -1;
+    VFSFile m_data;
+    Index<Range> m_ranges;  /* sorted and non-overlapping */
+
+    int64_t m_bytes_read = 0, m_bytes_written = 0;
+
+    static void add_range (Index<Range> & ranges, int64_t start, int64_t end);
+    static bool load_index (const char * path, const char * url, int64_t length,
+     Index<Range> & ranges);
+    void save_index ();
+    void drop ();
+};
+
+#endif
@@ -0,0 +1,286 @@
+/*
+ * Null (Benchmark) Output Plugin for Fauxdacious
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* This output never paces to a device:  period_wait () never blocks and all
+ * audio is discarded as soon as it is written, so the player runs the input
+ * plugin and the effect chain as fast as the CPU allows.  For each track we
+ * report the wall-clock time spent producing the audio and the resulting
+ * realtime factor (seconds of audio per second of wall time), the CPU time
+ * it took per hour of audio, and optionally a checksum of the raw output for
+ * use in decoder regression tests.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+
+#include <libfauxdcore/audio.h>
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/i18n.h>
+#include <libfauxdcore/plugin.h>
+#include <libfauxdcore/preferences.h>
+#include <libfauxdcore/runtime.h>
+
+class NullOutput : public OutputPlugin
+{
+public:
+    static const char about[];
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {
+        N_("Null (Benchmark) Output"),
+        PACKAGE,
+        about,
+        & prefs
+    };
+
+    constexpr NullOutput () : OutputPlugin (info, 0) {}
+
+    bool init ();
+    void cleanup ();
+
+    StereoVolume get_volume () { return {100, 100}; }
+    void set_volume (StereoVolume v) {}
+
+    void set_info (const char * filename, const Tuple & tuple);
+    bool open_audio (int fmt, int rate, int nch, String & error);
+    void close_audio ();
+
+    void period_wait () {}
+    int write_audio (const void * ptr, int length);
+    void drain () {}
+
+    int get_delay ()
+        { return 0; }
+
+    void pause (bool pause);
+    void flush ();
+};
+
+EXPORT NullOutput aud_plugin_instance;
+
+const char NullOutput::about[] =
+ N_("Null (Benchmark) Output Plugin for Fauxdacious\n\n"
+    "Discards all audio without pacing to a device, reporting the time taken "
+    "to decode (and run the effect chain on) each track, the resulting "
+    "realtime factor and the CPU time per hour of audio.  Optionally computes a checksum of the output data "
+    "for regression testing.");
+
+const char * const NullOutput::defaults[] = {
+ "checksum", "FALSE",
+ "report", "TRUE",
+ nullptr};
+
+/* per-track statistics; plugin calls are serialized by the core output lock */
+struct TrackStats {
+    String filename;
+    int64_t bytes;          /* total bytes written */
+    int64_t busy_us;        /* wall time spent unpaused since the first write */
+    int64_t started_at;     /* monotonic time of the first (or resumed) write, 0 if idle */
+    int64_t cpu_us;         /* CPU time of the writing thread between writes */
+    int64_t cpu_last;       /* thread CPU time at the last write, -1 if none */
+    int writes;
+    uint64_t checksum;
+};
+
+static int out_fmt, out_rate, out_channels;
+static bool paused;
+static bool want_checksum;
+static String pending_filename;
+static TrackStats stats;
+
+/* 64-bit FNV-1a; fast, dependency-free, and stable across platforms */
+static constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static uint64_t checksum_update (uint64_t hash, const void * data, int length)
+{
+    auto p = (const unsigned char *) data;
+    auto end = p + length;
+
+    while (p < end)
+    {
+        hash ^= * p ++;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/* CPU time used by the calling thread, or -1 if it cannot be measured; audio
+ * is written from the decoder's thread, so between two writes this is the
+ * time taken to decode (and run the effects on) a block */
+static int64_t thread_cpu_us ()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (! clock_gettime (CLOCK_THREAD_CPUTIME_ID, & ts))
+        return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+    return -1;
+}
+
+static void stats_reset (const String & filename)
+{
+    stats.filename = filename;
+    stats.bytes = 0;
+    stats.busy_us = 0;
+    stats.started_at = 0;
+    stats.cpu_us = 0;
+    stats.cpu_last = -1;
+    stats.writes = 0;
+    stats.checksum = FNV_OFFSET;
+}
+
+static void stats_stop_clock ()
+{
+    if (stats.started_at)
+    {
+        stats.busy_us += g_get_monotonic_time () - stats.started_at;
+        stats.started_at = 0;
+    }
+}
+
+static void stats_report ()
+{
+    stats_stop_clock ();
+
+    if (! stats.bytes || ! out_rate || ! out_channels)
+        return;
+
+    int frame_size = FMT_SIZEOF (out_fmt) * out_channels;
+    double audio_secs = (double) (stats.bytes / frame_size) / out_rate;
+    double wall_secs = (double) stats.busy_us / G_USEC_PER_SEC;
+    double factor = (wall_secs > 0) ? audio_secs / wall_secs : 0;
+
+    StringBuf summary = str_printf ("%.3f s audio in %.3f s (%.1fx realtime), "
+     "%d writes, avg %d bytes/write", audio_secs, wall_secs, factor, stats.writes,
+     (int) (stats.bytes / aud::max (stats.writes, 1)));
+
+    if (stats.cpu_us > 0 && audio_secs > 0)
+        str_append_printf (summary, ", %.1f s CPU per hour of audio",
+         (double) stats.cpu_us / G_USEC_PER_SEC / audio_secs * 3600);
+
+    if (want_checksum)
+        str_append_printf (summary, ", checksum %016llx",
+         (unsigned long long) stats.checksum);
+
+    /* keep the latest result where a script can get at it */
+    aud_set_str ("nullout", "_last_report", summary);
+
+    if (aud_get_bool ("nullout", "report"))
+        AUDINFO ("%s: %s\n", stats.filename ? (const char *) stats.filename :
+         "(unknown)", (const char *) summary);
+}
+
+bool NullOutput::init ()
+{
+    aud_config_set_defaults ("nullout", defaults);
+    return true;
+}
+
+void NullOutput::cleanup ()
+{
+    pending_filename = String ();
+    stats.filename = String ();
+}
+
+/* called at the start of each song, even when the output stays open across
+ * songs of the same format, so this is where per-track stats are split */
+void NullOutput::set_info (const char * filename, const Tuple & tuple)
+{
+    pending_filename = String (filename);
+
+    if (stats.writes)
+    {
+        stats_report ();
+        stats_reset (pending_filename);
+    }
+}
+
+bool NullOutput::open_audio (int fmt, int rate, int nch, String & error)
+{
+    AUDDBG ("Opening null output for %d channels, %d Hz, format %d.\n", nch, rate, fmt);
+
+    out_fmt = fmt;
+    out_rate = rate;
+    out_channels = nch;
+    paused = false;
+    want_checksum = aud_get_bool ("nullout", "checksum");
+
+    stats_reset (pending_filename);
+    return true;
+}
+
+void NullOutput::close_audio ()
+{
+    stats_report ();
+    stats_reset (String ());
+}
+
+int NullOutput::write_audio (const void * ptr, int length)
+{
+    if (! stats.started_at && ! paused)
+        stats.started_at = g_get_monotonic_time ();
+
+    int64_t cpu = thread_cpu_us ();
+    if (cpu >= 0 && stats.cpu_last >= 0)
+        stats.cpu_us += cpu - stats.cpu_last;
+    stats.cpu_last = cpu;
+
+    if (want_checksum)
+        stats.checksum = checksum_update (stats.checksum, ptr, length);
+
+    stats.bytes += length;
+    stats.writes ++;
+
+    return length;
+}
+
+void NullOutput::pause (bool pause)
+{
+    if (pause)
+        stats_stop_clock ();
+
+    paused = pause;
+}
+
+/* a seek invalidates both the running checksum and the realtime factor, so
+ * report what we have so far and start a new measurement */
+void NullOutput::flush ()
+{
+    if (stats.writes)
+    {
+        AUDDBG ("Seek requested; splitting statistics.\n");
+        stats_report ();
+        stats_reset (stats.filename);
+    }
+}
+
+const PreferencesWidget NullOutput::widgets[] = {
+    WidgetCheck (N_("Report decode time, realtime factor and CPU use per track"),
+        WidgetBool ("nullout", "report")),
+    WidgetCheck (N_("Compute checksum of output data"),
+        WidgetBool ("nullout", "checksum"))
+};
+
+const PluginPreferences NullOutput::prefs = {{widgets}};
@@ -42,6 +42,9 @@
 #include <libfauxdgui/list.h>
 
 #include <string.h>
+#include <time.h>
+
+#include "../ui-common/history-store.h"
 
 static const char * printable (const String & str)
 {
@@ -58,13 +61,17 @@ private:
            "GTK version Copyright (c) 2025 Jim Turner <turnerjw784@yahoo.com>\n\n"
            "This plugin tracks and provides access to playback history.\n\n"
 
-           "History entries are stored only in memory and are lost\n"
-           "on Fauxdacious exit. When the plugin is disabled,\n"
+           "History entries are saved in the config directory and kept\n"
+           "across Fauxdacious sessions. When the plugin is disabled,\n"
            "playback history is not tracked at all.\n"
-           "History entries are only added, never removed automatically.\n"
-           "The user can remove selected entries by pressing the Delete key.\n"
-           "Restart Fauxdacious or disable the plugin by closing\n"
-           "Playback History view to clear the entries.\n\n"
+           "The oldest entries are dropped once there are more of them,\n"
+           "or they are older, than set in the plugin's settings.\n"
+           "The user can remove selected entries by pressing the Delete key.\n\n"
+
+           "Besides the history itself, the view can list the songs\n"
+           "played most this week or ever, with their play counts.\n"
+           "Play counts are kept for all songs ever played, including\n"
+           "entries since removed or dropped.\n\n"
 
            "Two history item granularities (modes) are supported.\n"
            "The user can select a mode in the plugin's settings.\n"
@@ -89,6 +96,7 @@ public:
 
     constexpr PlaybackHistory () : GeneralPlugin (info, false) {}
 
+    bool init ();
     void * get_gtk_widget ();
 };
 
@@ -96,11 +104,24 @@ EXPORT PlaybackHistory aud_plugin_instance;
 
 static constexpr const char * configSection = "playback-history";
 static constexpr const char * configEntryType = "entry_type";
+static constexpr const char * configMaxEntries = "max_entries";
+static constexpr const char * configMaxDays = "max_days";
+static constexpr const char * configView = "view";
 static bool fromTitleChg = false;
-static bool forceTitleFetch = false;
 static int m_playingPosition = -1;
 static int prevPlayingPosition = -1;
 
+/* WHAT THE LIST SHOWS: */
+enum
+{
+    ViewHistory,
+    ViewWeek,      // MOST PLAYED IN THE LAST 7 DAYS
+    ViewEver,      // MOST PLAYED EVER
+    ViewCount
+};
+
+static constexpr int topListSize = 100;
+
 class HistoryEntry
 {
 public:
@@ -110,13 +131,22 @@ public:
         Album = Tuple::Field::Album
     };
     static constexpr Type defaultType = Type::Song;
-    String havetext;
 
     /**
      * Creates an invalid entry that can only be assigned to or destroyed.
      */
     HistoryEntry () = default;
 
+    /**
+     * Creates an entry from one saved in the history store.
+     */
+    explicit HistoryEntry (const HistoryRecord & record);
+
+    /**
+     * Returns @c this as a record for the history store.
+     */
+    HistoryRecord record () const;
+
     /**
      * Stores the currently playing entry in @c this->
      *
@@ -199,11 +229,62 @@ private:
      */
     int m_playlistPosition = -1;
     Type m_type = defaultType;
+    String m_filename;
 };
 
-Index<HistoryEntry> m_entries;
+static HistoryStore m_store;
+static Index<HistoryCount> m_top;  // FOR THE "MOST PLAYED" VIEWS
+static int m_view = ViewHistory;
 GtkWidget * treeview = nullptr;
 
+HistoryEntry::HistoryEntry (const HistoryRecord & record) :
+    m_text (record.text),
+    m_playlist (aud_playlist_by_unique_id (record.playlist_id)),
+    m_playlistPosition (record.position),
+    m_type ((record.type == static_cast<int>(Type::Album)) ? Type::Album : Type::Song),
+    m_filename (record.filename) {}
+
+HistoryRecord HistoryEntry::record () const
+{
+    HistoryRecord record;
+    record.time = time (nullptr);
+    record.type = static_cast<int>(m_type);
+    record.playlist_id = aud_playlist_get_unique_id (m_playlist);
+    record.position = m_playlistPosition;
+    record.filename = m_filename;
+    record.text = m_text;
+    return record;
+}
+
+/* THE NEWEST ENTRY IS AT THE TOP OF THE LIST: */
+static int positionFromRow (int row)
+{
+    return m_store.count () - (row + 1);
+}
+
+static bool getEntry (int position, HistoryEntry & entry)
+{
+    HistoryRecord record;
+    if (! m_store.get (position, record))
+        return false;
+
+    entry = HistoryEntry (record);
+    return true;
+}
+
+/* THE ENTRY AT A ROW OF WHICHEVER VIEW IS SHOWN: */
+static bool getRowEntry (int row, HistoryEntry & entry)
+{
+    if (m_view == ViewHistory)
+        return getEntry (positionFromRow (row), entry);
+
+    if (row < 0 || row >= m_top.len ())
+        return false;
+
+    entry = HistoryEntry (m_top[row].last);
+    return true;
+}
+
 /* ADDS NEW SONG ENTRIES INTO THE HISTORY-LIST: */
 bool HistoryEntry::assignPlayingEntry ()
 {
@@ -224,6 +305,7 @@ bool HistoryEntry::assignPlayingEntry ()
     }
     assert (m_playlistPosition >= 0);
     assert (m_playlistPosition < aud_playlist_entry_count (m_playlist));
+    m_filename = aud_playlist_entry_get_filename (m_playlist, m_playlistPosition);
 
     const auto entryType = aud_get_int (configSection, configEntryType);
     if (entryType == static_cast<int>(Type::Song) ||
@@ -296,32 +378,23 @@ const char * HistoryEntry::untranslatedTextDesignation ()
 
 bool HistoryEntry::retrieveText (String & text)
 {
-    if (! forceTitleFetch && havetext && havetext[0])
-        text = havetext;
-    else
-    {
-        String errorMessage;
-        const auto tuple = aud_playlist_entry_get_tuple (m_playlist,
-                m_playlistPosition, Playlist::Wait, & errorMessage);
+    String errorMessage;
+    const auto tuple = aud_playlist_entry_get_tuple (m_playlist,
+            m_playlistPosition, Playlist::Wait, & errorMessage);
 
-        if (errorMessage || tuple.state () != Tuple::Valid)
-        {
-            AUDWARN ("Failed to retrieve metadata of entry #%d in playlist %s: %s\n",
-                    entryNumber (), printable(playlistTitle ()),
-                    errorMessage ? printable (errorMessage)
-                                 : "Song info could not be read");
-            return false;
-        }
+    if (errorMessage || tuple.state () != Tuple::Valid)
+    {
+        AUDWARN ("Failed to retrieve metadata of entry #%d in playlist %s: %s\n",
+                entryNumber (), printable(playlistTitle ()),
+                errorMessage ? printable (errorMessage)
+                             : "Song info could not be read");
+        return false;
+    }
 
-        text = tuple.get_str (static_cast<Tuple::Field>(m_type));
-        if (! text || ! text[0])
-            text = String (str_printf ("--no %s!--", untranslatedTextDesignation ()));
+    text = tuple.get_str (static_cast<Tuple::Field>(m_type));
+    if (! text || ! text[0])
+        text = String (str_printf ("--no %s!--", untranslatedTextDesignation ()));
 
-        if (! forceTitleFetch)
-            havetext = text;
-        else
-            forceTitleFetch = false;  // ALWAYS A ONE-OFF!
-    }
     return true;
 }
 
@@ -341,7 +414,6 @@ bool HistoryEntry::isAvailable ()
         return false;
     }
 
-    forceTitleFetch = true;
     String currentTextAtPlaylistPosition;
     if (! retrieveText (currentTextAtPlaylistPosition))
         return false;
@@ -397,7 +469,9 @@ bool HistoryEntry::shouldAppendEntry ()
     if (m_playingPosition < 0 || fromTitleChg)
         return true;
 
-    auto & prevPlayingEntry = m_entries[m_playingPosition];
+    HistoryEntry prevPlayingEntry;
+    if (! getEntry (m_playingPosition, prevPlayingEntry))
+        return true;
 
     if (prevPlayingEntry.type () != this->type () ||
             prevPlayingEntry.playlist () != this->playlist ())
@@ -433,6 +507,48 @@ bool HistoryEntry::shouldAppendEntry ()
     return false;
 }
 
+/* FILLS THE LIST WITH THE SELECTED VIEW: */
+static void fillList (GtkWidget * list)
+{
+    audgui_list_delete_rows (list, 0, audgui_list_row_count (list));
+    audgui_list_set_highlight (list, -1);
+
+    switch (m_view)
+    {
+    case ViewHistory:
+        m_top.clear ();
+        audgui_list_insert_rows (list, 0, m_store.count ());
+        if (m_playingPosition >= 0)
+        {
+            int highlight_row = m_store.count () - (m_playingPosition + 1);
+            audgui_list_set_highlight (list, highlight_row);
+            audgui_list_set_focus (list, highlight_row);
+        }
+        break;
+    case ViewWeek:
+        m_top = m_store.most_played (time (nullptr) - 7 * 86400, topListSize);
+        audgui_list_insert_rows (list, 0, m_top.len ());
+        break;
+    case ViewEver:
+        m_top = m_store.most_played (0, topListSize);
+        audgui_list_insert_rows (list, 0, m_top.len ());
+        break;
+    }
+}
+
+/* SETS THE RETENTION LIMITS AND DROPS WHAT FALLS OUTSIDE THEM: */
+static void applyRetention ()
+{
+    m_store.set_retention (aud_get_int (configSection, configMaxEntries),
+            aud_get_int (configSection, configMaxDays));
+
+    if (m_playingPosition >= m_store.count ())
+        m_playingPosition = prevPlayingPosition = m_store.count () - 1;
+
+    if (treeview)
+        fillList (treeview);
+}
+
 /* CALLED WHEN PLAYBACK STARTS: */
 static void playbackStarted (void * data, void * list_)
 {
@@ -443,7 +559,7 @@ static void playbackStarted (void * data, void * list_)
     GtkWidget * list = (GtkWidget *) list_;
     entry.debugPrint ("Started playing ");
     AUDDBG ("playing position=%d, entry count=%d\n", m_playingPosition,
-           m_entries.len());
+           m_store.count ());
 
     if ((fromTitleChg && entry.type () == HistoryEntry::Type::Album) || ! entry.shouldAppendEntry ())
         return;
@@ -452,11 +568,28 @@ static void playbackStarted (void * data, void * list_)
 
     // The last played entry appears at the top of the view. Therefore, the new
     // entry is inserted at row 0.
-    // This code must be kept in sync with modelRowFromPosition().
+    // This code must be kept in sync with positionFromRow().
     // Update m_playingPosition during the row insertion to avoid
     // updating the font for the new playing position separately below.
-    m_playingPosition = m_entries.len ();
-    m_entries.append (std::move (entry));
+    // Entries dropped to stay within the retention limits are the oldest ones,
+    // at the bottom of the view.
+    int dropped = m_store.append (entry.record ());
+    m_playingPosition = m_store.count () - 1;
+
+    if (m_view != ViewHistory)
+    {
+        fillList (list);
+        return;
+    }
+
+    if (dropped > 0)
+    {
+        int rows = audgui_list_row_count (list);
+        dropped = aud::min (dropped, rows);
+        audgui_list_delete_rows (list, rows - dropped, dropped);
+        prevPlayingPosition = aud::max (prevPlayingPosition - dropped, -1);
+    }
+
     audgui_list_insert_rows (list, 0, 1);
     audgui_list_set_highlight (list, 0);
     audgui_list_set_focus (list, 0);
@@ -475,14 +608,22 @@ static void titleChanged (void * data, void * list_)
 
 static void get_value (void * user, int row, int column, GValue * value)
 {
-    int rowindx = m_entries.len ()-(row+1);
     switch (column)
     {
         case 0:
         {
-            String title;
-            if (m_entries[rowindx].retrieveText(title))
-                g_value_set_string (value, title);
+            if (m_view != ViewHistory)
+            {
+                if (row >= 0 && row < m_top.len ())
+                    g_value_set_string (value, str_printf ("%s (%d)",
+                            printable (m_top[row].last.text), m_top[row].count));
+                break;
+            }
+
+            // THE STORE KEEPS THE ROWS LAST READ, SO SCROLLING STAYS CHEAP:
+            HistoryRecord record;
+            if (m_store.get (positionFromRow (row), record))
+                g_value_set_string (value, record.text);
             else
                 g_value_set_string (value, "--error!--");
             break;
@@ -499,8 +640,9 @@ static bool get_selected (void * user, int row)
 /* CALLBACK WHEN USER SELECTES (HIGHLIGHTS) AN ENTRY: */
 static void set_selected (void * user, int row, bool selected)
 {
-    if (selected)
-        m_entries[m_entries.len ()-(row+1)].makeCurrent ();
+    HistoryEntry entry;
+    if (selected && getRowEntry (row, entry))
+        entry.makeCurrent ();
 }
 
 /* CALLBACK: UNUSED, BUT REQUIRED FOR set_selected() TO WORK: */
@@ -509,32 +651,38 @@ static void select_all (void * user, bool selected) {}
 /* CALLBACK WHEN USER DOUBLE-CLICKS AN ENTRY: */
 static void activate_row (void * user, int row)
 {
-    int pos = m_entries.len ()-(row+1);
-    if (! m_entries[pos].play ())
+    HistoryEntry entry;
+    if (! getRowEntry (row, entry) || ! entry.play ())
         return;
 
     // Update m_playingPosition here to prevent the imminent playbackStarted()
-    // invocation from appending a copy of the activated entry to m_entries.
+    // invocation from appending a copy of the activated entry to the history.
     // This does not prevent appending a different-type counterpart entry if the
     // type of the activated entry does not match the currently configured
     // History Item Granularity. Such a scenario is uncommon (happens only when
     // the user switches between the History modes), and so is not specially
     // handled or optimized for.
-    if (pos != m_playingPosition)
+    // An entry played from a "most played" view is a new play, and so is
+    // appended as usual.
+    int pos = positionFromRow (row);
+    if (m_view == ViewHistory && pos != m_playingPosition)
     {
         GtkWidget * list = (GtkWidget *) treeview;
         prevPlayingPosition = m_playingPosition;
         m_playingPosition = pos;
-        int highlight_row = m_entries.len ()-(m_playingPosition+1);
+        int highlight_row = m_store.count () - (m_playingPosition + 1);
         audgui_list_set_highlight (list, highlight_row);
         audgui_list_set_focus (list, highlight_row);
     }
-    aud_playlist_select_all (m_entries[pos].playlist (), false);
+    aud_playlist_select_all (entry.playlist (), false);
 }
 
 /* CALLED WHEN USER DELETES ROWS VIA PRESSING [Delete] KEY: */
 static void remove_selected (GtkWidget * treeview)
 {
+    if (m_view != ViewHistory)
+        return;  // PLAY COUNTS ARE NOT EDITABLE.
+
     GtkTreeModel * model;
     GtkTreeSelection * selection = gtk_tree_view_get_selection ((GtkTreeView *) treeview);
     GList * selected_list = gtk_tree_selection_get_selected_rows (selection, & model);
@@ -545,26 +693,26 @@ static void remove_selected (GtkWidget * treeview)
         GtkTreePath * path = (GtkTreePath *) cursor->data;
         gtk_tree_model_get_iter (model, &iter, path);
         int row = gtk_tree_path_get_indices (path)[0];
-        int pos = m_entries.len ()-(row+1);
+        int pos = positionFromRow (row);
         if (pos == m_playingPosition)
             m_playingPosition = -1;  // We removed the currently-playing item, so unset it!
         else if (m_playingPosition > pos)
             m_playingPosition--;
 
         audgui_list_delete_rows (treeview, row, 1);
-        m_entries.remove (pos, 1);
+        m_store.remove (pos);
         cursor = cursor->prev;
     }
     /* JWT:WE DIFFER NEXT LINE FROM AUDACIOUS BY RESETTING UNSET (-1) POSITION TO TOP
        ENTRY TO REDUCE POSSIBILITY OF SAME ENTRY APPEARING BACK-TO-BACK IN LIST:
     */
-    if (m_playingPosition < 0 || m_playingPosition >= m_entries.len ())
-        prevPlayingPosition = m_playingPosition = m_entries.len () - 1;
+    if (m_playingPosition < 0 || m_playingPosition >= m_store.count ())
+        prevPlayingPosition = m_playingPosition = m_store.count () - 1;
 
     g_list_free_full (selected_list, (GDestroyNotify) gtk_tree_path_free);
     if (m_playingPosition >= 0)
     {
-        int highlight_row = m_entries.len ()-(m_playingPosition+1);
+        int highlight_row = m_store.count () - (m_playingPosition + 1);
         GtkWidget * list = (GtkWidget *) treeview;
         audgui_list_set_highlight (list, highlight_row);
         audgui_list_set_focus (list, highlight_row);
@@ -591,11 +739,7 @@ static gboolean pbhist_keypress_cb (GtkWidget * treeview, GdkEventKey * event)
         case 'a':  // Ctrl-a:  SELECT ALL HISTORY-ENTRIES:
         {
             GtkTreeSelection * sel = gtk_tree_view_get_selection ((GtkTreeView *) treeview);
-            for (int i = 0; i < m_entries.len(); i ++)
-            {
-                GtkTreeIter iter = {0, GINT_TO_POINTER (i)};
-                gtk_tree_selection_select_iter (sel, & iter);
-            }
+            gtk_tree_selection_select_all (sel);
             return true;
         }
         // NOTE: Shift-Ctrl-A (DESELECT ALL ENTRIES) ALREADY HANDLED, SO NOT INCLUDED HERE!:
@@ -612,11 +756,15 @@ static gboolean pbhist_keypress_cb (GtkWidget * treeview, GdkEventKey * event)
                 GtkTreePath * path = (GtkTreePath *) cursor->data;
                 gtk_tree_model_get_iter (model, &iter, path);
                 int row = gtk_tree_path_get_indices (path)[0];
-                pastem.insert (-1, (const char *) m_entries[row].text ());
-                pastem.insert (-1, "\n");
+                HistoryEntry entry;
+                if (getRowEntry (row, entry))
+                {
+                    pastem.insert (-1, (const char *) printable (entry.text ()));
+                    pastem.insert (-1, "\n");
+                }
                 cursor = cursor->prev;
             }
-            gtk_clipboard_clear (gtk_clipboard_get (GDK_SELECTION_PRIMARY));                                                                                  
+            gtk_clipboard_clear (gtk_clipboard_get (GDK_SELECTION_PRIMARY));
             gtk_clipboard_set_text (gtk_clipboard_get (GDK_SELECTION_PRIMARY),
                     (const char *) pastem, strlen ((const char *) pastem));
             g_list_free_full (selected_list, (GDestroyNotify) gtk_tree_path_free);
@@ -635,19 +783,44 @@ static const AudguiListCallbacks callbacks = {
     activate_row
 };
 
+/* CALLBACK WHEN USER PICKS A DIFFERENT VIEW: */
+static void view_changed_cb (GtkComboBox * combo, void * list)
+{
+    m_view = aud::clamp (gtk_combo_box_get_active (combo), 0, ViewCount - 1);
+    aud_set_int (configSection, configView, m_view);
+    fillList ((GtkWidget *) list);
+}
+
 static void destroy_cb (GtkWidget * window)
 {
     hook_dissociate ("playback ready", (HookFunction) playbackStarted);
     hook_dissociate ("title change", (HookFunction) titleChanged);
-    m_entries.clear();
+    m_store.close ();
+    m_top.clear ();
     m_playingPosition = -1;
     prevPlayingPosition = -1; 
     treeview = nullptr;
 }
 
+bool PlaybackHistory::init ()
+{
+    aud_config_set_defaults (configSection, defaults);
+    return true;
+}
+
 /* CREATE ALL THE WIDGETS (ON STARTUP): */
 void * PlaybackHistory::get_gtk_widget ()
 {
+    // ONLY THE FILE SIZES ARE READ HERE, THE ENTRIES THEMSELVES AS THEY ARE SHOWN:
+    m_store.set_retention (aud_get_int (configSection, configMaxEntries),
+            aud_get_int (configSection, configMaxDays));
+    m_store.open ();
+
+    // THE LAST ENTRY OF THE PREVIOUS SESSION, SO THAT IT IS NOT ADDED AGAIN
+    // IF PLAYBACK RESUMES WITH THE SAME SONG:
+    m_playingPosition = prevPlayingPosition = m_store.count () - 1;
+    m_view = aud::clamp (aud_get_int (configSection, configView), 0, ViewCount - 1);
+
     if (treeview == nullptr)
         treeview = audgui_list_new (& callbacks, nullptr, 0);
 
@@ -656,14 +829,24 @@ void * PlaybackHistory::get_gtk_widget ()
 
     g_signal_connect (treeview, "key-press-event", (GCallback) pbhist_keypress_cb, nullptr);
 
+    GtkWidget * combo = gtk_combo_box_text_new ();
+    gtk_combo_box_text_append_text ((GtkComboBoxText *) combo, _("Recently played"));
+    gtk_combo_box_text_append_text ((GtkComboBoxText *) combo, _("Most played this week"));
+    gtk_combo_box_text_append_text ((GtkComboBoxText *) combo, _("Most played ever"));
+    gtk_combo_box_set_active ((GtkComboBox *) combo, m_view);
+    g_signal_connect (combo, "changed", (GCallback) view_changed_cb, treeview);
+
     GtkWidget * scrollview = gtk_scrolled_window_new (nullptr, nullptr);
     gtk_scrolled_window_set_shadow_type ((GtkScrolledWindow *) scrollview, GTK_SHADOW_IN);
     gtk_scrolled_window_set_policy ((GtkScrolledWindow *) scrollview, GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     GtkWidget * vbox = audgui_vbox_new (6);
 
     gtk_container_add ((GtkContainer *) scrollview, treeview);
+    gtk_box_pack_start ((GtkBox *) vbox, combo, false, false, 0);
     gtk_box_pack_start ((GtkBox *) vbox, scrollview, true, true, 0);
 
+    fillList (treeview);
+
     gtk_widget_show_all (vbox);
 
     hook_associate ("playback ready", (HookFunction) playbackStarted, treeview);
@@ -677,6 +860,9 @@ void * PlaybackHistory::get_gtk_widget ()
 const char * const PlaybackHistory::defaults[] = {
     configEntryType,
     aud::numeric_string<static_cast<int>(HistoryEntry::defaultType)>::str,
+    configMaxEntries, "10000",
+    configMaxDays, "0",
+    configView, "0",
     nullptr};
 
 const PreferencesWidget PlaybackHistory::widgets[] = {
@@ -687,6 +873,13 @@ const PreferencesWidget PlaybackHistory::widgets[] = {
                 {static_cast<int>(HistoryEntry::Type::Album)}),
     // JWT:ALSO RECORD CHANGES WITHIN STREAMING RADIO-STATIONS:
     WidgetCheck (N_("Check station metadata changes."),
-        WidgetBool ("playback-history", "chk_on_title_change"))};
+        WidgetBool ("playback-history", "chk_on_title_change")),
+    WidgetLabel (N_("<b>Retention (0 = unlimited)</b>")),
+    WidgetSpin (N_("Keep at most:"),
+        WidgetInt (configSection, configMaxEntries, applyRetention),
+        {0, 1000000, 100, N_("entries")}),
+    WidgetSpin (N_("Keep for:"),
+        WidgetInt (configSection, configMaxDays, applyRetention),
+        {0, 3650, 1, N_("days")})};
 
 const PluginPreferences PlaybackHistory::prefs = {{widgets}};
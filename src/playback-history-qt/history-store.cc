@@ -0,0 +1 @@
+#include "../ui-common/history-store.cc"
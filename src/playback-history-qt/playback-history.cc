@@ -20,15 +20,21 @@
 #include <cassert>
 #include <utility>
 
+#include <time.h>
+
 #include <QApplication>
 #include <QAbstractListModel>
+#include <QComboBox>
+#include <QDateTime>
 #include <QEvent>
 #include <QKeyEvent>
+#include <QLocale>
 #include <QFont>
 #include <QMetaObject>
 #include <QPointer>
 #include <QClipboard>
 #include <QThread>
+#include <QVBoxLayout>
 
 #include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/hook.h>
@@ -38,8 +44,11 @@
 #include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
 #include <libfauxdcore/templates.h>
+#include <libfauxdqt/libfauxdqt.h>
 #include <libfauxdqt/treeview.h>
 
+#include "../ui-common/history-store.h"
+
 /**
  * Returns a representation of @p str suitable for printing via audlog::log().
  */
@@ -57,13 +66,17 @@ private:
            "Copyright 2023-2024 Igor Kushnir <igorkuo@gmail.com>\n\n"
            "This plugin tracks and provides access to playback history.\n\n"
 
-           "History entries are stored only in memory and are lost\n"
-           "on Audacious exit. When the plugin is disabled,\n"
+           "History entries are saved in the config directory and kept\n"
+           "across Fauxdacious sessions. When the plugin is disabled,\n"
            "playback history is not tracked at all.\n"
-           "History entries are only added, never removed automatically.\n"
-           "The user can remove selected entries by pressing the Delete key.\n"
-           "Restart Audacious or disable the plugin by closing\n"
-           "Playback History view to clear the entries.\n\n"
+           "The oldest entries are dropped once there are more of them,\n"
+           "or they are older, than set in the plugin's settings.\n"
+           "The user can remove selected entries by pressing the Delete key.\n\n"
+
+           "Besides the history itself, the view can list the songs\n"
+           "played most this week or ever, with their play counts.\n"
+           "Play counts are kept for all songs ever played, including\n"
+           "entries since removed or dropped.\n\n"
 
            "Two history item granularities (modes) are supported.\n"
            "The user can select a mode in the plugin's settings.\n"
@@ -83,6 +96,7 @@ public:
 
     constexpr PlaybackHistory () : GeneralPlugin (info, false) {}
 
+    bool init () override;
     void * get_qt_widget () override;
     int take_message (const char * code, const void *, int) override;
 };
@@ -91,6 +105,11 @@ EXPORT PlaybackHistory aud_plugin_instance;
 
 static constexpr const char * configSection = "playback-history";
 static constexpr const char * configEntryType = "entry_type";
+static constexpr const char * configMaxEntries = "max_entries";
+static constexpr const char * configMaxDays = "max_days";
+static constexpr const char * configView = "view";
+
+static constexpr int topListSize = 100;
 
 class HistoryEntry
 {
@@ -107,6 +126,16 @@ public:
      */
     HistoryEntry () = default;
 
+    /**
+     * Creates an entry from one saved in the history store.
+     */
+    explicit HistoryEntry (const HistoryRecord & record);
+
+    /**
+     * Returns @c this as a record for the history store.
+     */
+    HistoryRecord record () const;
+
     /**
      * Stores the currently playing entry in @c this.
      *
@@ -188,11 +217,36 @@ private:
      */
     int m_playlistPosition = -1;
     Type m_type = defaultType;
+    String m_filename;
 };
 
 class HistoryModel : public QAbstractListModel
 {
 public:
+    enum View
+    {
+        ViewHistory,
+        ViewWeek,   /**< the most played in the last 7 days */
+        ViewEver,   /**< the most played ever */
+        ViewCount
+    };
+
+    /**
+     * Opens the history store. Only the file sizes are read here, the entries
+     * themselves as they are shown.
+     */
+    HistoryModel ();
+
+    /**
+     * Switches between the history and the "most played" lists.
+     */
+    void setView (int view);
+
+    /**
+     * Applies changed retention limits.
+     */
+    void applyRetention ();
+
     /**
      * Updates a cached font.
      *
@@ -225,7 +279,7 @@ public:
 
     int rowCount (const QModelIndex & parent) const override;
     int columnCount (const QModelIndex & parent) const override;
-    const char * textdata (const QModelIndex & index) const;
+    String textdata (const QModelIndex & index) const;
     QVariant data (const QModelIndex & index, int role) const override;
 
     bool removeRows (int row, int count,
@@ -238,7 +292,7 @@ private:
         NColumns
     };
 
-    // In this class the word "position" refers to an index into m_entries.
+    // In this class the word "position" refers to an entry number in m_store.
 
     bool isModelRowOutOfBounds (int row) const;
     bool isOutOfBounds (const QModelIndex & index) const;
@@ -254,6 +308,16 @@ private:
      */
     void updateFontForPosition (int position);
 
+    /**
+     * Returns the entry shown at model @p row.
+     */
+    bool entryAtRow (int row, HistoryEntry & entry) const;
+
+    /**
+     * Fills m_top for the current "most played" view.
+     */
+    void fillTop ();
+
     /**
      * Adds the newly played song into the playback history.
      */
@@ -265,7 +329,14 @@ private:
     const HookReceiver<HistoryModel> titlechg_hook {
         "title change", this, &HistoryModel::titleChanged};
 
-    Index<HistoryEntry> m_entries;
+    // Entries are read from m_store as the view asks for them; it keeps the
+    // ones read last, so repainting the same rows again and again is cheap.
+    mutable HistoryStore m_store;
+    Index<HistoryCount> m_top; /**< for the "most played" views */
+    int m_view = ViewHistory;
+    /** The number of model rows, which lags behind m_store while rows are
+     * inserted or removed. */
+    int m_rows = 0;
     /** The position of the entry that is currently playing
      * or was played last. -1 means "none". */
     int m_playingPosition = -1;
@@ -285,6 +356,8 @@ class HistoryView : public audqt::TreeView
 public:
     HistoryView ();
 
+    HistoryModel & historyModel () { return m_model; }
+
 protected:
     void changeEvent (QEvent * event) override;
     void currentChanged (const QModelIndex & current,
@@ -300,6 +373,25 @@ private:
 #endif
 };
 
+HistoryEntry::HistoryEntry (const HistoryRecord & record) :
+    m_text (record.text),
+    m_playlist (aud_playlist_by_unique_id (record.playlist_id)),
+    m_playlistPosition (record.position),
+    m_type ((record.type == static_cast<int>(Type::Album)) ? Type::Album : Type::Song),
+    m_filename (record.filename) {}
+
+HistoryRecord HistoryEntry::record () const
+{
+    HistoryRecord record;
+    record.time = time (nullptr);
+    record.type = static_cast<int>(m_type);
+    record.playlist_id = aud_playlist_get_unique_id (m_playlist);
+    record.position = m_playlistPosition;
+    record.filename = m_filename;
+    record.text = m_text;
+    return record;
+}
+
 bool HistoryEntry::assignPlayingEntry ()
 {
     m_playlist = aud_playlist_get_playing ();
@@ -319,6 +411,7 @@ bool HistoryEntry::assignPlayingEntry ()
     }
     assert (m_playlistPosition >= 0);
     assert (m_playlistPosition < aud_playlist_entry_count (m_playlist));
+    m_filename = aud_playlist_entry_get_filename (m_playlist, m_playlistPosition);
 
     const auto entryType = aud_get_int (configSection, configEntryType);
     if (entryType == static_cast<int>(Type::Song) ||
@@ -488,38 +581,121 @@ bool HistoryEntry::isAvailable () const
     return true;
 }
 
+HistoryModel::HistoryModel ()
+{
+    m_store.set_retention (aud_get_int (configSection, configMaxEntries),
+            aud_get_int (configSection, configMaxDays));
+    m_store.open ();
+    m_rows = m_store.count ();
+
+    // The last entry of the previous session, so that it is not added again if
+    // playback resumes with the same song.
+    m_playingPosition = m_store.count () - 1;
+
+    setView (aud_get_int (configSection, configView));
+}
+
+void HistoryModel::setView (int view)
+{
+    beginResetModel ();
+
+    m_view = aud::clamp (view, 0, ViewCount - 1);
+    fillTop ();
+    m_rows = (m_view == ViewHistory) ? m_store.count () : m_top.len ();
+
+    endResetModel ();
+}
+
+void HistoryModel::fillTop ()
+{
+    switch (m_view)
+    {
+    case ViewWeek:
+        m_top = m_store.most_played (time (nullptr) - 7 * 86400, topListSize);
+        break;
+    case ViewEver:
+        m_top = m_store.most_played (0, topListSize);
+        break;
+    default:
+        m_top.clear ();
+        break;
+    }
+}
+
+void HistoryModel::applyRetention ()
+{
+    // Changing the limits is rare enough to simply reset the model.
+    beginResetModel ();
+
+    m_store.set_retention (aud_get_int (configSection, configMaxEntries),
+            aud_get_int (configSection, configMaxDays));
+    if (m_playingPosition >= m_store.count ())
+        m_playingPosition = m_store.count () - 1;
+
+    fillTop ();
+    m_rows = (m_view == ViewHistory) ? m_store.count () : m_top.len ();
+
+    endResetModel ();
+}
+
 void HistoryModel::setFont (const QFont & font)
 {
     m_currentlyPlaingFont = font;
     m_currentlyPlaingFont.setBold (true);
 
-    if (m_playingPosition >= 0)
+    if (m_view == ViewHistory && m_playingPosition >= 0)
         updateFontForPosition (m_playingPosition);
 }
 
+bool HistoryModel::entryAtRow (int row, HistoryEntry & entry) const
+{
+    if (m_view != ViewHistory)
+    {
+        if (row < 0 || row >= m_top.len ())
+            return false;
+
+        entry = HistoryEntry (m_top[row].last);
+        return true;
+    }
+
+    HistoryRecord record;
+    if (! m_store.get (positionFromModelRow (row), record))
+        return false;
+
+    entry = HistoryEntry (record);
+    return true;
+}
+
 void HistoryModel::makeCurrent (const QModelIndex & index) const
 {
-    if (isOutOfBounds (index))
+    HistoryEntry entry;
+    if (isOutOfBounds (index) || ! entryAtRow (index.row (), entry))
         return;
-    const int pos = positionFromIndex (index);
-    m_entries[pos].makeCurrent ();
+
+    entry.makeCurrent ();
 }
 
 void HistoryModel::activate (const QModelIndex & index)
 {
-    if (isOutOfBounds (index))
+    HistoryEntry entry;
+    if (isOutOfBounds (index) || ! entryAtRow (index.row (), entry))
         return;
 
-    const int pos = positionFromIndex (index);
-
     // The "playback ready" hook is activated asynchronously, so
     // playbackStarted() for the playback initiated here will be invoked after
     // this function updates m_playingPosition and returns.
-    if (! m_entries[pos].play ())
+    if (! entry.play ())
+        return;
+
+    // An entry played from a "most played" view is a new play, and so is
+    // appended as usual.
+    if (m_view != ViewHistory)
         return;
 
+    const int pos = positionFromIndex (index);
+
     // Update m_playingPosition here to prevent the imminent playbackStarted()
-    // invocation from appending a copy of the activated entry to m_entries.
+    // invocation from appending a copy of the activated entry to the history.
     // This does not prevent appending a different-type counterpart entry if the
     // type of the activated entry does not match the currently configured
     // History Item Granularity. Such a scenario is uncommon (happens only when
@@ -537,7 +713,7 @@ void HistoryModel::activate (const QModelIndex & index)
 
 int HistoryModel::rowCount (const QModelIndex & parent) const
 {
-    return parent.isValid () ? 0 : m_entries.len ();
+    return parent.isValid () ? 0 : m_rows;
 }
 
 int HistoryModel::columnCount (const QModelIndex & parent) const
@@ -549,37 +725,75 @@ int HistoryModel::columnCount (const QModelIndex & parent) const
    (ONLY AS QString) *FROM* A String & I COULDN'T GET IT BACK TO String OR const char *!
    WITH ANY COMBO. OF QString's .to*()/.constData() METHODS!:
 */
-const char * HistoryModel::textdata (const QModelIndex & index) const
+String HistoryModel::textdata (const QModelIndex & index) const
 {
-    if (isOutOfBounds (index))
-        return "-no data-";  //PLAY SAFE!
-
-    return (const char *) m_entries[positionFromIndex (index)].text ();
+    HistoryEntry entry;
+    if (isOutOfBounds (index) || ! entryAtRow (index.row (), entry))
+        return String ("-no data-");  //PLAY SAFE!
 
+    return entry.text ();
 }
 
 QVariant HistoryModel::data (const QModelIndex & index, int role) const
 {
     if (isOutOfBounds (index))
         return QVariant ();
+
+    if (m_view != ViewHistory)
+    {
+        const auto & top = m_top[index.row ()];
+
+        switch (role)
+        {
+        case Qt::DisplayRole:
+            return QString (str_printf ("%s (%d)", printable (top.last.text),
+                    top.count));
+        case Qt::ToolTipRole:
+        {
+            const HistoryEntry entry (top.last);
+            return QString (
+                str_printf (_("<b>%s:</b> %s<br><b>Play Count:</b> %d<br>"
+                             "<b>Last Played:</b> %s"),
+                           entry.translatedTextDesignation (),
+                           static_cast<const char *>(entry.text ()), top.count,
+                           (const char *) QLocale ().toString (QDateTime::fromSecsSinceEpoch
+                            (top.last.time), QLocale::ShortFormat).toUtf8 ()));
+        }
+        }
+
+        return QVariant ();
+    }
+
     const int pos = positionFromIndex (index);
+    if (pos < 0)
+        return QVariant (); // dropped, about to be removed from the model
 
     switch (role)
     {
     case Qt::DisplayRole:
-        return QString (m_entries[pos].text ());
+    {
+        HistoryRecord record;
+        if (! m_store.get (pos, record))
+            return QString ("--error!--");
+        return QString (record.text);
+    }
     case Qt::ToolTipRole:
     {
-        const auto & entry = m_entries[pos];
+        HistoryRecord record;
+        if (! m_store.get (pos, record))
+            return QVariant ();
+
+        const HistoryEntry entry (record);
         // The playlist title and entry number are rarely interesting and
         // therefore shown only in the tooltip.
         return QString (
             str_printf (_("<b>%s:</b> %s<br><b>Playlist:</b> %s<br>"
-                         "<b>Entry Number:</b> %d"),
+                         "<b>Entry Number:</b> %d<br><b>Play Count:</b> %d"),
                        entry.translatedTextDesignation (),
                        static_cast<const char *>(entry.text ()),
                        static_cast<const char *>(entry.playlistTitle ()),
-                       entry.entryNumber ()));
+                       entry.entryNumber (),
+                       m_store.play_count (record.filename)));
     }
     case Qt::FontRole:
         if (pos == m_playingPosition)
@@ -592,7 +806,8 @@ QVariant HistoryModel::data (const QModelIndex & index, int role) const
 
 bool HistoryModel::removeRows (int row, int count, const QModelIndex & parent)
 {
-    if (count <= 0 || parent.isValid ())
+    // Play counts are not editable.
+    if (count <= 0 || parent.isValid () || m_view != ViewHistory)
         return false;
 
     const int lastRowToRemove = row + count - 1;
@@ -602,7 +817,7 @@ bool HistoryModel::removeRows (int row, int count, const QModelIndex & parent)
     const int pos = std::min (positionFromModelRow (row),
                              positionFromModelRow (lastRowToRemove));
     // pos is the lesser of the positions that correspond to the first and last
-    // removed model rows. Remove the range [pos, pos + count) from m_entries.
+    // removed model rows. Remove the range [pos, pos + count) from m_store.
 
     m_areRowsBeingRemoved = true;
     beginRemoveRows (QModelIndex (), row, lastRowToRemove);
@@ -615,7 +830,9 @@ bool HistoryModel::removeRows (int row, int count, const QModelIndex & parent)
         m_playingPosition -= count;
     }
 
-    m_entries.remove (pos, count);
+    for (int i = 0; i < count; i ++)
+        m_store.remove (pos);
+    m_rows -= count;
 
     endRemoveRows ();
     m_areRowsBeingRemoved = false;
@@ -623,7 +840,7 @@ bool HistoryModel::removeRows (int row, int count, const QModelIndex & parent)
        ENTRY TO REDUCE POSSIBILITY OF SAME ENTRY APPEARING BACK-TO-BACK IN LIST:
     */
     if (m_playingPosition < 0)
-        m_playingPosition = m_entries.len () - 1;
+        m_playingPosition = m_store.count () - 1;
 
     if (m_playingPosition > 0)
             updateFontForPosition (m_playingPosition);
@@ -633,10 +850,10 @@ bool HistoryModel::removeRows (int row, int count, const QModelIndex & parent)
 
 bool HistoryModel::isModelRowOutOfBounds (int row) const
 {
-    if (row >= 0 && row < m_entries.len ())
+    if (row >= 0 && row < m_rows)
         return false;
     AUDWARN ("Model row is out of bounds: %d is not in the range [0, %d)\n", row,
-            m_entries.len ());
+            m_rows);
     return true;
 }
 
@@ -647,10 +864,10 @@ bool HistoryModel::isOutOfBounds (const QModelIndex & index) const
         AUDWARN ("Invalid index.\n");
         return true;
     }
-    if (index.row () >= m_entries.len ())
+    if (index.row () >= m_rows)
     {
         AUDWARN ("Index row is out of bounds: %d >= %d\n", index.row (),
-                m_entries.len ());
+                m_rows);
         return true;
     }
     return false;
@@ -659,21 +876,22 @@ bool HistoryModel::isOutOfBounds (const QModelIndex & index) const
 int HistoryModel::modelRowFromPosition (int position) const
 {
     assert (position >= 0);
-    assert (position < m_entries.len ());
+    assert (position < m_store.count ());
     // Reverse the order of entries here in order to:
     // 1) display most recently played entries at the top of the view and thus
     // avoid scrolling to the bottom of the view each time a new entry is added;
-    // 2) efficiently append new elements to m_entries.
+    // 2) efficiently append new entries to m_store.
     // This code must be kept in sync with playbackStarted().
-    return m_entries.len () - 1 - position;
+    return m_store.count () - 1 - position;
 }
 
 int HistoryModel::positionFromModelRow (int row) const
 {
     assert (! isModelRowOutOfBounds (row));
     // modelRowFromPosition() is an involution (self-inverse function),
-    // and thus this inverse function delegates to it.
-    return modelRowFromPosition (row);
+    // and thus this inverse function delegates to it. While dropped rows are
+    // being removed from the bottom, they have negative positions.
+    return m_store.count () - 1 - row;
 }
 
 int HistoryModel::positionFromIndex (const QModelIndex & index) const
@@ -706,12 +924,13 @@ void HistoryModel::playbackStarted ()
 
     entry.debugPrint ("Started playing ");
     AUDDBG ("playing position=%d, entry count=%d\n", m_playingPosition,
-           m_entries.len());
+           m_store.count ());
 
     const auto shouldAppendEntry = [this, &entry] {
-        if (m_playingPosition < 0)
+        HistoryRecord record;
+        if (m_playingPosition < 0 || ! m_store.get (m_playingPosition, record))
             return true;
-        const auto & prevPlayingEntry = m_entries[m_playingPosition];
+        const HistoryEntry prevPlayingEntry (record);
 
         if (prevPlayingEntry.type () != entry.type () ||
                 prevPlayingEntry.playlist () != entry.playlist ())
@@ -745,7 +964,19 @@ void HistoryModel::playbackStarted ()
     if (! shouldAppendEntry)
         return;
 
-    const int prevPlayingPosition = m_playingPosition;
+    int prevPlayingPosition = m_playingPosition;
+
+    // Entries dropped to stay within the retention limits are the oldest ones,
+    // at the bottom of the view.
+    const int dropped = m_store.append (entry.record ());
+    prevPlayingPosition -= dropped;
+
+    if (m_view != ViewHistory)
+    {
+        m_playingPosition = m_store.count () - 1;
+        setView (m_view);
+        return;
+    }
 
     // The last played entry appears at the top of the view. Therefore, the new
     // entry is inserted at row 0.
@@ -753,10 +984,17 @@ void HistoryModel::playbackStarted ()
     beginInsertRows (QModelIndex (), 0, 0);
     // Update m_playingPosition during the row insertion to avoid
     // updating the font for the new playing position separately below.
-    m_playingPosition = m_entries.len ();
-    m_entries.append (std::move (entry));
+    m_playingPosition = m_store.count () - 1;
+    m_rows ++;
     endInsertRows ();
 
+    if (dropped > 0)
+    {
+        beginRemoveRows (QModelIndex (), m_rows - dropped, m_rows - 1);
+        m_rows -= dropped;
+        endRemoveRows ();
+    }
+
     if (prevPlayingPosition >= 0)
         updateFontForPosition (prevPlayingPosition);
 }
@@ -877,7 +1115,7 @@ void HistoryView::keyPressEvent (QKeyEvent * event)
             StringBuf pastem;
             for (auto & idx : selectionModel ()->selectedRows ())
             {
-                const char * rowtitle = m_model.textdata (idx);
+                String rowtitle = m_model.textdata (idx);
                 pastem.insert (-1, rowtitle);
                 pastem.insert (-1, "\n");
             }
@@ -931,6 +1169,18 @@ void HistoryView::makeCurrent (const QModelIndex & index)
 
 static QPointer<HistoryView> s_history_view;
 
+static void applyRetention ()
+{
+    if (s_history_view)
+        s_history_view->historyModel ().applyRetention ();
+}
+
+bool PlaybackHistory::init ()
+{
+    aud_config_set_defaults (configSection, defaults);
+    return true;
+}
+
 void * PlaybackHistory::get_qt_widget ()
 {
     assert (! s_history_view);
@@ -938,7 +1188,26 @@ void * PlaybackHistory::get_qt_widget ()
     /* JWT:NEEDED FOR KEYPRESS EVENTS TO BE SEEN!: */
     s_history_view->setFocusPolicy (Qt::StrongFocus);
 
-    return s_history_view;
+    auto combo = new QComboBox;
+    combo->addItem (_("Recently played"));
+    combo->addItem (_("Most played this week"));
+    combo->addItem (_("Most played ever"));
+    combo->setCurrentIndex (aud::clamp (aud_get_int (configSection, configView),
+            0, HistoryModel::ViewCount - 1));
+
+    QObject::connect (combo, QOverload<int>::of (& QComboBox::currentIndexChanged),
+            [] (int view) {
+        aud_set_int (configSection, configView, view);
+        if (s_history_view)
+            s_history_view->historyModel ().setView (view);
+    });
+
+    auto widget = new QWidget;
+    auto vbox = audqt::make_vbox (widget, 0);
+    vbox->addWidget (combo);
+    vbox->addWidget (s_history_view, 1);
+
+    return widget;
 }
 
 int PlaybackHistory::take_message (const char * code, const void *, int)
@@ -955,6 +1224,9 @@ int PlaybackHistory::take_message (const char * code, const void *, int)
 const char * const PlaybackHistory::defaults[] = {
     configEntryType,
     aud::numeric_string<static_cast<int>(HistoryEntry::defaultType)>::str,
+    configMaxEntries, "10000",
+    configMaxDays, "0",
+    configView, "0",
     nullptr};
 
 const PreferencesWidget PlaybackHistory::widgets[] = {
@@ -965,6 +1237,13 @@ const PreferencesWidget PlaybackHistory::widgets[] = {
                 {static_cast<int>(HistoryEntry::Type::Album)}),
     // JWT:ALSO RECORD CHANGES WITHIN STREAMING RADIO-STATIONS:
     WidgetCheck (N_("Check station metadata changes."),
-        WidgetBool ("playback-history", "chk_on_title_change"))};
+        WidgetBool ("playback-history", "chk_on_title_change")),
+    WidgetLabel (N_("<b>Retention (0 = unlimited)</b>")),
+    WidgetSpin (N_("Keep at most:"),
+        WidgetInt (configSection, configMaxEntries, applyRetention),
+        {0, 1000000, 100, N_("entries")}),
+    WidgetSpin (N_("Keep for:"),
+        WidgetInt (configSection, configMaxDays, applyRetention),
+        {0, 3650, 1, N_("days")})};
 
 const PluginPreferences PlaybackHistory::prefs = {{widgets}};
@@ -23,13 +23,19 @@
  */
 
 #include <math.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/i18n.h>
 #include <libfauxdcore/plugin.h>
+#include <libfauxdcore/preferences.h>
+#include <libfauxdcore/runtime.h>
 
+#include <QElapsedTimer>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_2_0>
+#include <QPainter>
 
 #define NUM_BANDS 32
 #define DB_RANGE 40
@@ -37,6 +43,13 @@
 #define BAR_SPACING (3.2f / NUM_BANDS)
 #define BAR_WIDTH (0.8f * BAR_SPACING)
 
+/* top, two sides and front of each bar, drawn as quads */
+#define VERTICES_PER_BAR 16
+#define NUM_VERTICES (NUM_BANDS * NUM_BANDS * VERTICES_PER_BAR)
+
+/* shared with the GTK version */
+#define CFG_ID "glspectrum"
+
 static const char gl_about[] =
  N_("OpenGL Spectrum Analyzer for Audacious\n"
     "Copyright 2013 Christophe Budé, John Lindgren, and Carlo Bramini\n"
@@ -49,11 +62,15 @@ static const char gl_about[] =
 class GLSpectrumQt : public VisPlugin
 {
 public:
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
     static constexpr PluginInfo info = {
         N_("OpenGL Spectrum Analyzer"),
         PACKAGE,
         gl_about,
-        nullptr, // prefs
+        & prefs,
         PluginQtOnly
     };
 
@@ -69,9 +86,51 @@ public:
 
 EXPORT GLSpectrumQt aud_plugin_instance;
 
+const char * const GLSpectrumQt::defaults[] = {
+    "show_fps", "FALSE",
+    nullptr
+};
+
+static bool s_show_fps = false;
+
+static void show_fps_changed ()
+{
+    s_show_fps = aud_get_bool (CFG_ID, "show_fps");
+}
+
+const PreferencesWidget GLSpectrumQt::widgets[] = {
+    WidgetCheck (N_("Show frame rate and frame time"),
+        WidgetBool (CFG_ID, "show_fps", show_fps_changed))
+};
+
+const PluginPreferences GLSpectrumQt::prefs = {{widgets}};
+
 static float logscale[NUM_BANDS + 1];
 static float colors[NUM_BANDS][NUM_BANDS][3];
 
+/* The geometry of a bar never changes except for its height, so it is
+ * described once here: each vertex as an offset from the bar's corner (in
+ * bar widths), whether it is at the top, and the shading of its face. */
+static const struct {
+    uint8_t x, top, z;
+    float shade;
+} bar_template[VERTICES_PER_BAR] = {
+    {0, 1, 0, 1}, {1, 1, 0, 1}, {1, 1, 1, 1}, {0, 1, 1, 1},  /* top */
+    {0, 0, 0, 0.65f}, {0, 1, 0, 0.65f}, {0, 1, 1, 0.65f}, {0, 0, 1, 0.65f},  /* left */
+    {1, 1, 0, 0.65f}, {1, 0, 0, 0.65f}, {1, 0, 1, 0.65f}, {1, 1, 1, 0.65f},  /* right */
+    {0, 0, 0, 0.8f}, {1, 0, 0, 0.8f}, {1, 1, 0, 0.8f}, {0, 1, 0, 0.8f}  /* front */
+};
+
+struct Vertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+
+/* All the bars, drawn with a single call; rebuilt only when new data
+ * arrives, not on every repaint. */
+static Vertex s_vertices[NUM_VERTICES];
+static bool s_vertices_valid = false;
+
 static int s_pos = 0;
 static float s_angle = 25, s_anglespeed = 0.05f;
 static float s_bars[NUM_BANDS][NUM_BANDS];
@@ -88,15 +147,22 @@ private:
     void initializeGL ();
 
     void draw_bars ();
-    void draw_bar (float x, float z, float h, float r, float g, float b);
-    void draw_rectangle (float x1, float y1, float z1, float x2, float y2,
-            float z2, float r, float g, float b);
+    void draw_stats (int64_t frame_ns);
+
+    /* frame statistics for the overlay, reset every second */
+    QElapsedTimer m_stats_timer;
+    int64_t m_stats_busy_ns = 0;
+    int m_stats_frames = 0;
+    QString m_stats_text;
 };
 
 GLSpectrumWidget * s_widget = nullptr;
 
 bool GLSpectrumQt::init ()
 {
+    aud_config_set_defaults (CFG_ID, defaults);
+    show_fps_changed ();
+
     for (int i = 0; i <= NUM_BANDS; i ++)
         logscale[i] = powf (256, (float) i / NUM_BANDS) - 0.5f;
 
@@ -164,6 +230,8 @@ void GLSpectrumQt::render_freq (const float * freq)
     if (s_angle > 45 || s_angle < -45)
         s_anglespeed = -s_anglespeed;
 
+    s_vertices_valid = false;
+
     if (s_widget)
         s_widget->update ();
 }
@@ -171,77 +239,99 @@ void GLSpectrumQt::render_freq (const float * freq)
 void GLSpectrumQt::clear ()
 {
     memset (s_bars, 0, sizeof s_bars);
+    s_vertices_valid = false;
 
     if (s_widget)
         s_widget->update ();
 }
 
-void GLSpectrumWidget::draw_rectangle (float x1, float y1, float z1, float x2, float y2,
-        float z2, float r, float g, float b)
+/* the tops of the tallest bars are shaded brighter than full colour;
+ * glColor3f () clamped them, and so must we */
+static uint8_t color_byte (float c)
 {
-    glColor4f (r, g, b, 1.0f);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y2, z2);
-    glVertex3f (x1, y2, z2);
-    glEnd ();
-
-    glColor4f (0.65f * r, 0.65f * g, 0.65f * b, 1.0f);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x1, y2, z1);
-    glVertex3f (x1, y2, z2);
-    glVertex3f (x1, y1, z2);
-    glEnd ();
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y1, z2);
-    glVertex3f (x2, y2, z2);
-    glEnd ();
-
-    glColor3f (0.8f * r, 0.8f * g, 0.8f * b);
-
-    glBegin (GL_POLYGON);
-    glVertex3f (x1, y1, z1);
-    glVertex3f (x2, y1, z1);
-    glVertex3f (x2, y2, z1);
-    glVertex3f (x1, y2, z1);
-    glEnd ();
+    return (uint8_t) (aud::clamp (c, 0.0f, 1.0f) * 255 + 0.5f);
 }
 
-void GLSpectrumWidget::draw_bar (float x, float z, float h, float r, float g, float b)
+static void build_vertices ()
 {
-    draw_rectangle (x, 0, z, x + BAR_WIDTH, h, z + BAR_WIDTH,
-     r * (0.2f + 0.8f * h), g * (0.2f + 0.8f * h), b * (0.2f + 0.8f * h));
+    Vertex * v = s_vertices;
+
+    for (int i = 0; i < NUM_BANDS; i ++)
+    {
+        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+        const float * row = s_bars[(s_pos + i) % NUM_BANDS];
+
+        for (int j = 0; j < NUM_BANDS; j ++)
+        {
+            float x = 1.6f - BAR_SPACING * j;
+            float h = row[j] * 1.6f;
+            float bright = 0.2f + 0.8f * h;
+
+            for (auto & t : bar_template)
+            {
+                float shade = bright * t.shade;
+
+                v->x = x + t.x * BAR_WIDTH;
+                v->y = t.top ? h : 0;
+                v->z = z + t.z * BAR_WIDTH;
+                v->r = color_byte (colors[i][j][0] * shade);
+                v->g = color_byte (colors[i][j][1] * shade);
+                v->b = color_byte (colors[i][j][2] * shade);
+                v->a = 255;
+                v ++;
+            }
+        }
+    }
+
+    s_vertices_valid = true;
 }
 
 void GLSpectrumWidget::draw_bars ()
 {
+    if (! s_vertices_valid)
+        build_vertices ();
+
     glPushMatrix ();
     glTranslatef (0.0f, -0.5f, -5.0f);
     glRotatef (38.0f, 1.0f, 0.0f, 0.0f);
     glRotatef (s_angle + 180.0f, 0.0f, 1.0f, 0.0f);
     glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
 
-    for (int i = 0; i < NUM_BANDS; i ++)
+    glEnableClientState (GL_VERTEX_ARRAY);
+    glEnableClientState (GL_COLOR_ARRAY);
+    glVertexPointer (3, GL_FLOAT, sizeof (Vertex), & s_vertices[0].x);
+    glColorPointer (4, GL_UNSIGNED_BYTE, sizeof (Vertex), & s_vertices[0].r);
+
+    glDrawArrays (GL_QUADS, 0, NUM_VERTICES);
+
+    glDisableClientState (GL_COLOR_ARRAY);
+    glDisableClientState (GL_VERTEX_ARRAY);
+
+    glPopMatrix ();
+}
+
+void GLSpectrumWidget::draw_stats (int64_t frame_ns)
+{
+    m_stats_busy_ns += frame_ns;
+    m_stats_frames ++;
+
+    int64_t elapsed_ns = m_stats_timer.nsecsElapsed ();
+
+    /* the text is updated only once a second, so that it can be read */
+    if (elapsed_ns >= 1000000000)
     {
-        float z = -1.6f + (NUM_BANDS - i) * BAR_SPACING;
+        m_stats_text = (const char *) str_printf (_("%.1f fps, %.2f ms/frame"),
+         m_stats_frames * 1e9 / elapsed_ns, m_stats_busy_ns / 1e6 / m_stats_frames);
 
-        for (int j = 0; j < NUM_BANDS; j ++)
-        {
-            draw_bar (1.6f - BAR_SPACING * j, z,
-             s_bars[(s_pos + i) % NUM_BANDS][j] * 1.6,
-             colors[i][j][0], colors[i][j][1], colors[i][j][2]);
-        }
+        m_stats_timer.restart ();
+        m_stats_busy_ns = 0;
+        m_stats_frames = 0;
     }
 
-    glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
-    glPopMatrix ();
+    QPainter painter (this);
+    painter.setPen (Qt::white);
+    painter.drawText (rect ().adjusted (4, 4, -4, -4), Qt::AlignLeft | Qt::AlignTop,
+     m_stats_text);
 }
 
 GLSpectrumWidget::GLSpectrumWidget (QWidget * parent) : QOpenGLWidget (parent)
@@ -259,6 +349,9 @@ GLSpectrumWidget::~GLSpectrumWidget ()
 
 void GLSpectrumWidget::paintGL ()
 {
+    QElapsedTimer frame_timer;
+    frame_timer.start ();
+
     glDisable (GL_BLEND);
     glMatrixMode (GL_PROJECTION);
     glPushMatrix();
@@ -284,6 +377,21 @@ void GLSpectrumWidget::paintGL ()
     glDisable (GL_DEPTH_TEST);
     glDisable (GL_BLEND);
     glDepthMask (GL_TRUE);
+
+    if (s_show_fps)
+    {
+        if (! m_stats_timer.isValid ())
+            m_stats_timer.start ();
+
+        draw_stats (frame_timer.nsecsElapsed ());
+    }
+    else if (m_stats_timer.isValid ())
+    {
+        m_stats_timer.invalidate ();
+        m_stats_busy_ns = 0;
+        m_stats_frames = 0;
+        m_stats_text = QString ();
+    }
 }
 
 void GLSpectrumWidget::resizeGL (int w, int h)
@@ -0,0 +1 @@
+#include "../ui-common/av-core.cc"
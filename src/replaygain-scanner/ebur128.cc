@@ -0,0 +1 @@
+#include "../ui-common/ebur128.cc"
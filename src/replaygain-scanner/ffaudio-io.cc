@@ -0,0 +1 @@
+#include "../ffaudio/ffaudio-io.cc"
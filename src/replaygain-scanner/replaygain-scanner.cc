@@ -0,0 +1,722 @@
+/*
+ * ReplayGain Scanner Plugin for Fauxdacious
+ *
+ * Measures the loudness (EBU R128) and true peak of the selected playlist
+ * entries, decoding them in the background as fast as they will go, and
+ * saves ReplayGain track and album values to their tags.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+
+#include <pthread.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/hook.h>
+#include <libfauxdcore/i18n.h>
+#include <libfauxdcore/interface.h>
+#include <libfauxdcore/mainloop.h>
+#include <libfauxdcore/multihash.h>
+#include <libfauxdcore/playlist.h>
+#include <libfauxdcore/plugin.h>
+#include <libfauxdcore/preferences.h>
+#include <libfauxdcore/probe.h>
+#include <libfauxdcore/runtime.h>
+
+#include "../ui-common/av-core.h"
+#include "../ui-common/ebur128.h"
+
+#define MAX_SCAN_THREADS 4
+#define PROGRESS_MS 250
+
+/* ReplayGain values are stored in hundredths of a dB and millionths */
+#define GAIN_DIVISOR 100
+#define PEAK_DIVISOR 1000000
+
+class ReplayGainScanner : public GeneralPlugin
+{
+public:
+    static const char about[];
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {
+        N_("ReplayGain Scanner"),
+        PACKAGE,
+        about,
+        & prefs
+    };
+
+    constexpr ReplayGainScanner () : GeneralPlugin (info, false) {}
+
+    bool init ();
+    void cleanup ();
+};
+
+EXPORT ReplayGainScanner aud_plugin_instance;
+
+static constexpr AudMenuID menus[] = {
+    AudMenuID::Main,
+    AudMenuID::Playlist
+};
+
+/* what was measured of one file: the true peak and the gated loudness */
+struct Measured {
+    float peak = 0;
+    Index<int> hist;   /* HIST_BINS bins */
+};
+
+struct Track {
+    String filename;
+    int album;        /* index into albums, or -1 if the track has no album */
+    bool ok = false;
+    float gain = 0, peak = 0;
+};
+
+struct Album {
+    int remaining = 0;   /* tracks not yet measured */
+    float peak = 0;
+    LoudnessMeasurement loudness;
+};
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static Index<Track> tracks;
+static Index<Album> albums;
+static int next_track, done_tracks, failed_tracks;
+static int workers;
+static bool scanning;
+static std::atomic<bool> cancel {false};
+
+/* files finished in an earlier, interrupted scan */
+static SimpleHash<String, Measured> journal;
+
+static QueuedFunc progress_timer;
+
+/* The journal lists the files measured so far, one line each:
+ *
+ *     <uri> <true peak> <bin>:<count> <bin>:<count> ...
+ *
+ * New lines are appended as files are done, so that a scan which is
+ * cancelled, or cut short by quitting, can be picked up where it left off;
+ * the file is deleted once a scan completes. */
+static StringBuf journal_path ()
+{
+    return filename_build ({aud_get_path (AudPath::UserDir), "replaygain-scan"});
+}
+
+static void load_journal ()
+{
+    journal.clear ();
+
+    FILE * file = fopen (journal_path (), "r");
+    if (! file)
+        return;
+
+    /* room for a full histogram; longer lines are not ours */
+    char line[32768];
+    bool partial = false;
+
+    while (fgets (line, sizeof line, file))
+    {
+        bool skip = partial;
+        partial = ! strchr (line, '\n') && ! feof (file);
+
+        if (skip || partial)
+            continue;
+
+        Index<String> words = str_list_to_index (line, " \n");
+        if (words.len () < 2)
+            continue;
+
+        Measured measured;
+        measured.peak = str_to_double (words[1]);
+        measured.hist.insert (0, HIST_BINS);
+
+        for (int i = 2; i < words.len (); i ++)
+        {
+            int bin, count;
+            if (sscanf (words[i], "%d:%d", & bin, & count) == 2 && bin >= 0 && bin < HIST_BINS)
+                measured.hist[bin] = count;
+        }
+
+        journal.add (words[0], std::move (measured));
+    }
+
+    AUDDBG ("replaygain-scanner: %d files measured earlier.\n", journal.n_items ());
+    fclose (file);
+}
+
+/* must be called with the mutex held */
+static void journal_add (const char * filename, const Measured & measured)
+{
+    FILE * file = fopen (journal_path (), "a");
+    if (! file)
+    {
+        AUDWARN ("replaygain-scanner: cannot write %s.\n", (const char *) journal_path ());
+        return;
+    }
+
+    fprintf (file, "%s %.6f", filename, measured.peak);
+
+    for (int i = 0; i < HIST_BINS; i ++)
+    {
+        if (measured.hist[i])
+            fprintf (file, " %d:%d", i, measured.hist[i]);
+    }
+
+    fputc ('\n', file);
+    fclose (file);
+}
+
+static void measure_samples (LoudnessMeasurement & loudness, const void * data,
+ int size, int format, int channels, Index<float> & buf)
+{
+    int samples = size / FMT_SIZEOF (format);
+
+    if (format == FMT_FLOAT)
+        loudness.process ((const float *) data, samples / channels);
+    else
+    {
+        buf.resize (samples);
+        audio_from_int (data, format, buf.begin (), samples);
+        loudness.process (buf.begin (), samples / channels);
+    }
+}
+
+/* Decodes the whole file with FFmpeg (the input plugins can only decode
+ * for playback).  Runs on a worker thread. */
+static bool measure_file (const char * filename, Measured & measured)
+{
+    VFSFile file (filename, "r");
+    if (! file)
+        return false;
+
+    AVFormatContext * c = avformat_alloc_context ();
+    AVIOContext * io = io_context_new (file);
+    if (! c || ! io)
+    {
+        if (c)
+            avformat_free_context (c);
+        if (io)
+            io_context_free (io);
+        return false;
+    }
+
+    c->pb = io;
+
+    /* frees the context itself on failure */
+    if (avformat_open_input (& c, filename, nullptr, nullptr) < 0)
+    {
+        io_context_free (io);
+        return false;
+    }
+
+    CodecInfo cinfo;
+    AVPacket * pkt = nullptr;
+    Index<char> audio_buf;
+    Index<float> float_buf;
+    LoudnessMeasurement loudness;
+    LoudnessReadings readings;
+    int format, channels;
+    bool planar;
+    bool ok = false;
+
+    if (avformat_find_stream_info (c, nullptr) < 0)
+        goto done;
+
+    cinfo.stream_idx = av_find_best_stream (c, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (cinfo.stream_idx < 0)
+        goto done;
+
+    cinfo.stream = c->streams[cinfo.stream_idx];
+#ifdef ALLOC_CONTEXT
+    cinfo.codec = (AVCodec *) avcodec_find_decoder (cinfo.stream->codecpar->codec_id);
+    if (! cinfo.codec)
+        goto done;
+
+    cinfo.context = avcodec_alloc_context3 (cinfo.codec);
+    avcodec_parameters_to_context (cinfo.context, cinfo.stream->codecpar);
+#else
+    cinfo.codec = (AVCodec *) avcodec_find_decoder (cinfo.stream->codec->codec_id);
+    if (! cinfo.codec)
+        goto done;
+
+    cinfo.context = cinfo.stream->codec;
+#endif
+
+    if (avcodec_open2 (cinfo.context, cinfo.codec, nullptr) < 0)
+        goto done;
+
+    if (! av_convert_format (cinfo.context->sample_fmt, format, planar))
+        goto done;
+
+#if CHECK_LIBAVCODEC_VERSION(59, 37, 100, 59, 37, 100)
+    channels = cinfo.context->ch_layout.nb_channels;
+#else
+    channels = cinfo.context->channels;
+#endif
+
+    if (channels < 1 || cinfo.context->sample_rate < 1 || ! (pkt = av_packet_alloc ()))
+        goto done;
+
+    loudness.start (channels, cinfo.context->sample_rate);
+
+    while (! cancel.load (std::memory_order_relaxed) && av_read_frame (c, pkt) >= 0)
+    {
+        if (pkt->stream_index == cinfo.stream_idx)
+            av_decode_audio (cinfo, pkt, format, planar, audio_buf,
+             [&] (const void * data, int size) {
+                measure_samples (loudness, data, size, format, channels, float_buf);
+            });
+
+        av_packet_unref (pkt);
+    }
+
+    if (cancel.load ())
+        goto done;
+
+    /* the last frames are still in the decoder */
+    av_decode_audio (cinfo, pkt, format, planar, audio_buf,
+     [&] (const void * data, int size) {
+        measure_samples (loudness, data, size, format, channels, float_buf);
+    });
+
+    loudness.get_readings (readings);
+
+    measured.peak = 0;
+    for (int ch = 0; ch < readings.channels; ch ++)
+        measured.peak = aud::max (measured.peak, readings.true_peak[ch]);
+
+    measured.hist.clear ();
+    measured.hist.insert (loudness.histogram (), 0, HIST_BINS);
+    ok = true;
+
+done:
+    if (pkt)
+        av_packet_free (& pkt);
+
+    av_close_codec (cinfo);
+    avformat_close_input (& c);
+    io_context_free (io);
+
+    return ok;
+}
+
+/* integrated loudness of the histogram(s) added to loudness, or -inf if
+ * there was nothing above the gate (silence) */
+static float integrated (LoudnessMeasurement & loudness)
+{
+    LoudnessReadings readings;
+    loudness.get_readings (readings);
+
+    return (readings.integrated > LOUDNESS_FLOOR) ? readings.integrated : -INFINITY;
+}
+
+static float gain_for (float lufs)
+{
+    return aud_get_int ("replaygain_scanner", "reference") - lufs;
+}
+
+/* rereads the tags, so that nothing changed since the playlist read them is
+ * lost; runs on a worker thread */
+static void write_tags (const Track & track, bool have_album, float album_gain,
+ float album_peak)
+{
+    VFSFile file;
+    String error;
+
+    PluginHandle * decoder = aud_file_find_decoder (track.filename, false, file, & error);
+    if (! decoder || ! aud_file_can_write_tuple (track.filename, decoder))
+    {
+        AUDINFO ("replaygain-scanner: cannot write tags to %s.\n", (const char *) track.filename);
+        return;
+    }
+
+    Tuple tuple;
+    if (! aud_file_read_tag (track.filename, decoder, file, tuple, nullptr, & error))
+    {
+        AUDWARN ("replaygain-scanner: cannot read tags of %s: %s\n",
+         (const char *) track.filename, (const char *) error);
+        return;
+    }
+
+    file = VFSFile ();  /* the plugin opens it again for writing */
+
+    /* the divisors are shared by the track and album values */
+    auto set_gain = [& tuple] (Tuple::Field field, float gain) {
+        tuple.set_int (field, lrintf (gain * GAIN_DIVISOR));
+    };
+    auto set_peak = [& tuple] (Tuple::Field field, float peak) {
+        tuple.set_int (field, lrintf (peak * PEAK_DIVISOR));
+    };
+
+    if (tuple.get_value_type (Tuple::AlbumGain) == Tuple::Int)
+        set_gain (Tuple::AlbumGain, (float) tuple.get_int (Tuple::AlbumGain) /
+         aud::max (tuple.get_int (Tuple::GainDivisor), 1));
+    if (tuple.get_value_type (Tuple::AlbumPeak) == Tuple::Int)
+        set_peak (Tuple::AlbumPeak, (float) tuple.get_int (Tuple::AlbumPeak) /
+         aud::max (tuple.get_int (Tuple::PeakDivisor), 1));
+
+    tuple.set_int (Tuple::GainDivisor, GAIN_DIVISOR);
+    tuple.set_int (Tuple::PeakDivisor, PEAK_DIVISOR);
+
+    set_gain (Tuple::TrackGain, track.gain);
+    set_peak (Tuple::TrackPeak, track.peak);
+
+    if (have_album)
+    {
+        set_gain (Tuple::AlbumGain, album_gain);
+        set_peak (Tuple::AlbumPeak, album_peak);
+    }
+
+    if (! aud_file_write_tuple (track.filename, decoder, tuple))
+        AUDWARN ("replaygain-scanner: cannot write tags to %s.\n", (const char *) track.filename);
+}
+
+static void * worker (void *)
+{
+    pthread_mutex_lock (& mutex);
+
+    while (next_track < tracks.len () && ! cancel.load ())
+    {
+        int t = next_track ++;
+        String filename = tracks[t].filename;
+
+        Measured measured;
+        Measured * earlier = journal.lookup (filename);
+        bool ok;
+
+        if (earlier)
+        {
+            measured = std::move (* earlier);
+            journal.remove (filename);
+            ok = true;
+        }
+        else
+        {
+            pthread_mutex_unlock (& mutex);
+            ok = measure_file (filename, measured);
+            pthread_mutex_lock (& mutex);
+
+            if (cancel.load ())
+                break;
+
+            if (ok)
+                journal_add (filename, measured);
+        }
+
+        Track & track = tracks[t];
+        Album * album = (track.album >= 0) ? & albums[track.album] : nullptr;
+
+        if (ok)
+        {
+            LoudnessMeasurement loudness;
+            loudness.reset ();
+            loudness.add_histogram (measured.hist.begin ());
+
+            float lufs = integrated (loudness);
+            if (lufs > -INFINITY)
+            {
+                track.ok = true;
+                track.gain = gain_for (lufs);
+                track.peak = measured.peak;
+            }
+
+            if (album)
+            {
+                album->loudness.add_histogram (measured.hist.begin ());
+                album->peak = aud::max (album->peak, measured.peak);
+            }
+
+            AUDDBG ("replaygain-scanner: %s: %.1f LUFS, peak %.6f.\n",
+             (const char *) filename, lufs, measured.peak);
+        }
+        else
+        {
+            AUDWARN ("replaygain-scanner: could not decode %s.\n", (const char *) filename);
+            failed_tracks ++;
+        }
+
+        done_tracks ++;
+
+        /* tags are written once the whole album (or the lone track) is
+         * measured; nothing else touches the finished tracks */
+        Index<int> to_write;
+        bool have_album = false;
+        float album_gain = 0, album_peak = 0;
+
+        if (album)
+        {
+            if (! -- album->remaining)
+            {
+                for (int i = 0; i < tracks.len (); i ++)
+                {
+                    if (tracks[i].album == track.album && tracks[i].ok)
+                        to_write.append (i);
+                }
+
+                float lufs = integrated (album->loudness);
+                if (lufs > -INFINITY)
+                {
+                    have_album = true;
+                    album_gain = gain_for (lufs);
+                    album_peak = album->peak;
+                }
+            }
+        }
+        else if (track.ok)
+            to_write.append (t);
+
+        if (to_write.len ())
+        {
+            pthread_mutex_unlock (& mutex);
+
+            for (int i : to_write)
+                write_tags (tracks[i], have_album, album_gain, album_peak);
+
+            pthread_mutex_lock (& mutex);
+        }
+    }
+
+    workers --;
+    pthread_cond_broadcast (& cond);
+    pthread_mutex_unlock (& mutex);
+
+    return nullptr;
+}
+
+/* runs in the main thread; the progress window is the interface's own */
+static void update_progress (void *)
+{
+    pthread_mutex_lock (& mutex);
+
+    if (workers)
+    {
+        StringBuf count = str_printf (_("%d of %d files"), done_tracks, tracks.len ());
+        pthread_mutex_unlock (& mutex);
+
+        hook_call ("ui show progress", (void *) _("Scanning ReplayGain ..."));
+        hook_call ("ui show progress 2", (void *) (const char *) count);
+        return;
+    }
+
+    bool complete = ! cancel.load ();
+    int failed = failed_tracks;
+    int total = tracks.len ();
+
+    tracks.clear ();
+    albums.clear ();
+    journal.clear ();
+    scanning = false;
+
+    pthread_mutex_unlock (& mutex);
+
+    progress_timer.stop ();
+    hook_call ("ui hide progress", nullptr);
+
+    if (complete)
+    {
+        remove (journal_path ());
+
+        if (failed)
+            aud_ui_show_error (str_printf (_("ReplayGain Scanner: %d of %d files "
+             "could not be decoded."), failed, total));
+    }
+}
+
+/* album artist (or artist) and album, so that albums of the same name by
+ * different artists are kept apart */
+static StringBuf album_key (const Tuple & tuple)
+{
+    String album = tuple.get_str (Tuple::Album);
+    if (! album || ! album[0])
+        return StringBuf ();
+
+    String artist = tuple.get_str (Tuple::AlbumArtist);
+    if (! artist || ! artist[0])
+        artist = tuple.get_str (Tuple::Artist);
+
+    return str_concat ({artist ? (const char *) artist : "", "\n", album});
+}
+
+static void start_scan ()
+{
+    pthread_mutex_lock (& mutex);
+
+    if (scanning)
+    {
+        pthread_mutex_unlock (& mutex);
+        aud_ui_show_error (_("A ReplayGain scan is already running."));
+        return;
+    }
+
+    int playlist = aud_playlist_get_active ();
+    int entry_count = aud_playlist_entry_count (playlist);
+    bool by_album = aud_get_bool ("replaygain_scanner", "album_gain");
+    SimpleHash<String, int> album_index;
+
+    for (int i = 0; i < entry_count; i ++)
+    {
+        if (! aud_playlist_entry_get_selected (playlist, i))
+            continue;
+
+        String filename = aud_playlist_entry_get_filename (playlist, i);
+
+        /* streams never end, and the gain of a whole file is not that of
+         * one of its subtunes (such as a track of a cue sheet) */
+        const char * sub;
+        uri_parse (filename, nullptr, nullptr, & sub, nullptr);
+
+        if (strncmp (filename, "file://", 7) || sub[0])
+        {
+            AUDINFO ("replaygain-scanner: skipping %s.\n", (const char *) filename);
+            continue;
+        }
+
+        Track & track = tracks.append ();
+        track.filename = std::move (filename);
+        track.album = -1;
+
+        if (! by_album)
+            continue;
+
+        StringBuf key = album_key (aud_playlist_entry_get_tuple (playlist, i));
+        if (! key)
+            continue;
+
+        int * a = album_index.lookup (String (key));
+        if (! a)
+        {
+            Album & album = albums.append ();
+            album.loudness.reset ();
+            a = album_index.add (String (key), albums.len () - 1);
+        }
+
+        track.album = * a;
+        albums[* a].remaining ++;
+    }
+
+    if (! tracks.len ())
+    {
+        pthread_mutex_unlock (& mutex);
+        return;
+    }
+
+    load_journal ();
+
+    next_track = done_tracks = failed_tracks = 0;
+    cancel.store (false);
+    scanning = true;
+
+    int max_workers = aud::min (aud::clamp ((int) std::thread::hardware_concurrency () / 2,
+     1, MAX_SCAN_THREADS), tracks.len ());
+
+    /* workers exit once every file has been taken */
+    while (workers < max_workers)
+    {
+        pthread_t thread;
+        if (pthread_create (& thread, nullptr, worker, nullptr))
+            break;
+
+        pthread_detach (thread);
+        workers ++;
+    }
+
+    AUDINFO ("replaygain-scanner: scanning %d files on %d threads.\n", tracks.len (), workers);
+    pthread_mutex_unlock (& mutex);
+
+    progress_timer.start (PROGRESS_MS, update_progress, nullptr);
+    update_progress (nullptr);
+}
+
+/* files finished so far stay in the journal, and are not decoded again
+ * when the same entries are scanned next time */
+static void cancel_scan ()
+{
+    pthread_mutex_lock (& mutex);
+
+    cancel.store (true);
+
+    while (workers)
+        pthread_cond_wait (& cond, & mutex);
+
+    pthread_mutex_unlock (& mutex);
+
+    if (progress_timer.running ())
+        update_progress (nullptr);
+}
+
+const char ReplayGainScanner::about[] =
+ N_("ReplayGain Scanner Plugin for Fauxdacious\n\n"
+    "Measures the loudness of the selected files as specified by EBU R128 "
+    "and saves ReplayGain track and album gain and peak values to their "
+    "tags (for the formats whose tags can be written).  Tracks are grouped "
+    "into albums by album and album artist.  Only local files are scanned; "
+    "streams and subtunes (such as the tracks of a cue sheet) are skipped.\n\n"
+    "A cancelled scan is picked up where it left off the next time the same "
+    "files are scanned.");
+
+const char * const ReplayGainScanner::defaults[] = {
+ "reference", "-18",
+ "album_gain", "TRUE",
+ nullptr};
+
+bool ReplayGainScanner::init ()
+{
+    aud_config_set_defaults ("replaygain_scanner", defaults);
+
+#if ! CHECK_LIBAVFORMAT_VERSION (58, 9, 100, 255, 255, 255)
+    av_register_all ();
+#endif
+
+    for (AudMenuID menu : menus)
+    {
+        aud_plugin_menu_add (menu, start_scan, _("Scan ReplayGain"), "audio-volume-high");
+        aud_plugin_menu_add (menu, cancel_scan, _("Cancel ReplayGain Scan"), "process-stop");
+    }
+
+    return true;
+}
+
+void ReplayGainScanner::cleanup ()
+{
+    for (AudMenuID menu : menus)
+    {
+        aud_plugin_menu_remove (menu, start_scan);
+        aud_plugin_menu_remove (menu, cancel_scan);
+    }
+
+    cancel_scan ();
+}
+
+const PreferencesWidget ReplayGainScanner::widgets[] = {
+    WidgetLabel (N_("<b>ReplayGain Scanner</b>")),
+    WidgetSpin (N_("Reference loudness:"),
+        WidgetInt ("replaygain_scanner", "reference"),
+        {-30, -5, 1, N_("LUFS")}),
+    WidgetCheck (N_("Save album gain (by album and album artist)"),
+        WidgetBool ("replaygain_scanner", "album_gain"))
+};
+
+const PluginPreferences ReplayGainScanner::prefs = {{widgets}};
@@ -7,9 +7,6 @@
  * It is licensed under the GNU General Public License, version 3.
  */
 
-//external includes
-#include <glib/gstdio.h>
-
 //fauxdacious includes
 #include <libfauxdcore/audstrings.h>
 #include <libfauxdcore/drct.h>
@@ -81,7 +78,6 @@ StringBuf clean_string (const char *string) {
 static void queue_track_to_scrobble () {
     AUDDBG("The playing track is going to be ENQUEUED!\n.");
 
-    StringBuf queue_path = str_concat({aud_get_path(AudPath::UserDir), "/scrobbler.log"});
     StringBuf artist = clean_string (playing_track.get_str (Tuple::Artist));
     StringBuf title  = clean_string (playing_track.get_str (Tuple::Title));
     StringBuf album  = clean_string (playing_track.get_str (Tuple::Album));
@@ -93,27 +89,18 @@ static void queue_track_to_scrobble () {
     if (artist[0] && title[0] && length > 0) {
         StringBuf track_str = (track > 0) ? int_to_str (track) : StringBuf (0);
 
-        pthread_mutex_lock(&log_access_mutex);
-        FILE *f = g_fopen(queue_path, "a");
-
-        if (f == nullptr) {
-            perror("fopen");
-        } else {
-            //This isn't exactly the scrobbler.log format because the header
-            //is missing, but we're sticking to it anyway...
-            //See http://www.audioscrobbler.net/wiki/Portable_Player_Logging
-            if (fprintf(f, "%s\t%s\t%s\t%s\t%i\tL\t%" G_GINT64_FORMAT "\n",
-             (const char *)artist, (const char *)album, (const char *)title,
-             (const char *)track_str, length / 1000, timestamp) < 0) {
-                perror("fprintf");
-            } else {
-                pthread_mutex_lock(&communication_mutex);
-                pthread_cond_signal(&communication_signal);
-                pthread_mutex_unlock(&communication_mutex);
-            }
-            fclose(f);
+        //This isn't exactly the scrobbler.log format because the header
+        //is missing, but we're sticking to it anyway...
+        //See http://www.audioscrobbler.net/wiki/Portable_Player_Logging
+        StringBuf line = str_printf("%s\t%s\t%s\t%s\t%i\tL\t%" G_GINT64_FORMAT,
+         (const char *)artist, (const char *)album, (const char *)title,
+         (const char *)track_str, length / 1000, timestamp);
+
+        if (journal_append(line)) {
+            pthread_mutex_lock(&communication_mutex);
+            pthread_cond_signal(&communication_signal);
+            pthread_mutex_unlock(&communication_mutex);
         }
-        pthread_mutex_unlock(&log_access_mutex);
     }
 
     cleanup_current_track();
@@ -19,6 +19,7 @@
 
 //fauxdacious includes
 #include <libfauxdcore/i18n.h>
+#include <libfauxdcore/index.h>
 #include <libfauxdcore/mainloop.h>
 #include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
@@ -80,6 +81,20 @@ extern gboolean read_authentication_test_result(String &error_code, String &erro
 extern gboolean read_token(String &error_code, String &error_detail);
 extern gboolean read_session_key(String &error_code, String &error_detail);
 extern gboolean read_scrobble_result(String &error_code, String &error_detail, gboolean *ignored, String &ignored_code);
+extern gboolean read_scrobble_batch_result(String &error_code, String &error_detail, int count, Index<int> &ignored_codes);
+
+//scrobbler_journal.cc
+struct JournalEntry {
+    String line;
+    int64_t end;    //offset just after this line
+};
+
+//reads up to max of the lines not yet dealt with
+extern bool journal_read(Index<JournalEntry> &entries, int max);
+//marks everything up to offset as dealt with
+extern void journal_ack(int64_t offset);
+extern bool journal_append(const char *line);
+extern void journal_compact();
 
 //scrobbler.c
 extern StringBuf clean_string(const char *string);
@@ -27,7 +27,20 @@ typedef struct {
     String argument;
 } API_Parameter;
 
-static CURL *curlHandle = nullptr;     //global handle holding cURL options
+//global handle holding cURL options; it is kept for all requests, so that
+//the connection to last.fm is reused
+static CURL *curlHandle = nullptr;
+
+//up to this many tracks are sent per track.scrobble request (the API maximum)
+#define SCROBBLE_BATCH 50
+
+//how long to wait before retrying after a failed request: this doubles
+//with each failure in a row, up to the maximum
+#define RETRY_DELAY_MIN 7
+#define RETRY_DELAY_MAX (30 * 60)
+
+static int retry_delay = RETRY_DELAY_MIN;
+static gboolean retry_requested = false;
 
 gboolean scrobbling_enabled = true;
 
@@ -82,32 +95,22 @@ static char * scrobbler_get_signature (Index<API_Parameter> & params)
  *
  * Returns nullptr if an error occurrs
  */
-static String create_message_to_lastfm (const char * method_name, int n_args, ...)
+static String create_message_from_params (const char * method_name,
+ Index<API_Parameter> & params)
 {
-    Index<API_Parameter> params;
-    params.append (String ("method"), String (method_name));
-
     StringBuf buf = str_concat ({"method=", method_name});
 
-    va_list vl;
-    va_start (vl, n_args);
-
-    for (int i = 0; i < n_args; i ++)
+    for (const API_Parameter & param : params)
     {
-        const char * name = va_arg (vl, const char *);
-        const char * arg = va_arg (vl, const char *);
-
-        params.append (String (name), String (arg));
-
-        char * esc = curl_easy_escape (curlHandle, arg, 0);
+        char * esc = curl_easy_escape (curlHandle, param.argument, 0);
         buf.insert (-1, "&");
-        buf.insert (-1, name);
+        buf.insert (-1, param.paramName);
         buf.insert (-1, "=");
         buf.insert (-1, esc ? esc : "");
         curl_free (esc);
     }
 
-    va_end (vl);
+    params.append (String ("method"), String (method_name));
 
     char * api_sig = scrobbler_get_signature (params);
     buf.insert (-1, "&api_sig=");
@@ -119,6 +122,26 @@ static String create_message_to_lastfm (const char * method_name, int n_args, ..
     return String (buf);
 }
 
+static String create_message_to_lastfm (const char * method_name, int n_args, ...)
+{
+    Index<API_Parameter> params;
+
+    va_list vl;
+    va_start (vl, n_args);
+
+    for (int i = 0; i < n_args; i ++)
+    {
+        const char * name = va_arg (vl, const char *);
+        const char * arg = va_arg (vl, const char *);
+
+        params.append (String (name), String (arg));
+    }
+
+    va_end (vl);
+
+    return create_message_from_params (method_name, params);
+}
+
 static gboolean send_message_to_lastfm (const char * data)
 {
     AUDDBG("This message will be sent to last.fm:\n%s\n%%%%End of message%%%%\n", data);//Enter?\n", data);
@@ -269,7 +292,9 @@ gboolean scrobbler_communication_init() {
         return false;
     }
 
-    curl_requests_result = curl_easy_setopt(curlHandle, CURLOPT_URL, SCROBBLER_URL);
+    //the URL can be pointed elsewhere (e.g. at a local stand-in for testing)
+    String url = aud_get_str("scrobbler", "api_url");
+    curl_requests_result = curl_easy_setopt(curlHandle, CURLOPT_URL, url[0] ? (const char *) url : SCROBBLER_URL);
     if (curl_requests_result != CURLE_OK) {
         AUDDBG("Could not define scrobbler destination URL: %s.\n", curl_easy_strerror(curl_requests_result));
         return false;
@@ -281,200 +306,153 @@ gboolean scrobbler_communication_init() {
         return false;
     }
 
+    //without a timeout, a stalled connection would hold up scrobbling forever
+    curl_easy_setopt(curlHandle, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curlHandle, CURLOPT_TIMEOUT, 120L);
+    curl_easy_setopt(curlHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curlHandle, CURLOPT_ACCEPT_ENCODING, "");
+
     return true;
 }
 
-static void set_timestamp_to_current(char **line) {
-    //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
-    //artist  album   title   number  length  "L"     timestamp nullptr
-
-    char **split_line = g_strsplit(*line, "\t", 0);
-    g_free(split_line[6]);
-    split_line[6] = g_strdup_printf("%" G_GINT64_FORMAT, g_get_real_time() / G_USEC_PER_SEC);
-    AUDDBG("split line's timestamp is now: %s.\n", split_line[6]);
-    g_free(*line);
-    (*line) = g_strjoinv("\t", split_line);
-    g_strfreev(split_line);
+//line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
+//artist  album   title   number  length  "L"     timestamp nullptr
+static bool is_scrobblable(char **line) {
+    return line[0] && line[1] && line[2] && line[3] && line[4] && line[5] &&
+     strcmp(line[5], "L") == 0 && line[6] && line[7] == nullptr;
 }
 
-static void delete_lines_from_scrobble_log (GSList **lines_to_remove_ptr, GSList **lines_to_retry_ptr, char *queuepath) {
-    GSList *lines_to_remove = *lines_to_remove_ptr;
-    GSList *lines_to_retry = *lines_to_retry_ptr;
-    char *contents = nullptr;
-    char **lines = nullptr;
-    char **finallines = g_new (char *, 1);
-    int n_finallines;
+//queues a track again with the current time, for scrobbles ignored because
+//their timestamp was too old
+static void requeue_with_current_time(char **line) {
+    char *timestamp = g_strdup_printf("%" G_GINT64_FORMAT, g_get_real_time() / G_USEC_PER_SEC);
+    char *old_timestamp = line[6];
 
-    if (lines_to_remove != nullptr) {
-        lines_to_remove = g_slist_reverse(lines_to_remove);
-    }
-    if (lines_to_retry != nullptr) {
-        lines_to_retry = g_slist_reverse(lines_to_retry);
-    }
+    line[6] = timestamp;
+    char *joined = g_strjoinv("\t", line);
+    line[6] = old_timestamp;
 
-    pthread_mutex_lock(&log_access_mutex);
+    AUDDBG("Queueing again: %s.\n", joined);
+    journal_append(joined);
 
-    gboolean success = g_file_get_contents(queuepath, &contents, nullptr, nullptr);
-    if (!success) {
-        AUDDBG("Could not read scrobbler.log contents.\n");
-    } else {
-        lines = g_strsplit(contents, "\n", 0);
+    g_free(joined);
+    g_free(timestamp);
+}
 
-        n_finallines = 0;
-        for (int i = 0 ; lines[i] != nullptr && strlen(lines[i]) > 0; i++) {
-            if (lines_to_remove != nullptr && *((int *) (lines_to_remove->data)) == i) {
-                //this line is to remove
-                lines_to_remove = g_slist_next(lines_to_remove);
-            } else {
-                //keep this line
-                AUDDBG("Going to keep line %i\n", i);
-                if (lines_to_retry != nullptr && *((int *) (lines_to_retry->data)) == i) {
-                    lines_to_retry = g_slist_next(lines_to_retry);
-                    //this line will be retried with a zero timestamp
-                    AUDDBG("Going to zero this line.\n");
-                    AUDDBG("Line before: %s.\n", lines[i]);
-                    set_timestamp_to_current(&(lines[i]));
-                    AUDDBG("Line after: %s.\n", lines[i]);
-                } else
-                    AUDDBG("not zeroing this line\n");
-
-                n_finallines++;
-                finallines = g_renew (char *, finallines, n_finallines);
-                finallines[n_finallines-1] = g_strdup(lines[i]);
+static void retry_later() {
+    retry_requested = true;
+}
+
+/*
+ * Submits the queued tracks in batches.  Each batch is marked as dealt with
+ * in the journal once last.fm has answered for it.  Returns when the queue is
+ * empty, or when it cannot be submitted right now.
+ */
+static void scrobble_cached_queue() {
+    Index<JournalEntry> entries;
+    int batch_size = SCROBBLE_BATCH;
+    int singles_left = 0;
+
+    while (scrobbling_enabled && journal_read(entries, batch_size) && entries.len()) {
+        Index<API_Parameter> params;
+        Index<char **> lines;   //the lines sent, in order
+
+        for (const JournalEntry &entry : entries) {
+            char **line = g_strsplit(entry.line, "\t", 0);
+
+            if (!is_scrobblable(line)) {
+                AUDDBG("Unscrobbable line: %s.\n", (const char *)entry.line);
+                g_strfreev(line);
+                continue;
             }
-        }
 
-        finallines = g_renew (char *, finallines, n_finallines + 2);
-        finallines[n_finallines] = g_strdup("");
-        finallines[n_finallines+1] = nullptr;
-        g_free(contents);
-        contents = g_strjoinv("\n", finallines);
-        success = g_file_set_contents(queuepath, contents, -1, nullptr);
-        if (!success) {
-            AUDERR("Could not write to scrobbler.log!\n");
+            int i = lines.len();
+            params.append(String(str_printf("artist[%d]", i)), String(line[0]));
+            params.append(String(str_printf("album[%d]", i)), String(line[1]));
+            params.append(String(str_printf("track[%d]", i)), String(line[2]));
+            params.append(String(str_printf("trackNumber[%d]", i)), String(line[3]));
+            params.append(String(str_printf("duration[%d]", i)), String(line[4]));
+            params.append(String(str_printf("timestamp[%d]", i)), String(line[6]));
+            lines.append(line);
         }
-    }
 
-    pthread_mutex_unlock(&log_access_mutex);
+        int64_t batch_end = entries[entries.len() - 1].end;
+        bool done = true;   //true once the batch has been dealt with
+        bool split = false; //true to send the same tracks again, one by one
 
-    g_strfreev(finallines);
-    g_strfreev(lines);
-    g_free(contents);
-}
+        if (lines.len()) {
+            params.append(String("api_key"), String(SCROBBLER_API_KEY));
+            params.append(String("sk"), session_key);
 
-static void save_line_to_remove(GSList **lines_to_remove, int linenumber) {
-    int *rem = g_new (int, 1);
-    *rem = linenumber;
-    (*lines_to_remove) = g_slist_prepend((*lines_to_remove), rem);
-}
+            String scrobblemsg = create_message_from_params("track.scrobble", params);
 
-static void scrobble_cached_queue() {
-    char *queuepath = g_build_filename(aud_get_path(AudPath::UserDir),"scrobbler.log", nullptr);
-    char *contents = nullptr;
-    gboolean success;
-    char **lines = nullptr;
-    char **line;
-    GSList *lines_to_remove = nullptr; //lines to remove because they were scrobbled (or ignored, and will not be retried)
-    GSList *lines_to_retry = nullptr; //lines to retry later because they were too old TODO: or "daily scrobble limit reached"
-
-    pthread_mutex_lock(&log_access_mutex);
-    success = g_file_get_contents(queuepath, &contents, nullptr, nullptr);
-    pthread_mutex_unlock(&log_access_mutex);
-
-    if (!success)
-        AUDDBG("Couldn't access the queue file.\n");
-    else {
-        lines = g_strsplit(contents, "\n", 0);
-
-        for (int i = 0; lines[i] != nullptr && strlen(lines[i]) > 0 && scrobbling_enabled; i++) {
-            line = g_strsplit(lines[i], "\t", 0);
-
-            //line[0] line[1] line[2] line[3] line[4] line[5] line[6]   line[7]
-            //artist  album   title   number  length  "L"     timestamp nullptr
-
-            if (line[0] && line[2] && (strcmp(line[5], "L") == 0) && line[6] && (line[7] == nullptr))
-            {
-                String scrobblemsg = create_message_to_lastfm ("track.scrobble",
-                 8, "artist", line[0], "album", line[1], "track", line[2],
-                 "trackNumber", line[3], "duration", line[4],
-                 "timestamp", line[6], "api_key", SCROBBLER_API_KEY,
-                 "sk", (const char *) session_key);
-
-                if (send_message_to_lastfm(scrobblemsg) == true) {
-                    String error_code;
-                    String error_detail;
-                    gboolean ignored = false;
-                    String ignored_code;
-
-                    if (read_scrobble_result(error_code, error_detail, &ignored, ignored_code) == true) {
-                        AUDDBG("SCROBBLE OK. Error code: %s. Error detail: %s\n",
-                         (const char *)error_code, (const char *)error_detail);
-                        AUDDBG("SCROBBLE OK. ignored: %i.\n", ignored);
-                        AUDDBG("SCROBBLE OK. ignored code: %s.\n",
-                         (const char *)ignored_code);
-                        if (ignored == true && g_strcmp0(ignored_code, "3") == 0) { //3: Timestamp was too old
-                            AUDDBG("SCROBBLE IGNORED!!! %i, detail: %s\n",
-                             ignored, (const char *)ignored_code);
-                            save_line_to_remove(&lines_to_retry, i);
-                        } else if (ignored == true && g_strcmp0(ignored_code, "") == 0) { //5: Daily scrobble limit reached
-                           //TODO: a track might not be scrobbled due to "daily scrobble limit exeeded".
-                           //This message comes on the ignoredMessage attribute, inside the XML of the response.
-                           //We are not dealing with this case currently and are losing that scrobble.
-                           //END TODO
-                        } else {
-                            AUDDBG("Not ignored. Carrying on...\n");
-                            save_line_to_remove(&lines_to_remove, i);
-                        }
-                    } else {
-                        AUDINFO("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n",
-                         (const char *)error_code, (const char *)error_detail);
-
-                        if (! error_code) { //net error(?) or the answer from last.fm was not well read
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code, "11") == 0 ||
-                                 g_strcmp0(error_code, "16") == 0){
-                            //error code 11: Service Offline - This service is temporarily offline. Try again later.
-                            //error code 16: The service is temporarily unavailable, please try again.
-                            //scrobble to be retried
-                        }
-                        else if (g_strcmp0(error_code,  "9") == 0) {
-                            //Bad Session. Reauth.
-                            scrobbling_enabled = false;
-                            session_key = String();
-                            aud_set_str("scrobbler", "session_key", "");
-                        }
-                        else
-                            save_line_to_remove(&lines_to_remove, i);
+            if (send_message_to_lastfm(scrobblemsg) == false) {
+                AUDDBG("Could not scrobble the queued tracks. Network problem?\n");
+                //to be retried
+                scrobbling_enabled = false;
+                done = false;
+            } else {
+                String error_code;
+                String error_detail;
+                Index<int> ignored_codes;
+
+                if (read_scrobble_batch_result(error_code, error_detail, lines.len(), ignored_codes) == true) {
+                    AUDDBG("SCROBBLE OK: %d tracks.\n", lines.len());
+                    retry_delay = RETRY_DELAY_MIN;
+
+                    for (int i = 0; i < lines.len(); i++) {
+                        if (ignored_codes[i] == 3) //3: Timestamp was too old
+                            requeue_with_current_time(lines[i]);
+                        else if (ignored_codes[i])
+                            AUDDBG("SCROBBLE IGNORED, code %d: %s.\n", ignored_codes[i], lines[i][2]);
                     }
                 } else {
-                    AUDDBG("Could not scrobble a track on the queue. Network problem?\n");
-                    //scrobble to be retried
-                    scrobbling_enabled = false;
+                    AUDINFO("SCROBBLE NOT OK. Error code: %s. Error detail: %s.\n",
+                     (const char *)error_code, (const char *)error_detail);
+
+                    if (! error_code ||                     //net error(?) or the answer from last.fm was not well read
+                        g_strcmp0(error_code, "11") == 0 || //Service Offline - This service is temporarily offline. Try again later.
+                        g_strcmp0(error_code, "16") == 0 || //The service is temporarily unavailable, please try again.
+                        g_strcmp0(error_code, "29") == 0) { //Rate limit exceeded
+                        retry_later();
+                        done = false;
+                    }
+                    else if (g_strcmp0(error_code,  "9") == 0) {
+                        //Bad Session. Reauth.
+                        scrobbling_enabled = false;
+                        session_key = String();
+                        aud_set_str("scrobbler", "session_key", "");
+                        done = false;
+                    }
+                    else if (lines.len() > 1) {
+                        //something in the batch was refused: send its tracks
+                        //one by one, so that only the culprit is dropped
+                        batch_size = 1;
+                        singles_left = entries.len();
+                        split = true;
+                    }
+                    //else a single track that was refused: drop it
                 }
-
-                //TODO: Avoid spamming last.fm --- It's not as simple as just adding a wait here:
-                //If audacious is closed while we're on this loop, tracks might be re-scrobbled.
-                //This shall be doable if we only pick one track at a time from the scrobbler.log
-            } else {
-                AUDDBG("Unscrobbable line.\n");
-                //leave entry on the cache file
             }
+        }
+
+        for (char **line : lines)
             g_strfreev(line);
-        } //for
 
-        delete_lines_from_scrobble_log(&lines_to_remove, &lines_to_retry, queuepath);
+        //nothing acknowledged: the next read starts with the first of them
+        if (split)
+            continue;
+
+        if (!done)
+            break;
 
-        if (lines_to_remove != nullptr)
-            g_slist_free_full(lines_to_remove, g_free);
-        if (lines_to_retry != nullptr)
-            g_slist_free_full(lines_to_retry, g_free);
+        journal_ack(batch_end);
 
-        g_strfreev(lines);
+        if (singles_left > 0 && --singles_left == 0)
+            batch_size = SCROBBLE_BATCH;
     }
 
-    g_free(contents);
-    g_free(queuepath);
+    journal_compact();
 }
 
 static void send_now_playing() {
@@ -605,25 +583,30 @@ void * scrobbling_thread (void * input_data) {
             //scrobbling may be disabled at this point if communication errors occur
 
             pthread_mutex_lock(&communication_mutex);
-            if (scrobbling_enabled) {
+            if (scrobbling_enabled && !retry_requested) {
                 pthread_cond_wait(&communication_signal, &communication_mutex);
                 pthread_mutex_unlock(&communication_mutex);
             }
             else {
                 //We don't want to wait until receiving a signal to retry
                 //if submitting the cache failed due to network problems
+                //or because last.fm asked us to come back later
                 pthread_mutex_unlock(&communication_mutex);
 
-                if (scrobbler_test_connection() == false || !scrobbling_enabled) {
+                if (retry_requested || scrobbler_test_connection() == false || !scrobbling_enabled) {
                     struct timeval curtime;
                     struct timespec timeout;
                     pthread_mutex_lock(&communication_mutex);
                     gettimeofday(&curtime, nullptr);
-                    timeout.tv_sec = curtime.tv_sec + 7;
+                    timeout.tv_sec = curtime.tv_sec + retry_delay;
                     timeout.tv_nsec = curtime.tv_usec * 1000;
                     pthread_cond_timedwait(&communication_signal, &communication_mutex, &timeout);
                     pthread_mutex_unlock(&communication_mutex);
+
+                    retry_delay = aud::min(retry_delay * 2, RETRY_DELAY_MAX);
                 }
+
+                retry_requested = false;
             }
         }
     } //while(scrobbler_running)
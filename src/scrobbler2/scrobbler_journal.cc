@@ -0,0 +1,226 @@
+/*
+ * Scrobbler Plugin v2.0 for Audacious by Pitxyoki
+ *
+ * Copyright 2012-2013 Luís Picciochi Oliveira <Pitxyoki@Gmail.com>
+ *
+ * This plugin is part of the Audacious Media Player.
+ * It is licensed under the GNU General Public License, version 3.
+ */
+
+/*
+ * The queue of tracks to scrobble (scrobbler.log) is a journal: lines are
+ * only ever appended to it, and a small index file (scrobbler.log.idx)
+ * records how far it has been dealt with, i.e. submitted or dropped.  If we
+ * are interrupted, at worst the last batch is submitted again.
+ *
+ * Once most of the journal has been dealt with, the rest is copied into a
+ * new one, which starts with a header line carrying a new generation number.
+ * An index written before that no longer matches the journal and is ignored,
+ * so the compaction is safe at any point.
+ */
+
+//external includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib/gstdio.h>
+
+//fauxdacious includes
+#include <libfauxdcore/audstrings.h>
+
+//plugin includes
+#include "scrobbler.h"
+
+#define JOURNAL_HEADER "#FAUXDACIOUS-JOURNAL "
+
+//don't bother compacting less than this
+#define COMPACT_MIN_BYTES (64 * 1024)
+
+static StringBuf journal_path () {
+    return filename_build({aud_get_path(AudPath::UserDir), "scrobbler.log"});
+}
+
+static StringBuf index_path () {
+    return filename_build({aud_get_path(AudPath::UserDir), "scrobbler.log.idx"});
+}
+
+//reads the generation from the header line, if there is one;
+//returns the length of the header
+static int64_t read_header (FILE *f, int &generation) {
+    char buf[64];
+    generation = 0;
+
+    if (!fgets(buf, sizeof buf, f) || strncmp(buf, JOURNAL_HEADER, strlen(JOURNAL_HEADER))) {
+        fseek(f, 0, SEEK_SET);
+        return 0;
+    }
+
+    generation = atoi(buf + strlen(JOURNAL_HEADER));
+    return ftell(f);
+}
+
+static void read_index (int &generation, int64_t &offset) {
+    char *contents = nullptr;
+    long long value = 0;
+
+    generation = -1;
+    offset = 0;
+
+    if (g_file_get_contents(index_path(), &contents, nullptr, nullptr)) {
+        if (sscanf(contents, "%d %lld", &generation, &value) == 2)
+            offset = value;
+        else
+            generation = -1;
+    }
+
+    g_free(contents);
+}
+
+static void write_index (int generation, int64_t offset) {
+    StringBuf contents = str_printf("%d %lld\n", generation, (long long) offset);
+
+    if (!g_file_set_contents(index_path(), contents, -1, nullptr))
+        AUDERR("Could not write to scrobbler.log.idx!\n");
+}
+
+//opens the journal, positioned at the first line not yet dealt with;
+//must be called with log_access_mutex held
+static FILE *open_journal (int &generation, int64_t &start, int64_t &size) {
+    FILE *f = g_fopen(journal_path(), "rb");
+    if (!f)
+        return nullptr;
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    int64_t header = read_header(f, generation);
+
+    int index_generation;
+    read_index(index_generation, start);
+
+    //no index, or a stale one (from before a compaction or a deleted log)
+    if (index_generation != generation || start < header || start > size)
+        start = header;
+
+    fseek(f, start, SEEK_SET);
+    return f;
+}
+
+//reads a line, including the newline; returns false at the end of the file
+//or if the last line is incomplete
+static bool read_line (FILE *f, StringBuf &line) {
+    char buf[1024];
+    line.resize(0);
+
+    while (fgets(buf, sizeof buf, f)) {
+        line.insert(-1, buf);
+        if (line[line.len() - 1] == '\n')
+            return true;
+    }
+
+    return false;
+}
+
+bool journal_read (Index<JournalEntry> &entries, int max) {
+    entries.clear();
+
+    pthread_mutex_lock(&log_access_mutex);
+
+    int generation;
+    int64_t offset, size;
+    FILE *f = open_journal(generation, offset, size);
+
+    if (!f) {
+        pthread_mutex_unlock(&log_access_mutex);
+        return false;
+    }
+
+    StringBuf line(0);
+
+    while (entries.len() < max && read_line(f, line)) {
+        offset += line.len();
+        line.resize(line.len() - 1);
+
+        JournalEntry &entry = entries.append();
+        entry.line = String(line);
+        entry.end = offset;
+    }
+
+    fclose(f);
+    pthread_mutex_unlock(&log_access_mutex);
+
+    return true;
+}
+
+void journal_ack (int64_t offset) {
+    pthread_mutex_lock(&log_access_mutex);
+
+    FILE *f = g_fopen(journal_path(), "rb");
+    if (f) {
+        int generation;
+        read_header(f, generation);
+        fclose(f);
+
+        write_index(generation, offset);
+    }
+
+    pthread_mutex_unlock(&log_access_mutex);
+}
+
+bool journal_append (const char *line) {
+    bool success = true;
+
+    pthread_mutex_lock(&log_access_mutex);
+
+    FILE *f = g_fopen(journal_path(), "ab");
+    if (!f) {
+        perror("fopen");
+        success = false;
+    } else {
+        if (fprintf(f, "%s\n", line) < 0) {
+            perror("fprintf");
+            success = false;
+        }
+        fclose(f);
+    }
+
+    pthread_mutex_unlock(&log_access_mutex);
+    return success;
+}
+
+void journal_compact () {
+    pthread_mutex_lock(&log_access_mutex);
+
+    int generation;
+    int64_t offset, size;
+    FILE *f = open_journal(generation, offset, size);
+
+    //worth it once at least half of the journal has been dealt with
+    if (!f || offset < COMPACT_MIN_BYTES || offset * 2 < size) {
+        if (f)
+            fclose(f);
+        pthread_mutex_unlock(&log_access_mutex);
+        return;
+    }
+
+    StringBuf header = str_printf(JOURNAL_HEADER "%d\n", generation + 1);
+    int64_t rest = size - offset;
+
+    char *contents = g_new(char, header.len() + rest);
+    memcpy(contents, header, header.len());
+
+    if (fread(contents + header.len(), 1, rest, f) != (size_t) rest) {
+        AUDERR("Could not read scrobbler.log contents.\n");
+    }
+    //the new header makes the old index stale, so it does not matter if we
+    //are interrupted before the new index is written
+    else if (g_file_set_contents(journal_path(), contents, header.len() + rest, nullptr)) {
+        write_index(generation + 1, header.len());
+        AUDDBG("Compacted scrobbler.log: %lld bytes dropped.\n", (long long) offset);
+    } else
+        AUDERR("Could not write to scrobbler.log!\n");
+
+    g_free(contents);
+    fclose(f);
+    pthread_mutex_unlock(&log_access_mutex);
+}
@@ -7,6 +7,12 @@
  * It is licensed under the GNU General Public License, version 3.
  */
 
+//external includes
+#include <stdlib.h>
+
+//fauxdacious includes
+#include <libfauxdcore/audstrings.h>
+
 //plugin includes
 #include "scrobbler.h"
 
@@ -187,6 +193,45 @@ gboolean read_scrobble_result(String &error_code, String &error_detail,
     return result;
 }
 
+/*
+ * Like read_scrobble_result(), for a track.scrobble request of count tracks.
+ * On success, ignored_codes holds the ignoredMessage code of each track in
+ * the order sent, 0 if it was accepted.
+ */
+gboolean read_scrobble_batch_result(String &error_code, String &error_detail,
+        int count, Index<int> &ignored_codes) {
+    ignored_codes.clear();
+
+    if (!prepare_data()) {
+        AUDDBG("Could not read received data from last.fm. What's up?\n");
+        return false;
+    }
+
+    String status = check_status(error_code, error_detail);
+
+    if (!status) {
+        AUDDBG("Status was nullptr. Invalid API answer.\n");
+        clean_data();
+        return false;
+    }
+
+    if (!strcmp(status, "failed")) {
+        AUDDBG("Error code: %s. Detail: %s.\n", (const char *)error_code,
+                (const char *)error_detail);
+        clean_data();
+        return false;
+    }
+
+    for (int i = 1; i <= count; i++) {
+        StringBuf path = str_printf("/lfm/scrobbles/scrobble[%d]/ignoredMessage[@code]", i);
+        String code = get_attribute_value(path, "code");
+        ignored_codes.append(code ? atoi(code) : 0);
+    }
+
+    clean_data();
+    return true;
+}
+
 //returns
 //FALSE if there was an error with the connection
 gboolean read_authentication_test_result (String &error_code, String &error_detail) {
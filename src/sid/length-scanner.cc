@@ -0,0 +1 @@
+#include "../ui-common/length-scanner.cc"
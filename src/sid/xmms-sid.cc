@@ -30,6 +30,8 @@
 #include <libfauxdcore/plugin.h>
 #include <libfauxdcore/runtime.h>
 
+#include "../ui-common/length-scanner.h"
+
 #include "xs_config.h"
 #include "xs_sidplay2.h"
 
@@ -51,11 +53,7 @@ public:
         .with_mimes(mimes)
         .with_exts(exts)) {}
 
-    bool init()
-    {
-        xs_init_configuration();
-        return true;
-    }
+    bool init();
 
     void cleanup();
 
@@ -76,9 +74,20 @@ static void xs_get_song_tuple_info(Tuple &pResult, const xs_tuneinfo_t &info, in
 
 static pthread_mutex_t s_init_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static int xs_scan_length(const char *filename, const Index<char> &data, int subTune);
+
+static LengthScanner s_length_scanner("sid", xs_scan_length);
+
 /*
  * Initialization functions
  */
+bool SIDPlugin::init()
+{
+    xs_init_configuration();
+    s_length_scanner.init();
+    return true;
+}
+
 bool SIDPlugin::delayed_init()
 {
     pthread_mutex_lock(&s_init_mutex);
@@ -101,6 +110,9 @@ bool SIDPlugin::delayed_init()
  */
 void SIDPlugin::cleanup()
 {
+    /* the scans use the ROMs loaded by the engine */
+    s_length_scanner.cleanup();
+
     if (m_initialized)
     {
         xs_sidplayfp_close();
@@ -111,6 +123,20 @@ void SIDPlugin::cleanup()
 }
 
 
+/*
+ * Find the length of a sub-tune missing from the song length database
+ */
+static bool xs_scan_cancelled()
+{
+    return s_length_scanner.cancelled();
+}
+
+static int xs_scan_length(const char *filename, const Index<char> &data, int subTune)
+{
+    return xs_sidplayfp_scanlength(data.begin(), data.len(), subTune, xs_scan_cancelled);
+}
+
+
 /*
  * Check whether this is a SID file
  */
@@ -154,6 +180,11 @@ bool SIDPlugin::play(const char *filename, VFSFile &file)
     if (subTune < 1 || subTune > info.nsubTunes)
         subTune = info.startTune;
 
+    /* Use the length found by an earlier scan, if any */
+    if (xs_cfg.scanLengths && info.subTunes[subTune - 1].tuneLength < 0)
+        s_length_scanner.get_length(filename, buf, subTune,
+            info.subTunes[subTune - 1].tuneLength, false);
+
     /* Check minimum playtime */
     int tmpLength = info.subTunes[subTune - 1].tuneLength;
     if (xs_cfg.playMinTimeEnable && (tmpLength >= 0)) {
@@ -273,6 +304,16 @@ bool SIDPlugin::read_tag(const char *filename, VFSFile &file, Tuple &tuple, Inde
     if (!xs_sidplayfp_getinfo(info, buf.begin(), buf.len()))
         return false;
 
+    /* Look up or start a scan for a length missing from the database; an
+     * entry that will be split into sub-tunes is not worth scanning */
+    bool split = (xs_cfg.subAutoEnable && info.nsubTunes > 1 && tune < 0);
+    int subTune = (tune < 0) ? info.startTune : tune;
+
+    if (xs_cfg.scanLengths && !split && subTune > 0 && subTune <= info.nsubTunes &&
+        info.subTunes[subTune - 1].tuneLength < 0)
+        s_length_scanner.get_length(filename, buf, subTune,
+            info.subTunes[subTune - 1].tuneLength, true);
+
     xs_get_song_tuple_info(tuple, info, tune);
 
     if (xs_cfg.subAutoEnable && info.nsubTunes > 1 && tune < 0)
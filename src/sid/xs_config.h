@@ -47,6 +47,8 @@ extern struct xs_cfg_t {
     bool    playMinTimeEnable;
     int     playMinTime;        /* MIN playtime in seconds */
 
+    bool    scanLengths;        /* Find the end of tunes missing from the database */
+
     /* Miscellaneous settings */
     bool    subAutoEnable,
             subAutoMinOnly;
@@ -48,11 +48,19 @@
 #include <libfauxdcore/runtime.h>
 #include <libfauxdcore/vfs.h>
 
+#include "../ui-common/length-scanner.h"
+
+/* Length scans are not heard, so they use a low rate and fast sampling */
+#define XS_SCAN_FREQ 22050
+
 struct SidState {
     sidplayfp *currEng;
     sidbuilder *currBuilder;
     SidTune *currTune;
 
+    /* kept for the engines used by length scans */
+    Index<char> kernal, basic, chargen;
+
     SidDatabase database;
     bool database_loaded = false;
     pthread_mutex_t database_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -72,19 +80,17 @@ bool xs_sidplayfp_probe(const void *buf, int64_t bufSize)
 }
 
 
-/* Initialize SIDPlayFP
+/* Configure an engine and its builder from the current settings
  */
-bool xs_sidplayfp_init()
+static bool xs_sidplayfp_configure(sidplayfp *engine, sidbuilder *builder,
+    int frequency, int channels, bool fast)
 {
-    /* Initialize the engine */
-    state.currEng = new sidplayfp;
-
     /* Get current configuration */
-    SidConfig config = state.currEng->config();
+    SidConfig config = engine->config();
 
 #if !LIBSIDPLAYFP_CHECK_VERSION(3, 0, 0)
     /* Configure channels and stuff */
-    switch (xs_cfg.audioChannels)
+    switch (channels)
     {
     case XS_CHN_STEREO:
         config.playback = SidConfig::STEREO;
@@ -97,29 +103,29 @@ bool xs_sidplayfp_init()
 #endif
 
     /* Audio parameters sanity checking and setup */
-    config.frequency = xs_cfg.audioFrequency;
+    config.frequency = frequency;
 
-    /* Initialize builder object */
-    state.currBuilder = new ReSIDfpBuilder("ReSIDfp builder");
+    if (fast)
+        config.samplingMethod = SidConfig::INTERPOLATE;
 
 #if !LIBSIDPLAYFP_CHECK_VERSION(3, 0, 0)
     /* Builder object created, initialize it */
-    state.currBuilder->create(state.currEng->info().maxsids());
-    if (!state.currBuilder->getStatus()) {
+    builder->create(engine->info().maxsids());
+    if (!builder->getStatus()) {
         AUDERR("reSID->create() failed.\n");
         return false;
     }
 #endif
 
 #if !LIBSIDPLAYFP_CHECK_VERSION(2, 10, 0)
-    state.currBuilder->filter(xs_cfg.emulateFilters);
-    if (!state.currBuilder->getStatus()) {
+    builder->filter(xs_cfg.emulateFilters);
+    if (!builder->getStatus()) {
         AUDERR("reSID->filter(%d) failed.\n", xs_cfg.emulateFilters);
         return false;
     }
 #endif
 
-    config.sidEmulation = state.currBuilder;
+    config.sidEmulation = builder;
 
     /* Clockspeed settings */
     switch (xs_cfg.clockSpeed) {
@@ -148,18 +154,29 @@ bool xs_sidplayfp_init()
     config.forceSidModel = xs_cfg.forceModel;
 
     /* Now set the emulator configuration */
-    if (!state.currEng->config(config)) {
+    if (!engine->config(config)) {
         AUDERR("[SIDPlayFP] Emulator engine configuration failed!\n");
         return false;
     }
 
 #if LIBSIDPLAYFP_CHECK_VERSION(2, 10, 0)
     /* Call filter() after config() to have an effect */
-    state.currEng->filter(0, xs_cfg.emulateFilters);
-    state.currEng->filter(1, xs_cfg.emulateFilters);
-    state.currEng->filter(2, xs_cfg.emulateFilters);
+    engine->filter(0, xs_cfg.emulateFilters);
+    engine->filter(1, xs_cfg.emulateFilters);
+    engine->filter(2, xs_cfg.emulateFilters);
 #endif
 
+    if (state.kernal.len())
+        engine->setRoms((uint8_t*)state.kernal.begin(), (uint8_t*)state.basic.begin(), (uint8_t*)state.chargen.begin());
+
+    return true;
+}
+
+
+/* Initialize SIDPlayFP
+ */
+bool xs_sidplayfp_init()
+{
     /* Load ROMs */
     VFSFile kernal_file("file://" SIDDATADIR "/sidplayfp/kernal", "r");
     VFSFile basic_file("file://" SIDDATADIR "/sidplayfp/basic", "r");
@@ -172,9 +189,21 @@ bool xs_sidplayfp_init()
         Index<char> chargen = chargen_file.read_all();
 
         if (kernal.len() == 8192 && basic.len() == 8192 && chargen.len() == 4096)
-            state.currEng->setRoms((uint8_t*)kernal.begin(), (uint8_t*)basic.begin(), (uint8_t*)chargen.begin());
+        {
+            state.kernal = std::move(kernal);
+            state.basic = std::move(basic);
+            state.chargen = std::move(chargen);
+        }
     }
 
+    /* Initialize the engine and builder object */
+    state.currEng = new sidplayfp;
+    state.currBuilder = new ReSIDfpBuilder("ReSIDfp builder");
+
+    if (!xs_sidplayfp_configure(state.currEng, state.currBuilder,
+        xs_cfg.audioFrequency, xs_cfg.audioChannels, false))
+        return false;
+
     /* Load song length database */
     state.database_loaded = state.database.open(SIDDATADIR "/sidplayfp/Songlengths.md5");
 
@@ -207,6 +236,10 @@ void xs_sidplayfp_close()
 
     if (state.database_loaded)
         state.database.close();
+
+    state.kernal.clear();
+    state.basic.clear();
+    state.chargen.clear();
 }
 
 
@@ -233,22 +266,64 @@ bool xs_sidplayfp_initsong(int subtune)
 }
 
 
-/* Emulate and render audio data to given buffer
- */
-unsigned xs_sidplayfp_fillbuffer(char * audioBuffer, unsigned audioBufSize)
+static unsigned xs_sidplayfp_render(sidplayfp *engine, char * audioBuffer, unsigned audioBufSize)
 {
 #if LIBSIDPLAYFP_CHECK_VERSION(2, 15, 0)
-    int samples = state.currEng->play(audioBufSize / 2);
+    int samples = engine->play(audioBufSize / 2);
     if (samples < 0)
         return 0;
 
-    return state.currEng->mix((short *)audioBuffer, samples) * 2;
+    return engine->mix((short *)audioBuffer, samples) * 2;
 #else
-    return state.currEng->play((short *)audioBuffer, audioBufSize / 2) * 2;
+    return engine->play((short *)audioBuffer, audioBufSize / 2) * 2;
 #endif
 }
 
 
+/* Emulate and render audio data to given buffer
+ */
+unsigned xs_sidplayfp_fillbuffer(char * audioBuffer, unsigned audioBufSize)
+{
+    return xs_sidplayfp_render(state.currEng, audioBuffer, audioBufSize);
+}
+
+
+/* Find the end of a sub-tune by emulating it on a private engine, in mono;
+ * called from length scanner threads.  Returns -1 if no end is found.
+ */
+int xs_sidplayfp_scanlength(const void *buf, int64_t bufSize, int subtune,
+    bool (*cancelled)())
+{
+    SidTune tune((const uint8_t*)buf, bufSize);
+    if (!tune.getStatus() || !tune.selectSong(subtune))
+        return -1;
+
+    sidplayfp engine;
+    ReSIDfpBuilder builder("ReSIDfp scanner");
+
+    if (!xs_sidplayfp_configure(&engine, &builder, XS_SCAN_FREQ, XS_CHN_MONO, true) ||
+        !engine.load(&tune))
+        return -1;
+
+#if LIBSIDPLAYFP_CHECK_VERSION(2, 15, 0)
+    engine.initMixer(false);
+#endif
+
+    SilenceTracker tracker(XS_SCAN_FREQ, 1);
+    short samples[4096];
+
+    while (!cancelled())
+    {
+        unsigned bytes = xs_sidplayfp_render(&engine, (char *)samples, sizeof(samples));
+        if (!bytes || !tracker.feed(samples, bytes / 2))
+            break;
+    }
+
+    /* a tune that stops producing samples has crashed rather than ended */
+    return tracker.length_ms(false);
+}
+
+
 /* Load a given SID-tune file
  */
 bool xs_sidplayfp_load(const void *buf, int64_t bufSize)
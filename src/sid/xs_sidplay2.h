@@ -12,5 +12,7 @@ bool xs_sidplayfp_initsong(int subtune);
 unsigned xs_sidplayfp_fillbuffer(char *, unsigned);
 bool xs_sidplayfp_load(const void *buf, int64_t bufSize);
 bool xs_sidplayfp_getinfo(xs_tuneinfo_t &ti, const void *buf, int64_t bufSize);
+int xs_sidplayfp_scanlength(const void *buf, int64_t bufSize, int subtune,
+    bool (*cancelled)());
 
 #endif /* XS_SIDPLAYFP_H */
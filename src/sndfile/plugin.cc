@@ -325,8 +325,10 @@ bool SndfilePlugin::play (const char * filename, VFSFile & file)
 
     open_audio (FMT_FLOAT, sfinfo.samplerate, sfinfo.channels);
 
+    /* about 100 ms per block; libsndfile converts straight into the buffer,
+     * which is then handed to the output as is */
     Index<float> buffer;
-    buffer.resize (sfinfo.channels * (sfinfo.samplerate / 50));
+    buffer.resize (sfinfo.channels * aud::max (sfinfo.samplerate / 10, 256));
 
     while (! check_stop ())
     {
@@ -0,0 +1,331 @@
+// Copyright (c) 2019 Ariadne Conill <ariadne@dereferenced.org>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// This software is provided 'as is' and without any warranty, express or
+// implied.  In no event shall the authors be liable for any damages arising
+// from the use of this software.
+
+#include <libfauxdcore/i18n.h>
+#include <libfauxdcore/runtime.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QLocale>
+#include <QTimer>
+#include <QUrl>
+
+#include "directory-cache.h"
+
+// read from the cache per turn of the main loop
+#define CHUNK_SIZE (256 * 1024)
+
+DirectoryCache::DirectoryCache (QObject * parent) :
+    QObject (parent)
+{
+    m_qnam = new QNetworkAccessManager (this);
+}
+
+DirectoryCache::~DirectoryCache ()
+{
+    cancel ();
+}
+
+QString DirectoryCache::path (const char * ext) const
+{
+    QString path = QString (aud_get_path (AudPath::UserDir)) + "/streamtuner/" + m_name;
+    return ext ? path + ext : path;
+}
+
+void DirectoryCache::cancel ()
+{
+    m_serial ++;
+    m_reading_cache = false;
+    m_cache_file.close ();
+
+    if (m_reply)
+    {
+        QNetworkReply * reply = m_reply;
+        m_reply = nullptr;
+
+        QObject::disconnect (reply, nullptr, this, nullptr);
+        reply->abort ();
+        reply->deleteLater ();
+    }
+
+    if (m_receiving)
+    {
+        m_temp_file.remove ();
+        m_receiving = false;
+    }
+}
+
+void DirectoryCache::fetch (const QString & name, const QString & url,
+                            const QByteArray & post_data, Handlers handlers)
+{
+    cancel ();
+
+    m_name = name;
+    m_url = url;
+    m_handlers = std::move (handlers);
+
+    QDir ().mkpath (QString (aud_get_path (AudPath::UserDir)) + "/streamtuner");
+
+    load_meta ();
+    m_have_cache = QFile::exists (path ());
+
+    if (m_have_cache)
+        read_cache ();
+    else
+        m_handlers.status (QString (_("Loading ...")));
+
+    revalidate (post_data);
+}
+
+void DirectoryCache::read_cache ()
+{
+    m_cache_file.setFileName (path ());
+    if (! m_cache_file.open (QIODevice::ReadOnly))
+    {
+        AUDWARN ("Could not read %s.\n", (const char *) path ().toUtf8 ());
+        m_have_cache = false;
+        return;
+    }
+
+    m_reading_cache = true;
+    m_handlers.reset ();
+    set_status (false);
+
+    int serial = m_serial;
+    QTimer::singleShot (0, this, [this, serial] () { read_cache_chunk (serial); });
+}
+
+// one chunk per turn of the main loop, so that the UI stays responsive
+void DirectoryCache::read_cache_chunk (int serial)
+{
+    if (serial != m_serial || ! m_reading_cache)
+        return;
+
+    QByteArray chunk = m_cache_file.read (CHUNK_SIZE);
+    if (! chunk.isEmpty ())
+        m_handlers.data (chunk);
+
+    // the handler may have started another fetch
+    if (serial != m_serial)
+        return;
+
+    if (chunk.isEmpty () || m_cache_file.atEnd ())
+    {
+        m_cache_file.close ();
+        m_reading_cache = false;
+        m_handlers.done (! chunk.isEmpty () || m_cache_file.size () == 0);
+        return;
+    }
+
+    QTimer::singleShot (0, this, [this, serial] () { read_cache_chunk (serial); });
+}
+
+void DirectoryCache::revalidate (const QByteArray & post_data)
+{
+    QNetworkRequest request ((QUrl (m_url)));
+
+    if (m_have_cache)
+    {
+        if (! m_etag.isEmpty ())
+            request.setRawHeader ("If-None-Match", m_etag);
+        if (! m_last_modified.isEmpty ())
+            request.setRawHeader ("If-Modified-Since", m_last_modified);
+    }
+
+    // there is no point in Qt keeping a second copy
+    request.setAttribute (QNetworkRequest::CacheLoadControlAttribute,
+                          QNetworkRequest::AlwaysNetwork);
+
+    QNetworkReply * reply;
+    if (post_data.isEmpty ())
+        reply = m_qnam->get (request);
+    else
+    {
+        request.setHeader (QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+        reply = m_qnam->post (request, post_data);
+    }
+
+    m_reply = reply;
+
+    QObject::connect (reply, &QNetworkReply::readyRead, this, [this] () {
+        reply_data ();
+    });
+    QObject::connect (reply, &QNetworkReply::finished, this, [this, reply] () {
+        reply_finished ();
+        m_reply = nullptr;
+        reply->deleteLater ();
+    });
+}
+
+// new contents are passed on as they come in, and also written to a temporary
+// file, which replaces the cache once complete
+void DirectoryCache::reply_data ()
+{
+    int code = m_reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+    if (code != 200)
+    {
+        m_reply->readAll ();  // not modified, or an error page
+        return;
+    }
+
+    if (! m_receiving)
+    {
+        // whatever is left of the old contents is of no use now
+        m_serial ++;
+        m_reading_cache = false;
+        m_cache_file.close ();
+
+        m_temp_file.setFileName (path (".part"));
+        if (! m_temp_file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+            AUDWARN ("Could not write to %s.\n", (const char *) path (".part").toUtf8 ());
+
+        m_receiving = true;
+        m_handlers.reset ();
+        m_handlers.status (QString (_("Loading ...")));
+    }
+
+    QByteArray chunk = m_reply->readAll ();
+    if (chunk.isEmpty ())
+        return;
+
+    if (m_temp_file.isOpen ())
+        m_temp_file.write (chunk);
+
+    m_handlers.data (chunk);
+}
+
+void DirectoryCache::reply_finished ()
+{
+    int code = m_reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+    bool ok = (m_reply->error () == QNetworkReply::NoError);
+
+    if (ok && code == 200)
+    {
+        reply_data ();  // an empty reply never calls it
+
+        bool saved = m_temp_file.isOpen () && m_temp_file.flush ();
+        m_temp_file.close ();
+        m_receiving = false;
+
+        QFile::remove (path ());
+        if (saved && m_temp_file.rename (path ()))
+        {
+            m_etag = m_reply->rawHeader ("ETag");
+            m_last_modified = m_reply->rawHeader ("Last-Modified");
+            m_fetched = QDateTime::currentSecsSinceEpoch ();
+            m_have_cache = true;
+            save_meta ();
+        }
+        else
+        {
+            m_temp_file.remove ();
+            m_have_cache = false;
+        }
+
+        AUDINFO ("streamtuner: %s updated.\n", (const char *) m_name.toUtf8 ());
+        set_status (false);
+        m_handlers.done (true);
+    }
+    else if (ok && code == 304)
+    {
+        AUDDBG ("streamtuner: %s not modified.\n", (const char *) m_name.toUtf8 ());
+        m_fetched = QDateTime::currentSecsSinceEpoch ();
+        save_meta ();
+
+        if (! m_reading_cache)
+            set_status (false);
+    }
+    else
+    {
+        AUDWARN ("streamtuner: could not fetch %s: %s\n", (const char *) m_url.toUtf8 (),
+                 (const char *) m_reply->errorString ().toUtf8 ());
+
+        // the list was cut short; go back to the one we have
+        if (m_receiving)
+        {
+            m_temp_file.remove ();
+            m_receiving = false;
+
+            if (m_have_cache)
+                read_cache ();
+            else
+                m_handlers.done (false);
+        }
+        else if (! m_have_cache)
+            m_handlers.done (false);
+
+        if (m_have_cache)
+            set_status (true);
+        else
+            m_handlers.status (QString (_("Could not load the station list: %1"))
+                               .arg (m_reply->errorString ()));
+    }
+}
+
+void DirectoryCache::set_status (bool offline)
+{
+    if (! m_fetched)
+    {
+        m_handlers.status (QString ());
+        return;
+    }
+
+    QString when = QLocale ().toString (QDateTime::fromSecsSinceEpoch (m_fetched),
+                                        QLocale::ShortFormat);
+
+    if (offline)
+        m_handlers.status (QString (_("Offline, showing the list from %1")).arg (when));
+    else
+        m_handlers.status (QString (_("Updated %1")).arg (when));
+}
+
+// a few lines of "key value"
+void DirectoryCache::load_meta ()
+{
+    m_etag.clear ();
+    m_last_modified.clear ();
+    m_fetched = 0;
+
+    QFile file (path (".meta"));
+    if (! file.open (QIODevice::ReadOnly))
+        return;
+
+    while (! file.atEnd ())
+    {
+        QByteArray line = file.readLine ().trimmed ();
+        int space = line.indexOf (' ');
+        if (space < 0)
+            continue;
+
+        QByteArray key = line.left (space);
+        QByteArray value = line.mid (space + 1);
+
+        if (key == "etag")
+            m_etag = value;
+        else if (key == "last-modified")
+            m_last_modified = value;
+        else if (key == "fetched")
+            m_fetched = value.toLongLong ();
+    }
+}
+
+void DirectoryCache::save_meta ()
+{
+    QFile file (path (".meta"));
+    if (! file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        AUDWARN ("Could not write to %s.\n", (const char *) path (".meta").toUtf8 ());
+        return;
+    }
+
+    file.write ("etag " + m_etag + "\n");
+    file.write ("last-modified " + m_last_modified + "\n");
+    file.write ("fetched " + QByteArray::number (m_fetched) + "\n");
+}
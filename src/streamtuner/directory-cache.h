@@ -0,0 +1,82 @@
+// Copyright (c) 2019 Ariadne Conill <ariadne@dereferenced.org>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// This software is provided 'as is' and without any warranty, express or
+// implied.  In no event shall the authors be liable for any damages arising
+// from the use of this software.
+
+#ifndef STREAMTUNER_DIRECTORY_CACHE_H
+#define STREAMTUNER_DIRECTORY_CACHE_H
+
+#include <functional>
+
+#include <QByteArray>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+// Keeps a copy of each station directory on disk, in the streamtuner
+// subdirectory of the config directory.  The copy is shown at once (or when
+// offline), while the server is asked in the background whether it has
+// changed (using its ETag or Last-Modified date).  Either way the contents
+// are passed on in chunks as they are read, so that even the Icecast
+// directory, tens of MB of XML, can be parsed without blocking the UI.
+class DirectoryCache : public QObject {
+public:
+    struct Handlers {
+        std::function<void ()> reset;   // new contents follow
+        std::function<void (const QByteArray & chunk)> data;
+        std::function<void (bool complete)> done;
+        std::function<void (const QString & status)> status;
+    };
+
+    DirectoryCache (QObject * parent = nullptr);
+    ~DirectoryCache ();
+
+    // name is the file name in the cache; post_data, if not empty, is sent
+    // with a POST instead of a GET.  Cancels a fetch still running.
+    void fetch (const QString & name, const QString & url,
+                const QByteArray & post_data, Handlers handlers);
+
+    void cancel ();
+
+private:
+    void read_cache ();
+    void read_cache_chunk (int serial);
+    void revalidate (const QByteArray & post_data);
+    void reply_data ();
+    void reply_finished ();
+
+    void load_meta ();
+    void save_meta ();
+    void set_status (bool offline);
+
+    QString path (const char * ext = nullptr) const;
+
+    QNetworkAccessManager * m_qnam;
+    QPointer<QNetworkReply> m_reply;
+
+    QString m_name, m_url;
+    Handlers m_handlers;
+    int m_serial = 0;   // bumped to stop reading the cache
+
+    QFile m_cache_file;
+    bool m_reading_cache = false;
+    bool m_have_cache = false;
+
+    QFile m_temp_file;
+    bool m_receiving = false;   // new contents are coming from the server
+
+    // from the .meta file
+    QByteArray m_etag, m_last_modified;
+    qint64 m_fetched = 0;   // when the server last confirmed the contents
+};
+
+#endif
@@ -8,16 +8,118 @@
 // implied.  In no event shall the authors be liable for any damages arising
 // from the use of this software.
 
+#include <algorithm>
+
 #include <QXmlStreamReader>
 
 #include "icecast-model.h"
 
-static const char *ICECAST_YP = "http://dir.xiph.org/yp.xml";
+void IcecastSearchIndex::clear ()
+{
+    m_words.clear ();
+    m_sorted = true;
+}
+
+QStringList IcecastSearchIndex::split (const QString & text)
+{
+    QStringList words;
+    QString folded = text.toCaseFolded ();
+    int start = -1;
+
+    for (int i = 0; i <= folded.length (); i ++)
+    {
+        bool in_word = (i < folded.length () && folded[i].isLetterOrNumber ());
+
+        if (in_word && start < 0)
+            start = i;
+        else if (! in_word && start >= 0)
+        {
+            words.append (folded.mid (start, i - start));
+            start = -1;
+        }
+    }
+
+    return words;
+}
+
+void IcecastSearchIndex::add (int id, const IcecastEntry & entry)
+{
+    for (auto & word : split (entry.title + ' ' + entry.genre))
+        m_words.push_back ({word, id});
+
+    m_sorted = false;
+}
+
+Index<int> IcecastSearchIndex::search (const QStringList & words)
+{
+    if (! m_sorted)
+    {
+        std::sort (m_words.begin (), m_words.end (), [] (const Word & a, const Word & b)
+            { return a.word < b.word || (a.word == b.word && a.id < b.id); });
+        m_sorted = true;
+    }
+
+    std::vector<int> result;
+    bool first = true;
+
+    for (auto & query : words)
+    {
+        // all words beginning with query follow each other
+        auto it = std::lower_bound (m_words.begin (), m_words.end (), query,
+            [] (const Word & a, const QString & b) { return a.word < b; });
+
+        std::vector<int> ids;
+        for (; it != m_words.end () && it->word.startsWith (query); it ++)
+            ids.push_back (it->id);
+
+        std::sort (ids.begin (), ids.end ());
+        ids.erase (std::unique (ids.begin (), ids.end ()), ids.end ());
+
+        if (first)
+            result = std::move (ids);
+        else
+        {
+            std::vector<int> both;
+            std::set_intersection (result.begin (), result.end (), ids.begin (),
+                                   ids.end (), std::back_inserter (both));
+            result = std::move (both);
+        }
+
+        first = false;
+    }
+
+    Index<int> rows;
+    rows.insert (result.data (), 0, result.size ());
+    return rows;
+}
+
+bool IcecastSearchIndex::matches (const IcecastEntry & entry, const QStringList & words)
+{
+    QStringList station_words = split (entry.title + ' ' + entry.genre);
+
+    for (auto & query : words)
+    {
+        bool found = false;
+        for (auto & word : station_words)
+        {
+            if (word.startsWith (query))
+            {
+                found = true;
+                break;
+            }
+        }
+
+        if (! found)
+            return false;
+    }
+
+    return true;
+}
 
 IcecastTunerModel::IcecastTunerModel (QObject * parent) :
     QAbstractListModel (parent)
 {
-    fetch_stations ();
+    m_cache = new DirectoryCache (this);
 }
 
 IcecastTunerModel::~IcecastTunerModel ()
@@ -27,77 +129,183 @@ IcecastTunerModel::~IcecastTunerModel ()
 
 void IcecastTunerModel::fetch_stations ()
 {
-    vfs_async_file_get_contents (ICECAST_YP, [&] (const char *, const Index<char> & buf) {
-        if (! buf.len ())
-            return;
-
-        beginResetModel ();
-
-        AUDINFO("icecast: got results from YP server\n");
-
-        // oh, this is going to be fun... parse the XML as fast as possible
-        QXmlStreamReader reader (QByteArray (buf.begin (), buf.len ()));
-        IcecastEntry entry;
-
-        // lets prefab some atoms for fast comparisons
-        QString entry_atom = QString ("entry");
-        QString server_name_atom = QString ("server_name");
-        QString listen_url_atom = QString ("listen_url");
-        QString server_type_atom = QString ("server_type");
-        QString bitrate_atom = QString ("bitrate");
-        QString genre_atom = QString ("genre");
-        QString current_song_atom = QString ("current_song");
-        QString mp3_atom = QString ("audio/mpeg");
-        QString aac_atom = QString ("audio/aacp");
-        QString vorbis_atom = QString ("application/ogg");
-
-        while (! reader.atEnd ()) {
-            auto token_type = reader.readNext ();
-
-            switch (token_type) {
-            case QXmlStreamReader::StartElement:
-                if (! reader.name ().compare (server_name_atom))
-                    entry.title = reader.readElementText ();
-                else if (! reader.name ().compare (listen_url_atom))
-                    entry.stream_uri = reader.readElementText ();
-                else if (! reader.name ().compare (current_song_atom))
-                    entry.current_song = reader.readElementText ();
-                else if (! reader.name ().compare (genre_atom))
-                    entry.genre = reader.readElementText ();
-                else if (! reader.name ().compare (server_type_atom))
-                {
-                    auto server_type = reader.readElementText ();
-
-                    if (! server_type.compare (mp3_atom))
-                        entry.type = IcecastEntry::MP3;
-                    else if (! server_type.compare (aac_atom))
-                        entry.type = IcecastEntry::AAC;
-                    else if (! server_type.compare (vorbis_atom))
-                        entry.type = IcecastEntry::Vorbis;
-                    else
-                        entry.type = IcecastEntry::Other;
-                }
-                else if (! reader.name ().compare (bitrate_atom))
-                    entry.bitrate = reader.readElementText ().toInt ();
+    DirectoryCache::Handlers handlers;
+
+    handlers.reset = [this] () { reset (); };
+    handlers.data = [this] (const QByteArray & chunk) { parse (chunk); };
+    handlers.done = [this] (bool complete) {
+        if (complete && m_reader.error () == QXmlStreamReader::PrematureEndOfDocumentError)
+            AUDWARN ("icecast: the directory ends prematurely.\n");
+
+        AUDINFO ("icecast: %d stations.\n", m_results.len ());
+    };
+    handlers.status = [this] (const QString & status) {
+        if (m_status_func)
+            m_status_func (status);
+    };
+
+    m_cache->fetch ("icecast-yp.xml", QString (aud_get_str ("streamtuner", "icecast_url")),
+                    QByteArray (), std::move (handlers));
+}
 
-                break;
-            case QXmlStreamReader::EndElement:
-                if (! reader.name ().compare (entry_atom))
-                    m_results.append (entry);
+void IcecastTunerModel::reset ()
+{
+    beginResetModel ();
 
-                break;
-            default:
-                break;
+    m_reader.clear ();
+    m_entry = IcecastEntry ();
+    m_text.clear ();
+    m_parse_error = false;
+
+    m_results.clear ();
+    m_added = 0;
+    m_index.clear ();
+    m_rows.clear ();
+
+    endResetModel ();
+}
+
+// The directory is parsed as it comes in, so it does not need to be in memory
+// all at once; parsing stops at the end of each chunk, even in the middle of
+// an element, and goes on from there with the next chunk.
+void IcecastTunerModel::parse (const QByteArray & chunk)
+{
+    if (m_parse_error)
+        return;
+
+    m_reader.addData (chunk);
+
+    // lets prefab some atoms for fast comparisons
+    static const QString entry_atom = QString ("entry");
+    static const QString server_name_atom = QString ("server_name");
+    static const QString listen_url_atom = QString ("listen_url");
+    static const QString server_type_atom = QString ("server_type");
+    static const QString bitrate_atom = QString ("bitrate");
+    static const QString genre_atom = QString ("genre");
+    static const QString current_song_atom = QString ("current_song");
+    static const QString mp3_atom = QString ("audio/mpeg");
+    static const QString aac_atom = QString ("audio/aacp");
+    static const QString vorbis_atom = QString ("application/ogg");
+
+    while (! m_reader.atEnd ()) {
+        auto token_type = m_reader.readNext ();
+
+        switch (token_type) {
+        case QXmlStreamReader::StartElement:
+            m_text.clear ();
+            if (! m_reader.name ().compare (entry_atom))
+                m_entry = IcecastEntry ();
+
+            break;
+        case QXmlStreamReader::Characters:
+            m_text += m_reader.text ();
+            break;
+        case QXmlStreamReader::EndElement:
+            if (! m_reader.name ().compare (server_name_atom))
+                m_entry.title = m_text;
+            else if (! m_reader.name ().compare (listen_url_atom))
+                m_entry.stream_uri = m_text;
+            else if (! m_reader.name ().compare (current_song_atom))
+                m_entry.current_song = m_text;
+            else if (! m_reader.name ().compare (genre_atom))
+                m_entry.genre = m_text;
+            else if (! m_reader.name ().compare (server_type_atom))
+            {
+                if (! m_text.compare (mp3_atom))
+                    m_entry.type = IcecastEntry::MP3;
+                else if (! m_text.compare (aac_atom))
+                    m_entry.type = IcecastEntry::AAC;
+                else if (! m_text.compare (vorbis_atom))
+                    m_entry.type = IcecastEntry::Vorbis;
+                else
+                    m_entry.type = IcecastEntry::Other;
+            }
+            else if (! m_reader.name ().compare (bitrate_atom))
+                m_entry.bitrate = m_text.toInt ();
+            else if (! m_reader.name ().compare (entry_atom))
+            {
+                m_index.add (m_results.len (), m_entry);
+                m_results.append (m_entry);
             }
+
+            m_text.clear ();
+            break;
+        default:
+            break;
         }
+    }
+
+    // out of data for now, or a real error
+    if (m_reader.hasError () && m_reader.error () != QXmlStreamReader::PrematureEndOfDocumentError)
+    {
+        AUDWARN ("icecast: could not parse the directory: %s\n",
+                 (const char *) m_reader.errorString ().toUtf8 ());
+        m_parse_error = true;
+    }
+
+    add_rows ();
+}
+
+// adds the stations parsed from the last chunk to the model in one go
+void IcecastTunerModel::add_rows ()
+{
+    int count = m_results.len ();
+    if (m_added == count)
+        return;
+
+    if (m_filter.isEmpty ())
+    {
+        beginInsertRows (QModelIndex (), m_added, count - 1);
+        m_added = count;
+        endInsertRows ();
+        return;
+    }
+
+    Index<int> matches;
+    for (int id = m_added; id < count; id ++)
+    {
+        if (IcecastSearchIndex::matches (m_results[id], m_filter))
+            matches.append (id);
+    }
+
+    m_added = count;
+
+    if (matches.len ())
+    {
+        beginInsertRows (QModelIndex (), m_rows.len (), m_rows.len () + matches.len () - 1);
+        m_rows.move_from (matches, 0, -1, -1, true, true);
+        endInsertRows ();
+    }
+}
+
+void IcecastTunerModel::set_filter (const QString & text)
+{
+    QStringList words = IcecastSearchIndex::split (text);
+    if (words == m_filter)
+        return;
+
+    beginResetModel ();
+
+    m_filter = words;
+    m_rows.clear ();
+
+    if (! m_filter.isEmpty ())
+    {
+        m_rows = m_index.search (m_filter);
+
+        // the index also holds stations not yet added to the model
+        int keep = 0;
+        while (keep < m_rows.len () && m_rows[keep] < m_added)
+            keep ++;
+        m_rows.remove (keep, -1);
+    }
 
-        endResetModel ();
-    });
+    endResetModel ();
 }
 
 const IcecastEntry & IcecastTunerModel::entry (int idx) const
 {
-    return m_results[idx];
+    return m_results[m_filter.isEmpty () ? idx : m_rows[idx]];
 }
 
 int IcecastTunerModel::columnCount (const QModelIndex &) const
@@ -107,7 +315,7 @@ int IcecastTunerModel::columnCount (const QModelIndex &) const
 
 int IcecastTunerModel::rowCount (const QModelIndex &) const
 {
-    return m_results.len ();
+    return m_filter.isEmpty () ? m_added : m_rows.len ();
 }
 
 QVariant IcecastTunerModel::headerData (int section, Qt::Orientation orientation, int role) const
@@ -141,7 +349,7 @@ QVariant IcecastTunerModel::data (const QModelIndex &index, int role) const
         return QVariant ();
 
     int row = index.row ();
-    auto station = entry (row);
+    auto & station = entry (row);
 
     switch (index.column ())
     {
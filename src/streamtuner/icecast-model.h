@@ -25,11 +25,18 @@
 
 #include <libfauxdqt/treeview.h>
 
+#include <functional>
+#include <vector>
+
 #include <QWidget>
 #include <QTabWidget>
 #include <QVBoxLayout>
 #include <QSplitter>
 #include <QAbstractListModel>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include "directory-cache.h"
 
 struct IcecastEntry {
     QString title;
@@ -42,9 +49,33 @@ struct IcecastEntry {
         AAC,
         Vorbis,
         Other
-    } type;
+    } type = Other;
 
-    int bitrate;
+    int bitrate = 0;
+};
+
+// The words of the station names and genres, sorted, so that a search looks
+// up each word of the query instead of going through all stations.
+class IcecastSearchIndex {
+public:
+    void clear ();
+    void add (int id, const IcecastEntry & entry);
+
+    // the stations (in order) having words beginning with each of the given
+    // words, which should come from split ()
+    Index<int> search (const QStringList & words);
+    static bool matches (const IcecastEntry & entry, const QStringList & words);
+
+    static QStringList split (const QString & text);
+
+private:
+    struct Word {
+        QString word;
+        int id;
+    };
+
+    std::vector<Word> m_words;
+    bool m_sorted = true;
 };
 
 class IcecastTunerModel : public QAbstractListModel {
@@ -66,12 +97,37 @@ public:
     QVariant headerData (int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+    // the list is read (from the cache or the server) and parsed a chunk at a
+    // time, and rows are added as they are parsed
     void fetch_stations ();
 
+    // shows only the stations matching all words of text (in name or genre)
+    void set_filter (const QString & text);
+
+    void set_status_func (std::function<void (const QString &)> func)
+        { m_status_func = func; }
+
     const IcecastEntry & entry (int idx) const;
 
 private:
+    void reset ();
+    void parse (const QByteArray & chunk);
+    void add_rows ();
+
+    DirectoryCache * m_cache;
+    std::function<void (const QString &)> m_status_func;
+
+    QXmlStreamReader m_reader;
+    IcecastEntry m_entry;   // being parsed
+    QString m_text;         // of the element being parsed
+    bool m_parse_error = false;
+
     Index<IcecastEntry> m_results;
+    int m_added = 0;        // of m_results, added to the model so far
+
+    IcecastSearchIndex m_index;
+    QStringList m_filter;
+    Index<int> m_rows;      // the stations shown, when filtering
 };
 
 #endif
@@ -33,3 +33,35 @@ void IcecastListingWidget::activate (const QModelIndex & index)
     int playlist = aud_playlist_get_active ();
     aud_playlist_entry_insert (playlist, -1, entry.stream_uri.toUtf8 (), Tuple (), false);
 }
+
+IcecastTunerWidget::IcecastTunerWidget (QWidget * parent) :
+    QWidget (parent)
+{
+    m_layout = new QVBoxLayout (this);
+
+    m_search = new QLineEdit ();
+    m_search->setPlaceholderText (_("Search by name or genre"));
+    m_search->setClearButtonEnabled (true);
+    m_layout->addWidget (m_search);
+
+    m_tuner = new IcecastListingWidget ();
+    m_layout->addWidget (m_tuner);
+
+    m_status = new QLabel ();
+    m_layout->addWidget (m_status);
+
+    // search once typing pauses, not on every key
+    m_search_timer.setSingleShot (true);
+    m_search_timer.setInterval (250);
+
+    connect (m_search, &QLineEdit::textChanged, [this] () { m_search_timer.start (); });
+    connect (& m_search_timer, &QTimer::timeout, [this] () {
+        m_tuner->tuner_model ()->set_filter (m_search->text ());
+    });
+
+    m_tuner->tuner_model ()->set_status_func ([this] (const QString & status) {
+        m_status->setText (status);
+    });
+
+    m_tuner->tuner_model ()->fetch_stations ();
+}
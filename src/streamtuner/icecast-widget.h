@@ -24,6 +24,9 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
 
 #include "icecast-model.h"
 
@@ -33,8 +36,22 @@ public:
 
      void activate (const QModelIndex & index);
 
+     IcecastTunerModel * tuner_model () { return m_model; }
+
 private:
      IcecastTunerModel *m_model;
 };
 
+class IcecastTunerWidget : public QWidget {
+public:
+    IcecastTunerWidget(QWidget * parent = nullptr);
+
+private:
+    QLineEdit *m_search;
+    IcecastListingWidget *m_tuner;
+    QLabel *m_status;
+    QVBoxLayout *m_layout;
+    QTimer m_search_timer;
+};
+
 #endif
@@ -18,7 +18,6 @@
 #include <libfauxdcore/runtime.h>
 #include <libfauxdcore/index.h>
 #include <libfauxdcore/playlist.h>
-#include <libfauxdcore/vfs_async.h>
 
 #include <libfauxdqt/treeview.h>
 
@@ -37,7 +36,7 @@
 IHRMarketModel::IHRMarketModel (QObject * parent) :
     QAbstractListModel (parent)
 {
-    fetch_markets ();
+    m_cache = new DirectoryCache (this);
 }
 
 IHRMarketModel::~IHRMarketModel ()
@@ -78,43 +77,59 @@ QVariant IHRMarketModel::data (const QModelIndex &index, int role) const
            .arg (entry.station_count);
 }
 
-static const char *URI_GET_MARKETS = "https://api.iheart.com/api/v2/content/markets?limit=10000&cache=true";
-
 void IHRMarketModel::fetch_markets ()
 {
-    vfs_async_file_get_contents (URI_GET_MARKETS, [&] (const char *, const Index<char> & buf) {
-        if (! buf.len ())
+    String base = aud_get_str ("streamtuner", "ihr_url");
+    StringBuf uri = str_concat ({base, "/api/v2/content/markets?limit=10000&cache=true"});
+
+    DirectoryCache::Handlers handlers;
+
+    handlers.reset = [this] () { m_reply.clear (); };
+    handlers.data = [this] (const QByteArray & chunk) { m_reply.append (chunk); };
+    handlers.done = [this] (bool complete) {
+        auto doc = QJsonDocument::fromJson (m_reply);
+        m_reply.clear ();
+
+        if (! complete || ! doc.isObject ())
             return;
 
-       auto doc = QJsonDocument::fromJson(QByteArray (buf.begin (), buf.len ()));
-       if (! doc.isObject ())
-           return;
+        process_markets (doc.object ());
+    };
+    handlers.status = [this] (const QString & status) {
+        if (m_status_func)
+            m_status_func (status);
+    };
 
-       auto root = doc.object ();
-       auto market_count = root["total"].toInt ();
+    m_cache->fetch ("ihr-markets.json", QString (uri), QByteArray (), std::move (handlers));
+}
 
-       AUDINFO ("Fetched %d markets.\n", market_count);
+void IHRMarketModel::process_markets (const QJsonObject & root)
+{
+    auto market_count = root["total"].toInt ();
+
+    AUDINFO ("Fetched %d markets.\n", market_count);
 
-       beginResetModel ();
+    beginResetModel ();
 
-       auto markets = root["hits"].toArray ();
+    m_results.clear ();
 
-       for (auto market_ref : markets)
-       {
-           auto market = market_ref.toObject ();
-           IHRMarketEntry entry;
+    auto markets = root["hits"].toArray ();
 
-           entry.market_id = market["marketId"].toInt ();
-           entry.station_count = market["stationCount"].toInt ();
-           entry.city = market["city"].toString ();
-           entry.state = market["stateAbbreviation"].toString ();
-           entry.country_code = market["countryAbbreviation"].toString ();
+    for (auto market_ref : markets)
+    {
+        auto market = market_ref.toObject ();
+        IHRMarketEntry entry;
 
-           m_results.append (entry);
-       }
+        entry.market_id = market["marketId"].toInt ();
+        entry.station_count = market["stationCount"].toInt ();
+        entry.city = market["city"].toString ();
+        entry.state = market["stateAbbreviation"].toString ();
+        entry.country_code = market["countryAbbreviation"].toString ();
 
-       endResetModel ();
-    });
+        m_results.append (entry);
+    }
+
+    endResetModel ();
 }
 
 int IHRMarketModel::id_for_idx (const QModelIndex &index) const
@@ -129,6 +144,7 @@ int IHRMarketModel::id_for_idx (const QModelIndex &index) const
 IHRTunerModel::IHRTunerModel (QObject * parent) :
     QAbstractListModel (parent)
 {
+    m_cache = new DirectoryCache (this);
 }
 
 IHRTunerModel::~IHRTunerModel ()
@@ -196,58 +212,74 @@ QVariant IHRTunerModel::data (const QModelIndex &index, int role) const
 
 void IHRTunerModel::fetch_stations (int market_id)
 {
-    StringBuf uri = str_printf("https://api.iheart.com/api/v2/content/liveStations?limit=100&marketId=%d", market_id);
-
-    vfs_async_file_get_contents(uri, [&] (const char *, const Index<char> & buf) {
-        if (! buf.len ())
-            return;
+    String base = aud_get_str ("streamtuner", "ihr_url");
+    StringBuf uri = str_printf ("%s/api/v2/content/liveStations?limit=100&marketId=%d",
+                                (const char *) base, market_id);
 
-       auto doc = QJsonDocument::fromJson(QByteArray (buf.begin (), buf.len ()));
-       if (! doc.isObject ())
-           return;
+    DirectoryCache::Handlers handlers;
 
-       auto root = doc.object ();
-       auto station_count = root["total"].toInt ();
+    handlers.reset = [this] () { m_reply.clear (); };
+    handlers.data = [this] (const QByteArray & chunk) { m_reply.append (chunk); };
+    handlers.done = [this, market_id] (bool complete) {
+        auto doc = QJsonDocument::fromJson (m_reply);
+        m_reply.clear ();
 
-       AUDINFO ("Fetched %d stations for market %d.\n", station_count, market_id);
+        if (! complete || ! doc.isObject ())
+            return;
 
-       beginResetModel ();
+        process_stations (doc.object (), market_id);
+    };
+    handlers.status = [this] (const QString & status) {
+        if (m_status_func)
+            m_status_func (status);
+    };
 
-       m_results.clear ();
+    m_cache->fetch (QString ("ihr-market-%1.json").arg (market_id), QString (uri),
+                    QByteArray (), std::move (handlers));
+}
 
-       auto stations = root["hits"].toArray ();
+void IHRTunerModel::process_stations (const QJsonObject & root, int market_id)
+{
+    auto station_count = root["total"].toInt ();
 
-       for (auto station_ref : stations)
-       {
-           auto station = station_ref.toObject ();
-           IHRStationEntry entry;
+    AUDINFO ("Fetched %d stations for market %d.\n", station_count, market_id);
 
-           entry.title = station["name"].toString ();
-           entry.description = station["description"].toString ();
-           entry.call_letters = station["callLetters"].toString ();
-           entry.logo = station["logo"].toString ();
+    beginResetModel ();
 
-           auto streams = station["streams"].toObject ();
-           auto genres = station["genres"].toArray ();
-           for (auto genre : genres)
-           {
-               auto genre0 = genre.toObject ();
-               entry.genre = genre0["name"].toString();
-               break;  /* ONLY GRAB 1ST ONE. */
-           }
-           entry.stream_uri = streams["shoutcast_stream"].toString ();
-           if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
-               entry.stream_uri = streams["secure_shoutcast_stream"].toString ();
-           if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
-               entry.stream_uri = streams["hls_stream"].toString ();
-           if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
-               entry.stream_uri = streams["secure_hls_stream"].toString ();
+    m_results.clear ();
 
-           m_results.append (entry);
-       }
+    auto stations = root["hits"].toArray ();
+
+    for (auto station_ref : stations)
+    {
+        auto station = station_ref.toObject ();
+        IHRStationEntry entry;
+
+        entry.title = station["name"].toString ();
+        entry.description = station["description"].toString ();
+        entry.call_letters = station["callLetters"].toString ();
+        entry.logo = station["logo"].toString ();
+
+        auto streams = station["streams"].toObject ();
+        auto genres = station["genres"].toArray ();
+        for (auto genre : genres)
+        {
+            auto genre0 = genre.toObject ();
+            entry.genre = genre0["name"].toString();
+            break;  /* ONLY GRAB 1ST ONE. */
+        }
+        entry.stream_uri = streams["shoutcast_stream"].toString ();
+        if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
+            entry.stream_uri = streams["secure_shoutcast_stream"].toString ();
+        if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
+            entry.stream_uri = streams["hls_stream"].toString ();
+        if (entry.stream_uri.isNull() || entry.logo.isEmpty() || entry.logo.length () <= 0)
+            entry.stream_uri = streams["secure_hls_stream"].toString ();
+
+        m_results.append (entry);
+    }
 
-       endResetModel ();
-    });
+    endResetModel ();
 }
 
 const IHRStationEntry & IHRTunerModel::station_for_idx (const QModelIndex &index) const
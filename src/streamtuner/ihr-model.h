@@ -34,6 +34,10 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+#include <functional>
+
+#include "directory-cache.h"
+
 struct IHRMarketEntry {
     QString city;
     QString state;
@@ -61,12 +65,21 @@ public:
     QVariant headerData (int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+    // shows the cached list at once, if there is one
     void fetch_markets ();
 
+    void set_status_func (std::function<void (const QString &)> func)
+        { m_status_func = func; }
+
     int id_for_idx (const QModelIndex &index) const;
 
 private:
+    void process_markets (const QJsonObject & root);
+
     Index<IHRMarketEntry> m_results;
+    DirectoryCache *m_cache;
+    QByteArray m_reply;
+    std::function<void (const QString &)> m_status_func;
 };
 
 class IHRTunerModel : public QAbstractListModel {
@@ -87,12 +100,21 @@ public:
     QVariant headerData (int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+    // shows the cached list for the market at once, if there is one
     void fetch_stations (int market_id);
 
+    void set_status_func (std::function<void (const QString &)> func)
+        { m_status_func = func; }
+
     const IHRStationEntry & station_for_idx (const QModelIndex &index) const;
 
 private:
+    void process_stations (const QJsonObject & root, int market_id);
+
     Index<IHRStationEntry> m_results;
+    DirectoryCache *m_cache;
+    QByteArray m_reply;
+    std::function<void (const QString &)> m_status_func;
 };
 
 #endif
@@ -136,6 +136,17 @@ IHRTunerWidget::IHRTunerWidget (QWidget * parent) :
 
     m_layout->addWidget (m_splitter);
 
+    m_status = new QLabel ();
+    m_layout->addWidget (m_status);
+
+    auto set_status = [this] (const QString & status) {
+        m_status->setText (status);
+    };
+
+    m_markets->market_model ()->set_status_func (set_status);
+    m_tuner->tuner_model ()->set_status_func (set_status);
+    m_markets->market_model ()->fetch_markets ();
+
     auto market_selection_model = m_markets->selectionModel ();
     connect(market_selection_model, &QItemSelectionModel::selectionChanged, [&] (const QItemSelection &selected, const QItemSelection &) {
         // this should never happen, but just to be sure...
@@ -24,6 +24,7 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QLabel>
 
 #include "ihr-model.h"
 
@@ -33,6 +34,8 @@ public:
 
      void activate (const QModelIndex & index);
 
+     IHRTunerModel * tuner_model () { return m_model; }
+
 private:
      IHRTunerModel *m_model;
 };
@@ -41,6 +44,8 @@ class IHRMarketWidget : public QTreeView {
 public:
     IHRMarketWidget(QWidget * parent = nullptr);
 
+    IHRMarketModel * market_model () { return m_model; }
+
 private:
     IHRMarketModel *m_model;
 };
@@ -52,6 +57,7 @@ public:
 private:
     IHRListingWidget *m_tuner;
     IHRMarketWidget *m_markets;
+    QLabel *m_status;
     QSplitter *m_splitter;
     QVBoxLayout *m_layout;
 };
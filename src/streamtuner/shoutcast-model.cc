@@ -26,15 +26,14 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QRegularExpression>
 
 #include "shoutcast-model.h"
 
 ShoutcastTunerModel::ShoutcastTunerModel (QObject * parent) :
     QAbstractListModel (parent)
 {
-    m_qnam = new QNetworkAccessManager (this);
-
-    fetch_stations ();
+    m_cache = new DirectoryCache (this);
 }
 
 ShoutcastTunerModel::~ShoutcastTunerModel ()
@@ -44,38 +43,46 @@ ShoutcastTunerModel::~ShoutcastTunerModel ()
 
 void ShoutcastTunerModel::fetch_stations (String genre)
 {
-    auto base = "https://directory.shoutcast.com";
+    String base = aud_get_str ("streamtuner", "shoutcast_url");
     StringBuf uri;
     StringBuf post_data;
+    QString name;
 
     // undefined genre: fetch top 500
     if (! genre || ! strcmp (genre, "Top 500 Stations"))
+    {
         uri = str_concat ({base, "/Home/Top"});
+        name = "shoutcast-top.json";
+    }
     else
     {
         uri = str_concat ({base, "/Home/BrowseByGenre"});
         post_data = str_concat ({"genrename=", genre});
+        name = QString ("shoutcast-%1.json").arg (QString (genre).toLower ()
+                .replace (QRegularExpression ("[^a-z0-9]+"), "-"));
     }
 
-    // build the request for the fetch
-    QUrl url = QUrl (QString (uri));
-    QNetworkRequest request = QNetworkRequest (url);
-    request.setHeader (QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    DirectoryCache::Handlers handlers;
 
-    QNetworkReply * reply = m_qnam->post (request, (const char *) post_data);
-    QObject::connect (reply, &QNetworkReply::finished, [reply, this] () {
-        if (200 != reply->attribute (QNetworkRequest::HttpStatusCodeAttribute))
-            return;
+    handlers.reset = [this] () { m_reply.clear (); };
+    handlers.data = [this] (const QByteArray & chunk) { m_reply.append (chunk); };
+    handlers.done = [this] (bool complete) {
+        auto doc = QJsonDocument::fromJson (m_reply);
+        m_reply.clear ();
 
-       auto data = reply->readAll();
-       auto doc = QJsonDocument::fromJson(data);
+        if (! complete || ! doc.isArray ())
+            return;
 
-       if (! doc.isArray ())
-           return;
+        auto stations = doc.array ();
+        process_stations (stations);
+    };
+    handlers.status = [this] (const QString & status) {
+        if (m_status_func)
+            m_status_func (status);
+    };
 
-       auto stations = doc.array ();
-       process_stations (stations);
-    });
+    m_cache->fetch (name, QString (uri), QByteArray ((const char *) post_data),
+                    std::move (handlers));
 }
 
 void ShoutcastTunerModel::process_station (QJsonObject object)
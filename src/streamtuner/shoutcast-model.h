@@ -34,6 +34,10 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+#include <functional>
+
+#include "directory-cache.h"
+
 struct ShoutcastEntry {
     QString title;
     QString genre;
@@ -69,8 +73,12 @@ public:
     QVariant headerData (int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
     QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+    // shows the cached list for the genre at once, if there is one
     void fetch_stations (String genre = String ());
 
+    void set_status_func (std::function<void (const QString &)> func)
+        { m_status_func = func; }
+
     void process_station (QJsonObject object);
     void process_stations (QJsonArray & stations);
 
@@ -78,7 +86,9 @@ public:
 
 private:
     Index<ShoutcastEntry> m_results;
-    QNetworkAccessManager *m_qnam;
+    DirectoryCache *m_cache;
+    QByteArray m_reply;
+    std::function<void (const QString &)> m_status_func;
 };
 
 class ShoutcastGenreModel : public QAbstractListModel {
@@ -78,6 +78,14 @@ ShoutcastTunerWidget::ShoutcastTunerWidget (QWidget * parent) :
 
     m_layout->addWidget (m_splitter);
 
+    m_status = new QLabel ();
+    m_layout->addWidget (m_status);
+
+    m_tuner->tuner_model ()->set_status_func ([this] (const QString & status) {
+        m_status->setText (status);
+    });
+    m_tuner->tuner_model ()->fetch_stations ();
+
     auto genre_selection_model = m_genre->selectionModel ();
     connect(genre_selection_model, &QItemSelectionModel::selectionChanged, [&] (const QItemSelection &selected, const QItemSelection &) {
         // this should never happen, but just to be sure...
@@ -24,6 +24,7 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QLabel>
 
 #include "shoutcast-model.h"
 
@@ -33,6 +34,8 @@ public:
 
      void activate (const QModelIndex & index);
 
+     ShoutcastTunerModel * tuner_model () { return m_model; }
+
 private:
      ShoutcastTunerModel *m_model;
 };
@@ -52,6 +55,7 @@ public:
 private:
     ShoutcastListingWidget *m_tuner;
     ShoutcastGenreWidget *m_genre;
+    QLabel *m_status;
     QSplitter *m_splitter;
     QVBoxLayout *m_layout;
 };
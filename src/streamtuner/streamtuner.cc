@@ -42,7 +42,7 @@ public:
 
 private:
      ShoutcastTunerWidget *m_shoutcast_tuner;
-     IcecastListingWidget *m_icecast_tuner;
+     IcecastTunerWidget *m_icecast_tuner;
      IHRTunerWidget *m_ihr_tuner;
 };
 
@@ -53,7 +53,7 @@ StreamTunerWidget::StreamTunerWidget(QWidget *parent) :
     setTabPosition (QTabWidget::TabPosition::South);
 
     m_shoutcast_tuner = new ShoutcastTunerWidget (this);
-    m_icecast_tuner = new IcecastListingWidget (this);
+    m_icecast_tuner = new IcecastTunerWidget (this);
     m_ihr_tuner = new IHRTunerWidget (this);
 
     addTab (m_shoutcast_tuner, _("Shoutcast"));
@@ -77,11 +77,27 @@ public:
 
     constexpr StreamTunerPlugin () : GeneralPlugin (info, false) { }
 
+    bool init ();
     void * get_qt_widget ();
 };
 
 EXPORT StreamTunerPlugin aud_plugin_instance;
 
+// not shown in the settings; they only point the directories elsewhere, such
+// as at a mirror or a local copy
+static const char * const defaults[] = {
+    "icecast_url", "http://dir.xiph.org/yp.xml",
+    "shoutcast_url", "https://directory.shoutcast.com",
+    "ihr_url", "https://api.iheart.com",
+    nullptr
+};
+
+bool StreamTunerPlugin::init ()
+{
+    aud_config_set_defaults ("streamtuner", defaults);
+    return true;
+}
+
 void * StreamTunerPlugin::get_qt_widget ()
 {
     return new StreamTunerWidget ();
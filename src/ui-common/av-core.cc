@@ -0,0 +1,761 @@
+/*
+ * av-core.cc
+ *
+ * Packet queues, audio/video decoding and the SDL video window, shared by
+ * the FFaudio and DVD plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "av-core.h"
+
+#include <stdlib.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/plugins.h>
+#include <libfauxdcore/runtime.h>
+
+/* MUST CAPTURE WxH OF WINDOW-DECORATIONS FOR AfterStep WM FOR PROPER WINDOW PLACEMENT!
+   (KEPT FROM ONE PLAY TO THE NEXT, EACH PLUGIN HAS ITS OWN COPY) */
+static int as_decor_fudge_x = 0;
+static int as_decor_fudge_y = 0;
+#if SDL_COMPILEDVERSION > 4600
+static bool as_decor_fudge_set = false;
+#endif
+
+static int av_log_result (const char * func, int ret)
+{
+    if (ret < 0 && ret != (int) AVERROR_EOF && ret != AVERROR (EAGAIN))
+    {
+        static char buf[256];
+        if (! av_strerror (ret, buf, sizeof buf))
+            AUDERR ("%s failed: %s\n", func, buf);
+        else
+            AUDERR ("%s failed\n", func);
+    }
+
+    return ret;
+}
+
+#define LOG(function, ...) av_log_result (#function, function (__VA_ARGS__))
+
+/*
+    JWT: ADDED ALL THIS QUEUE STUFF TO SMOOTH VIDEO PERFORMANCE SO THAT VIDEO FRAMES WOULD
+    BE OUTPUT MORE INTERLACED WITH THE AUDIO FRAMES BY QUEUEING VIDEO FRAMES UNTIL AN
+    AUDIO FRAME IS PROCESSED, THEN DEQUEUEING AND PROCESSING 'EM WITH EACH AUDIO FRAME.
+    IDEALLY, PACKETS SHOULD BE PROCESSED:  V A V A V A..., BUT THIS HANDLES:
+    V1 V2 V3 V4 V5 A1 A2 A3 A4 A5 A6 A7 V7 A8... AS:
+    (q:V1 V2 V3 V4 V5 V6) A1 A2 dq:V1 A3 A4 dq:V2 A5 A6 dq:V3 A7 A8...
+    BORROWED THESE FUNCTIONS FROM:
+    http://www.thelearningpoint.net/computer-science/data-structures-queues--with-c-program-source-code
+*/
+
+PacketQueue::PacketQueue (int capacity) :
+    m_capacity (capacity > 0 ? capacity : 1)
+{
+    m_elements = (AVPacket * *) malloc (sizeof (AVPacket *) * m_capacity);
+}
+
+PacketQueue::~PacketQueue ()
+{
+    flush ();
+    free (m_elements);
+    pthread_mutex_destroy (& m_mutex);
+}
+
+int PacketQueue::size ()
+{
+    pthread_mutex_lock (& m_mutex);
+    int size = m_size;
+    pthread_mutex_unlock (& m_mutex);
+    return size;
+}
+
+/* THE FRONT SLOT IS ONLY EVER CHANGED BY THE POPPING THREAD, SO THE PACKET
+   STAYS PUT AFTER THE LOCK IS RELEASED: */
+AVPacket * PacketQueue::front ()
+{
+    pthread_mutex_lock (& m_mutex);
+    AVPacket * pkt = m_size ? m_elements[m_front] : nullptr;
+    pthread_mutex_unlock (& m_mutex);
+    return pkt;
+}
+
+bool PacketQueue::push (AVPacket * pkt)
+{
+    pthread_mutex_lock (& m_mutex);  // (MAIN THREAD IS DEQUEUING THEM AT SAME TIME)!
+
+    bool pushed = (m_size < m_capacity);
+    if (pushed)
+    {
+        /* WE FILL THE QUEUE IN CIRCULAR FASHION: */
+        m_elements[(m_front + m_size) % m_capacity] = pkt;
+        m_size ++;
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+    return pushed;
+}
+
+bool PacketQueue::pop ()
+{
+    pthread_mutex_lock (& m_mutex);  // (READER THREAD IS ENQUEUING MORE AT SAME TIME)!
+
+    AVPacket * pkt = nullptr;
+    if (m_size)
+    {
+        pkt = m_elements[m_front];
+        m_front = (m_front + 1) % m_capacity;
+        m_size --;
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+
+    if (! pkt)
+        return false;
+
+    av_packet_free (& pkt);  // NO NEED TO HOLD THE LOCK FOR THIS
+    return true;
+}
+
+/* JWT:FLUSH AND FREE EVERYTHING IN THE QUEUE */
+void PacketQueue::flush ()
+{
+    pthread_mutex_lock (& m_mutex);  // DON'T ALLOW THREADS TO ENQUEUE OR DEQUEUE WHILST FLUSHING!
+
+    while (m_size > 0)
+    {
+        av_packet_free (& m_elements[m_front]);
+        m_front = (m_front + 1) % m_capacity;
+        m_size --;
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+}
+
+bool av_convert_format (int ff_fmt, int & aud_fmt, bool & planar)
+{
+    switch (ff_fmt)
+    {
+        case AV_SAMPLE_FMT_U8: aud_fmt = FMT_U8; planar = false; break;
+        case AV_SAMPLE_FMT_S16: aud_fmt = FMT_S16_NE; planar = false; break;
+        case AV_SAMPLE_FMT_S32: aud_fmt = FMT_S32_NE; planar = false; break;
+        case AV_SAMPLE_FMT_FLT: aud_fmt = FMT_FLOAT; planar = false; break;
+
+        case AV_SAMPLE_FMT_U8P: aud_fmt = FMT_U8; planar = true; break;
+        case AV_SAMPLE_FMT_S16P: aud_fmt = FMT_S16_NE; planar = true; break;
+        case AV_SAMPLE_FMT_S32P: aud_fmt = FMT_S32_NE; planar = true; break;
+        case AV_SAMPLE_FMT_FLTP: aud_fmt = FMT_FLOAT; planar = true; break;
+
+    default:
+        AUDERR ("Unsupported audio format %d\n", (int) ff_fmt);
+        return false;
+    }
+
+    return true;
+}
+
+void av_close_codec (CodecInfo & info)
+{
+    if (! info.context)
+        return;
+
+#ifdef ALLOC_CONTEXT
+    avcodec_free_context (& info.context);
+#else
+    avcodec_close (info.context);
+#endif
+    info.context = nullptr;
+}
+
+void av_decode_audio (CodecInfo & cinfo, AVPacket * pkt, int out_fmt, bool planar,
+ Index<char> & buf, const std::function<void (const void * data, int size)> & write)
+{
+#ifdef SEND_PACKET
+    if (LOG (avcodec_send_packet, cinfo.context, pkt) < 0)
+        return;
+#else
+    int decoded = 0;
+    int len = 0;
+#endif
+
+#if CHECK_LIBAVCODEC_VERSION(59, 37, 100, 59, 37, 100)
+    int channels = cinfo.context->ch_layout.nb_channels;
+#else
+    int channels = cinfo.context->channels;
+#endif
+
+    /* an empty packet: take what the decoder still holds, until it runs dry */
+    bool drain = ! pkt->size;
+
+    while (pkt->size > 0 || drain)
+    {
+        ScopedFrame frame;
+#ifdef SEND_PACKET
+        if (LOG (avcodec_receive_frame, cinfo.context, frame.ptr) < 0)
+            break; /* read next packet (continue past errors) */
+#else
+        decoded = 0;
+        len = LOG (avcodec_decode_audio4, cinfo.context, frame.ptr, & decoded, pkt);
+        if (len < 0)
+        {
+            AUDERR ("decode_audio() failed, code %d\n", len);
+            break;
+        }
+
+        pkt->size -= len;
+        pkt->data += len;
+
+        if (! decoded)
+        {
+            if (pkt->size > 0)
+                continue; /* process more of current packet */
+
+            break;
+        }
+#endif
+        int size = FMT_SIZEOF (out_fmt) * channels * frame->nb_samples;
+
+        if (planar)
+        {
+            if (size > buf.len ())
+                buf.resize (size);
+
+            audio_interlace ((const void * *) frame->data, out_fmt,
+                    channels, buf.begin (), frame->nb_samples);
+            write (buf.begin (), size);
+        }
+        else
+            write (frame->data[0], size);
+    }
+
+#ifdef SEND_PACKET
+    if (drain)
+        avcodec_flush_buffers (cinfo.context);  // READY FOR MORE (AFTER A SEEK)
+#endif
+}
+
+/* JWT: WRITES VIDEO FRAMES TO THE POPUP WINDOW: */
+bool av_decode_video (CodecInfo & vcinfo, AVPacket * pkt, SDL_Renderer * renderer,
+ SDL_Texture * texture, bool blit)
+{
+#ifdef SEND_PACKET
+    if (LOG (avcodec_send_packet, vcinfo.context, pkt) < 0)
+        return false;
+#else
+    int subframeCnt = 0;
+    int frameFinished = 0;
+    int len = 0;
+    while (subframeCnt < 16)
+    {
+#endif
+        ScopedFrame vframe;
+#ifdef SEND_PACKET
+        if (LOG (avcodec_receive_frame, vcinfo.context, vframe.ptr) < 0)
+            return false;  /* read next packet (continue past errors) */
+        else if (! pkt->size)
+            avcodec_flush_buffers (vcinfo.context);  // DRAINED, GET READY FOR MORE (DVD MENUS)
+#else
+        frameFinished = 0;
+        len = LOG (avcodec_decode_video2, vcinfo.context, vframe.ptr, & frameFinished, pkt);
+        /* Did we get a video frame? */
+        if (len < 0)
+        {
+            AUDERR ("decode_video() failed, code %d\n", len);
+            return false;
+        }
+        if (frameFinished)
+        {
+#endif
+            if (! blit)  /* WE DON'T BLIT WHILST THE WINDOW IS BEING RESIZED! */
+                return false;
+
+            SDL_UpdateYUVTexture (texture, nullptr, vframe->data[0], vframe->linesize[0],
+                vframe->data[1], vframe->linesize[1], vframe->data[2], vframe->linesize[2]);
+            SDL_RenderCopy (renderer, texture, nullptr, nullptr);  // USE NULL TO GET IMAGE TO FIT WINDOW!
+            return true;
+#ifndef SEND_PACKET
+        }
+        else
+        {
+            if (pkt->size <= 0 || pkt->data < 0)
+                return false;
+            pkt->size -= len;
+            pkt->data += len;
+            if (pkt->size <= 0)
+                return false;
+        }
+        ++subframeCnt;
+    }
+    AUDERR ("w:write_videoframe: runaway frame skipped (more than 16 parts)\n");
+    return false;
+#endif
+}
+
+SDL_Renderer * av_create_renderer (SDL_Window * window)
+{
+    SDL_Renderer * renderer = window ? SDL_CreateRenderer (window, -1, 0) : nullptr;
+    if (window && ! renderer)
+        AUDERR ("e:SDL: could not create video renderer - no video play (%s)\n", SDL_GetError ());
+
+    return renderer;
+}
+
+SDL_Texture * av_create_texture (SDL_Window * window, SDL_Renderer * renderer,
+ int width, int height)
+{
+    if (! renderer)
+        return nullptr;
+
+    SDL_Texture * texture = SDL_CreateTexture (renderer, SDL_PIXELFORMAT_YV12,
+            SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (! texture)
+    {
+        AUDERR ("e:Could not create texture (%s)\n", SDL_GetError ());
+        return nullptr;
+    }
+
+    SDL_RenderPresent (renderer);
+    if (aud_get_bool ("audacious", "video_display"))
+        SDL_ShowWindow (window);  // ONLY SHOW WINDOW IF video_display VISUALIZATION PLUGIN ON!
+
+    /* NOTIFY video_display VISUALIZATION PLUGIN WE'RE NOW DEMUXING VIDEO. */
+    aud_set_bool ("audacious", "_video_playing", true);
+
+    return texture;
+}
+
+bool VideoWindow::open ()
+{
+    m_window = fauxd_get_sdl_window ();
+    if (! m_window)
+    {
+        AUDERR ("e:Failed to create SDL window (no video playing): %s.\n", SDL_GetError ());
+        return false;
+    }
+
+    m_display_at_startup = aud_get_bool ("audacious", "video_display");
+
+#if SDL_COMPILEDVERSION < 4601
+    as_decor_fudge_x = 0;
+    as_decor_fudge_y = 0;
+#endif
+
+    m_noresize_optimizations = aud_get_bool ("ffaudio", "noresize_optimizations");
+    if (m_noresize_optimizations)
+    {
+        /* JWT: time in seconds to wait for user to stop dragging before resetting window aspect */
+        m_resize_delay = aud_get_int ("ffaudio", "video_resizedelay");
+        if (m_resize_delay <= 0 || m_resize_delay > 9)
+            m_resize_delay = 1;
+    }
+    /* JWT: size below which window is reset to video's original requested size. */
+    m_doreset_width = aud_get_int ("ffaudio", "video_doreset_width");
+    if (m_doreset_width <= 0)
+        m_doreset_width = 149;
+    m_doreset_height = aud_get_int ("ffaudio", "video_doreset_height");
+    if (m_doreset_height <= 0)
+        m_doreset_height = 149;
+
+    /*  -1: Always let windowmanager place (random);
+        0(UNSPECIFIED): DEFAULT to 1.
+        1(default): Relocate window via SDL;
+    */
+    int xmove = aud_get_int (m_section, "video_xmove");
+    if (xmove == 0)
+        xmove = 1;
+
+    /* GET SAVED PREV. VIDEO WINDOW LOCN. AND SIZE AND TRY TO PLACE NEW WINDOW ACCORDINGLY: */
+    /* JWT: I ADDED THIS TO AVOID NEW VID. WINDOW RANDOMLY POPPING UP IN NEW LOCN., IE. WHEN REPEATING A VIDEO. */
+    m_saved_x = aud_get_int (m_section, "video_window_x");
+    m_saved_y = aud_get_int (m_section, "video_window_y");
+    m_saved_w = aud_get_int (m_section, "video_window_w");
+    m_saved_h = aud_get_int (m_section, "video_window_h");
+    m_need_placement = (xmove != -1);  // NO FUDGING NEEDED IF WINDOW TO BE PLACED RANDOMLY BY WINDOWMANAGER!
+
+#if SDL_COMPILEDVERSION < 4601
+    if (xmove > 0)
+        SDL_SetWindowPosition (m_window, m_saved_x, m_saved_y);
+#endif
+
+    return true;
+}
+
+void VideoWindow::set_title (const char * title)
+{
+    StringBuf buf = str_copy (title);
+    str_replace_char (buf, '_', ' ');
+    SDL_SetWindowTitle (m_window, buf);
+}
+
+/* NOW CALCULATE THE WIDTH, HEIGHT, & ASPECT BASED ON VIDEO'S SIZE & AND ANY USER PARAMATERS GIVEN:
+    IDEALLY, ONE SHOULD ONLY SET X OR Y AND LET Fauxdacious CALCULATE THE OTHER DIMENSION,
+    SO THAT THE ASPECT RATIO IS MAINTAINED, THOUGH ONE CAN SPECIFY BOTH AND FORCE
+    THE ASPECT TO BE ADJUSTED TO FIT.  IF A SINGLE ONE IS SPECIFIED AS "-1", THEN
+    THE NEW WINDOW WILL KEEP THE SAME VALUE FOR THAT DIMENSION AS THE PREV. WINDOW,
+    AND ADJUST THE OTHER DIMENTION ACCORDINGLY TO FIT THE NEW VIDEO'S ASPECT RATIO.
+    IF BOTH ARE SPECIFIED AS "-1", USE PREVIOUSLY-SAVED WINDOW SIZE REGUARDLESS OF ASPECT RATIO.
+*/
+void VideoWindow::set_video_size (int width, int height, int display_width,
+ int display_height, float aspect)
+{
+    int vx = m_xsize = aud_get_int (m_section, "video_xsize");
+    int vy = m_ysize = aud_get_int (m_section, "video_ysize");
+
+    if (!vx && vy)   /* User specified (or saved) height only, calc. width based on aspect: */
+    {
+        m_height = (vy == -1) ? (m_saved_h ? m_saved_h : display_height) : vy;
+        m_width = (int)((float)m_height * aspect);
+    }
+    else if (vx && !vy)   /* User specified (or saved) width only, calc. height based on aspect: */
+    {
+        m_width = (vx == -1) ? (m_saved_w ? m_saved_w : display_width) : vx;
+        m_height = (int)((float)m_width / aspect);
+    }
+    else if (vx && vy)   /* User specified fixed width and height: */
+    {
+        if (vx == -1 && vy == -1)  /* Use same (saved) settings or video's settings (SCREW THE ASPECT)! */
+        {
+            m_width = m_saved_w ? m_saved_w : display_width;
+            m_height = m_saved_h ? m_saved_h : display_height;
+        }
+        else if (vy == -1)  /* Use same (saved) width & calculate new height based on aspect: */
+        {
+            m_width = vx;
+            m_height = (int)((float)m_width / aspect);
+        }
+        else if (vx == -1)  /* Use same (saved) height & calculate new width based on aspect: */
+        {
+            m_height = vy;
+            m_width = (int)((float)m_height * aspect);
+        }
+        else  /* User specified window size (SCREW THE ASPECT)! */
+        {
+            m_width = vx;
+            m_height = vy;
+        }
+    }
+    else   /* User specified nothing, use the video's desired wXh (& ignore saved settings!): */
+    {
+        m_width = display_width;
+        m_height = display_height;
+    }
+    AUDINFO ("---VIDEO W x H SET TO (%d x %d)!\n", m_width, m_height);
+
+    m_picture_width = width;
+    m_picture_height = height;
+    m_aspect = m_height
+        ? (float)m_width / (float)m_height : 1.0;   /* Fall thru to square to avoid possibliity of "/0"! */
+
+    m_resized_width = m_width;
+    m_resized_height = m_height;
+    m_reaspected = true;
+    m_resize_time = time (nullptr);
+    m_stable = false;
+    m_exposed = false;
+
+    /* NOW "RESIZE" sdl_window to user's wXh, if user set something: */
+    SDL_SetWindowSize (m_window, m_width, m_height);
+
+    String scale = aud_get_str (m_section, "video_render_scale");
+    SDL_SetHint (SDL_HINT_RENDER_SCALE_QUALITY, scale[0] ? (const char *) scale : "1");
+}
+
+bool VideoWindow::handle_event (const SDL_WindowEvent & event)
+{
+    switch (event.event)
+    {
+        case SDL_WINDOWEVENT_CLOSE:  /* USER CLICKED THE "X" IN UPPER-RIGHT CORNER, KILL VIDEO WINDOW BUT KEEP PLAYING AUDIO! */
+        {
+            AUDINFO ("i:SDL_CLOSE (User killed video window for this play)!\n");
+            /* DISABLE "video_display" VISUALIZATION PLUGIN (WHICH WILL HIDE THE VIDEO WINDOW! */
+            /* (THIS IS HOW ALL OTHER VISUALIZATION PLUGINS WORK) */
+            save ();
+            PluginHandle * visHandle = aud_plugin_lookup_basename ("video_display");
+            aud_plugin_enable (visHandle, false);  // DISABLE VIDEO VISUALIZATION PLUGIN!
+            return true;
+        }
+        case SDL_WINDOWEVENT_RESIZED:  /* WINDOW CHANGED SIZE EITHER BY US OR BY USER DRAGGING WINDOW CORNER (WE DON'T KNOW WHICH HERE) */
+            /* ONCE A FRAME IS SHOWN, SOME WMS NEVER SEND AN EXPOSE BEFORE THE USER RESIZES (DVD MENUS): */
+            if (! m_exposed && ! m_stable)
+                return true;
+
+            m_resized_width = event.data1;  // window's reported new size
+            m_resized_height = event.data2;
+            AUDDBG ("i:SDL_RESIZE!!!!!! rvw=%d h=%d\n", m_resized_width, m_resized_height);
+            m_reaspected = false;  // false means now we'll need re-aspecting, so stop blitting!
+            if (m_noresize_optimizations)
+                m_resize_time = time (nullptr);  // reset the wait counter for when to assume user's done dragging window corner.
+            return true;
+        case SDL_WINDOWEVENT_HIDDEN:
+            /* SOME WMS SEEM TO SEND A "SHOW" EVENT IMMEDIATELY AFTER SOME "HIDE" EVENTS?! */
+            return true;
+        case SDL_WINDOWEVENT_SHOWN:
+            /* UNDO IMMEDIATE (RE)SHOW-ON-HIDE CAUSED BY SOME WMS! */
+            if (! aud_get_bool ("audacious", "video_display"))
+                SDL_HideWindow (m_window);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool VideoWindow::reaspect_due (bool force) const
+{
+    return ! m_reaspected && (! m_noresize_optimizations  // OPTIMIZE MOSTLY MEANS NOT NEEDING TIMER/DELAY:
+            || force || since_resize () > m_resize_delay);
+}
+
+void VideoWindow::take_window_aspect ()
+{
+    m_aspect = m_resized_height
+        ? (float)m_resized_width / (float)m_resized_height : 1.0;
+    AUDINFO ("---RESIZE(videohasnowh): NEW RATIO=%f=\n", m_aspect);
+}
+
+void VideoWindow::reaspect ()
+{
+    int new_width;   // WILL ADJUST ONE OF THESE TO RESTORE TO VIDEO'S PROPER ASPECT
+    int new_height;  // THEN RESIZE (RE-ASPECT) THE WINDOW TO KEEP ASPECT CONSTANT!
+    /* CALCULATE THE RESIZED WINDOW'S ASPECT RATIO */
+    float new_aspect = m_resized_height
+        ? (float)m_resized_width / (float)m_resized_height : 1.0;
+
+    /* NOW MANUALLY ADJUST EITHER THE WIDTH OR HEIGHT BASED ON USER'S CONFIG. TO RESTORE
+       THE NEW WINDOW TO THE PROPER ASPECT RATIO FOR THE CURRENTLY-PLAYING VIDEO:
+    */
+    /* USER SHRANK THE WINDOW BELOW "DORESET" THRESHOLD (user-configurable) SO RESIZE TO VIDEO'S ORIGINALLY REQUESTED (IDEAL) SIZE: */
+    if (m_resized_width < m_doreset_width && m_resized_height < m_doreset_height)
+    {
+        new_width = m_picture_width;
+        new_height = m_picture_height;
+    }
+    else if (m_ysize == -1)  // USER SAYS ADJUST HEIGHT TO MATCH WIDTH:
+    {
+        new_height = m_resized_height;
+        new_width = (int)(m_aspect * (float)new_height);
+    }
+    else if (m_xsize == -1)  // USER SAYS ADJUST WIDTH TO MATCH HEIGHT:
+    {
+        new_width = m_resized_width;
+        new_height = (int)((float)new_width / m_aspect);
+    }
+    /* USER DOESN'T CARE, SO WE DECIDE WHICH TO ADJUST: */
+    else if (m_resized_width < m_width || m_resized_height < m_height)
+    {
+        if (new_aspect > m_aspect)  // WINDOW SHRANK & BECAME MORE HORIZONTAL - ADJUST WIDTH TO NEW HEIGHT:
+        {
+            new_height = m_resized_height;
+            new_width = (int)(m_aspect * (float)new_height);
+        }
+        else  // WINDOW SHRANK & BECAME MORE VERTICAL - ADJUST HEIGHT TO NEW WIDTH:
+        {
+            new_width = m_resized_width;
+            new_height = (int)((float)new_width / m_aspect);
+        }
+    }
+    else if (new_aspect > m_aspect)  // WINDOW GREW & BECAME MORE HORIZONTAL - ADJUST HEIGHT TO NEW WIDTH:
+    {
+        new_width = m_resized_width;
+        new_height = (int)((float)new_width / m_aspect);
+    }
+    else  // WINDOW GREW & BECAME MORE VERTICAL - ADJUST WIDTH TO NEW HEIGHT:
+    {
+        new_height = m_resized_height;
+        new_width = (int)(m_aspect * (float)new_height);
+    }
+    m_width = new_width;
+    m_height = new_height;
+    /* NOW MANUALLY RESIZE (RE-ASPECT) WINDOW BASED ON VIDEO'S ORIGINALLY-CALCULATED ASPECT RATIO: */
+    SDL_SetWindowSize (m_window, m_width, m_height);
+    SDL_Delay (50);
+    m_reaspected = true;  // WE'VE RE-ASPECTED, SO ALLOW BLITTING TO RESUME!
+    m_exposed = true;
+}
+
+void VideoWindow::place ()
+{
+    if (! m_need_placement || ! m_stable || ! aud_get_bool ("audacious", "video_display"))
+        return;
+
+#if SDL_COMPILEDVERSION < 4601
+    int x, y;
+
+    /* FETCH UNDECORATED WINDOW'S (SDL) COORDS AFTER (RANDOM?) INITIAL W/M PLACEMENT: */
+    SDL_GetWindowPosition (m_window, &x, &y);
+    as_decor_fudge_x = m_saved_x - x;
+    as_decor_fudge_y = m_saved_y - y;
+    AUDDBG ("FUDGE SET(x=%d y=%d) vw=(%d, %d) F=(%d, %d)\n", x, y, m_saved_x,
+            m_saved_y, as_decor_fudge_x, as_decor_fudge_y);
+    if ((as_decor_fudge_x || as_decor_fudge_y)
+            && (! aud_get_bool ("audacious", "afterstep")))
+    {
+        /* JWT:FOR RECENT SDL2 VSNS (SEE ABOVE), AFTERSTEP NEEDS THIS TOO!
+           MOST WMS PLACE WINDOWS BASED ON THE RAW WINDOW EXCLUDING DECORATIONS, BUT
+           AFTERSTEP, AND PERHAPS SOME OTHERS?, INCLUDE DECORATIONS, RESULTING IN WINDOWS
+           BEING PLACED A BIT LOWER AND TO RIGHT (RESULTING IN THIS RECALCULATED FUDGE-FACTOR
+           BEING THE WxH OF THE WINDOW'S DECORATIONS - NORMALLY WILL BE 0, 0 FOR MOST WMS)!:
+        */
+        SDL_SetWindowPosition (m_window, x+as_decor_fudge_x, y+as_decor_fudge_y);
+        SDL_GetWindowPosition (m_window, &x, &y);
+        as_decor_fudge_x = m_saved_x - x;
+        as_decor_fudge_y = m_saved_y - y;
+        AUDDBG ("WINDOW MOVED BY FUDGE AND FUDGE RESET TO 0,0 (WERE NOT RUNNING AFTERSTEP)!\n");
+    }
+#else
+    int x, y, sdl_init_fudge_x, sdl_init_fudge_y;
+    /* FETCH UNDECORATED WINDOW'S (SDL) COORDS AFTER (RANDOM?) INITIAL W/M PLACEMENT: */
+    SDL_GetWindowPosition (m_window, &x, &y);
+    /* JWT:FOR RECENT SDL2 VSNS (SEE ABOVE), AFTERSTEP NEEDS THIS TOO (BUT WILL HAVE A FUDGE
+       FOR DECORATIONS)!
+       MOST WMS PLACE WINDOWS BASED ON THE RAW WINDOW EXCLUDING DECORATIONS, BUT AFTERSTEP,
+       AND PERHAPS SOME OTHER OLDER ONES, INCLUDE DECORATIONS, RESULTING IN WINDOWS
+       BEING PLACED A BIT LOWER AND TO RIGHT (RESULTING IN THIS RECALCULATED FUDGE-FACTOR
+       BEING THE WxH OF THE WINDOW'S DECORATIONS - NORMALLY WILL BE 0, 0 FOR MOST WMS)!:
+       NOTE:  THERE ARE ACTUALLY 2 "FUDGE" FACTORS (OFFSETS) WE HAVE TO ACCOUNT FOR:
+       1)  SDL / WINDOW-MANAGER RETURNING RANDOM COORDINATES BEFORE 1ST BLIT (as_decor_fudge_*), AND
+       2)  THE WxH OF WINDOW-DECORATIONS (FOR AfterStep & PERHAPS SOME OTHER WMs) THAT
+       PLACE WINDOWS BASED TON UPPER-LEFT CORNER OF THE TITALBAR AND SDL, WHICH USES THE
+       UPPER-LEFT CORNER OF THE UNDECORATED WINDOW! (sdl_init_*).
+       THE FORMER ONLY APPLIES ON INITIAL PLACEMENT, THE OTHER, AFFECTS EVERY Get/SetWindowPosition().
+    */
+    if (as_decor_fudge_set)  // CONVERT WM'S COORDS TO SDL'S (UNDECORATED WINDOW) COORDS:
+    {
+        if (m_display_at_startup)
+        {
+            sdl_init_fudge_x = as_decor_fudge_x;  // USUALLY 0,0 (SAME) FOR MODERN WMs BUT NOT Afterstep!
+            sdl_init_fudge_y = as_decor_fudge_y;
+        }
+        else
+            sdl_init_fudge_x = sdl_init_fudge_y = 0;  // USUALLY 0,0 (SAME) FOR MODERN WMs BUT NOT Afterstep!
+
+        AUDDBG ("--ASD FUDGE IS SET: (%d, %d) VW(%d, %d) - FETCHEDxy(%d, %d)\n",
+                sdl_init_fudge_x, sdl_init_fudge_y, m_saved_x, m_saved_y, x,y);
+        if (sdl_init_fudge_x == 0 && sdl_init_fudge_y == 0
+                && aud_get_bool ("audacious", "afterstep"))  //JWT:NOTE: MAY NOT NEED AS-TEST HERE?
+        {
+            x = m_saved_x; //JWT:IGNORE CURRENT PLACEMENT IF INITIAL FUDGE IS (0,0):
+            y = m_saved_y;
+        }
+    }
+    else  // CALCULATE HOW FAR WINDOW WILL BE "MOVED" WHEN WE PLACE IT (ONLY HAPPENS ON 1ST VIDEO PLAYED):
+    {
+        sdl_init_fudge_x = m_saved_x - x;  // WHERE WE WANT IT - WHERE IT WAS INITIALLY PLACED.
+        sdl_init_fudge_y = m_saved_y - y;
+        AUDDBG ("--ASD FUDGE NOT SET: VW(%d, %d) - FETCHEDxy(%d, %d)\n", m_saved_x,
+                m_saved_y, x,y);
+    }
+    /* PLACE IT WHERE WE WANT IT. (SDL COORDINATES MATCHING  SAVED IN CONFIG FILE): */
+    AUDDBG ("--SET WINDOW TO (%d, %d) USING INIT FUDGE (%d, %d):\n", x+sdl_init_fudge_x,
+            y+sdl_init_fudge_y, sdl_init_fudge_x, sdl_init_fudge_y);
+    SDL_SetWindowPosition (m_window, x+sdl_init_fudge_x, y+sdl_init_fudge_y);
+    SDL_Delay (50);
+    /* NOW FETCH BACK THE COORDINATES (WILL BE SDL COORDINATES (UNDECORATED WINDOW)): */
+    SDL_GetWindowPosition (m_window, & m_init_x, & m_init_y);
+    if (! as_decor_fudge_set) // 1ST VIDEO: SAVE WINDOW-DECORATION W/H (FOR AfterStep, etc.):
+    {
+        as_decor_fudge_x = m_saved_x - m_init_x;  // DECORATION W,H FOR AfterStep,
+        as_decor_fudge_y = m_saved_y - m_init_y;  // OR 0,0 FOR (MOST) OTHER WMs.
+        if (m_display_at_startup)
+            as_decor_fudge_set = true;
+
+        AUDDBG ("---SET ASDECOR FUDGE:=VW(%d, %d) - FETCHED INITxy(%d, %d)\n", m_saved_x,
+                m_saved_y, m_init_x, m_init_y);
+        m_init_x += as_decor_fudge_x;  // CONVERT SET SDL COORDS BACK TO WM COORDINATES
+        m_init_y += as_decor_fudge_y;  // USED WHEN SAVING TO SEE IF WINDOW MOVED BY USER:
+    }
+    AUDDBG ("--PLACED WINDOW REQ(%d, %d) INIT=(%d, %d)\n", m_saved_x, m_saved_y,
+            m_init_x, m_init_y);
+#endif
+    m_need_placement = false;  // WE HAVE OUR DECORATION FUDGE-FACTOR (IF ANY)!
+}
+
+/* WHEN EXITING PLAY, WE SAVE THE WINDOW-POSITION & SIZE SO WINDOW CAN POP UP IN SAME POSITION NEXT TIME! */
+void VideoWindow::save ()
+{
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+
+    SDL_GetWindowSize (m_window, &w, &h);
+    if (w < 1 || h < 1 || w > 9999 || h > 9999)  /* SDL RETURNED BAD WINDOW INFO, DON'T SAVE! */
+        return;
+
+    /* JWT:NOTE:  FETCH WINDOW'S CURRENT COORDS, BUT LATEST SDL VERSION RETURNS SDL COORDINATES
+       *ONLY* IF WINDOW WAS "MOVED" (EITHER BY USER OR BY INITIAL (RE)PLACEMENT ON 1ST VIDEO PLAY),
+       OTHERWISE, IT NOW (IN LATEST SDL) SEEMS TO RETURN WM COORDINATES?!
+       (PREV. SDL VSNS RETURNED SDL COORDINATES ALWAYS)!
+    */
+    SDL_GetWindowPosition (m_window, &x, &y);  /* FETCH WINDOW'S CURRENT (SDL) COORDS: */
+    AUDDBG ("--SAVING: WINDOW AT (%d, %d), FUDGE=(%d, %d) VW=(%d, %d)\n", x, y, as_decor_fudge_x, as_decor_fudge_y, m_saved_x, m_saved_y);
+
+#if SDL_COMPILEDVERSION > 4600
+    /* IF WINDOW "MOVED", WE'LL HAVE SDL COORDS, SO CONVERT TO WM COORDS, (OTHERWISE */
+    /* WE ALREADY HAVE WM COORDS): NOTE:  OLDER SDL VSNS ALWAYS RETURNED SDL COORDS): */
+    if (! m_display_at_startup)
+    {
+        if (! as_decor_fudge_set && aud_get_bool ("audacious", "video_display"))
+        {
+            /* STARTED OUT W/VIDEO OFF, BUT TURNED ON, NOW NEED TO CALCULATE FUDGE NOW: */
+            as_decor_fudge_x = m_saved_x - x;
+            as_decor_fudge_y = m_saved_y - y;
+            AUDDBG ("--FUDGE SET IN SAVE (%d, %d) B/C VIDEO TOGGLED ON DURING PLAY B4 FUDGE CALCULATED.\n", as_decor_fudge_x, as_decor_fudge_y);
+            as_decor_fudge_set = true;
+        }
+        x = m_saved_x;  // NO VIDEO AT STARTUP, BUT WE HAVE WM COORDS ALREADY (NOT MOVED):
+        y = m_saved_y;
+    }
+    else if (x != m_init_x || y != m_init_y  // WE HAVE "SDL" COORDS. IF ANY OF THIS IS TRUE:
+            || aud_get_bool ("audacious", "video_display") || aud_get_bool ("audacious", "afterstep"))
+#else
+    if (! m_display_at_startup && aud_get_bool ("audacious", "video_display"))
+    {
+        /* JWT:MUST RECALCULATE FUDGE HERE IFF WINDOW STARTED PLAY HIDDEN (UNDECORATED), */
+        /* BUT FINISNED SHOWN (DECORATED?) (WE ACTIVATED VIDEO VISUALIZATION DURING PLAY)!: */
+        as_decor_fudge_x = m_saved_x - x;
+        as_decor_fudge_y = m_saved_y - y;
+        AUDDBG ("FUDGE RE-SET(x=%d y=%d) vw=(%d, %d) F=(%d, %d)\n", x, y, m_saved_x,
+                m_saved_y, as_decor_fudge_x, as_decor_fudge_y);
+    }
+#endif
+    {
+        AUDDBG ("--MOVED?  ADD FUDGE!  init=(%d, %d)\n", m_init_x, m_init_y);
+        x += as_decor_fudge_x;  /* APPLY CALCULATED FUDGE-FACTOR (WE HAVE SDL COORDS): */
+        if (x < 0 || x > 9999)
+            x = 0;              // DON'T ALLOW WEIRD OR OFF LEFT/TOP OF SCREEN!
+        y += as_decor_fudge_y;
+        if (y < 0 || y > 9999)
+            y = 0;
+    }
+    aud_set_int (m_section, "video_window_x", x);  // SAVE TO CONFIG-FILE AS WM COORDS!:
+    aud_set_int (m_section, "video_window_y", y);
+    aud_set_int (m_section, "video_window_w", w);
+    aud_set_int (m_section, "video_window_h", h);
+    AUDDBG ("--save_window_xy(%d, %d)\n", x, y);
+}
+
+void VideoWindow::finish (bool save_position)
+{
+    if (! m_window)
+        return;
+
+    if (save_position)
+        save ();
+
+    SDL_HideWindow (m_window);
+    /* NOTIFY video_display VISUALIZATION PLUGIN WE'RE NOT DEMUXING VIDEO. */
+    aud_set_bool ("audacious", "_video_playing", false);
+}
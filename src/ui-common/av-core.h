@@ -0,0 +1,233 @@
+/*
+ * av-core.h
+ *
+ * Packet queues, audio/video decoding and the SDL video window, shared by
+ * the FFaudio and DVD plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_AV_CORE_H
+#define UI_COMMON_AV_CORE_H
+
+#include <time.h>
+#include <functional>
+
+#include <pthread.h>
+
+#include "../ffaudio/ffaudio-stdinc.h"
+
+#define  USE_SDL2 1
+#include <libfauxdcore/sdl_window.h>
+#include <libfauxdcore/index.h>
+
+#if CHECK_LIBAVFORMAT_VERSION (57, 33, 100, 57, 5, 0)
+#define ALLOC_CONTEXT 1
+#endif
+
+#if CHECK_LIBAVCODEC_VERSION (57, 37, 100, 57, 16, 0)
+#define SEND_PACKET 1
+#endif
+
+struct CodecInfo
+{
+    int stream_idx = -1;
+    AVStream * stream = nullptr;
+    AVCodecContext * context = nullptr;  // JWT:ADDED
+    AVCodec * codec = nullptr;
+};
+
+struct ScopedFrame
+{
+#if CHECK_LIBAVCODEC_VERSION (55, 45, 101, 55, 28, 1)
+    AVFrame * ptr = av_frame_alloc ();
+#else
+    AVFrame * ptr = avcodec_alloc_frame ();
+#endif
+
+    AVFrame * operator-> () { return ptr; }
+
+#if CHECK_LIBAVCODEC_VERSION (55, 45, 101, 55, 28, 1)
+    ~ScopedFrame () { av_frame_free (& ptr); }
+#elif CHECK_LIBAVCODEC_VERSION (54, 59, 100, 54, 28, 0)
+    ~ScopedFrame () { avcodec_free_frame (& ptr); }
+#else
+    ~ScopedFrame () { av_free (ptr); }
+#endif
+};
+
+/*
+ * A fixed-size ring of demuxed packets, holding back the packets of one
+ * stream so that they can be output interleaved with those of the other.
+ * One thread may push while another pops; each queue has a lock of its own.
+ * Packets in the queue belong to it and are freed on popping or flushing.
+ */
+class PacketQueue
+{
+public:
+    PacketQueue (int capacity);
+    ~PacketQueue ();
+
+    int capacity () const { return m_capacity; }
+    int size ();
+    bool full () { return size () >= m_capacity; }
+
+    /* the oldest packet (still owned by the queue), or nullptr if empty;
+     * only the popping thread may call this */
+    AVPacket * front ();
+
+    /* false if full, in which case the caller keeps the packet */
+    bool push (AVPacket * pkt);
+
+    /* frees the oldest packet; false if empty */
+    bool pop ();
+
+    void flush ();
+
+private:
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    AVPacket * * m_elements;
+    int m_capacity;
+    int m_size = 0;
+    int m_front = 0;
+};
+
+bool av_convert_format (int ff_fmt, int & aud_fmt, bool & planar);
+void av_close_codec (CodecInfo & info);
+
+/* Decodes an audio packet, passing the (interleaved) samples of each frame
+ * to write.  buf is scratch space for interleaving planar formats, kept by
+ * the caller from one packet to the next.  An empty packet drains the
+ * decoder of the frames it still holds. */
+void av_decode_audio (CodecInfo & cinfo, AVPacket * pkt, int out_fmt, bool planar,
+ Index<char> & buf, const std::function<void (const void * data, int size)> & write);
+
+/* Decodes a video packet; if a frame comes out of it and blit is set, copies
+ * the frame to the renderer (leaving presenting it to the caller) and returns
+ * true.  An empty packet drains the decoder, which is then made ready for
+ * new packets again. */
+bool av_decode_video (CodecInfo & vcinfo, AVPacket * pkt, SDL_Renderer * renderer,
+ SDL_Texture * texture, bool blit);
+
+SDL_Renderer * av_create_renderer (SDL_Window * window);
+
+/* Also shows the window (if the video_display visualization plugin is on)
+ * and tells that plugin video is now playing. */
+SDL_Texture * av_create_texture (SDL_Window * window, SDL_Renderer * renderer,
+ int width, int height);
+
+/*
+ * The popup video window: its size, keeping the video's aspect ratio as the
+ * user resizes it, and putting it back where it was the last time it was
+ * closed.  The position and size are saved to, and the size preferences
+ * read from, the given config section; the resizing preferences are always
+ * FFaudio's.  The window itself is the one Fauxdacious keeps for all
+ * plugins; it is hidden again by finish ().
+ *
+ * The plugin runs the event loop, passing window events to handle_event ()
+ * and calling reaspect () and place () after each round, and must call
+ * frame_shown () whenever a frame has been presented.
+ */
+class VideoWindow
+{
+public:
+    VideoWindow (const char * section) :
+        m_section (section) {}
+
+    /* fetches the window and reads the saved position; false if there is none */
+    bool open ();
+    SDL_Window * window () const { return m_window; }
+
+    void set_title (const char * title);
+
+    /* Sizes the window for a new video, going by the video_xsize and
+     * video_ysize preferences.  width and height are the size of the decoded
+     * picture, to which the window snaps back when shrunk below the
+     * video_doreset_* size; display_width and display_height the size to
+     * show it at by default, and aspect the aspect ratio to keep. */
+    void set_video_size (int width, int height, int display_width,
+     int display_height, float aspect);
+
+    int width () const { return m_width; }
+    int height () const { return m_height; }
+
+    /* Handles the events all video windows have in common: closing (which
+     * turns off the video_display plugin), resizing, hiding and showing.
+     * Returns false for those left to the caller (such as exposing). */
+    bool handle_event (const SDL_WindowEvent & event);
+
+    /* true while the window is being resized, when frames are not blitted */
+    bool resizing () const { return ! m_reaspected; }
+
+    /* true once a resize has been waited out; force skips the wait */
+    bool reaspect_due (bool force = false) const;
+
+    /* resizes the window back to the video's aspect ratio after the user
+     * has resized it */
+    void reaspect ();
+
+    /* the user's last resize sets the aspect ratio (the video gave none) */
+    void take_window_aspect ();
+
+    /* seconds since the last resize (or other event restarting the wait) */
+    double since_resize () const { return difftime (time (nullptr), m_resize_time); }
+    void restart_resize_wait () { m_resize_time = time (nullptr); }
+    int resize_delay () const { return m_resize_delay; }
+
+    void frame_shown () { m_stable = true; }
+    bool stable () const { return m_stable; }
+    void set_exposed () { m_exposed = true; }
+    bool exposed () const { return m_exposed; }
+
+    /* once the first frame is up, moves the window to its saved position,
+     * working out how far the window manager's decorations shift it */
+    void place ();
+    bool placed () const { return ! m_need_placement; }
+
+    /* saves the position and size for next time */
+    void save ();
+
+    /* saves (if asked to) and hides the window at the end of playback */
+    void finish (bool save_position);
+
+private:
+    const char * m_section;
+    SDL_Window * m_window = nullptr;
+
+    bool m_display_at_startup = false;  // video_display plugin on when play started
+    bool m_noresize_optimizations = false;
+    int m_resize_delay = 1;        // seconds to wait for the user to finish resizing
+    int m_doreset_width = 149;     // shrunk below this, the window snaps back to
+    int m_doreset_height = 149;    // the size of the picture
+
+    int m_saved_x = 0, m_saved_y = 0;   // position and size when last closed
+    int m_saved_w = 0, m_saved_h = 0;
+    int m_init_x = 0, m_init_y = 0;     // where we placed it, to tell if the user moved it
+    bool m_need_placement = true;
+
+    int m_xsize = 0, m_ysize = 0;       // the video_xsize and video_ysize preferences
+    int m_width = 0, m_height = 0;      // current size, kept to the aspect ratio
+    int m_picture_width = 0, m_picture_height = 0;
+    float m_aspect = 1.0;
+
+    int m_resized_width = 0, m_resized_height = 0;  // size after the user's last resize
+    bool m_reaspected = true;
+    time_t m_resize_time = 0;
+
+    bool m_stable = false;   // a frame has been shown
+    bool m_exposed = false;  // the window has been exposed (needed before resizing on Windows)
+};
+
+#endif // UI_COMMON_AV_CORE_H
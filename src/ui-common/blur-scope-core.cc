@@ -0,0 +1,314 @@
+/*
+ * blur-scope-core.cc
+ *
+ * Toolkit-independent renderer for the Blur Scope, shared by the GTK and Qt
+ * plugins.  Frames are rendered in a thread of their own, at a fixed rate,
+ * so that the main thread only has to copy the finished frame to the screen.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "blur-scope-core.h"
+
+#include <string.h>
+#include <time.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <libfauxdcore/objects.h>
+#include <libfauxdcore/runtime.h>
+
+/* Frames are blurred at this rate whether PCM data comes in faster or
+ * slower, so the speed of the fade stays the same. */
+#define BLUR_RATE 50
+
+/* without new data, the whole image has faded to black after this many
+ * frames, and the render thread can go to sleep */
+#define IDLE_FRAMES 256
+
+static int64_t monotonic_us ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, & ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* waits on cond for at most the given time; the condition variable uses the
+ * realtime clock, so the deadline is converted */
+static void timed_wait (pthread_cond_t * cond, pthread_mutex_t * mutex, int64_t us)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_REALTIME, & ts);
+
+    int64_t ns = ts.tv_nsec + (us % 1000000) * 1000;
+    ts.tv_sec += us / 1000000 + ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+
+    pthread_cond_timedwait (cond, mutex, & ts);
+}
+
+/* We do a quick and dirty average of the four neighbouring color values,
+ * first masking off the lowest two bits.  Over a large area, this masking has
+ * the net effect of subtracting 1.5 from each value, which by a happy chance
+ * is just right for a gradual fade effect.  Since the masked channels are
+ * multiples of 4, their sums cannot carry into the next channel before the
+ * shift.  Each pixel of the new frame depends only on the previous frame, so
+ * four are done at a time where the CPU allows. */
+static void blur_row (uint32_t * dest, const uint32_t * src, int stride, int width)
+{
+    const uint32_t * up = src - stride;
+    const uint32_t * down = src + stride;
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32 (0xFCFCFC);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i a = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (up + x)), mask);
+        __m128i b = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (src + x - 1)), mask);
+        __m128i c = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (src + x + 1)), mask);
+        __m128i d = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (down + x)), mask);
+
+        __m128i sum = _mm_add_epi32 (_mm_add_epi32 (a, b), _mm_add_epi32 (c, d));
+        _mm_storeu_si128 ((__m128i *) (dest + x), _mm_srli_epi32 (sum, 2));
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t mask = vdupq_n_u32 (0xFCFCFC);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        uint32x4_t a = vandq_u32 (vld1q_u32 (up + x), mask);
+        uint32x4_t b = vandq_u32 (vld1q_u32 (src + x - 1), mask);
+        uint32x4_t c = vandq_u32 (vld1q_u32 (src + x + 1), mask);
+        uint32x4_t d = vandq_u32 (vld1q_u32 (down + x), mask);
+
+        uint32x4_t sum = vaddq_u32 (vaddq_u32 (a, b), vaddq_u32 (c, d));
+        vst1q_u32 (dest + x, vshrq_n_u32 (sum, 2));
+    }
+#endif
+
+    for (; x < width; x ++)
+        dest[x] = ((up[x] & 0xFCFCFC) + (src[x - 1] & 0xFCFCFC) +
+         (src[x + 1] & 0xFCFCFC) + (down[x] & 0xFCFCFC)) >> 2;
+}
+
+void BlurScopeCore::start ()
+{
+    if (m_running)
+        return;
+
+    m_quit = false;
+    m_idle_frames = 0;
+
+    if (pthread_create (& m_thread, nullptr, run, this))
+    {
+        AUDERR ("Cannot start render thread.\n");
+        return;
+    }
+
+    m_running = true;
+}
+
+void BlurScopeCore::stop ()
+{
+    if (! m_running)
+        return;
+
+    pthread_mutex_lock (& m_mutex);
+    m_quit = true;
+    pthread_cond_signal (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    pthread_join (m_thread, nullptr);
+    m_running = false;
+
+    /* no frame will be shown now */
+    m_redraw_queue.stop ();
+}
+
+void BlurScopeCore::resize (int width, int height)
+{
+    pthread_mutex_lock (& m_mutex);
+    m_new_width = aud::max (width, 0);
+    m_new_height = aud::max (height, 0);
+    m_resize_pending = true;
+    pthread_cond_signal (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void BlurScopeCore::clear ()
+{
+    pthread_mutex_lock (& m_mutex);
+    m_clear_pending = true;
+    m_pcm_pending = false;
+    pthread_cond_signal (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+/* only the latest data is drawn if it comes in faster than BLUR_RATE */
+void BlurScopeCore::add_pcm (const float * pcm)
+{
+    pthread_mutex_lock (& m_mutex);
+    memcpy (m_pcm, pcm, sizeof m_pcm);
+    m_pcm_pending = true;
+    pthread_cond_signal (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+const uint32_t * BlurScopeCore::lock_frame (int & width, int & height, int & stride)
+{
+    pthread_mutex_lock (& m_mutex);
+
+    width = m_width;
+    height = m_height;
+    stride = m_stride;
+
+    if (! m_width || ! m_height)
+        return nullptr;
+
+    return m_frames[m_front].begin () + m_stride + 1;
+}
+
+void BlurScopeCore::unlock_frame ()
+{
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void * BlurScopeCore::run (void * data)
+{
+    ((BlurScopeCore *) data)->loop ();
+    return nullptr;
+}
+
+void BlurScopeCore::loop ()
+{
+    const int64_t interval = 1000000 / BLUR_RATE;
+    float pcm[BLUR_SCOPE_SAMPLES];
+
+    pthread_mutex_lock (& m_mutex);
+
+    int64_t next_frame = monotonic_us ();
+
+    while (! m_quit)
+    {
+        bool work = (m_pcm_pending || m_resize_pending || m_clear_pending);
+
+        if (! work && m_idle_frames >= IDLE_FRAMES)
+        {
+            pthread_cond_wait (& m_cond, & m_mutex);
+            next_frame = monotonic_us ();
+            continue;
+        }
+
+        int64_t now = monotonic_us ();
+        if (now < next_frame)
+        {
+            timed_wait (& m_cond, & m_mutex, next_frame - now);
+            continue;
+        }
+
+        /* if we fell behind, don't try to catch up */
+        next_frame = aud::max (next_frame + interval, now);
+
+        if (m_resize_pending)
+        {
+            m_width = m_new_width;
+            m_height = m_new_height;
+            m_stride = m_width + 2;
+
+            for (auto & frame : m_frames)
+            {
+                frame.clear ();
+                frame.insert (0, m_stride * (m_height + 2));
+            }
+
+            m_resize_pending = false;
+        }
+
+        if (m_clear_pending)
+        {
+            for (auto & frame : m_frames)
+                memset (frame.begin (), 0, frame.len () * sizeof (uint32_t));
+
+            m_clear_pending = false;
+        }
+
+        bool have_pcm = m_pcm_pending;
+        if (have_pcm)
+            memcpy (pcm, m_pcm, sizeof pcm);
+
+        m_pcm_pending = false;
+        m_idle_frames = have_pcm ? 0 : m_idle_frames + 1;
+
+        if (! m_width || ! m_height)
+            continue;
+
+        /* the main thread only reads the front frame, so the back one can
+         * be rendered without holding the mutex */
+        pthread_mutex_unlock (& m_mutex);
+        render (have_pcm ? pcm : nullptr);
+        pthread_mutex_lock (& m_mutex);
+
+        m_front = ! m_front;
+        m_redraw_queue.queue (m_redraw, m_user);
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void BlurScopeCore::render (const float * pcm)
+{
+    const uint32_t * src = m_frames[m_front].begin () + m_stride + 1;
+    uint32_t * dest = m_frames[! m_front].begin () + m_stride + 1;
+
+    for (int y = 0; y < m_height; y ++)
+        blur_row (dest + m_stride * y, src + m_stride * y, m_stride, m_width);
+
+    if (! pcm)
+        return;
+
+    uint32_t color = m_color.load (std::memory_order_relaxed);
+
+    int prev_y = (0.5 + pcm[0]) * m_height;
+    prev_y = aud::clamp (prev_y, 0, m_height - 1);
+
+    for (int i = 0; i < m_width; i ++)
+    {
+        int y = (0.5 + pcm[i * BLUR_SCOPE_SAMPLES / m_width]) * m_height;
+        y = aud::clamp (y, 0, m_height - 1);
+        draw_vert_line (dest, i, prev_y, y, color);
+        prev_y = y;
+    }
+}
+
+void BlurScopeCore::draw_vert_line (uint32_t * corner, int x, int y1, int y2,
+ uint32_t color)
+{
+    int y, h;
+
+    if (y1 < y2) {y = y1 + 1; h = y2 - y1;}
+    else if (y2 < y1) {y = y2; h = y1 - y2;}
+    else {y = y1; h = 1;}
+
+    uint32_t * p = corner + y * m_stride + x;
+
+    for (; h --; p += m_stride)
+        * p = color;
+}
@@ -0,0 +1,99 @@
+/*
+ * blur-scope-core.h
+ *
+ * Toolkit-independent renderer for the Blur Scope, shared by the GTK and Qt
+ * plugins.  Frames are rendered in a thread of their own, at a fixed rate,
+ * so that the main thread only has to copy the finished frame to the screen.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef UI_COMMON_BLUR_SCOPE_CORE_H
+#define UI_COMMON_BLUR_SCOPE_CORE_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include <pthread.h>
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/mainloop.h>
+
+/* number of samples passed to render_mono_pcm () */
+#define BLUR_SCOPE_SAMPLES 512
+
+class BlurScopeCore
+{
+public:
+    /* called in the main thread when a new frame is ready */
+    typedef void (* RedrawFunc) (void * user);
+
+    BlurScopeCore (RedrawFunc redraw, void * user) :
+        m_redraw (redraw), m_user (user) {}
+
+    ~BlurScopeCore () { stop (); }
+
+    void start ();
+    void stop ();
+
+    void set_color (int color) { m_color.store (color, std::memory_order_relaxed); }
+
+    /* these only record the request; the render thread acts on it */
+    void resize (int width, int height);
+    void clear ();
+    void add_pcm (const float * pcm);
+
+    /* The latest frame, as 32-bit RGB pixels, or nullptr if there is none.
+     * It stays valid (and the render thread waits) until unlock_frame ()
+     * is called, which must be done in either case. */
+    const uint32_t * lock_frame (int & width, int & height, int & stride);
+    void unlock_frame ();
+
+private:
+    RedrawFunc m_redraw;
+    void * m_user;
+
+    pthread_t m_thread;
+    bool m_running = false;
+
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+
+    /* protected by the mutex */
+    bool m_quit = false;
+    bool m_resize_pending = false, m_clear_pending = false, m_pcm_pending = false;
+    int m_new_width = 0, m_new_height = 0;
+    float m_pcm[BLUR_SCOPE_SAMPLES];
+
+    /* Two frames, each with a one-pixel black border: the front one is
+     * complete and may be shown at any time; the next one is rendered from
+     * it into the back one, after which the two are swapped.  Reallocated
+     * and swapped only by the render thread, with the mutex held. */
+    Index<uint32_t> m_frames[2];
+    int m_front = 0;
+    int m_width = 0, m_height = 0, m_stride = 0;
+
+    std::atomic<int> m_color {0};
+    int m_idle_frames = 0;
+
+    QueuedFunc m_redraw_queue;
+
+    static void * run (void * data);
+    void loop ();
+    void render (const float * pcm);
+    void draw_vert_line (uint32_t * corner, int x, int y1, int y2, uint32_t color);
+};
+
+#endif // UI_COMMON_BLUR_SCOPE_CORE_H
@@ -0,0 +1,350 @@
+/*
+ * ebur128.cc
+ *
+ * ITU-R BS.1770 / EBU R128 loudness and true peak measurement, shared by
+ * the Loudness Meter and ReplayGain Scanner plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "ebur128.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <libfauxdcore/objects.h>
+
+static float energy_to_lufs (double energy)
+{
+    if (energy <= 0)
+        return -INFINITY;
+
+    return -0.691 + 10 * log10 (energy);
+}
+
+static double lufs_to_energy (double lufs)
+{
+    return pow (10, (lufs + 0.691) / 10);
+}
+
+static int lufs_to_bin (float lufs)
+{
+    return aud::clamp ((int) ((lufs - LOUDNESS_FLOOR) * 10), 0, HIST_BINS - 1);
+}
+
+static float bin_to_lufs (int bin)
+{
+    return LOUDNESS_FLOOR + (bin + 0.5f) / 10;
+}
+
+void LoudnessMeasurement::start (int channels, int rate)
+{
+    m_input_channels = channels;
+    m_channels = aud::min (channels, LOUDNESS_MAX_CHANNELS);
+    m_rate = rate;
+
+    /* K-weighting: a high shelf modelling the head, then a high pass
+     * (BS.1770 gives the coefficients for 48 kHz; these are the analog
+     * prototypes, warped to the actual rate) */
+    double K = tan (M_PI * 1681.974450955533 / rate);
+    double Q = 0.7071752369554196;
+    double Vh = pow (10, 3.999843853973347 / 20);
+    double Vb = pow (Vh, 0.4996667741545416);
+    double a0 = 1 + K / Q + K * K;
+
+    m_stage[0].b0 = (Vh + Vb * K / Q + K * K) / a0;
+    m_stage[0].b1 = 2 * (K * K - Vh) / a0;
+    m_stage[0].b2 = (Vh - Vb * K / Q + K * K) / a0;
+    m_stage[0].a1 = 2 * (K * K - 1) / a0;
+    m_stage[0].a2 = (1 - K / Q + K * K) / a0;
+
+    K = tan (M_PI * 38.13547087602444 / rate);
+    Q = 0.5003270373238773;
+    a0 = 1 + K / Q + K * K;
+
+    m_stage[1].b0 = 1;
+    m_stage[1].b1 = -2;
+    m_stage[1].b2 = 1;
+    m_stage[1].a1 = 2 * (K * K - 1) / a0;
+    m_stage[1].a2 = (1 - K / Q + K * K) / a0;
+
+    /* surround channels of a 5.0 or 5.1 layout count for more; LFE not
+     * at all */
+    for (int c = 0; c < m_channels; c ++)
+        m_weight[c] = 1;
+
+    if (m_channels == 5)
+        m_weight[3] = m_weight[4] = 1.41;
+    else if (m_channels == 6)
+    {
+        m_weight[3] = 0;
+        m_weight[4] = m_weight[5] = 1.41;
+    }
+
+    /* Windowed sinc, cutting off at the original Nyquist frequency, with
+     * each phase summing to 1 */
+    const int taps = TP_PHASES * TP_TAPS;
+    float h[taps];
+    double sum = 0;
+
+    for (int i = 0; i < taps; i ++)
+    {
+        double x = (i - (taps - 1) / 2.0) / TP_PHASES;
+        double sinc = x ? sin (M_PI * x) / (M_PI * x) : 1;
+        double window = 0.42 - 0.5 * cos (2 * M_PI * (i + 0.5) / taps) +
+         0.08 * cos (4 * M_PI * (i + 0.5) / taps);
+
+        h[i] = sinc * window;
+        sum += h[i];
+    }
+
+    for (int k = 0; k < TP_TAPS; k ++)
+    {
+        for (int p = 0; p < TP_PHASES; p ++)
+            m_tp_coef[k][p] = h[k * TP_PHASES + p] * TP_PHASES / sum;
+    }
+
+    m_block_frames = aud::max (rate / 10, 1);
+
+    reset ();
+}
+
+void LoudnessMeasurement::reset ()
+{
+    memset (m_state, 0, sizeof m_state);
+
+    m_block_pos = 0;
+    m_block_energy = 0;
+    m_blocks_done = 0;
+
+    m_momentary = m_short_term = LOUDNESS_FLOOR;
+    memset (m_integrated_hist, 0, sizeof m_integrated_hist);
+    memset (m_range_hist, 0, sizeof m_range_hist);
+}
+
+/* in holds TP_TAPS - 1 samples of history, then the new frames */
+void LoudnessMeasurement::true_peak (ChannelState & state, const float * in, int frames)
+{
+#ifdef __SSE2__
+    const __m128 abs_mask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    __m128 peak = _mm_set1_ps (state.peak);
+
+    for (int t = TP_TAPS - 1; t < TP_TAPS - 1 + frames; t ++)
+    {
+        __m128 acc = _mm_setzero_ps ();
+
+        for (int k = 0; k < TP_TAPS; k ++)
+            acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (m_tp_coef[k]),
+             _mm_set1_ps (in[t - k])));
+
+        peak = _mm_max_ps (peak, _mm_and_ps (acc, abs_mask));
+    }
+
+    peak = _mm_max_ps (peak, _mm_shuffle_ps (peak, peak, _MM_SHUFFLE (1, 0, 3, 2)));
+    peak = _mm_max_ps (peak, _mm_shuffle_ps (peak, peak, _MM_SHUFFLE (2, 3, 0, 1)));
+    _mm_store_ss (& state.peak, peak);
+#else
+    float peak = state.peak;
+
+    for (int t = TP_TAPS - 1; t < TP_TAPS - 1 + frames; t ++)
+    {
+        float acc[TP_PHASES] = {};
+
+        for (int k = 0; k < TP_TAPS; k ++)
+        {
+            for (int p = 0; p < TP_PHASES; p ++)
+                acc[p] += m_tp_coef[k][p] * in[t - k];
+        }
+
+        for (int p = 0; p < TP_PHASES; p ++)
+            peak = aud::max (peak, fabsf (acc[p]));
+    }
+
+    state.peak = peak;
+#endif
+}
+
+void LoudnessMeasurement::process (const float * data, int frames)
+{
+    if (! m_channels)
+        return;
+
+    while (frames > 0)
+    {
+        int chunk = aud::min (frames, m_block_frames - m_block_pos);
+
+        m_scratch.resize (TP_TAPS - 1 + chunk);
+        float * buf = m_scratch.begin ();
+        float * in = buf + TP_TAPS - 1;
+
+        for (int c = 0; c < m_channels; c ++)
+        {
+            ChannelState & state = m_state[c];
+
+            memcpy (buf, state.history, sizeof state.history);
+            for (int i = 0; i < chunk; i ++)
+                in[i] = data[i * m_input_channels + c];
+
+            true_peak (state, buf, chunk);
+            memcpy (state.history, in + chunk - (TP_TAPS - 1), sizeof state.history);
+
+            if (! m_weight[c])
+                continue;
+
+            double energy = 0;
+
+            for (int i = 0; i < chunk; i ++)
+            {
+                double x = in[i];
+
+                for (int s = 0; s < 2; s ++)
+                {
+                    const Biquad & f = m_stage[s];
+                    double y = f.b0 * x + state.z1[s];
+                    state.z1[s] = f.b1 * x - f.a1 * y + state.z2[s];
+                    state.z2[s] = f.b2 * x - f.a2 * y;
+                    x = y;
+                }
+
+                energy += x * x;
+            }
+
+            m_block_energy += m_weight[c] * energy;
+        }
+
+        data += chunk * m_input_channels;
+        frames -= chunk;
+        m_block_pos += chunk;
+
+        if (m_block_pos == m_block_frames)
+            end_block ();
+    }
+}
+
+void LoudnessMeasurement::end_block ()
+{
+    memmove (m_blocks + 1, m_blocks, sizeof m_blocks - sizeof m_blocks[0]);
+    m_blocks[0] = m_block_energy / m_block_frames;
+    m_blocks_done = aud::min (m_blocks_done + 1, 30);
+
+    m_block_pos = 0;
+    m_block_energy = 0;
+
+    /* gating blocks overlap by 75% (momentary), and short-term values are
+     * taken at 10 Hz, as in EBU Tech 3341/3342 */
+    if (m_blocks_done >= 4)
+    {
+        double sum = 0;
+        for (int i = 0; i < 4; i ++)
+            sum += m_blocks[i];
+
+        m_momentary = energy_to_lufs (sum / 4);
+        if (m_momentary >= LOUDNESS_FLOOR)
+            m_integrated_hist[lufs_to_bin (m_momentary)] ++;
+    }
+
+    if (m_blocks_done >= 30)
+    {
+        double sum = 0;
+        for (int i = 0; i < 30; i ++)
+            sum += m_blocks[i];
+
+        m_short_term = energy_to_lufs (sum / 30);
+        if (m_short_term >= LOUDNESS_FLOOR)
+            m_range_hist[lufs_to_bin (m_short_term)] ++;
+    }
+}
+
+void LoudnessMeasurement::add_histogram (const int * hist)
+{
+    for (int i = 0; i < HIST_BINS; i ++)
+        m_integrated_hist[i] += hist[i];
+}
+
+/* mean energy of the histogram bins from start on */
+static double mean_energy (const int * hist, int start, int & count)
+{
+    double sum = 0;
+    count = 0;
+
+    for (int i = start; i < HIST_BINS; i ++)
+    {
+        if (hist[i])
+        {
+            sum += hist[i] * lufs_to_energy (bin_to_lufs (i));
+            count += hist[i];
+        }
+    }
+
+    return count ? sum / count : 0;
+}
+
+void LoudnessMeasurement::get_readings (LoudnessReadings & readings)
+{
+    readings.channels = m_channels;
+
+    for (int c = 0; c < m_channels; c ++)
+    {
+        readings.true_peak[c] = m_state[c].peak;
+        m_state[c].peak = 0;
+    }
+
+    readings.momentary = m_momentary;
+    readings.short_term = m_short_term;
+
+    /* integrated: relative gate 10 LU below the absolutely gated mean */
+    int count;
+    double energy = mean_energy (m_integrated_hist, 0, count);
+
+    if (count)
+    {
+        int gate = lufs_to_bin (energy_to_lufs (energy) - 10);
+        readings.integrated = energy_to_lufs (mean_energy (m_integrated_hist, gate, count));
+    }
+    else
+        readings.integrated = LOUDNESS_FLOOR;
+
+    /* range: relative gate 20 LU below, then the 10th to 95th percentile */
+    energy = mean_energy (m_range_hist, 0, count);
+    readings.range = 0;
+
+    if (count)
+    {
+        int gate = lufs_to_bin (energy_to_lufs (energy) - 20);
+        int total = 0;
+
+        for (int i = gate; i < HIST_BINS; i ++)
+            total += m_range_hist[i];
+
+        int low = -1, high = -1, seen = 0;
+
+        for (int i = gate; i < HIST_BINS && high < 0; i ++)
+        {
+            seen += m_range_hist[i];
+
+            if (low < 0 && seen > total * 0.10)
+                low = i;
+            if (seen >= total * 0.95)
+                high = i;
+        }
+
+        if (low >= 0 && high >= 0)
+            readings.range = (high - low) / 10.0f;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * ebur128.h
+ *
+ * ITU-R BS.1770 / EBU R128 loudness and true peak measurement, shared by
+ * the Loudness Meter and ReplayGain Scanner plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_EBUR128_H
+#define UI_COMMON_EBUR128_H
+
+#include <libfauxdcore/index.h>
+
+#include "loudness-readings.h"
+
+/* true peak: taps of the 4x oversampling filter, per phase */
+#define TP_PHASES 4
+#define TP_TAPS 12
+
+/* the gated measurements keep histograms of 0.1 LU bins from the floor
+ * (-70 LUFS) up to +30 LUFS, so memory and time stay bounded however long
+ * the measurement runs */
+#define HIST_BINS 1000
+
+/* ITU-R BS.1770 / EBU R128 loudness and true peak measurement */
+class LoudnessMeasurement
+{
+public:
+    void start (int channels, int rate);
+
+    /* forgets everything measured so far */
+    void reset ();
+
+    void process (const float * data, int frames);
+
+    /* fills in the readings; the true peaks start over afterwards */
+    void get_readings (LoudnessReadings & readings);
+
+    /* the gated momentary loudness so far, as HIST_BINS bins; adding up the
+     * histograms of several measurements (the tracks of an album, say) gives
+     * their combined integrated loudness */
+    const int * histogram () const { return m_integrated_hist; }
+    void add_histogram (const int * hist);
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct ChannelState {
+        double z1[2], z2[2];     /* K-weighting filter state, per stage */
+        float history[TP_TAPS - 1];  /* last input samples, newest last */
+        float peak;
+    };
+
+    int m_input_channels = 0, m_channels = 0, m_rate = 0;
+    Biquad m_stage[2];
+    float m_weight[LOUDNESS_MAX_CHANNELS];
+    ChannelState m_state[LOUDNESS_MAX_CHANNELS];
+
+    /* coefficients of the true-peak filter, [tap][phase], so that all
+     * phases of one output sample are computed together */
+    float m_tp_coef[TP_TAPS][TP_PHASES];
+    Index<float> m_scratch;
+
+    /* 100 ms blocks: the momentary value spans 4 of them, the short-term
+     * value 30 */
+    int m_block_frames = 0, m_block_pos = 0;
+    double m_block_energy = 0;
+    double m_blocks[30];
+    int m_blocks_done = 0;
+
+    float m_momentary = LOUDNESS_FLOOR, m_short_term = LOUDNESS_FLOOR;
+    int m_integrated_hist[HIST_BINS];
+    int m_range_hist[HIST_BINS];
+
+    void end_block ();
+    void true_peak (ChannelState & state, const float * in, int frames);
+};
+
+#endif // UI_COMMON_EBUR128_H
@@ -0,0 +1,537 @@
+/*
+ * fetch-queue.cc
+ *
+ * Background fetching of per-song data (album art, lyrics) with a disk cache,
+ * shared by the album art and lyrics plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "fetch-queue.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <utime.h>
+#include <algorithm>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/runtime.h>
+
+/* how often a running helper is checked on */
+#define HELPER_POLL_MS 100
+
+/* once the cache is too large, it is trimmed to this share of the limit, so
+ * that it is not trimmed again on every new entry */
+#define CACHE_TRIM_PERCENT 75
+
+static int64_t monotonic_ms ()
+{
+    return g_get_monotonic_time () / 1000;
+}
+
+/* lowercase, with runs of white space made single spaces, so that tags
+ * differing only in these still find the same entry */
+static void append_normalized (StringBuf & buf, const char * str)
+{
+    if (str)
+    {
+        char * folded = g_utf8_casefold (str, -1);
+        bool space = false, started = false;
+
+        for (const char * c = folded; * c; c ++)
+        {
+            if (g_ascii_isspace (* c))
+                space = true;
+            else
+            {
+                if (space && started)
+                    buf.insert (-1, " ", 1);
+
+                buf.insert (-1, c, 1);
+                space = false;
+                started = true;
+            }
+        }
+
+        g_free (folded);
+    }
+
+    buf.insert (-1, "\n", 1);
+}
+
+static String cache_key (const FetchRequest & request)
+{
+    StringBuf buf (0);
+    append_normalized (buf, request.artist);
+    append_normalized (buf, request.album);
+    append_normalized (buf, request.title);
+
+    char * hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, buf, -1);
+    String key (hash);
+    g_free (hash);
+
+    return key;
+}
+
+StringBuf FetchQueue::cache_dir () const
+{
+    return filename_build ({aud_get_path (AudPath::UserDir), "fetch-cache", m_section});
+}
+
+String FetchQueue::find_entry (const char * key, bool touch)
+{
+    StringBuf dir = cache_dir ();
+
+    for (auto & ext : str_list_to_index (m_exts, ","))
+    {
+        StringBuf path = filename_build ({dir, str_concat ({key, ".", ext})});
+
+        if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        {
+            /* the modification time is what eviction goes by */
+            if (touch && g_utime (path, nullptr) < 0)
+                AUDWARN ("Failed to update the time of %s.\n", (const char *) path);
+
+            return String (path);
+        }
+    }
+
+    return String ();
+}
+
+String FetchQueue::lookup (const FetchRequest & request)
+{
+    if (request.force)
+        return String ();
+
+    return find_entry (cache_key (request), true);
+}
+
+/* copies the file into the cache; the extension is kept, as it is all that
+ * tells the image loaders what type of file it is */
+String FetchQueue::store (const char * key, const char * file)
+{
+    const char * ext = strrchr (file, '.');
+    if (! ext || strchr (ext, '/'))
+        ext = ".txt";
+
+    char * data = nullptr;
+    gsize len = 0;
+    GError * error = nullptr;
+
+    if (! g_file_get_contents (file, & data, & len, & error))
+    {
+        AUDERR ("Could not read %s: %s\n", file, error->message);
+        g_error_free (error);
+        return String ();
+    }
+
+    StringBuf dir = cache_dir ();
+    StringBuf path = filename_build ({dir, str_concat ({key, ext})});
+    String stored;
+
+    /* a refetched entry may be of another type than the one it replaces */
+    for (auto & other : str_list_to_index (m_exts, ","))
+        g_unlink (filename_build ({dir, str_concat ({key, ".", other})}));
+
+    if (g_mkdir_with_parents (dir, 0755) < 0)
+        AUDERR ("Could not create %s: %s\n", (const char *) dir, strerror (errno));
+    else if (! g_file_set_contents (path, data, len, & error))
+    {
+        AUDERR ("Could not write %s: %s\n", (const char *) path, error->message);
+        g_error_free (error);
+    }
+    else
+    {
+        stored = String (path);
+
+        if (m_cache_size >= 0)
+            m_cache_size += len;
+    }
+
+    g_free (data);
+    evict (stored);
+
+    return stored;
+}
+
+/* removes the least recently used entries (but not keep, which is about to be
+ * used) once the cache has grown too large; the size is only added up the
+ * first time and then kept track of */
+void FetchQueue::evict (const char * keep)
+{
+    int max_mb = aud_get_int (m_section, "fetch_cache_mb");
+    if (max_mb <= 0)
+        max_mb = m_default_cache_mb;
+
+    int64_t max_size = (int64_t) max_mb << 20;
+
+    if (m_cache_size >= 0 && m_cache_size <= max_size)
+        return;
+
+    struct Entry {
+        String path;
+        int64_t size;
+        time_t mtime;
+    };
+
+    StringBuf dir = cache_dir ();
+    GDir * folder = g_dir_open (dir, 0, nullptr);
+    if (! folder)
+        return;
+
+    Index<Entry> entries;
+    m_cache_size = 0;
+
+    const char * name;
+    while ((name = g_dir_read_name (folder)))
+    {
+        StringBuf path = filename_build ({dir, name});
+        GStatBuf info;
+
+        if (g_stat (path, & info) == 0 && S_ISREG (info.st_mode))
+        {
+            Entry & entry = entries.append ();
+            entry.path = String (path);
+            entry.size = info.st_size;
+            entry.mtime = info.st_mtime;
+            m_cache_size += info.st_size;
+        }
+    }
+
+    g_dir_close (folder);
+
+    if (m_cache_size <= max_size)
+        return;
+
+    std::sort (entries.begin (), entries.end (), [] (const Entry & a, const Entry & b)
+        { return a.mtime < b.mtime; });
+
+    int64_t target = max_size / 100 * CACHE_TRIM_PERCENT;
+    int removed = 0;
+
+    for (const Entry & entry : entries)
+    {
+        if (m_cache_size <= target)
+            break;
+
+        if (keep && ! strcmp (entry.path, keep))
+            continue;
+
+        if (g_unlink (entry.path) == 0)
+        {
+            m_cache_size -= entry.size;
+            removed ++;
+        }
+    }
+
+    AUDDBG ("Removed %d old entries from the %s cache.\n", removed, m_section);
+}
+
+void FetchQueue::run (Job & job, Result & result)
+{
+    result.request = std::move (job.request);
+    result.status = 0;
+    result.serial = job.serial;
+
+    /* another request for the same song may have been dealt with already */
+    if (! result.request.force)
+    {
+        result.path = find_entry (job.key, true);
+        if (result.path)
+            return;
+    }
+
+    String file;
+    if (m_fetch (* this, result.request, file, result.status) && file && ! cancelled ())
+        result.path = store (job.key, file);
+}
+
+void * FetchQueue::worker (void * data)
+{
+    auto queue = (FetchQueue *) data;
+
+    pthread_mutex_lock (& queue->m_mutex);
+
+    while (! queue->m_quit)
+    {
+        if (! queue->m_pending.len ())
+        {
+            pthread_cond_wait (& queue->m_cond, & queue->m_mutex);
+            continue;
+        }
+
+        int64_t wait = queue->m_pending[0].due - monotonic_ms ();
+
+        if (wait > 0)
+        {
+            struct timespec ts;
+            clock_gettime (CLOCK_REALTIME, & ts);
+            ts.tv_sec += wait / 1000;
+            ts.tv_nsec += (wait % 1000) * 1000000;
+            if (ts.tv_nsec >= 1000000000)
+            {
+                ts.tv_sec ++;
+                ts.tv_nsec -= 1000000000;
+            }
+
+            pthread_cond_timedwait (& queue->m_cond, & queue->m_mutex, & ts);
+            continue;
+        }
+
+        Job job = std::move (queue->m_pending[0]);
+        queue->m_pending.clear ();
+        queue->m_running_key = job.key;
+        queue->m_running_serial = job.serial;
+
+        pthread_mutex_unlock (& queue->m_mutex);
+
+        Result result;
+        queue->run (job, result);
+
+        pthread_mutex_lock (& queue->m_mutex);
+
+        queue->m_running_key = String ();
+        queue->m_results.append (std::move (result));
+        queue->m_deliver.queue (deliver, queue);
+    }
+
+    pthread_mutex_unlock (& queue->m_mutex);
+    return nullptr;
+}
+
+void FetchQueue::deliver (void * data)
+{
+    auto queue = (FetchQueue *) data;
+
+    pthread_mutex_lock (& queue->m_mutex);
+    Index<Result> results = std::move (queue->m_results);
+    int serial = queue->m_serial.load (std::memory_order_relaxed);
+    pthread_mutex_unlock (& queue->m_mutex);
+
+    for (const Result & result : results)
+    {
+        if (result.serial == serial)
+            queue->m_done (result.request, result.path, result.status);
+    }
+}
+
+void FetchQueue::request (const FetchRequest & request, int delay_ms)
+{
+    String key = cache_key (request);
+    int64_t due = monotonic_ms () + delay_ms;
+
+    pthread_mutex_lock (& m_mutex);
+
+    if (! request.force && m_running_key && ! strcmp (m_running_key, key)
+     && m_running_serial == m_serial.load (std::memory_order_relaxed))
+    {
+        /* already being fetched; the result will do for both */
+        m_pending.clear ();
+    }
+    else if (! request.force && m_pending.len () && ! strcmp (m_pending[0].key, key))
+        m_pending[0].due = aud::min (m_pending[0].due, due);
+    else
+    {
+        m_pending.clear ();
+        m_pending.append (Job {request, key, ++ m_serial, due});
+    }
+
+    if (! m_thread_running)
+    {
+        m_quit = false;
+        m_thread_running = ! pthread_create (& m_thread, nullptr, worker, this);
+        if (! m_thread_running)
+            AUDERR ("Could not create the %s fetch thread: %s\n", m_section, strerror (errno));
+    }
+
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void FetchQueue::cancel ()
+{
+    pthread_mutex_lock (& m_mutex);
+    m_pending.clear ();
+    m_serial ++;
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void FetchQueue::cleanup ()
+{
+    pthread_mutex_lock (& m_mutex);
+    m_pending.clear ();
+    m_serial ++;
+    m_quit = true;
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    if (m_thread_running)
+    {
+        pthread_join (m_thread, nullptr);
+        m_thread_running = false;
+    }
+
+    m_deliver.stop ();
+    m_results.clear ();
+}
+
+#ifndef _WIN32
+/* in a process group of its own, so that whatever the helper starts in turn
+ * is stopped along with it */
+static void helper_setup (void *)
+{
+    setpgid (0, 0);
+}
+
+static void log_helper_output (int fd, StringBuf & line)
+{
+    char buf[512];
+    int len;
+
+    while ((len = read (fd, buf, sizeof buf)) > 0)
+    {
+        for (int i = 0; i < len; i ++)
+        {
+            if (buf[i] == '\n')
+            {
+                AUDDBG ("helper: %s\n", (const char *) line);
+                line.resize (0);
+            }
+            else
+                line.insert (-1, buf + i, 1);
+        }
+    }
+}
+#endif
+
+int fetch_run_helper (FetchQueue & queue, const char * command,
+ const Index<String> & args)
+{
+    int argc;
+    char ** command_argv;
+    GError * error = nullptr;
+
+    if (! g_shell_parse_argv (command, & argc, & command_argv, & error))
+    {
+        AUDERR ("Invalid helper command (%s): %s\n", command, error->message);
+        g_error_free (error);
+        return -1;
+    }
+
+    Index<char *> argv;
+    for (int i = 0; i < argc; i ++)
+        argv.append (command_argv[i]);
+    for (const String & arg : args)
+        argv.append ((char *) (const char *) arg);
+    argv.append (nullptr);
+
+    GPid pid;
+    int status = -1;
+
+#ifdef _WIN32
+    bool spawned = g_spawn_async (nullptr, argv.begin (), nullptr,
+     (GSpawnFlags) (G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD),
+     nullptr, nullptr, & pid, & error);
+#else
+    int out_fd;
+    bool spawned = g_spawn_async_with_pipes (nullptr, argv.begin (), nullptr,
+     (GSpawnFlags) (G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD),
+     helper_setup, nullptr, & pid, nullptr, & out_fd, nullptr, & error);
+#endif
+
+    g_strfreev (command_argv);
+
+    if (! spawned)
+    {
+        AUDERR ("Could not run the helper (%s): %s\n", command, error->message);
+        g_error_free (error);
+        return -1;
+    }
+
+#ifdef _WIN32
+    while (WaitForSingleObject (pid, HELPER_POLL_MS) == WAIT_TIMEOUT)
+    {
+        if (queue.cancelled ())
+        {
+            TerminateProcess (pid, 1);
+            WaitForSingleObject (pid, INFINITE);
+            break;
+        }
+    }
+
+    DWORD code;
+    if (! queue.cancelled () && GetExitCodeProcess (pid, & code))
+        status = code;
+#else
+    fcntl (out_fd, F_SETFL, fcntl (out_fd, F_GETFL) | O_NONBLOCK);
+
+    StringBuf line (0);
+    int wstatus;
+
+    while (true)
+    {
+        struct pollfd fd = {out_fd, POLLIN, 0};
+        poll (& fd, 1, HELPER_POLL_MS);
+        log_helper_output (out_fd, line);
+
+        pid_t done = waitpid (pid, & wstatus, WNOHANG);
+
+        if (done == pid)
+        {
+            if (WIFEXITED (wstatus))
+                status = WEXITSTATUS (wstatus);
+            break;
+        }
+
+        if (done < 0)
+            break;
+
+        if (queue.cancelled ())
+        {
+            AUDDBG ("Stopping the helper (%s).\n", command);
+            kill (- pid, SIGTERM);
+            waitpid (pid, & wstatus, 0);
+            break;
+        }
+    }
+
+    log_helper_output (out_fd, line);
+    if (line.len ())
+        AUDDBG ("helper: %s\n", (const char *) line);
+
+    close (out_fd);
+#endif
+
+    g_spawn_close_pid (pid);
+    return status;
+}
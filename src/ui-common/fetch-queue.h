@@ -0,0 +1,148 @@
+/*
+ * fetch-queue.h
+ *
+ * Background fetching of per-song data (album art, lyrics) with a disk cache,
+ * shared by the album art and lyrics plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_FETCH_QUEUE_H
+#define UI_COMMON_FETCH_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include <pthread.h>
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/mainloop.h>
+#include <libfauxdcore/objects.h>
+
+struct FetchRequest
+{
+    /* what the cache entry is keyed by (after normalizing case and spaces) */
+    String artist, album, title;
+
+    /* passed on to the backend */
+    String filename;  /* the song's URI */
+    String options;
+    bool force = false;  /* fetch again, even if there is a cache entry */
+};
+
+/* Fetches one song's data at a time on a worker thread.  Only the newest
+ * request matters (it is for the song now playing), so a new request
+ * cancels the older ones, unless it is for the same song, in which case the
+ * two are merged.  Whatever is found is kept in a cache directory of its
+ * own, named by a hash of the song's artist, album and title; the least
+ * recently used entries are removed once it grows too large. */
+class FetchQueue
+{
+public:
+    /* The backend.  Runs on the worker thread; on success, sets file to a
+     * local file holding the data, which is then copied into the cache, and
+     * returns true.  status is passed on to the done callback as is.  Should
+     * poll cancelled () and give up soon once it is set. */
+    typedef bool (* FetchFunc) (FetchQueue & queue, const FetchRequest & request,
+     String & file, int & status);
+
+    /* Called in the main thread once a request has been dealt with, unless it
+     * was cancelled; path is the cache entry, or null if nothing was found. */
+    typedef void (* DoneFunc) (const FetchRequest & request, const char * path,
+     int status);
+
+    /* section is the config section, also naming the cache directory; exts
+     * are the file extensions that the backend may produce */
+    FetchQueue (const char * section, const char * exts, int default_cache_mb,
+     FetchFunc fetch, DoneFunc done) :
+        m_section (section), m_exts (exts), m_default_cache_mb (default_cache_mb),
+        m_fetch (fetch), m_done (done) {}
+
+    /* cancels everything and stops the worker thread */
+    void cleanup ();
+
+    /* Looks for a cache entry for the song, without blocking on the worker
+     * thread; marks it as recently used. */
+    String lookup (const FetchRequest & request);
+
+    /* Queues a request, to be started after delay_ms.  A request that comes
+     * in the meantime replaces it (or, for the same song, is merged into it),
+     * so a short delay lets the song title of a stream settle first. */
+    void request (const FetchRequest & request, int delay_ms = 0);
+
+    /* forgets the queued request and stops the running one */
+    void cancel ();
+
+    /* for the backend */
+    bool cancelled () const
+        { return m_running_serial != m_serial.load (std::memory_order_relaxed); }
+
+private:
+    struct Job {
+        FetchRequest request;
+        String key;
+        int serial;
+        int64_t due;   /* monotonic time in milliseconds */
+    };
+
+    struct Result {
+        FetchRequest request;
+        String path;
+        int status;
+        int serial;
+    };
+
+    const char * m_section;
+    const char * m_exts;
+    int m_default_cache_mb;
+    FetchFunc m_fetch;
+    DoneFunc m_done;
+
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+    pthread_t m_thread;
+    bool m_thread_running = false;
+    bool m_quit = false;
+
+    Index<Job> m_pending;     /* at most one */
+    String m_running_key;     /* of the job on the worker thread, if any */
+    int m_running_serial = 0;
+    std::atomic<int> m_serial {0};   /* bumped to cancel everything before */
+
+    Index<Result> m_results;
+    QueuedFunc m_deliver;
+
+    /* used on the worker thread only */
+    int64_t m_cache_size = -1;
+
+    StringBuf cache_dir () const;
+    String find_entry (const char * key, bool touch);
+    String store (const char * key, const char * file);
+    void evict (const char * keep);
+    void run (Job & job, Result & result);
+
+    static void * worker (void * data);
+    static void deliver (void * data);
+};
+
+/* The backend for helper programs (such as the Perl helpers that come with
+ * Fauxdacious).  command is the helper's command line, taken from the config,
+ * to which the arguments are added; its output goes to the log.  Returns the
+ * exit status of the helper, or -1 if it could not be run or was stopped
+ * because the request was cancelled. */
+int fetch_run_helper (FetchQueue & queue, const char * command,
+ const Index<String> & args);
+
+#endif // UI_COMMON_FETCH_QUEUE_H
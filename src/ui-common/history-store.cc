@@ -0,0 +1,861 @@
+/*
+ * history-store.cc
+ *
+ * Persistent playback history, shared by the GTK and Qt playback history
+ * plugins.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File formats (all numbers little-endian):
+ *
+ * playback-history.log: "FXHLOG01", generation (8 bytes), then the records:
+ *     time (8), type (4), playlist ID (4), position (4), length of the
+ *     filename (4), length of the text (4), filename, text
+ * playback-history.idx: "FXHIDX01", entries ever appended (8), generation
+ *     (8), then for each record: its offset in the log (8), time (8)
+ * playback-history.removed: generation, then the removed entries, as text
+ * playback-history.counts: "FXHCNT01", entries ever appended when saved (8),
+ *     then for each file: play count (4), its latest record
+ *
+ * A record is appended to the log before its index entry, so after a crash
+ * the log can only be ahead of the index, and the few records missing from
+ * the index are added to it on opening.  Compacting writes new files with a
+ * new generation; an index or list of removed entries that does not match
+ * the log's generation is rebuilt or dropped.
+ */
+
+#include "history-store.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/runtime.h>
+#include <libfauxdcore/templates.h>
+
+#define LOG_NAME "playback-history.log"
+#define INDEX_NAME "playback-history.idx"
+#define REMOVED_NAME "playback-history.removed"
+#define COUNTS_NAME "playback-history.counts"
+
+#define LOG_MAGIC "FXHLOG01"
+#define INDEX_MAGIC "FXHIDX01"
+#define COUNTS_MAGIC "FXHCNT01"
+#define MAGIC_LEN 8
+
+#define LOG_HEADER 16
+#define INDEX_HEADER 24
+#define INDEX_ENTRY 16
+#define RECORD_HEADER 28
+
+/* anything longer is taken as a sign of a damaged file */
+#define MAX_STRING (1 << 20)
+
+/* don't bother compacting less than this */
+#define COMPACT_MIN_ENTRIES 1024
+
+static StringBuf store_path (const char * name)
+{
+    return filename_build ({aud_get_path (AudPath::UserDir), name});
+}
+
+static void put_int (Index<char> & buf, int64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i ++)
+        buf.append ((char) (value >> (8 * i)));
+}
+
+static int64_t get_int64 (const unsigned char * data)
+{
+    uint64_t value = 0;
+    for (int i = 8; i --; )
+        value = (value << 8) | data[i];
+
+    return (int64_t) value;
+}
+
+static int32_t get_int32 (const unsigned char * data)
+{
+    return (int32_t) (data[0] | (data[1] << 8) | (data[2] << 16) |
+     ((uint32_t) data[3] << 24));
+}
+
+static void put_record (Index<char> & buf, const HistoryRecord & record)
+{
+    int filename_len = record.filename ? strlen (record.filename) : 0;
+    int text_len = record.text ? strlen (record.text) : 0;
+
+    put_int (buf, record.time, 8);
+    put_int (buf, record.type, 4);
+    put_int (buf, record.playlist_id, 4);
+    put_int (buf, record.position, 4);
+    put_int (buf, filename_len, 4);
+    put_int (buf, text_len, 4);
+
+    buf.insert (record.filename, -1, filename_len);
+    buf.insert (record.text, -1, text_len);
+}
+
+static String read_string (FILE * file, int len)
+{
+    StringBuf buf (len);
+    if (len && fread (buf, 1, len, file) != (size_t) len)
+        return String ();
+
+    return String (buf);
+}
+
+/* reads a record from the current position; length is set to its size in
+ * the file */
+static bool read_next (FILE * file, HistoryRecord & record, int64_t & length)
+{
+    unsigned char header[RECORD_HEADER];
+    if (fread (header, 1, sizeof header, file) != sizeof header)
+        return false;
+
+    int filename_len = get_int32 (header + 20);
+    int text_len = get_int32 (header + 24);
+    if (filename_len < 0 || filename_len > MAX_STRING ||
+     text_len < 0 || text_len > MAX_STRING)
+        return false;
+
+    record.time = get_int64 (header);
+    record.type = get_int32 (header + 8);
+    record.playlist_id = get_int32 (header + 12);
+    record.position = get_int32 (header + 16);
+
+    record.filename = read_string (file, filename_len);
+    record.text = read_string (file, text_len);
+    if (! record.filename || ! record.text)
+        return false;
+
+    length = RECORD_HEADER + filename_len + text_len;
+    return true;
+}
+
+/* opens a file for reading and writing, creating it with the given header
+ * if it does not exist or does not start with the magic */
+static FILE * open_file (const char * name, const char * magic, int header_len)
+{
+    StringBuf path = store_path (name);
+    FILE * file = g_fopen (path, "r+b");
+
+    if (file)
+    {
+        char buf[MAGIC_LEN];
+        if (fread (buf, 1, MAGIC_LEN, file) == MAGIC_LEN && ! memcmp (buf, magic, MAGIC_LEN))
+            return file;
+
+        fclose (file);
+
+        /* keep it, just in case */
+        AUDERR ("%s is damaged, starting a new one.\n", name);
+        g_rename (path, str_concat ({path, ".bad"}));
+    }
+
+    if (! (file = g_fopen (path, "w+b")))
+    {
+        AUDERR ("Could not create %s: %s.\n", name, strerror (errno));
+        return nullptr;
+    }
+
+    Index<char> header;
+    header.insert (magic, 0, MAGIC_LEN);
+    header.insert (-1, header_len - MAGIC_LEN);
+
+    if (fwrite (header.begin (), 1, header_len, file) != (size_t) header_len)
+    {
+        AUDERR ("Could not write to %s.\n", name);
+        fclose (file);
+        return nullptr;
+    }
+
+    return file;
+}
+
+static int64_t file_size (FILE * file)
+{
+    fseeko (file, 0, SEEK_END);
+    return ftello (file);
+}
+
+bool HistoryStore::open ()
+{
+    if (m_log)
+        return true;
+
+    if (! (m_log = open_file (LOG_NAME, LOG_MAGIC, LOG_HEADER)) ||
+     ! (m_index = open_file (INDEX_NAME, INDEX_MAGIC, INDEX_HEADER)))
+    {
+        close ();
+        return false;
+    }
+
+    unsigned char log_header[LOG_HEADER], index_header[INDEX_HEADER];
+
+    fseeko (m_log, 0, SEEK_SET);
+    fseeko (m_index, 0, SEEK_SET);
+
+    if (fread (log_header, 1, LOG_HEADER, m_log) != LOG_HEADER ||
+     fread (index_header, 1, INDEX_HEADER, m_index) != INDEX_HEADER)
+    {
+        AUDERR ("Could not read the playback history.\n");
+        close ();
+        return false;
+    }
+
+    m_generation = get_int64 (log_header + MAGIC_LEN);
+    m_appended = get_int64 (index_header + MAGIC_LEN);
+    m_log_size = file_size (m_log);
+
+    /* an index from before the last compaction is of no use */
+    bool rebuild = (get_int64 (index_header + 16) != m_generation);
+    m_total = rebuild ? 0 : (file_size (m_index) - INDEX_HEADER) / INDEX_ENTRY;
+
+    recover (rebuild);
+    load_removed ();
+
+    m_first = 0;
+    m_count = m_total - m_removed.len ();
+    apply_retention ();
+
+    AUDDBG ("Playback history: %d entries, %d kept.\n", m_total, m_count);
+    return true;
+}
+
+/* matches the index with the log, see the top of the file */
+void HistoryStore::recover (bool rebuild)
+{
+    HistoryRecord record;
+    int64_t end = LOG_HEADER;
+
+    /* normally, checks just the last index entry */
+    while (m_total > 0)
+    {
+        IndexEntry entry;
+        int64_t length;
+
+        if (read_index (m_total - 1, entry) && entry.offset >= LOG_HEADER &&
+         fseeko (m_log, entry.offset, SEEK_SET) == 0 &&
+         read_next (m_log, record, length) && entry.offset + length <= m_log_size)
+        {
+            end = entry.offset + length;
+            break;
+        }
+
+        m_total --;
+    }
+
+    int reindexed = 0;
+
+    if (end < m_log_size)
+    {
+        int64_t length;
+        fseeko (m_log, end, SEEK_SET);
+
+        while (end < m_log_size && read_next (m_log, record, length))
+        {
+            Index<char> buf;
+            put_int (buf, end, 8);
+            put_int (buf, record.time, 8);
+
+            fseeko (m_index, INDEX_HEADER + (int64_t) m_total * INDEX_ENTRY, SEEK_SET);
+            if (fwrite (buf.begin (), 1, INDEX_ENTRY, m_index) != INDEX_ENTRY)
+                break;
+
+            /* back to reading */
+            fseeko (m_log, end + length, SEEK_SET);
+
+            end += length;
+            m_total ++;
+            reindexed ++;
+        }
+
+        /* whatever is left is a record cut short */
+        m_log_size = end;
+        fflush (m_log);
+        if (ftruncate (fileno (m_log), end) < 0)
+            AUDWARN ("Could not truncate " LOG_NAME ".\n");
+    }
+
+    fflush (m_index);
+    if (ftruncate (fileno (m_index), INDEX_HEADER + (int64_t) m_total * INDEX_ENTRY) < 0)
+        AUDWARN ("Could not truncate " INDEX_NAME ".\n");
+
+    /* records that never made it into the index were played since the play
+     * counts were saved; a rebuilt index holds no new records */
+    if (! rebuild)
+        m_appended += reindexed;
+
+    if (reindexed || rebuild)
+    {
+        AUDINFO ("Playback history: %d entries added to the index.\n", reindexed);
+        write_header ();
+    }
+}
+
+void HistoryStore::write_header ()
+{
+    Index<char> buf;
+    put_int (buf, m_appended, 8);
+    put_int (buf, m_generation, 8);
+
+    fseeko (m_index, MAGIC_LEN, SEEK_SET);
+    if (fwrite (buf.begin (), 1, buf.len (), m_index) != (size_t) buf.len ())
+        AUDERR ("Could not write to " INDEX_NAME ".\n");
+
+    fflush (m_index);
+}
+
+void HistoryStore::load_removed ()
+{
+    m_removed.clear ();
+
+    char * contents = nullptr;
+    if (! g_file_get_contents (store_path (REMOVED_NAME), & contents, nullptr, nullptr))
+        return;
+
+    char * next = contents;
+    if (strtoll (next, & next, 10) == m_generation)
+    {
+        int prev = -1;
+        while (* next)
+        {
+            char * end;
+            long value = strtol (next, & end, 10);
+            if (end == next)
+                break;
+
+            /* keep it sorted, even if the file was not */
+            if (value > prev && value < m_total)
+                m_removed.append ((prev = value));
+
+            next = end;
+        }
+    }
+
+    g_free (contents);
+}
+
+void HistoryStore::save_removed ()
+{
+    StringBuf path = store_path (REMOVED_NAME);
+
+    if (! m_removed.len ())
+    {
+        g_unlink (path);
+        return;
+    }
+
+    StringBuf contents = int_to_str (m_generation);
+    for (int removed : m_removed)
+        contents.insert (-1, str_printf (" %d", removed));
+
+    contents.insert (-1, "\n");
+
+    if (! g_file_set_contents (path, contents, contents.len (), nullptr))
+        AUDERR ("Could not write to " REMOVED_NAME ".\n");
+}
+
+void HistoryStore::close ()
+{
+    if (m_log && m_index)
+    {
+        compact ();
+        save_counts ();
+    }
+
+    if (m_log)
+        fclose (m_log);
+    if (m_index)
+        fclose (m_index);
+
+    m_log = m_index = nullptr;
+    m_log_size = m_appended = m_generation = 0;
+    m_total = m_first = m_count = 0;
+    m_removed.clear ();
+
+    for (CachedRecord & cached : m_cache)
+        cached = CachedRecord ();
+
+    m_counts_loaded = m_counts_changed = false;
+    m_counts_appended = 0;
+    m_counts.clear ();
+}
+
+void HistoryStore::set_retention (int max_entries, int max_days)
+{
+    m_max_entries = aud::max (max_entries, 0);
+    m_max_days = aud::max (max_days, 0);
+
+    if (m_log)
+        apply_retention ();
+}
+
+/* returns how many entries were dropped */
+int HistoryStore::apply_retention ()
+{
+    int first = m_first;
+
+    if (m_max_entries && m_count > m_max_entries)
+        first = physical (m_count - m_max_entries);
+
+    if (m_max_days && first < m_total)
+    {
+        int64_t cutoff = (int64_t) time (nullptr) - (int64_t) m_max_days * 86400;
+        IndexEntry entry;
+
+        if (read_index (first, entry) && entry.time < cutoff)
+            first = aud::max (first, find_time_physical (cutoff));
+    }
+
+    if (first == m_first)
+        return 0;
+
+    int old_count = m_count;
+    int dropped_removed = 0;
+
+    while (dropped_removed < m_removed.len () && m_removed[dropped_removed] < first)
+        dropped_removed ++;
+
+    m_removed.remove (0, dropped_removed);
+    m_first = first;
+    m_count = m_total - m_first - m_removed.len ();
+
+    return old_count - m_count;
+}
+
+int HistoryStore::physical (int n) const
+{
+    int p = m_first + n;
+
+    for (int removed : m_removed)
+    {
+        if (removed > p)
+            break;
+        p ++;
+    }
+
+    return p;
+}
+
+bool HistoryStore::read_index (int physical, IndexEntry & entry)
+{
+    unsigned char buf[INDEX_ENTRY];
+
+    if (fseeko (m_index, INDEX_HEADER + (int64_t) physical * INDEX_ENTRY, SEEK_SET) != 0 ||
+     fread (buf, 1, INDEX_ENTRY, m_index) != INDEX_ENTRY)
+        return false;
+
+    entry.offset = get_int64 (buf);
+    entry.time = get_int64 (buf + 8);
+    return true;
+}
+
+bool HistoryStore::get_physical (int physical, HistoryRecord & record)
+{
+    CachedRecord & cached = m_cache[physical % aud::n_elems (m_cache)];
+
+    if (cached.physical != physical)
+    {
+        IndexEntry entry;
+        int64_t length;
+
+        if (! read_index (physical, entry) ||
+         fseeko (m_log, entry.offset, SEEK_SET) != 0 ||
+         ! read_next (m_log, cached.record, length))
+        {
+            AUDERR ("Could not read playback history entry %d.\n", physical);
+            cached.physical = -1;
+            return false;
+        }
+
+        cached.physical = physical;
+    }
+
+    record = cached.record;
+    return true;
+}
+
+bool HistoryStore::get (int n, HistoryRecord & record)
+{
+    if (! m_log || n < 0 || n >= m_count)
+        return false;
+
+    return get_physical (physical (n), record);
+}
+
+int HistoryStore::append (const HistoryRecord & record)
+{
+    if (! m_log)
+        return 0;
+
+    Index<char> buf;
+    put_record (buf, record);
+    int length = buf.len ();
+
+    fseeko (m_log, m_log_size, SEEK_SET);
+    if (fwrite (buf.begin (), 1, buf.len (), m_log) != (size_t) buf.len () ||
+     fflush (m_log) != 0)
+    {
+        AUDERR ("Could not write to " LOG_NAME ".\n");
+        return 0;
+    }
+
+    buf.clear ();
+    put_int (buf, m_log_size, 8);
+    put_int (buf, record.time, 8);
+
+    /* if this fails, the entry is indexed on opening */
+    fseeko (m_index, INDEX_HEADER + (int64_t) m_total * INDEX_ENTRY, SEEK_SET);
+    if (fwrite (buf.begin (), 1, INDEX_ENTRY, m_index) != INDEX_ENTRY)
+        AUDERR ("Could not write to " INDEX_NAME ".\n");
+
+    m_log_size += length;
+    m_total ++;
+    m_count ++;
+    m_appended ++;
+    write_header ();
+
+    if (m_counts_loaded)
+        count_play (record);
+
+    return apply_retention ();
+}
+
+void HistoryStore::remove (int n)
+{
+    if (! m_log || n < 0 || n >= m_count)
+        return;
+
+    int p = physical (n);
+    int pos = 0;
+
+    while (pos < m_removed.len () && m_removed[pos] < p)
+        pos ++;
+
+    m_removed.insert (pos, 1);
+    m_removed[pos] = p;
+    m_count --;
+
+    save_removed ();
+}
+
+/* the first entry at or after the given time, searching the index */
+int HistoryStore::find_time_physical (int64_t time)
+{
+    int low = m_first, high = m_total;
+
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        IndexEntry entry;
+
+        if (! read_index (mid, entry))
+            return high;
+
+        if (entry.time < time)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+int HistoryStore::find_time (int64_t time)
+{
+    if (! m_log)
+        return 0;
+
+    int p = find_time_physical (time);
+    int n = p - m_first;
+
+    for (int removed : m_removed)
+    {
+        if (removed >= p)
+            break;
+        n --;
+    }
+
+    return n;
+}
+
+/* calls func for the entries from first on, reading the log in one go */
+template<class F>
+static void scan_log (FILE * log, int64_t offset, int64_t end, F func)
+{
+    HistoryRecord record;
+    int64_t length;
+
+    if (fseeko (log, offset, SEEK_SET) != 0)
+        return;
+
+    while (offset < end && read_next (log, record, length))
+    {
+        func (record);
+        offset += length;
+    }
+}
+
+static int count_compare (const HistoryCount & a, const HistoryCount & b)
+{
+    if (a.count != b.count)
+        return b.count - a.count;
+
+    return (a.last.time < b.last.time) ? 1 : (a.last.time > b.last.time) ? -1 : 0;
+}
+
+static Index<HistoryCount> sorted_counts (const std::map<std::string, HistoryCount> & counts, int max)
+{
+    Index<HistoryCount> list;
+
+    for (auto & item : counts)
+        list.append (item.second);
+
+    list.sort (count_compare);
+
+    if (max > 0 && list.len () > max)
+        list.remove (max, -1);
+
+    return list;
+}
+
+Index<HistoryCount> HistoryStore::most_played (int64_t since, int max)
+{
+    if (! m_log)
+        return Index<HistoryCount> ();
+
+    if (! since)
+    {
+        load_counts ();
+        return sorted_counts (m_counts, max);
+    }
+
+    int p = find_time_physical (since);
+    IndexEntry entry;
+
+    if (p >= m_total || ! read_index (p, entry))
+        return Index<HistoryCount> ();
+
+    std::map<std::string, HistoryCount> counts;
+    int next_removed = 0;
+
+    while (next_removed < m_removed.len () && m_removed[next_removed] < p)
+        next_removed ++;
+
+    scan_log (m_log, entry.offset, m_log_size, [&] (const HistoryRecord & record)
+    {
+        if (next_removed < m_removed.len () && m_removed[next_removed] == p)
+            next_removed ++;
+        else if (record.filename)
+        {
+            HistoryCount & count = counts[(const char *) record.filename];
+            count.count ++;
+            count.last = record;
+        }
+
+        p ++;
+    });
+
+    return sorted_counts (counts, max);
+}
+
+int HistoryStore::play_count (const char * filename)
+{
+    if (! m_log || ! filename)
+        return 0;
+
+    load_counts ();
+
+    auto found = m_counts.find (filename);
+    return (found != m_counts.end ()) ? found->second.count : 0;
+}
+
+void HistoryStore::count_play (const HistoryRecord & record)
+{
+    if (! record.filename)
+        return;
+
+    HistoryCount & count = m_counts[(const char *) record.filename];
+    count.count ++;
+    count.last = record;
+
+    m_counts_appended ++;
+    m_counts_changed = true;
+}
+
+/* The play counts are loaded when first asked for, not on opening.  Whatever
+ * was appended since they were saved is counted from the end of the log. */
+void HistoryStore::load_counts ()
+{
+    if (m_counts_loaded)
+        return;
+
+    m_counts_loaded = true;
+    m_counts.clear ();
+    m_counts_appended = 0;
+
+    int start = 0;
+    FILE * file = g_fopen (store_path (COUNTS_NAME), "rb");
+    unsigned char header[MAGIC_LEN + 8];
+
+    if (file && fread (header, 1, sizeof header, file) == sizeof header &&
+     ! memcmp (header, COUNTS_MAGIC, MAGIC_LEN) &&
+     get_int64 (header + MAGIC_LEN) <= m_appended)
+    {
+        unsigned char buf[4];
+
+        while (fread (buf, 1, 4, file) == 4)
+        {
+            HistoryRecord record;
+            int64_t length;
+
+            if (! read_next (file, record, length) || ! record.filename)
+                break;
+
+            HistoryCount & count = m_counts[(const char *) record.filename];
+            count.count = get_int32 (buf);
+            count.last = std::move (record);
+        }
+
+        m_counts_appended = get_int64 (header + MAGIC_LEN);
+        start = aud::max (m_total - (int) (m_appended - m_counts_appended), 0);
+    }
+
+    if (file)
+        fclose (file);
+
+    IndexEntry entry;
+    if (start < m_total && read_index (start, entry))
+    {
+        AUDDBG ("Counting plays from playback history entry %d on.\n", start);
+        scan_log (m_log, entry.offset, m_log_size, [this] (const HistoryRecord & record)
+            { count_play (record); });
+    }
+
+    m_counts_appended = m_appended;
+}
+
+void HistoryStore::save_counts ()
+{
+    if (! m_counts_changed)
+        return;
+
+    Index<char> buf;
+    buf.insert (COUNTS_MAGIC, 0, MAGIC_LEN);
+    put_int (buf, m_counts_appended, 8);
+
+    for (auto & item : m_counts)
+    {
+        put_int (buf, item.second.count, 4);
+        put_record (buf, item.second.last);
+    }
+
+    if (! g_file_set_contents (store_path (COUNTS_NAME), buf.begin (), buf.len (), nullptr))
+        AUDERR ("Could not write to " COUNTS_NAME ".\n");
+
+    m_counts_changed = false;
+}
+
+/* Rewrites the files without the dropped and removed entries, once that
+ * makes a difference; see the top of the file for why this is safe. */
+void HistoryStore::compact ()
+{
+    int gone = m_total - m_count;
+    if (gone < COMPACT_MIN_ENTRIES || gone * 2 < m_total)
+        return;
+
+    IndexEntry entry;
+    if (m_first < m_total && ! read_index (m_first, entry))
+        return;
+
+    StringBuf log_path = store_path (LOG_NAME);
+    StringBuf index_path = store_path (INDEX_NAME);
+    StringBuf log_temp = str_concat ({log_path, ".tmp"});
+    StringBuf index_temp = str_concat ({index_path, ".tmp"});
+
+    FILE * log = g_fopen (log_temp, "wb");
+    FILE * index = g_fopen (index_temp, "wb");
+    bool success = (log && index);
+
+    if (success)
+    {
+        Index<char> buf;
+        buf.insert (LOG_MAGIC, 0, MAGIC_LEN);
+        put_int (buf, m_generation + 1, 8);
+        success = (fwrite (buf.begin (), 1, buf.len (), log) == (size_t) buf.len ());
+
+        buf.clear ();
+        buf.insert (INDEX_MAGIC, 0, MAGIC_LEN);
+        put_int (buf, m_appended, 8);
+        put_int (buf, m_generation + 1, 8);
+        success = success && (fwrite (buf.begin (), 1, buf.len (), index) == (size_t) buf.len ());
+    }
+
+    if (success && m_first < m_total)
+    {
+        int p = m_first, next_removed = 0;
+        int64_t offset = LOG_HEADER;
+
+        scan_log (m_log, entry.offset, m_log_size, [&] (const HistoryRecord & record)
+        {
+            if (next_removed < m_removed.len () && m_removed[next_removed] == p)
+                next_removed ++;
+            else if (success)
+            {
+                Index<char> buf;
+                put_record (buf, record);
+                success = (fwrite (buf.begin (), 1, buf.len (), log) == (size_t) buf.len ());
+
+                buf.clear ();
+                put_int (buf, offset, 8);
+                put_int (buf, record.time, 8);
+                success = success && (fwrite (buf.begin (), 1, buf.len (), index) == (size_t) buf.len ());
+
+                offset += RECORD_HEADER + strlen (record.filename) + strlen (record.text);
+            }
+
+            p ++;
+        });
+
+        success = success && (p == m_total);
+    }
+
+    if (log && fclose (log) != 0)
+        success = false;
+    if (index && fclose (index) != 0)
+        success = false;
+
+    /* the log first: an index with the old generation is then rebuilt */
+    if (success && ! g_rename (log_temp, log_path) && ! g_rename (index_temp, index_path))
+    {
+        AUDINFO ("Compacted the playback history: %d entries dropped.\n", gone);
+        g_unlink (store_path (REMOVED_NAME));
+    }
+    else
+    {
+        AUDERR ("Could not compact the playback history.\n");
+        g_unlink (log_temp);
+        g_unlink (index_temp);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * history-store.h
+ *
+ * Persistent playback history, shared by the GTK and Qt playback history
+ * plugins.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UI_COMMON_HISTORY_STORE_H
+#define UI_COMMON_HISTORY_STORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/objects.h>
+
+struct HistoryRecord
+{
+    int64_t time = 0;      /* when playback started, in seconds since the epoch */
+    int type = 0;          /* the tuple field that text is (title or album) */
+    int playlist_id = -1;  /* unique ID of the playlist it was played from */
+    int position = -1;     /* in that playlist */
+    String filename, text;
+};
+
+struct HistoryCount
+{
+    HistoryRecord last;    /* the latest play */
+    int count = 0;
+};
+
+/*
+ * The history is kept in two files in the config directory: a log, to which
+ * each entry is appended as it is played, and an index holding the offset and
+ * time of each entry in the log.  Entries are numbered from 0 (the oldest one
+ * kept) and read from disk only when asked for, so opening the history takes
+ * the same time however long it has grown.  As entries are appended in the
+ * order played, the index is also sorted by time.
+ *
+ * Entries older than the retention limits are dropped; the files are only
+ * rewritten without them (and without removed entries) on closing, once that
+ * frees at least half of them.
+ */
+class HistoryStore
+{
+public:
+    ~HistoryStore () { close (); }
+
+    bool open ();
+    void close ();
+
+    /* 0 = unlimited */
+    void set_retention (int max_entries, int max_days);
+
+    int count () const { return m_count; }
+
+    /* n counts from the oldest entry; a few entries read recently are
+     * cached, for list views asking for the same rows again and again */
+    bool get (int n, HistoryRecord & record);
+
+    /* returns how many of the oldest entries were dropped to make room */
+    int append (const HistoryRecord & record);
+
+    void remove (int n);
+
+    /* the first entry played at or after time */
+    int find_time (int64_t time);
+
+    /* how often each file was played since the given time (0 = ever), most
+     * played first; play counts over all time include entries since removed
+     * or dropped */
+    Index<HistoryCount> most_played (int64_t since, int max);
+    int play_count (const char * filename);
+
+private:
+    struct IndexEntry {
+        int64_t offset, time;
+    };
+
+    struct CachedRecord {
+        int physical = -1;
+        HistoryRecord record;
+    };
+
+    FILE * m_log = nullptr, * m_index = nullptr;
+    int64_t m_log_size = 0;
+    int64_t m_appended = 0;  /* entries ever appended, for the play counts */
+    int64_t m_generation = 0;  /* bumped by compacting */
+
+    int m_total = 0;     /* entries in the files */
+    int m_first = 0;     /* first entry kept; those before are dropped */
+    Index<int> m_removed;  /* removed entries (sorted), from m_first on */
+    int m_count = 0;     /* entries from m_first on, not removed */
+
+    int m_max_entries = 0, m_max_days = 0;
+
+    CachedRecord m_cache[64];
+
+    bool m_counts_loaded = false, m_counts_changed = false;
+    int64_t m_counts_appended = 0;
+    std::map<std::string, HistoryCount> m_counts;
+
+    int physical (int n) const;
+    bool read_index (int physical, IndexEntry & entry);
+    bool read_record (int64_t offset, HistoryRecord & record, int64_t * end = nullptr);
+    bool get_physical (int physical, HistoryRecord & record);
+    int find_time_physical (int64_t time);
+
+    void recover (bool rebuild);
+    int apply_retention ();
+    void write_header ();
+    void load_removed ();
+    void save_removed ();
+    void compact ();
+
+    void count_play (const HistoryRecord & record);
+    void load_counts ();
+    void save_counts ();
+};
+
+#endif // UI_COMMON_HISTORY_STORE_H
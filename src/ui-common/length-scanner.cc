@@ -0,0 +1,260 @@
+/*
+ * length-scanner.cc
+ *
+ * Background song length detection for emulated (chiptune) formats whose
+ * files carry no timing information, shared by the console and SID plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "length-scanner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/playlist.h>
+#include <libfauxdcore/runtime.h>
+
+/* samples closer to zero than this count as silence (as in Game_Music_Emu) */
+#define SILENCE_THRESHOLD 0x10
+
+/* delay before updating the playlist, so that results arriving close
+ * together are handled at once */
+#define RESCAN_DELAY 1000
+
+#define MAX_SCAN_THREADS 4
+
+bool SilenceTracker::feed (const short * samples, int count)
+{
+    for (int i = 0; i < count; i ++)
+    {
+        if (samples[i] < -SILENCE_THRESHOLD || samples[i] > SILENCE_THRESHOLD)
+            m_last_sound = m_frames + i / m_channels + 1;
+    }
+
+    m_frames += count / m_channels;
+
+    int64_t silence_frames = (int64_t) m_rate * LENGTH_SCAN_SILENCE_MS / 1000;
+    int64_t max_frames = (int64_t) m_rate * LENGTH_SCAN_MAX_MS / 1000;
+
+    /* silence before the song starts does not end it */
+    if (m_last_sound >= 0 && m_frames - m_last_sound >= silence_frames)
+        return false;
+
+    return m_frames < max_frames;
+}
+
+int SilenceTracker::length_ms (bool emulator_ended) const
+{
+    if (m_last_sound <= 0)
+        return -1;
+
+    int64_t silence_frames = (int64_t) m_rate * LENGTH_SCAN_SILENCE_MS / 1000;
+    if (! emulator_ended && m_frames - m_last_sound < silence_frames)
+        return -1;  /* still playing at the time limit */
+
+    return aud::rescale<int64_t> (m_last_sound, m_rate, 1000);
+}
+
+/* 64-bit FNV-1a over the file contents, including the size */
+static uint64_t content_hash (const Index<char> & data)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t) data.len ();
+
+    for (char c : data)
+    {
+        hash ^= (unsigned char) c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+StringBuf LengthScanner::cache_path () const
+{
+    return filename_build ({aud_get_path (AudPath::UserDir),
+     str_concat ({m_name, "-lengths"})});
+}
+
+/* cache format: one "hash subtune length" line per entry */
+void LengthScanner::init ()
+{
+    m_cancel.store (false);
+
+    FILE * file = fopen (cache_path (), "r");
+    if (! file)
+        return;
+
+    char line[128];
+    unsigned long long hash;
+    int subtune, length;
+
+    pthread_mutex_lock (& m_mutex);
+
+    while (fgets (line, sizeof line, file))
+    {
+        if (sscanf (line, "%llx %d %d", & hash, & subtune, & length) == 3)
+            m_lengths[Key ((uint64_t) hash, subtune)] = length;
+    }
+
+    AUDDBG ("%s: %d song lengths cached.\n", m_name, (int) m_lengths.size ());
+
+    pthread_mutex_unlock (& m_mutex);
+    fclose (file);
+}
+
+void LengthScanner::cleanup ()
+{
+    pthread_mutex_lock (& m_mutex);
+
+    m_cancel.store (true);
+    m_jobs.clear ();
+
+    while (m_workers)
+        pthread_cond_wait (& m_cond, & m_mutex);
+
+    m_queued.clear ();
+    m_lengths.clear ();
+    m_rescans.clear ();
+    m_rescan_queued = false;
+
+    pthread_mutex_unlock (& m_mutex);
+
+    /* only now can no worker queue it again */
+    m_rescan_timer.stop ();
+}
+
+bool LengthScanner::get_length (const char * filename, const Index<char> & data,
+ int subtune, int & length, bool queue)
+{
+    if (! data.len ())
+        return false;
+
+    Key key (content_hash (data), subtune);
+
+    pthread_mutex_lock (& m_mutex);
+
+    auto it = m_lengths.find (key);
+    if (it != m_lengths.end ())
+    {
+        length = it->second;
+        pthread_mutex_unlock (& m_mutex);
+        return true;
+    }
+
+    if (queue && ! m_cancel.load () && ! m_queued.count (key))
+    {
+        m_queued.insert (key);
+
+        Job & job = m_jobs.append ();
+        job.key = key;
+        job.filename = String (filename);
+        job.data.insert (data.begin (), 0, data.len ());
+        job.subtune = subtune;
+
+        int max_workers = aud::clamp ((int) std::thread::hardware_concurrency () / 2,
+         1, MAX_SCAN_THREADS);
+
+        /* workers exit once the queue is empty, so none are idle */
+        if (m_workers < max_workers)
+        {
+            pthread_t thread;
+            if (! pthread_create (& thread, nullptr, worker, this))
+            {
+                pthread_detach (thread);
+                m_workers ++;
+            }
+        }
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+    return false;
+}
+
+/* must be called with the mutex held; new entries are appended, so nothing
+ * is lost if we are not shut down cleanly */
+void LengthScanner::store (const Key & key, int length)
+{
+    m_lengths[key] = length;
+
+    FILE * file = fopen (cache_path (), "a");
+    if (! file)
+    {
+        AUDWARN ("%s: cannot write song length cache.\n", m_name);
+        return;
+    }
+
+    fprintf (file, "%016llx %d %d\n", (unsigned long long) key.first, key.second, length);
+    fclose (file);
+}
+
+void * LengthScanner::worker (void * data)
+{
+    auto scanner = (LengthScanner *) data;
+
+    pthread_mutex_lock (& scanner->m_mutex);
+
+    while (scanner->m_jobs.len () && ! scanner->m_cancel.load ())
+    {
+        Job job = std::move (scanner->m_jobs[0]);
+        scanner->m_jobs.remove (0, 1);
+
+        pthread_mutex_unlock (& scanner->m_mutex);
+        int length = scanner->m_scan (job.filename, job.data, job.subtune);
+        pthread_mutex_lock (& scanner->m_mutex);
+
+        if (scanner->m_cancel.load ())
+            break;
+
+        AUDDBG ("%s: %s (subtune %d): %d ms.\n", scanner->m_name,
+         (const char *) job.filename, job.subtune, length);
+
+        scanner->store (job.key, length);
+        scanner->m_queued.erase (job.key);
+
+        if (length > 0)
+        {
+            scanner->m_rescans.append (std::move (job.filename));
+
+            if (! scanner->m_rescan_queued)
+            {
+                scanner->m_rescan_timer.queue (RESCAN_DELAY, rescan, scanner);
+                scanner->m_rescan_queued = true;
+            }
+        }
+    }
+
+    scanner->m_workers --;
+    pthread_cond_broadcast (& scanner->m_cond);
+    pthread_mutex_unlock (& scanner->m_mutex);
+
+    return nullptr;
+}
+
+/* runs in the main thread; reading the tags again picks up the new length */
+void LengthScanner::rescan (void * data)
+{
+    auto scanner = (LengthScanner *) data;
+
+    pthread_mutex_lock (& scanner->m_mutex);
+    Index<String> rescans = std::move (scanner->m_rescans);
+    scanner->m_rescan_queued = false;
+    pthread_mutex_unlock (& scanner->m_mutex);
+
+    for (const String & filename : rescans)
+        aud_playlist_rescan_file (filename);
+}
@@ -0,0 +1,126 @@
+/*
+ * length-scanner.h
+ *
+ * Background song length detection for emulated (chiptune) formats whose
+ * files carry no timing information, shared by the console and SID plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_LENGTH_SCANNER_H
+#define UI_COMMON_LENGTH_SCANNER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <set>
+#include <utility>
+
+#include <pthread.h>
+
+#include <libfauxdcore/index.h>
+#include <libfauxdcore/mainloop.h>
+#include <libfauxdcore/objects.h>
+
+/* how much emulated time a scan may take before the song is given up on as
+ * looping forever */
+#define LENGTH_SCAN_MAX_MS (20 * 60 * 1000)
+
+/* how long the sound has to stay silent to count as the end of the song */
+#define LENGTH_SCAN_SILENCE_MS 4000
+
+/* Finds where the sound ends in a stream of 16-bit samples.  The emulator is
+ * run as fast as it will go and its output fed in block by block, until
+ * feed () returns false or the emulator itself reports the end. */
+class SilenceTracker
+{
+public:
+    SilenceTracker (int rate, int channels) :
+        m_rate (rate), m_channels (channels) {}
+
+    /* returns false once the song has ended (or the time limit is reached) */
+    bool feed (const short * samples, int count);
+
+    /* length of the song in milliseconds, or -1 if no end was found;
+     * emulator_ended is true if the emulator stopped by itself */
+    int length_ms (bool emulator_ended) const;
+
+private:
+    int m_rate, m_channels;
+    int64_t m_frames = 0;       /* frames fed so far */
+    int64_t m_last_sound = -1;  /* frame after the last audible one */
+};
+
+class LengthScanner
+{
+public:
+    /* Emulates the given subtune on a worker thread and returns its length
+     * in milliseconds, or -1 if no end was found.  Should poll cancelled ()
+     * now and then. */
+    typedef int (* ScanFunc) (const char * filename, const Index<char> & data,
+     int subtune);
+
+    LengthScanner (const char * name, ScanFunc scan) :
+        m_name (name), m_scan (scan) {}
+
+    /* loads the lengths found in earlier sessions */
+    void init ();
+
+    /* cancels pending scans and waits for the running ones to stop */
+    void cleanup ();
+
+    bool cancelled () const { return m_cancel.load (std::memory_order_relaxed); }
+
+    /* Looks up the length found for a subtune earlier; length is -1 if the
+     * song was found to loop forever.  If there is none and queue is set, a
+     * scan is started in the background, after which the playlist entry for
+     * filename is rescanned.  Never blocks on a scan. */
+    bool get_length (const char * filename, const Index<char> & data, int subtune,
+     int & length, bool queue);
+
+private:
+    typedef std::pair<uint64_t, int> Key;
+
+    struct Job {
+        Key key;
+        String filename;
+        Index<char> data;
+        int subtune;
+    };
+
+    const char * m_name;
+    ScanFunc m_scan;
+
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+
+    std::map<Key, int> m_lengths;
+    std::set<Key> m_queued;
+    Index<Job> m_jobs;
+    int m_workers = 0;
+    std::atomic<bool> m_cancel {false};
+
+    Index<String> m_rescans;
+    QueuedFunc m_rescan_timer;
+    bool m_rescan_queued = false;
+
+    StringBuf cache_path () const;
+    void store (const Key & key, int length);
+
+    static void * worker (void * data);
+    static void rescan (void * data);
+};
+
+#endif // UI_COMMON_LENGTH_SCANNER_H
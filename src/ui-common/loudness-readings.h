@@ -0,0 +1,52 @@
+/*
+ * loudness-readings.h
+ *
+ * Readings published by the Loudness Meter effect plugin, for display by the
+ * VU meter plugins (GTK and Qt).
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_LOUDNESS_READINGS_H
+#define UI_COMMON_LOUDNESS_READINGS_H
+
+/* Called in the main thread, about 25 times a second during playback and
+ * roughly in step with what is being heard; the data is a pointer to a
+ * LoudnessReadings, valid only during the call. */
+#define LOUDNESS_READINGS_HOOK "loudness meter readings"
+
+#define LOUDNESS_MAX_CHANNELS 20
+
+/* loudness values below this (LUFS) are not measured; readings at or below
+ * it mean "silence" or "not enough audio yet" */
+#define LOUDNESS_FLOOR (-70.0f)
+
+struct LoudnessReadings
+{
+    int channels;
+
+    /* 4x oversampled (true) peak of each channel since the previous
+     * readings, as linear amplitude */
+    float true_peak[LOUDNESS_MAX_CHANNELS];
+
+    /* EBU R128 loudness in LUFS: over the last 400 ms, the last 3 s, and
+     * gated over everything since playback started or was last sought */
+    float momentary, short_term, integrated;
+
+    /* EBU Tech 3342 loudness range in LU */
+    float range;
+};
+
+#endif // UI_COMMON_LOUDNESS_READINGS_H
@@ -0,0 +1,111 @@
+/*
+ * synced-lyrics.cc
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "synced-lyrics.h"
+
+#include <algorithm>
+#include <regex>     // For std::regex and std::smatch
+#include <sstream>   // For std::istringstream
+
+bool SyncedLyrics::parse (const char * lyrics)
+{
+    bool have_timestamps = false;
+
+    m_lines.clear ();
+
+    std::istringstream iss (lyrics ? lyrics : "");
+    std::string line;
+    // Support both SS.SS and SS.SSS formats
+    std::regex re (R"(\[\s*(\d+)\s*:\s*(\d+\.\d{2,3})\s*\]\s*(.*))");
+    std::regex re_offset (R"(\[offset:([+-]?\d+)\])");
+
+    // Add a dummy timestamp line at the beginning to prevent title from being highlighted
+    m_lines.push_back ({0, String ("")});
+    int offset_ms = 0;
+
+    while (std::getline (iss, line))
+    {
+        // Sanitize the line: remove leading/trailing spaces and carriage return
+        line.erase (0, line.find_first_not_of (" \t\r"));
+        line.erase (line.find_last_not_of (" \t\r") + 1);
+        std::smatch match;
+        if (std::regex_match (line, match, re))
+        {
+            have_timestamps = true;
+            int minutes = std::stoi (match[1].str ());
+            float seconds = std::stof (match[2].str ());
+            int timestamp_ms = static_cast<int>(((minutes * 60 + seconds) * 1000) + offset_ms);
+
+            m_lines.push_back ({timestamp_ms, String (match[3].str ().c_str ())});
+        }
+        else if (std::regex_match (line, match, re_offset))
+            offset_ms = std::stoi (match[1].str ());
+    }
+
+    if (! have_timestamps)
+    {
+        m_lines.clear ();
+        return false;
+    }
+
+    /* files are normally in order, but nothing guarantees it; keep lines
+     * with equal timestamps in file order */
+    std::stable_sort (m_lines.begin (), m_lines.end (),
+     [] (const TimedLyricLine & a, const TimedLyricLine & b)
+        { return a.timestamp_ms < b.timestamp_ms; });
+
+    return true;
+}
+
+int SyncedLyrics::position (int time_ms) const
+{
+    auto it = std::lower_bound (m_lines.begin (), m_lines.end (), time_ms,
+     [] (const TimedLyricLine & line, int time)
+        { return line.timestamp_ms < time; });
+
+    return it - m_lines.begin ();
+}
+
+int SyncedLyrics::time_to_next (int pos, int time_ms) const
+{
+    if (pos < 0 || pos >= (int) m_lines.size ())
+        return -1;
+
+    /* the position moves on once the time is past this line's timestamp */
+    return std::max (m_lines[pos].timestamp_ms - time_ms + 1, 0);
+}
+
+int SyncedLyrics::window (int pos, const TimedLyricLine * lines[4], int & highlight) const
+{
+    int count = 0;
+    highlight = -1;
+
+    if (pos < 0 || pos >= (int) m_lines.size ())
+        return 0;
+
+    int start = (pos > 1) ? pos - 2 : 0;  // Start 2 lines before the current line
+    int end = std::min (pos + 2, (int) m_lines.size () - 1);
+
+    for (int i = start; i <= end && count < 4; i ++)
+        lines[count ++] = & m_lines[i];
+
+    if (count > 1)
+        highlight = 1;  // The line before the current one is the one being sung
+
+    return count;
+}
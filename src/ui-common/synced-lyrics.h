@@ -0,0 +1,63 @@
+/*
+ * synced-lyrics.h
+ *
+ * Toolkit-independent engine for displaying timestamped (LRC-style) lyrics,
+ * shared by the GTK and Qt lyrics plugins.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef UI_COMMON_SYNCED_LYRICS_H
+#define UI_COMMON_SYNCED_LYRICS_H
+
+#include <vector>
+
+#include <libfauxdcore/objects.h>
+
+/* how often to check the time while paused or after the last line (the
+ * lyrics plugins also resync immediately on seek and unpause) */
+#define SYNCED_LYRICS_IDLE_MS 1000
+
+struct TimedLyricLine {
+    int timestamp_ms;   // Timestamp in milliseconds
+    String text;        // Lyric text at this timestamp
+};
+
+class SyncedLyrics
+{
+public:
+    /* parses the timestamped lines of lyrics, sorted by time; returns false
+     * if there were none (leaving the engine empty) */
+    bool parse (const char * lyrics);
+    void clear ()
+        { m_lines.clear (); }
+
+    /* position of the display at the given playback time: the index of the
+     * first line timestamped at or after it (binary search) */
+    int position (int time_ms) const;
+
+    /* milliseconds until position () will return something other than pos,
+     * or -1 if it never will (past the last line) */
+    int time_to_next (int pos, int time_ms) const;
+
+    /* the lines to show at a position (up to 4 lines, from 2 lines before
+     * it), and which of them (if any) to highlight */
+    int window (int pos, const TimedLyricLine * lines[4], int & highlight) const;
+
+private:
+    std::vector<TimedLyricLine> m_lines;
+};
+
+#endif
@@ -97,6 +97,25 @@ static void insert_int_tuple_field_to_dictionary (const Tuple & tuple,
         dict.remove (String (key));
 }
 
+/* ReplayGain values are left as they are if the tuple has none (we do not
+ * read them from these tags ourselves); they are set by the ReplayGain
+ * Scanner plugin */
+static void insert_gain_tuple_field_to_dictionary (const Tuple & tuple,
+ Tuple::Field field, Tuple::Field divisor_field, Dictionary & dict, const char * key)
+{
+    int divisor = tuple.get_int (divisor_field);
+
+    if (tuple.get_value_type (field) != Tuple::Int || divisor <= 0)
+        return;
+
+    double val = (double) tuple.get_int (field) / divisor;
+
+    if (divisor_field == Tuple::PeakDivisor)
+        dict.add (String (key), String (str_printf ("%.6f", val)));
+    else
+        dict.add (String (key), String (str_printf ("%.2f dB", val)));
+}
+
 /* JWT:  EMULATE: $>kid3-cli -c 'set picture:"<imagefid>" "front cover"' <songfile.ogg>
    SEE:  https://xiph.org/flac/format.html#metadata_block_picture
 */
@@ -175,6 +194,11 @@ bool VorbisPlugin::write_tuple (const char * filename, VFSFile & file, const Tup
     insert_str_tuple_field_to_dictionary (tuple, Tuple::CatalogNum, dict, "CATALOGNUMBER");
     insert_str_tuple_field_to_dictionary (tuple, Tuple::Performer, dict, "PERFORMER");
 
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::TrackGain, Tuple::GainDivisor, dict, "REPLAYGAIN_TRACK_GAIN");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::TrackPeak, Tuple::PeakDivisor, dict, "REPLAYGAIN_TRACK_PEAK");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::AlbumGain, Tuple::GainDivisor, dict, "REPLAYGAIN_ALBUM_GAIN");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::AlbumPeak, Tuple::PeakDivisor, dict, "REPLAYGAIN_ALBUM_PEAK");
+
     String comment = tuple.get_str (Tuple::Comment);
     bool wrote_art = false;
     if (comment && comment[0] && ! strncmp ((const char *) comment, "file://", 7)
@@ -22,14 +22,19 @@
 #include "vumeter_qt_widget.h"
 
 #include <QPointer>
+#include <libfauxdcore/hook.h>
 #include <libfauxdcore/interface.h>
 #include <libfauxdcore/runtime.h>
 
+#include "../ui-common/loudness-readings.h"
+
 EXPORT VUMeterQt aud_plugin_instance;
 
 const char VUMeterQt::about[] =
     N_("VU Meter Plugin for Audacious\n"
-        "Copyright 2017-2019 Marc Sánchez Fauste");
+        "Copyright 2017-2019 Marc Sánchez Fauste\n\n"
+        "When the Loudness Meter effect is enabled, the meter shows the "
+        "true peak of every sample played, and EBU R128 loudness below.");
 
 const PreferencesWidget VUMeterQt::widgets[] = {
     WidgetLabel (N_("<b>VU Meter Settings</b>")),
@@ -59,12 +64,26 @@ const char * const VUMeterQt::prefs_defaults[] = {
 
 static QPointer<VUMeterQtWidget> spect_widget;
 
+static void loudness_cb(void * data, void *)
+{
+    if (spect_widget)
+    {
+        spect_widget->set_loudness(* (const LoudnessReadings *) data);
+    }
+}
+
 bool VUMeterQt::init()
 {
     aud_config_set_defaults ("vumeter", prefs_defaults);
+    hook_associate (LOUDNESS_READINGS_HOOK, loudness_cb, nullptr);
     return true;
 }
 
+void VUMeterQt::cleanup()
+{
+    hook_dissociate (LOUDNESS_READINGS_HOOK, loudness_cb);
+}
+
 void VUMeterQt::render_multi_pcm(const float * pcm, int channels)
 {
     if (spect_widget)
@@ -44,6 +44,7 @@ public:
     constexpr VUMeterQt () : VisPlugin (info, Visualizer::MultiPCM) {}
 
     bool init ();
+    void cleanup ();
     void * get_qt_widget ();
 
     void clear ();
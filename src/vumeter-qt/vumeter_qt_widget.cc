@@ -29,6 +29,10 @@ const QColor VUMeterQtWidget::db_line_color = QColor(120, 120, 120);
 const float VUMeterQtWidget::legend_line_width = 1.0f;
 const int VUMeterQtWidget::redraw_interval = 25; // ms
 
+/* readings from the Loudness Meter effect replace the visualizer data for
+ * this long after they stop coming */
+static constexpr qint64 loudness_timeout = 500; // ms
+
 float VUMeterQtWidget::get_db_on_range(float db)
 {
     return aud::clamp<float>(db, -db_range, 0);
@@ -70,23 +74,53 @@ float VUMeterQtWidget::get_y_from_db(float db)
 
 void VUMeterQtWidget::render_multi_pcm (const float * pcm, int channels)
 {
-    nchannels = aud::clamp(channels, 1, max_channels);
+    if (loudness_timer.isValid())
+    {
+        if (loudness_timer.elapsed() < loudness_timeout)
+            return;
+
+        loudness_timer.invalidate();
+        update_sizes();
+    }
+
+    channels = aud::clamp(channels, 1, max_channels);
 
-    float * peaks = new float[nchannels];
+    float peaks[max_channels];
 
-    for (int channel = 0; channel < nchannels; channel++)
+    for (int channel = 0; channel < channels; channel++)
     {
         peaks[channel] = fabsf(pcm[channel]);
     }
 
-    for (int i = 0; i < 512 * nchannels;)
+    for (int i = 0; i < 512 * channels;)
     {
-        for (int channel = 0; channel < nchannels; channel++)
+        for (int channel = 0; channel < channels; channel++)
         {
             peaks[channel] = fmaxf(peaks[channel], fabsf(pcm[i++]));
         }
     }
 
+    update_levels(peaks, channels);
+}
+
+/* the true peaks cover every sample, not just the visualizer's snapshots */
+void VUMeterQtWidget::set_loudness (const LoudnessReadings & readings)
+{
+    bool was_shown = loudness_timer.isValid();
+
+    loudness = readings;
+    loudness_timer.start();
+
+    if (!was_shown)
+        update_sizes();
+
+    update_levels(loudness.true_peak, loudness.channels);
+}
+
+void VUMeterQtWidget::update_levels(const float * peaks, int channels)
+{
+    nchannels = aud::clamp(channels, 1, max_channels);
+
     for (int i = 0; i < nchannels; i++)
     {
         float n = peaks[i];
@@ -101,8 +135,6 @@ void VUMeterQtWidget::render_multi_pcm (const float * pcm, int channels)
             last_peak_times[i].start();
         }
     }
-
-    delete[] peaks;
 }
 
 void VUMeterQtWidget::redraw_timer_expired()
@@ -280,6 +312,49 @@ void VUMeterQtWidget::draw_visualizer(QPainter & p)
     }
 }
 
+QString VUMeterQtWidget::format_lufs(const float val)
+{
+    if (val > LOUDNESS_FLOOR)
+        return QString::number(val, 'f', 1);
+    else
+        return QString("-inf");
+}
+
+void VUMeterQtWidget::draw_loudness(QPainter &p)
+{
+    QString text = QString("M %1   S %2   I %3 LUFS   LRA %4 LU")
+        .arg(format_lufs(loudness.momentary))
+        .arg(format_lufs(loudness.short_term))
+        .arg(format_lufs(loudness.integrated))
+        .arg(loudness.range, 0, 'f', 1);
+
+    QFont font = p.font();
+    font.setPointSizeF(vumeter_bottom_padding * 0.4f);
+    p.setFont(font);
+
+    /* shrink to fit if the window is narrow */
+    QFontMetricsF fm(p.font());
+    QSizeF text_size = fm.size(0, text);
+    if (text_size.width() > width())
+    {
+        font.setPointSizeF(font.pointSizeF() * width() / text_size.width());
+        p.setFont(font);
+        text_size = QFontMetricsF(font).size(0, text);
+    }
+
+    QPen pen = p.pen();
+    pen.setColor(text_color);
+    p.setPen(pen);
+
+    p.drawText(
+        QPointF(
+            (width() - text_size.width()) / 2.0f,
+            height() - vumeter_bottom_padding / 2.0f + (text_size.height()/4.0f)
+        ),
+        text
+    );
+}
+
 QString VUMeterQtWidget::format_db(const float val)
 {
     if (val > -10)
@@ -301,7 +376,7 @@ void VUMeterQtWidget::update_sizes()
     {
         must_draw_vu_legend = true;
         vumeter_top_padding = height() * 0.03f;
-        vumeter_bottom_padding = height() * 0.015f;
+        vumeter_bottom_padding = height() * (loudness_timer.isValid() ? 0.05f : 0.015f);
         vumeter_height = height() - vumeter_top_padding - vumeter_bottom_padding;
         legend_width = width() * 0.3f;
         vumeter_width = width() - (legend_width * 2);
@@ -356,6 +431,9 @@ void VUMeterQtWidget::paintEvent (QPaintEvent *)
     {
         draw_vu_legend(p);
         draw_visualizer_peaks(p);
+
+        if (loudness_timer.isValid())
+            draw_loudness(p);
     }
     draw_visualizer(p);
 }
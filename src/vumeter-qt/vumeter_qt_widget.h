@@ -29,6 +29,8 @@
 #include <QTimer>
 #include <QElapsedTimer>
 
+#include "../ui-common/loudness-readings.h"
+
 class VUMeterQtWidget : public QWidget
 {
 private:
@@ -55,6 +57,8 @@ private:
     bool must_draw_vu_legend;
     QTimer *redraw_timer;
     QElapsedTimer redraw_elapsed_timer;
+    LoudnessReadings loudness;
+    QElapsedTimer loudness_timer; // invalid if no readings are shown
 
     void draw_background (QPainter &p);
     void draw_visualizer (QPainter &p);
@@ -66,9 +70,12 @@ private:
     void draw_vu_legend_db(QPainter &p, float db, const char *text);
     void draw_vu_legend_line(QPainter &p, float db, float line_width_factor = 1.0f);
     void draw_visualizer_peaks(QPainter &p);
+    void draw_loudness(QPainter &p);
+    void update_levels(const float * peaks, int channels);
     void update_sizes();
 
     static QString format_db(const float val);
+    static QString format_lufs(const float val);
     static float get_db_on_range(float db);
     static float get_db_factor(float db);
 
@@ -80,6 +87,7 @@ public:
 
     void reset ();
     void render_multi_pcm (const float * pcm, int channels);
+    void set_loudness (const LoudnessReadings & readings);
     void toggle_display_legend();
 
 protected:
@@ -25,16 +25,23 @@
 #include <gtk/gtk.h>
 
 #include <libfauxdcore/audstrings.h>
+#include <libfauxdcore/hook.h>
 #include <libfauxdcore/i18n.h>
 #include <libfauxdcore/plugin.h>
 #include <libfauxdcore/preferences.h>
 #include <libfauxdcore/runtime.h>
 #include <libfauxdgui/gtk-compat.h>
 
+#include "../ui-common/loudness-readings.h"
+
 #define CFG_ID "vumeter"
 #define MAX_CHANNELS 20
 #define DB_RANGE 96
 
+/* readings from the Loudness Meter effect replace the visualizer data for
+ * this long after they stop coming */
+#define LOUDNESS_TIMEOUT 500000
+
 class VUMeter : public VisPlugin
 {
 public:
@@ -54,6 +61,7 @@ public:
     constexpr VUMeter () : VisPlugin (info, Visualizer::MultiPCM) {}
 
     bool init ();
+    void cleanup ();
     void * get_gtk_widget ();
 
     void clear ();
@@ -67,7 +75,9 @@ EXPORT VUMeter aud_plugin_instance;
 
 const char VUMeter::about[] =
  N_("VU Meter Plugin for Audacious\n"
-    "Copyright 2017-2019 Marc Sanchez Fauste");
+    "Copyright 2017-2019 Marc Sanchez Fauste\n\n"
+    "When the Loudness Meter effect is enabled, the meter shows the "
+    "true peak of every sample played, and EBU R128 loudness below.");
 
 const PreferencesWidget VUMeter::widgets[] = {
     WidgetLabel (N_("<b>VU Meter Settings</b>")),
@@ -107,6 +117,8 @@ static float channels_db_level[MAX_CHANNELS];
 static float channels_peaks[MAX_CHANNELS];
 static gint64 last_peak_times[MAX_CHANNELS]; // Time elapsed since peak was set
 static gint64 last_render_time = 0;
+static LoudnessReadings loudness;
+static gint64 loudness_time = 0;   // zero if no readings are shown
 
 static void update_sizes ()
 {
@@ -114,7 +126,7 @@ static void update_sizes ()
     {
         legend_width = width * 0.3f;
         vumeter_top_padding = height * 0.04f;
-        vumeter_bottom_padding = height * 0.015f;
+        vumeter_bottom_padding = height * (loudness_time ? 0.05f : 0.015f);
         vumeter_width = width * 0.4f / nchannels;
         vumeter_height = height - vumeter_top_padding - vumeter_bottom_padding;
     }
@@ -167,7 +179,7 @@ static float get_y_from_db (float db)
     return vumeter_top_padding + vumeter_height - get_height_from_db (db);
 }
 
-void VUMeter::render_multi_pcm (const float * pcm, int channels)
+static void update_levels (const float * peaks, int channels)
 {
     gint64 current_time = g_get_monotonic_time ();
     gint64 elapsed_render_time = current_time - last_render_time;
@@ -182,16 +194,6 @@ void VUMeter::render_multi_pcm (const float * pcm, int channels)
         update_sizes ();
     }
 
-    float * peaks = new float[nchannels];
-    for (int channel = 0; channel < nchannels; channel ++)
-        peaks[channel] = aud::abs (pcm[channel]);
-
-    for (int i = 0; i < 512 * nchannels;)
-    {
-        for (int channel = 0; channel < nchannels; channel ++)
-            peaks[channel] = aud::max (peaks[channel], aud::abs (pcm[i ++]));
-    }
-
     for (int i = 0; i < nchannels; i ++)
     {
         float n = peaks[i];
@@ -209,12 +211,50 @@ void VUMeter::render_multi_pcm (const float * pcm, int channels)
         }
     }
 
-    delete[] peaks;
-
     if (spect_widget)
         gtk_widget_queue_draw (spect_widget);
 }
 
+void VUMeter::render_multi_pcm (const float * pcm, int channels)
+{
+    if (loudness_time)
+    {
+        if (g_get_monotonic_time () - loudness_time < LOUDNESS_TIMEOUT)
+            return;
+
+        loudness_time = 0;
+        update_sizes ();
+    }
+
+    channels = aud::clamp (channels, 1, MAX_CHANNELS);
+
+    float peaks[MAX_CHANNELS];
+    for (int channel = 0; channel < channels; channel ++)
+        peaks[channel] = aud::abs (pcm[channel]);
+
+    for (int i = 0; i < 512 * channels;)
+    {
+        for (int channel = 0; channel < channels; channel ++)
+            peaks[channel] = aud::max (peaks[channel], aud::abs (pcm[i ++]));
+    }
+
+    update_levels (peaks, channels);
+}
+
+/* the true peaks cover every sample, not just the visualizer's snapshots */
+static void loudness_cb (void * data, void *)
+{
+    bool was_shown = loudness_time;
+
+    loudness = * (const LoudnessReadings *) data;
+    loudness_time = g_get_monotonic_time ();
+
+    if (! was_shown)
+        update_sizes ();
+
+    update_levels (loudness.true_peak, loudness.channels);
+}
+
 static void reset_variables ()
 {
     for (int i = 0; i < MAX_CHANNELS; i ++)
@@ -230,9 +270,16 @@ bool VUMeter::init ()
 {
     reset_variables ();
     aud_config_set_defaults (CFG_ID, prefs_defaults);
+    hook_associate (LOUDNESS_READINGS_HOOK, loudness_cb, nullptr);
     return true;
 }
 
+void VUMeter::cleanup ()
+{
+    hook_dissociate (LOUDNESS_READINGS_HOOK, loudness_cb);
+    loudness_time = 0;
+}
+
 void VUMeter::clear ()
 {
     reset_variables ();
@@ -394,6 +441,39 @@ static void draw_visualizer_peak_legend (cairo_t * cr)
     }
 }
 
+static StringBuf format_lufs (const float val)
+{
+    if (val > LOUDNESS_FLOOR)
+        return str_printf ("%.1f", val);
+    else
+        return str_copy ("-inf");
+}
+
+static void draw_loudness_legend (cairo_t * cr)
+{
+    StringBuf text = str_printf (_("M %s   S %s   I %s LUFS   LRA %.1f LU"),
+     (const char *) format_lufs (loudness.momentary),
+     (const char *) format_lufs (loudness.short_term),
+     (const char *) format_lufs (loudness.integrated), loudness.range);
+
+    cairo_set_font_size (cr, vumeter_bottom_padding * 0.5f);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+
+    cairo_text_extents_t extents;
+    cairo_text_extents (cr, text, & extents);
+
+    /* shrink to fit if the window is narrow */
+    if (extents.width > width)
+    {
+        cairo_set_font_size (cr, vumeter_bottom_padding * 0.5f * width / extents.width);
+        cairo_text_extents (cr, text, & extents);
+    }
+
+    cairo_move_to (cr, (width - extents.width) / 2.0f,
+        height - vumeter_bottom_padding / 2.0f + (extents.height / 2.0f));
+    cairo_show_text (cr, text);
+}
+
 static gboolean configure_event (GtkWidget * widget, GdkEventConfigure * event)
 {
     width = event->width;
@@ -417,6 +497,9 @@ static gboolean draw_event (GtkWidget * widget)
     {
         draw_legend (cr);
         draw_visualizer_peak_legend (cr);
+
+        if (loudness_time)
+            draw_loudness_legend (cr);
     }
     draw_visualizer (cr);
 #ifndef USE_GTK3
@@ -10,7 +10,11 @@
 #include <libfauxdcore/plugin.h>
 #include <libfauxdcore/audstrings.h>
 
-#define BUFFER_SIZE 256 /* read buffer size, in samples / frames */
+/* decode block size, in frames: about 100 ms, so that the per-call overhead
+ * (stop/seek checks, output locking) is small even for high-rate files */
+#define BLOCK_MS 100
+#define MIN_BLOCK_FRAMES 256
+#define MAX_BLOCK_FRAMES 32768
 #define SAMPLE_SIZE(a) (a <= 8 ? sizeof(uint8_t) : (a <= 16 ? sizeof(uint16_t) : sizeof(uint32_t)))
 #define SAMPLE_FMT(a) (a <= 8 ? FMT_S8 : (a <= 16 ? FMT_S16_NE : (a <= 24 ? FMT_S24_NE : FMT_S32_NE)))
 
@@ -34,6 +38,8 @@ public:
     bool is_our_file (const char * filename, VFSFile & file)
         { return false; }
 
+    void cleanup ();
+
     bool read_tag (const char * filename, VFSFile & file, Tuple & tuple, Index<char> * image);
     bool write_tuple (const char * filename, VFSFile & file, const Tuple & tuple);
     bool play (const char * filename, VFSFile & file);
@@ -42,52 +48,64 @@ public:
 EXPORT WavpackPlugin aud_plugin_instance;
 
 /* Audacious VFS wrappers for Wavpack stream reading
+ *
+ * The stream id is a WvSource rather than the VFSFile itself, so that a
+ * decoding context can be pointed at a new VFSFile (see WvSegment below).
  */
 
+struct WvSource {
+    VFSFile * file;
+};
+
+static VFSFile * wv_file (void * id)
+{
+    return ((WvSource *) id)->file;
+}
+
 static int32_t
 wv_read_bytes(void *id, void *data, int32_t bcount)
 {
-    return ((VFSFile *) id)->fread (data, 1, bcount);
+    return wv_file (id)->fread (data, 1, bcount);
 }
 
 static uint32_t
 wv_get_pos(void *id)
 {
-    return aud::clamp (((VFSFile *) id)->ftell (), (int64_t) 0, (int64_t) 0xffffffff);
+    return aud::clamp (wv_file (id)->ftell (), (int64_t) 0, (int64_t) 0xffffffff);
 }
 
 static int
 wv_set_pos_abs(void *id, uint32_t pos)
 {
-    return ((VFSFile *) id)->fseek (pos, VFS_SEEK_SET);
+    return wv_file (id)->fseek (pos, VFS_SEEK_SET);
 }
 
 static int
 wv_set_pos_rel(void *id, int32_t delta, int mode)
 {
-    return ((VFSFile *) id)->fseek (delta, to_vfs_seek_type(mode));
+    return wv_file (id)->fseek (delta, to_vfs_seek_type(mode));
 }
 
 static int
 wv_push_back_byte(void *id, int c)
 {
-    return (((VFSFile *) id)->fseek (-1, VFS_SEEK_CUR) == 0) ? c : -1;
+    return (wv_file (id)->fseek (-1, VFS_SEEK_CUR) == 0) ? c : -1;
 }
 
 static uint32_t
 wv_get_length(void *id)
 {
-    return aud::clamp (((VFSFile *) id)->fsize (), (int64_t) 0, (int64_t) 0xffffffff);
+    return aud::clamp (wv_file (id)->fsize (), (int64_t) 0, (int64_t) 0xffffffff);
 }
 
 static int wv_can_seek(void *id)
 {
-    return (((VFSFile *) id)->fsize () >= 0);
+    return (wv_file (id)->fsize () >= 0);
 }
 
 static int32_t wv_write_bytes(void *id, void *data, int32_t bcount)
 {
-    return ((VFSFile *) id)->fwrite (data, 1, bcount);
+    return wv_file (id)->fwrite (data, 1, bcount);
 }
 
 WavpackStreamReader wv_readers = {
@@ -101,40 +119,89 @@ WavpackStreamReader wv_readers = {
     wv_write_bytes
 };
 
-static bool wv_attach (const char * filename, VFSFile & wv_input,
- VFSFile & wvc_input, WavpackContext * * ctx, char * error, int flags)
+/* When a cue sheet splits one large image into several playlist entries, each
+ * entry is played by a separate call to play ().  Rather than reopening and
+ * seeking for every entry, a context stopped at the end time of a segment is
+ * kept, along with its last decoded block (part of which belongs to the next
+ * segment), and reused if the next segment of the same file starts there.
+ * This is static because the context holds pointers to the sources. */
+static struct {
+    String filename;            /* set only while a session is retained */
+    WavpackContext * ctx = nullptr;
+    WvSource input {nullptr}, wvc_source {nullptr};
+    VFSFile wvc_input;
+    int64_t file_pos = 0;
+    int64_t block_sample = 0;   /* first sample of the retained block */
+    int block_samples = 0;      /* per channel */
+    Index<int32_t> block;       /* already in output format */
+} session;
+
+static void session_close ()
+{
+    if (session.ctx)
+        WavpackCloseFile (session.ctx);
+
+    session.filename = String ();
+    session.ctx = nullptr;
+    session.input.file = nullptr;
+    session.wvc_input = VFSFile ();
+    session.block.clear ();
+}
+
+static bool wv_attach (const char * filename, char * error, int flags)
 {
     if (flags & OPEN_WVC)
     {
         StringBuf corrFilename = str_concat ({filename, "c"});
         if (VFSFile::test_file (corrFilename, VFS_IS_REGULAR))
-            wvc_input = VFSFile (corrFilename, "r");
+            session.wvc_input = VFSFile (corrFilename, "r");
     }
 
-    * ctx = WavpackOpenFileInputEx (& wv_readers, & wv_input,
-     wvc_input ? (& wvc_input) : nullptr, error, flags, 0);
+    session.wvc_source.file = & session.wvc_input;
 
-    return (* ctx != nullptr);
+    session.ctx = WavpackOpenFileInputEx (& wv_readers, & session.input,
+     session.wvc_input ? (& session.wvc_source) : nullptr, error, flags, 0);
+
+    return (session.ctx != nullptr);
 }
 
-static void wv_deattach (WavpackContext * ctx)
+void WavpackPlugin::cleanup ()
 {
-    WavpackCloseFile(ctx);
+    session_close ();
 }
 
 bool WavpackPlugin::play (const char * filename, VFSFile & file)
 {
     int sample_rate, num_channels, bits_per_sample;
     unsigned num_samples;
-    WavpackContext *ctx = nullptr;
-    VFSFile wvc_input;
 
-    if (! wv_attach (filename, file, wvc_input, & ctx, nullptr, OPEN_TAGS | OPEN_WVC))
+    Tuple tuple = get_playback_tuple ();
+    bool is_segment = (tuple.get_int (Tuple::EndTime) > 0 && file.fsize () >= 0);
+    int start_time = tuple.get_int (Tuple::StartTime);
+    bool resuming = false;
+
+    if (session.ctx && session.filename && start_time > 0
+     && ! strcmp (session.filename, filename)
+     && ! file.fseek (session.file_pos, VFS_SEEK_SET))
+    {
+        AUDDBG ("Continuing decoder session at %d ms.\n", start_time);
+        resuming = true;
+    }
+    else
+        session_close ();
+
+    session.filename = String ();
+    session.input.file = & file;
+
+    if (! resuming && ! wv_attach (filename, nullptr, OPEN_TAGS | OPEN_WVC))
     {
         AUDERR ("Error opening Wavpack file '%s'.\n", filename);
+        session_close ();
         return false;
     }
 
+    WavpackContext * ctx = session.ctx;
+
     sample_rate = WavpackGetSampleRate(ctx);
     num_channels = WavpackGetNumChannels(ctx);
     bits_per_sample = WavpackGetBitsPerSample(ctx);
@@ -147,17 +214,55 @@ bool WavpackPlugin::play (const char * filename, VFSFile & file)
     else
         open_audio(SAMPLE_FMT(bits_per_sample), sample_rate, num_channels);
 
-    Index<int32_t> input;
-    input.resize (BUFFER_SIZE * num_channels);
+    int frame_size = num_channels * SAMPLE_SIZE (bits_per_sample);
+    int block_frames = aud::clamp (sample_rate / (1000 / BLOCK_MS),
+     MIN_BLOCK_FRAMES, MAX_BLOCK_FRAMES);
+
+    /* Wavpack unpacks to 32-bit samples, which are also the output format
+     * for 24-bit, 32-bit and float data; narrower samples are packed in
+     * place after each block, so there is no second buffer */
+    Index<int32_t> buffer;
+    if (resuming)
+        buffer = std::move (session.block);
+    buffer.resize (block_frames * num_channels);
 
-    Index<char> output;
-    output.resize (BUFFER_SIZE * num_channels * SAMPLE_SIZE (bits_per_sample));
+    char * output = (char *) buffer.begin ();
 
-    while (! check_stop ())
+    int64_t last_sample = session.block_sample;
+    int last_samples = resuming ? session.block_samples : 0;
+    bool stopped = false;
+
+    while (true)
     {
+        if (check_stop ())
+        {
+            stopped = true;
+            break;
+        }
+
         int seek_value = check_seek ();
+
+        /* the core should already have asked us to seek to the start time */
+        if (resuming && seek_value < 0)
+            seek_value = start_time;
+
         if (seek_value >= 0)
-            WavpackSeekSample (ctx, (int64_t) seek_value * sample_rate / 1000);
+        {
+            int64_t target = (int64_t) seek_value * sample_rate / 1000;
+
+            if (resuming && target >= last_sample && target <= last_sample + last_samples)
+            {
+                /* the start of the segment is in (or just after) the retained block */
+                int skip = target - last_sample;
+                if (skip < last_samples)
+                    write_audio (output + skip * frame_size,
+                     (last_samples - skip) * frame_size);
+            }
+            else
+                WavpackSeekSample (ctx, target);
+        }
+
+        resuming = false;
 
         /* Decode audio data */
         unsigned samples_left = num_samples - WavpackGetSampleIndex(ctx);
@@ -165,7 +270,8 @@ bool WavpackPlugin::play (const char * filename, VFSFile & file)
         if (samples_left == 0)
             break;
 
-        int ret = WavpackUnpackSamples (ctx, input.begin (), BUFFER_SIZE);
+        last_sample = WavpackGetSampleIndex (ctx);
+        int ret = WavpackUnpackSamples (ctx, buffer.begin (), block_frames);
 
         if (ret < 0)
         {
@@ -174,34 +280,46 @@ bool WavpackPlugin::play (const char * filename, VFSFile & file)
         }
         else
         {
-            /* Perform audio data conversion and output */
-            int32_t * rp = input.begin ();
-            int8_t * wp = (int8_t *) output.begin ();
-            int16_t * wp2 = (int16_t *) output.begin ();
-            int32_t * wp4 = (int32_t *) output.begin ();
+            /* Perform audio data conversion (in place; the write pointer
+             * never passes the read pointer, and writing through char keeps
+             * the compiler from assuming the two do not overlap) and output */
+            const int32_t * rp = buffer.begin ();
+            int count = ret * num_channels;
 
             if (bits_per_sample <= 8)
             {
-                for (int i = 0; i < ret * num_channels; i++, wp++, rp++)
-                    *wp = *rp & 0xff;
+                for (int i = 0; i < count; i++)
+                    output[i] = (char) rp[i];
             }
             else if (bits_per_sample <= 16)
             {
-                for (int i = 0; i < ret * num_channels; i++, wp2++, rp++)
-                    *wp2 = *rp & 0xffff;
-            }
-            else
-            {
-                for (int i = 0; i < ret * num_channels; i++, wp4++, rp++)
-                    *wp4 = *rp;
+                for (int i = 0; i < count; i++)
+                {
+                    int16_t sample = rp[i];
+                    memcpy (output + 2 * i, & sample, 2);
+                }
             }
 
-            write_audio (output.begin (),
-             ret * num_channels * SAMPLE_SIZE (bits_per_sample));
+            write_audio (output, ret * frame_size);
+            last_samples = ret;
         }
     }
 
-    wv_deattach (ctx);
+    int64_t pos = file.ftell ();
+
+    if (is_segment && stopped && pos >= 0)
+    {
+        /* keep the context; the next segment may continue from here */
+        session.filename = String (filename);
+        session.input.file = nullptr;
+        session.file_pos = pos;
+        session.block_sample = last_sample;
+        session.block_samples = last_samples;
+        session.block = std::move (buffer);
+        return true;
+    }
+
+    session_close ();
     return true;
 }
 
@@ -227,7 +345,8 @@ bool WavpackPlugin::read_tag (const char * filename, VFSFile & file, Tuple & tup
 {
     char error[1024];
 
-    auto ctx = WavpackOpenFileInputEx(&wv_readers, &file, nullptr, error, OPEN_TAGS, 0);
+    WvSource source = {& file};
+    auto ctx = WavpackOpenFileInputEx(&wv_readers, &source, nullptr, error, OPEN_TAGS, 0);
     if (! ctx)
         return false;
 